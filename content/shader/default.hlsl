@@ -1,4 +1,4 @@
-cbuffer PerFrame : register(b0)
+cbuffer PerDraw : register(b1)
 {
     row_major float4x4 uMVP;
 };
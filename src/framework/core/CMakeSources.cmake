@@ -1,9 +1,17 @@
+set(CORE_ALGO_SRCS
+    "core/algo/prefix_sum.c"
+    "core/algo/radix_sort.c")
+
+set(CORE_CONTAINER_SRCS
+    "core/container/hashmap.c")
+
 set(CORE_FS_SRCS
     "core/fs/fs.c"
     "core/fs/path.c")
 
 set(CORE_HANDLE_SRCS
-    "core/handle/handle_pool.c")
+    "core/handle/handle_pool.c"
+    "core/handle/handle_pool_mt.c")
 
 set(CORE_MATH_SRCS
     "core/math/math.c"
@@ -11,8 +19,15 @@ set(CORE_MATH_SRCS
     "core/math/transform.c")
 
 set(CORE_MEM_SRCS
+    "core/mem/allocator.c"
+    "core/mem/mem_churn.c"
     "core/mem/mem_diag.c"
-    "core/mem/mem_frame.c")
+    "core/mem/mem_frame.c"
+    "core/mem/mem_region.c"
+    "core/mem/mem_scratch.c"
+    "core/mem/mem_slab.c"
+    "core/mem/tlsf.c"
+    "core/mem/vm_arena.c")
 
 set(CORE_MISC_SRCS
     "core/misc/cjson.c")
@@ -26,9 +41,19 @@ set(CORE_PLUGIN_SRCS
     "core/plugin/plugin.c")
 
 set(CORE_THREAD_SRCS
-    "core/thread/mutex.c")
+    "core/thread/atomic.c"
+    "core/thread/event.c"
+    "core/thread/futex.c"
+    "core/thread/job.c"
+    "core/thread/mpmc_ring.c"
+    "core/thread/mutex.c"
+    "core/thread/semaphore.c"
+    "core/thread/spsc_ring.c"
+    "core/thread/thread.c")
 
 set(CORE_SOURCES
+    ${CORE_ALGO_SRCS}
+    ${CORE_CONTAINER_SRCS}
     ${CORE_FS_SRCS}
     ${CORE_HANDLE_SRCS}
     ${CORE_MATH_SRCS}
@@ -41,5 +66,6 @@ set(CORE_SOURCES
     "core/log.c"
     "core/error.c"
     "core/json.c"
+    "core/strid.c"
     "core/time.c"
 )
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "prefix_sum.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PREFIX_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PREFIX_NEON 1
+#endif
+
+uint32_t maru_prefix_sum_inclusive_u32(const uint32_t *in, uint32_t *out, size_t n) {
+    size_t i = 0;
+    uint32_t carry = 0;
+
+#if PREFIX_SSE2
+    /* log-step scan inside a 4-lane register, then add the running carry */
+    __m128i vcarry = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*) (in + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, vcarry);
+        _mm_storeu_si128((__m128i*) (out + i), x);
+        vcarry = _mm_shuffle_epi32(x, 0xFF);
+    }
+    carry = (uint32_t) _mm_cvtsi128_si32(vcarry);
+#elif PREFIX_NEON
+    uint32x4_t vcarry = vdupq_n_u32(0);
+    const uint32x4_t zero = vdupq_n_u32(0);
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t x = vld1q_u32(in + i);
+        x = vaddq_u32(x, vextq_u32(zero, x, 3));
+        x = vaddq_u32(x, vextq_u32(zero, x, 2));
+        x = vaddq_u32(x, vcarry);
+        vst1q_u32(out + i, x);
+        vcarry = vdupq_laneq_u32(x, 3);
+    }
+    carry = vgetq_lane_u32(vcarry, 0);
+#endif
+
+    for (; i < n; ++i) {
+        carry += in[i];
+        out[i] = carry;
+    }
+    return carry;
+}
+
+uint32_t maru_prefix_sum_exclusive_u32(const uint32_t *in, uint32_t *out, size_t n) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t v = in[i];
+        out[i] = sum;
+        sum += v;
+    }
+    return sum;
+}
+
+size_t maru_compact_indices(const uint8_t *keep, size_t n, uint32_t *out) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        out[k] = (uint32_t) i;
+        k += keep[i] != 0;
+    }
+    return k;
+}
+
+size_t maru_compact_u32(const uint32_t *in, const uint8_t *keep, size_t n, uint32_t *out) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        out[k] = in[i];
+        k += keep[i] != 0;
+    }
+    return k;
+}
+
+size_t maru_compact(const void *in, size_t stride, const uint8_t *keep, size_t n, void *out) {
+    const uint8_t *src = (const uint8_t*) in;
+    uint8_t *dst = (uint8_t*) out;
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(dst + k * stride, src + i * stride, stride);
+        k += keep[i] != 0;
+    }
+    return k;
+}
@@ -0,0 +1,33 @@
+#ifndef MARU_PREFIX_SUM_H
+#define MARU_PREFIX_SUM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Prefix sums over uint32 counts (wrapping). `out` may alias `in`.
+ * Both return the total of all n inputs.
+ *   inclusive: out[i] = in[0] + ... + in[i]
+ *   exclusive: out[i] = in[0] + ... + in[i-1], out[0] = 0
+ */
+uint32_t maru_prefix_sum_inclusive_u32(const uint32_t *in, uint32_t *out, size_t n);
+uint32_t maru_prefix_sum_exclusive_u32(const uint32_t *in, uint32_t *out, size_t n);
+
+/*
+ * Stream compaction: keep element i when keep[i] != 0, preserving order.
+ * Returns the number kept. `out` needs room for n elements (writes are
+ * branchless, so slots past the result may be scribbled) and must not alias.
+ */
+size_t maru_compact_indices(const uint8_t *keep, size_t n, uint32_t *out);
+size_t maru_compact_u32(const uint32_t *in, const uint8_t *keep, size_t n, uint32_t *out);
+size_t maru_compact(const void *in, size_t stride, const uint8_t *keep, size_t n, void *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_PREFIX_SUM_H */
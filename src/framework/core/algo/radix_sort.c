@@ -0,0 +1,250 @@
+#include "radix_sort.h"
+
+#include <string.h>
+
+#include "macro.h"
+#include "mem/mem_diag.h"
+#include "mem/mem_frame.h"
+
+#define RADIX_BUCKETS   256
+#define RADIX_SMALL     64      /* insertion sort below this */
+#define RADIX_MT_MIN    65536   /* MT variant sorts serially below this */
+#define RADIX_MAX_TASKS 64
+
+/* ---- scratch ---- */
+
+typedef struct {
+    void *keys;
+    uint32_t *vals;
+    void *heap;     /* non-NULL when the frame arena could not serve the request */
+} scratch_t;
+
+static int scratch_get(scratch_t *s, size_t n, size_t key_size, int with_vals) {
+    size_t key_bytes = ALIGN_UP(n * key_size, (size_t) 64);
+    size_t bytes = key_bytes + (with_vals ? n * sizeof(uint32_t) : 0);
+
+    uint8_t *p = (uint8_t*) frame_alloc(bytes, 64);
+    s->heap = NULL;
+    if (!p) {
+        p = (uint8_t*) MARU_MALLOC(bytes);
+        if (!p) return 0;
+        s->heap = p;
+    }
+
+    s->keys = p;
+    s->vals = with_vals ? (uint32_t*) (p + key_bytes) : NULL;
+    return 1;
+}
+
+static void scratch_release(scratch_t *s) {
+    if (s->heap) MARU_FREE(s->heap);
+}
+
+/*
+ * Per-width implementation. Histograms for every digit are built in a single
+ * read of the keys; each pass then only scatters. A pass is skipped when all
+ * keys share that digit, which leaves the data where it is.
+ */
+#define RADIX_DEFINE(suffix, key_t, digits)                                                     \
+    static void insertion_##suffix(key_t *k, uint32_t *v, size_t n) {                          \
+        for (size_t i = 1; i < n; ++i) {                                                        \
+            key_t key = k[i];                                                                   \
+            uint32_t val = v ? v[i] : 0;                                                        \
+            size_t j = i;                                                                       \
+            while (j > 0 && k[j - 1] > key) {                                                   \
+                k[j] = k[j - 1];                                                                \
+                if (v) v[j] = v[j - 1];                                                         \
+                --j;                                                                            \
+            }                                                                                   \
+            k[j] = key;                                                                         \
+            if (v) v[j] = val;                                                                  \
+        }                                                                                       \
+    }                                                                                           \
+                                                                                                \
+    static void histogram_##suffix(const key_t *k, size_t n, uint32_t (*h)[RADIX_BUCKETS]) {   \
+        memset(h, 0, sizeof(uint32_t) * RADIX_BUCKETS * (digits));                              \
+        for (size_t i = 0; i < n; ++i) {                                                        \
+            key_t x = k[i];                                                                     \
+            for (uint32_t d = 0; d < (digits); ++d) {                                           \
+                ++h[d][(x >> (d * 8)) & 0xFF];                                                  \
+            }                                                                                   \
+        }                                                                                       \
+    }                                                                                           \
+                                                                                                \
+    static void scatter_##suffix(const key_t *sk, const uint32_t *sv, key_t *dk, uint32_t *dv, \
+                                 size_t n, uint32_t shift, uint32_t *off) {                     \
+        if (sv) {                                                                               \
+            for (size_t i = 0; i < n; ++i) {                                                    \
+                uint32_t o = off[(sk[i] >> shift) & 0xFF]++;                                    \
+                dk[o] = sk[i];                                                                  \
+                dv[o] = sv[i];                                                                  \
+            }                                                                                   \
+        } else {                                                                                \
+            for (size_t i = 0; i < n; ++i) {                                                    \
+                dk[off[(sk[i] >> shift) & 0xFF]++] = sk[i];                                     \
+            }                                                                                   \
+        }                                                                                       \
+    }                                                                                           \
+                                                                                                \
+    int maru_radix_sort_##suffix(key_t *keys, uint32_t *vals, size_t n) {                      \
+        if (!keys || n < 2) return 0;                                                           \
+        if (n <= RADIX_SMALL) {                                                                 \
+            insertion_##suffix(keys, vals, n);                                                  \
+            return 0;                                                                           \
+        }                                                                                       \
+                                                                                                \
+        scratch_t s;                                                                            \
+        if (!scratch_get(&s, n, sizeof(key_t), vals != NULL)) return -1;                        \
+                                                                                                \
+        uint32_t hist[(digits)][RADIX_BUCKETS];                                                 \
+        histogram_##suffix(keys, n, hist);                                                      \
+                                                                                                \
+        key_t *sk = keys, *dk = (key_t*) s.keys;                                                \
+        uint32_t *sv = vals, *dv = s.vals;                                                      \
+                                                                                                \
+        for (uint32_t d = 0; d < (digits); ++d) {                                               \
+            uint32_t *h = hist[d];                                                              \
+            if (h[(sk[0] >> (d * 8)) & 0xFF] == (uint32_t) n) continue;                         \
+                                                                                                \
+            uint32_t sum = 0;                                                                   \
+            for (uint32_t b = 0; b < RADIX_BUCKETS; ++b) {                                      \
+                uint32_t c = h[b];                                                              \
+                h[b] = sum;                                                                     \
+                sum += c;                                                                       \
+            }                                                                                   \
+                                                                                                \
+            scatter_##suffix(sk, sv, dk, dv, n, d * 8, h);                                      \
+                                                                                                \
+            key_t *tk = sk; sk = dk; dk = tk;                                                   \
+            uint32_t *tv = sv; sv = dv; dv = tv;                                                \
+        }                                                                                       \
+                                                                                                \
+        if (sk != keys) {                                                                       \
+            memcpy(keys, sk, n * sizeof(key_t));                                                \
+            if (vals) memcpy(vals, sv, n * sizeof(uint32_t));                                   \
+        }                                                                                       \
+                                                                                                \
+        scratch_release(&s);                                                                    \
+        return 0;                                                                               \
+    }
+
+RADIX_DEFINE(u32, uint32_t, 4)
+RADIX_DEFINE(u64, uint64_t, 8)
+
+/* ---- multi-threaded ---- */
+
+typedef struct {
+    const void *sk;
+    const uint32_t *sv;
+    void *dk;
+    uint32_t *dv;
+    size_t n;
+    uint32_t tasks;
+    uint32_t shift;
+    int wide;
+    uint32_t (*hist)[RADIX_BUCKETS]; /* one row per task */
+} radix_mt_t;
+
+static void task_range(const radix_mt_t *c, uint32_t t, size_t *lo, size_t *hi) {
+    *lo = c->n * t / c->tasks;
+    *hi = c->n * (t + 1) / c->tasks;
+}
+
+static void mt_histogram_task(void *ctx, uint32_t t) {
+    radix_mt_t *c = (radix_mt_t*) ctx;
+    uint32_t *h = c->hist[t];
+    size_t lo, hi;
+    task_range(c, t, &lo, &hi);
+
+    memset(h, 0, sizeof(uint32_t) * RADIX_BUCKETS);
+    if (c->wide) {
+        const uint64_t *k = (const uint64_t*) c->sk;
+        for (size_t i = lo; i < hi; ++i) ++h[(k[i] >> c->shift) & 0xFF];
+    } else {
+        const uint32_t *k = (const uint32_t*) c->sk;
+        for (size_t i = lo; i < hi; ++i) ++h[(k[i] >> c->shift) & 0xFF];
+    }
+}
+
+static void mt_scatter_task(void *ctx, uint32_t t) {
+    radix_mt_t *c = (radix_mt_t*) ctx;
+    size_t lo, hi;
+    task_range(c, t, &lo, &hi);
+
+    const uint32_t *sv = c->sv ? c->sv + lo : NULL;
+    if (c->wide) {
+        scatter_u64((const uint64_t*) c->sk + lo, sv, (uint64_t*) c->dk, c->dv, hi - lo, c->shift, c->hist[t]);
+    } else {
+        scatter_u32((const uint32_t*) c->sk + lo, sv, (uint32_t*) c->dk, c->dv, hi - lo, c->shift, c->hist[t]);
+    }
+}
+
+/* Turns per-task counts into per-task write offsets (digit-major, then task: keeps it stable) */
+static int mt_offsets(radix_mt_t *c) {
+    uint32_t sum = 0;
+    for (uint32_t b = 0; b < RADIX_BUCKETS; ++b) {
+        uint32_t digit_total = 0;
+        for (uint32_t t = 0; t < c->tasks; ++t) {
+            uint32_t n = c->hist[t][b];
+            c->hist[t][b] = sum + digit_total;
+            digit_total += n;
+        }
+        if (digit_total == (uint32_t) c->n) return 0; /* every key has this digit */
+        sum += digit_total;
+    }
+    return 1;
+}
+
+static int radix_sort_mt(void *keys, uint32_t *vals, size_t n, int wide, const maru_parallel_t *par) {
+    size_t key_size = wide ? sizeof(uint64_t) : sizeof(uint32_t);
+
+    uint32_t tasks = par->workers < RADIX_MAX_TASKS ? par->workers : RADIX_MAX_TASKS;
+    uint32_t hist[RADIX_MAX_TASKS][RADIX_BUCKETS];
+
+    scratch_t s;
+    if (!scratch_get(&s, n, key_size, vals != NULL)) return -1;
+
+    radix_mt_t c;
+    c.sk = keys;
+    c.sv = vals;
+    c.dk = s.keys;
+    c.dv = s.vals;
+    c.n = n;
+    c.tasks = tasks;
+    c.wide = wide;
+    c.hist = hist;
+
+    uint32_t digits = wide ? 8 : 4;
+    for (uint32_t d = 0; d < digits; ++d) {
+        c.shift = d * 8;
+
+        par->run(par->user, tasks, mt_histogram_task, &c);
+        if (!mt_offsets(&c)) continue;
+        par->run(par->user, tasks, mt_scatter_task, &c);
+
+        const void *tk = c.sk; c.sk = c.dk; c.dk = (void*) tk;
+        const uint32_t *tv = c.sv; c.sv = c.dv; c.dv = (uint32_t*) tv;
+    }
+
+    if (c.sk != keys) {
+        memcpy(keys, c.sk, n * key_size);
+        if (vals) memcpy(vals, c.sv, n * sizeof(uint32_t));
+    }
+
+    scratch_release(&s);
+    return 0;
+}
+
+int maru_radix_sort_u32_mt(uint32_t *keys, uint32_t *vals, size_t n, const maru_parallel_t *par) {
+    if (!par || !par->run || par->workers < 2 || n < RADIX_MT_MIN) {
+        return maru_radix_sort_u32(keys, vals, n);
+    }
+    return radix_sort_mt(keys, vals, n, 0, par);
+}
+
+int maru_radix_sort_u64_mt(uint64_t *keys, uint32_t *vals, size_t n, const maru_parallel_t *par) {
+    if (!par || !par->run || par->workers < 2 || n < RADIX_MT_MIN) {
+        return maru_radix_sort_u64(keys, vals, n);
+    }
+    return radix_sort_mt(keys, vals, n, 1, par);
+}
@@ -0,0 +1,38 @@
+#ifndef MARU_RADIX_SORT_H
+#define MARU_RADIX_SORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "thread/parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Stable LSD radix sort, 8-bit digits, ascending. `vals` (may be NULL) is
+ * permuted alongside the keys, typically an index or handle per key.
+ *
+ * Scratch (n keys + n vals) comes from the current frame arena, falling back
+ * to MARU_MALLOC when the arena is missing or full. Digits on which every key
+ * agrees are skipped, so e.g. 64-bit keys with empty high bytes cost fewer
+ * passes. Returns 0, or -1 if scratch could not be allocated.
+ */
+int maru_radix_sort_u32(uint32_t *keys, uint32_t *vals, size_t n);
+int maru_radix_sort_u64(uint64_t *keys, uint32_t *vals, size_t n);
+
+/*
+ * Same result split across par->workers tasks: per-task digit histograms,
+ * a serial offset scan, then per-task scatter. Small inputs, or par NULL,
+ * sort on the calling thread. Scratch is taken before any task starts, so
+ * the frame arena is only touched from the caller.
+ */
+int maru_radix_sort_u32_mt(uint32_t *keys, uint32_t *vals, size_t n, const maru_parallel_t *par);
+int maru_radix_sort_u64_mt(uint64_t *keys, uint32_t *vals, size_t n, const maru_parallel_t *par);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_RADIX_SORT_H */
@@ -0,0 +1,353 @@
+#include "hashmap.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHMAP_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HASHMAP_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#define GROUP_WIDTH  16
+#define CTRL_EMPTY   ((uint8_t) 0x80)
+#define CTRL_DELETED ((uint8_t) 0xFE)
+#define MIN_CAP      16
+
+/* Full slots hold h2 (0..127); EMPTY and DELETED both have the top bit set */
+#define CTRL_IS_FULL(c) (((c) & 0x80) == 0)
+
+static inline uint32_t ctz32(uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return (uint32_t) i;
+#else
+    return (uint32_t) __builtin_ctz(v);
+#endif
+}
+
+static inline uint32_t clz32(uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanReverse(&i, v);
+    return 31u - (uint32_t) i;
+#else
+    return (uint32_t) __builtin_clz(v);
+#endif
+}
+
+/* ---- group probing: each returns a 16-bit mask, bit i = byte i matched ---- */
+
+#if defined(HASHMAP_SSE2)
+
+static inline uint32_t group_match(const uint8_t *g, uint8_t h2) {
+    __m128i ctrl = _mm_loadu_si128((const __m128i*) g);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) h2)));
+}
+
+static inline uint32_t group_match_empty(const uint8_t *g) {
+    return group_match(g, CTRL_EMPTY);
+}
+
+static inline uint32_t group_match_free(const uint8_t *g) {
+    return (uint32_t) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) g));
+}
+
+#elif defined(HASHMAP_NEON)
+
+static inline uint32_t neon_movemask(uint8x16_t v) {
+    static const uint8_t bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t m = vandq_u8(v, vld1q_u8(bits));
+    return (uint32_t) vaddv_u8(vget_low_u8(m)) | ((uint32_t) vaddv_u8(vget_high_u8(m)) << 8);
+}
+
+static inline uint32_t group_match(const uint8_t *g, uint8_t h2) {
+    return neon_movemask(vceqq_u8(vld1q_u8(g), vdupq_n_u8(h2)));
+}
+
+static inline uint32_t group_match_empty(const uint8_t *g) {
+    return group_match(g, CTRL_EMPTY);
+}
+
+static inline uint32_t group_match_free(const uint8_t *g) {
+    return neon_movemask(vcltzq_s8(vreinterpretq_s8_u8(vld1q_u8(g))));
+}
+
+#else
+
+static inline uint32_t group_match(const uint8_t *g, uint8_t h2) {
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < GROUP_WIDTH; ++i) {
+        if (g[i] == h2) mask |= 1u << i;
+    }
+    return mask;
+}
+
+static inline uint32_t group_match_empty(const uint8_t *g) {
+    return group_match(g, CTRL_EMPTY);
+}
+
+static inline uint32_t group_match_free(const uint8_t *g) {
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < GROUP_WIDTH; ++i) {
+        if (!CTRL_IS_FULL(g[i])) mask |= 1u << i;
+    }
+    return mask;
+}
+
+#endif
+
+/* ---- layout ---- */
+
+static size_t natural_align(size_t size) {
+    size_t a = 1;
+    while (a < 8 && (size & (a * 2 - 1)) == 0) a *= 2;
+    return a;
+}
+
+static size_t ctrl_bytes(size_t cap) {
+    return ALIGN_UP(cap + GROUP_WIDTH - 1, (size_t) 16);
+}
+
+static size_t table_bytes(const maru_hashmap_t *m, size_t cap) {
+    return ctrl_bytes(cap) + cap * m->slot_size;
+}
+
+static size_t max_load(size_t cap) {
+    return cap - cap / 8;
+}
+
+static inline uint8_t *slot_at(const maru_hashmap_t *m, size_t i) {
+    return m->slots + i * m->slot_size;
+}
+
+/* Writes ctrl[i] and its mirror past the end for i < GROUP_WIDTH - 1 */
+static inline void set_ctrl(maru_hashmap_t *m, size_t i, uint8_t c) {
+    m->ctrl[i] = c;
+    m->ctrl[((i - (GROUP_WIDTH - 1)) & (m->cap - 1)) + (GROUP_WIDTH - 1)] = c;
+}
+
+static inline int key_eq(const maru_hashmap_t *m, const void *a, const void *b) {
+    if (m->eq_fn) return m->eq_fn(a, b);
+
+    switch (m->key_size) {
+    case 4: {
+        uint32_t x, y;
+        memcpy(&x, a, 4);
+        memcpy(&y, b, 4);
+        return x == y;
+    }
+    case 8: {
+        uint64_t x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        return x == y;
+    }
+    default:
+        return memcmp(a, b, m->key_size) == 0;
+    }
+}
+
+/* ---- core ---- */
+
+void maru_hashmap_init(maru_hashmap_t *m, size_t key_size, size_t val_size,
+                       maru_hash_fn hash_fn, maru_key_eq_fn eq_fn, const maru_allocator_t *alloc) {
+    memset(m, 0, sizeof(*m));
+
+    size_t ka = natural_align(key_size);
+    size_t va = natural_align(val_size);
+    size_t sa = ka > va ? ka : va;
+
+    m->key_size = (uint32_t) key_size;
+    m->val_size = (uint32_t) val_size;
+    m->val_offset = (uint32_t) ALIGN_UP(key_size, va);
+    m->slot_size = (uint32_t) ALIGN_UP(m->val_offset + val_size, sa);
+    m->hash_fn = hash_fn;
+    m->eq_fn = eq_fn;
+    m->alloc = alloc ? alloc : maru_default_allocator();
+}
+
+void maru_hashmap_destroy(maru_hashmap_t *m) {
+    if (!m) return;
+    if (m->ctrl) {
+        maru_free(m->alloc, m->ctrl, table_bytes(m, m->cap), 16);
+    }
+    m->ctrl = NULL;
+    m->slots = NULL;
+    m->cap = 0;
+    m->count = 0;
+    m->growth_left = 0;
+}
+
+void maru_hashmap_clear(maru_hashmap_t *m) {
+    if (!m || !m->ctrl) return;
+    memset(m->ctrl, CTRL_EMPTY, m->cap + GROUP_WIDTH - 1);
+    m->count = 0;
+    m->growth_left = max_load(m->cap);
+}
+
+static size_t probe_free(const maru_hashmap_t *m, uint64_t hash) {
+    size_t mask = m->cap - 1;
+    size_t pos = (size_t) (hash >> 7) & mask;
+    size_t step = 0;
+
+    for (;;) {
+        uint32_t bits = group_match_free(m->ctrl + pos);
+        if (bits) return (pos + ctz32(bits)) & mask;
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+static int rehash(maru_hashmap_t *m, size_t new_cap) {
+    uint8_t *mem = (uint8_t*) maru_alloc(m->alloc, table_bytes(m, new_cap), 16);
+    if (!mem) return 0;
+
+    uint8_t *old_ctrl = m->ctrl;
+    uint8_t *old_slots = m->slots;
+    size_t old_cap = m->cap;
+
+    m->ctrl = mem;
+    m->slots = mem + ctrl_bytes(new_cap);
+    m->cap = new_cap;
+    memset(m->ctrl, CTRL_EMPTY, new_cap + GROUP_WIDTH - 1);
+
+    for (size_t i = 0; i < old_cap; ++i) {
+        if (!CTRL_IS_FULL(old_ctrl[i])) continue;
+
+        const uint8_t *src = old_slots + i * m->slot_size;
+        uint64_t hash = m->hash_fn(src);
+        size_t j = probe_free(m, hash);
+        set_ctrl(m, j, (uint8_t) (hash & 0x7F));
+        memcpy(slot_at(m, j), src, m->slot_size);
+    }
+
+    m->growth_left = max_load(new_cap) - m->count;
+
+    if (old_ctrl) {
+        maru_free(m->alloc, old_ctrl, ctrl_bytes(old_cap) + old_cap * m->slot_size, 16);
+    }
+    return 1;
+}
+
+int maru_hashmap_reserve(maru_hashmap_t *m, size_t count) {
+    if (!m) return -1;
+
+    size_t cap = m->cap ? m->cap : MIN_CAP;
+    while (max_load(cap) < count) cap *= 2;
+    if (cap == m->cap) return 0;
+
+    return rehash(m, cap) ? 0 : -1;
+}
+
+static size_t find_index(const maru_hashmap_t *m, const void *key, uint64_t hash) {
+    if (m->cap == 0) return SIZE_MAX;
+
+    size_t mask = m->cap - 1;
+    size_t pos = (size_t) (hash >> 7) & mask;
+    size_t step = 0;
+    uint8_t h2 = (uint8_t) (hash & 0x7F);
+
+    for (;;) {
+        const uint8_t *g = m->ctrl + pos;
+
+        uint32_t bits = group_match(g, h2);
+        while (bits) {
+            size_t i = (pos + ctz32(bits)) & mask;
+            if (LIKELY(key_eq(m, slot_at(m, i), key))) return i;
+            bits &= bits - 1;
+        }
+
+        /* An empty slot ends the probe chain: the key was never pushed past it */
+        if (group_match_empty(g)) return SIZE_MAX;
+
+        step += GROUP_WIDTH;
+        pos = (pos + step) & mask;
+    }
+}
+
+void *maru_hashmap_find(const maru_hashmap_t *m, const void *key, uint64_t hash) {
+    if (!m || !key) return NULL;
+
+    size_t i = find_index(m, key, hash);
+    return i == SIZE_MAX ? NULL : slot_at(m, i) + m->val_offset;
+}
+
+void *maru_hashmap_insert(maru_hashmap_t *m, const void *key, uint64_t hash, int *inserted) {
+    if (inserted) *inserted = 0;
+    if (!m || !key) return NULL;
+
+    size_t i = find_index(m, key, hash);
+    if (i != SIZE_MAX) return slot_at(m, i) + m->val_offset;
+
+    if (m->cap == 0 && !rehash(m, MIN_CAP)) return NULL;
+
+    i = probe_free(m, hash);
+    if (m->ctrl[i] == CTRL_EMPTY && m->growth_left == 0) {
+        /* Mostly tombstones: rebuild in place. Otherwise double. */
+        size_t new_cap = (m->count * 2 <= max_load(m->cap)) ? m->cap : m->cap * 2;
+        if (!rehash(m, new_cap)) return NULL;
+        i = probe_free(m, hash);
+    }
+
+    if (m->ctrl[i] == CTRL_EMPTY) --m->growth_left;
+    set_ctrl(m, i, (uint8_t) (hash & 0x7F));
+
+    uint8_t *slot = slot_at(m, i);
+    memcpy(slot, key, m->key_size);
+    memset(slot + m->val_offset, 0, m->val_size);
+    ++m->count;
+
+    if (inserted) *inserted = 1;
+    return slot + m->val_offset;
+}
+
+int maru_hashmap_erase(maru_hashmap_t *m, const void *key, uint64_t hash) {
+    if (!m || !key) return 0;
+
+    size_t i = find_index(m, key, hash);
+    if (i == SIZE_MAX) return 0;
+
+    /*
+     * If every 16-wide window containing i already holds an empty slot, no
+     * probe chain can have passed through i, so it may go straight back to
+     * EMPTY instead of leaving a tombstone.
+     */
+    uint32_t after = group_match_empty(m->ctrl + i);
+    uint32_t before = group_match_empty(m->ctrl + ((i - GROUP_WIDTH) & (m->cap - 1)));
+    uint32_t run_after = after ? ctz32(after) : GROUP_WIDTH;
+    uint32_t run_before = before ? clz32(before) - (32 - GROUP_WIDTH) : GROUP_WIDTH;
+
+    if (run_before + run_after < GROUP_WIDTH) {
+        set_ctrl(m, i, CTRL_EMPTY);
+        ++m->growth_left;
+    } else {
+        set_ctrl(m, i, CTRL_DELETED);
+    }
+
+    --m->count;
+    return 1;
+}
+
+int maru_hashmap_next(const maru_hashmap_t *m, size_t *it, void **out_key, void **out_val) {
+    if (!m || !it) return 0;
+
+    for (size_t i = *it; i < m->cap; ++i) {
+        if (!CTRL_IS_FULL(m->ctrl[i])) continue;
+
+        uint8_t *slot = slot_at(m, i);
+        if (out_key) *out_key = slot;
+        if (out_val) *out_val = slot + m->val_offset;
+        *it = i + 1;
+        return 1;
+    }
+
+    *it = m->cap;
+    return 0;
+}
@@ -0,0 +1,188 @@
+#ifndef MARU_HASHMAP_H
+#define MARU_HASHMAP_H
+
+/*
+ * Open-addressing hash map, Swiss-table layout.
+ *
+ * Each slot has a control byte: EMPTY, DELETED, or the low 7 bits of the key's
+ * hash (h2). Lookups start at h1 = hash >> 7 and scan the control bytes in
+ * groups of 16 with one SIMD compare (SSE2 / NEON, scalar otherwise), only
+ * touching slots whose h2 matches. Max load is 7/8.
+ *
+ * Keys and values are fixed-size and stored inline in one allocation drawn
+ * from a maru_allocator_t. Callers pass the 64-bit hash explicitly so it can
+ * be computed inline (or cached); `hash_fn` is only used when rehashing.
+ * `eq_fn` NULL means memcmp on key_size bytes.
+ *
+ * Pointers returned by find/insert stay valid until the next insert or erase.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "macro.h"
+#include "mem/allocator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t (*maru_hash_fn)(const void *key);
+typedef int (*maru_key_eq_fn)(const void *a, const void *b);
+
+typedef struct maru_hashmap {
+    uint8_t *ctrl;        /* cap + 15 bytes; the tail mirrors the first 15 */
+    uint8_t *slots;       /* cap * slot_size */
+    size_t cap;           /* 0 or a power of two >= 16 */
+    size_t count;
+    size_t growth_left;
+
+    uint32_t key_size;
+    uint32_t val_size;
+    uint32_t val_offset;
+    uint32_t slot_size;
+
+    maru_hash_fn hash_fn;
+    maru_key_eq_fn eq_fn;
+    const maru_allocator_t *alloc;
+} maru_hashmap_t;
+
+/* alloc NULL = maru_default_allocator(). No memory is taken until first insert. */
+void maru_hashmap_init(maru_hashmap_t *m, size_t key_size, size_t val_size,
+                       maru_hash_fn hash_fn, maru_key_eq_fn eq_fn, const maru_allocator_t *alloc);
+void maru_hashmap_destroy(maru_hashmap_t *m);
+void maru_hashmap_clear(maru_hashmap_t *m);
+int maru_hashmap_reserve(maru_hashmap_t *m, size_t count);
+
+/* Value pointer, or NULL */
+void *maru_hashmap_find(const maru_hashmap_t *m, const void *key, uint64_t hash);
+
+/*
+ * Value pointer for `key`, inserting it (value zeroed) if absent.
+ * *inserted tells which happened. NULL only on allocation failure.
+ */
+void *maru_hashmap_insert(maru_hashmap_t *m, const void *key, uint64_t hash, int *inserted);
+
+/* 1 if the key was present */
+int maru_hashmap_erase(maru_hashmap_t *m, const void *key, uint64_t hash);
+
+/*
+ * Iteration: start with *it = 0. Returns 0 when done.
+ *   size_t it = 0; void *k, *v;
+ *   while (maru_hashmap_next(m, &it, &k, &v)) { ... }
+ */
+int maru_hashmap_next(const maru_hashmap_t *m, size_t *it, void **out_key, void **out_val);
+
+static inline size_t maru_hashmap_count(const maru_hashmap_t *m) {
+    return m->count;
+}
+
+/* ---- hashing helpers ---- */
+
+/* Finalizer from MurmurHash3; spreads entropy into the low 7 bits used for h2 */
+static inline uint64_t maru_hash_mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline uint64_t maru_hash_bytes(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*) data;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return maru_hash_mix64(h);
+}
+
+static inline uint64_t maru_hash_str(const char *s) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; *s; ++s) {
+        h ^= (uint8_t) *s;
+        h *= 0x100000001b3ULL;
+    }
+    return maru_hash_mix64(h);
+}
+
+/*
+ * Typed wrapper generator:
+ *
+ *   MARU_HASHMAP_DEFINE(name, key_type, val_type, hash_expr, eq_expr)
+ *
+ * `hash_expr(k)` and `eq_expr(a, b)` are macros or functions taking key
+ * values. Emits name##_t plus static inline name##_init / _destroy / _clear /
+ * _find / _get / _put / _remove / _count / _next.
+ * MARU_HASHMAP_DEFINE_POD skips eq_expr and compares keys bytewise.
+ */
+#define MARU_HASHMAP_DEFINE(name, key_type, val_type, hash_expr, eq_expr)                         \
+    MARU_UNUSED_FUNC static int name##_eq_cb_(const void *a, const void *b) {                     \
+        return eq_expr(*(key_type const*) a, *(key_type const*) b);                               \
+    }                                                                                             \
+    MARU_HASHMAP_DEFINE_IMPL_(name, key_type, val_type, hash_expr, name##_eq_cb_)
+
+/* Plain-old-data keys compared bytewise (integers, packed structs without padding) */
+#define MARU_HASHMAP_DEFINE_POD(name, key_type, val_type, hash_expr)                              \
+    MARU_HASHMAP_DEFINE_IMPL_(name, key_type, val_type, hash_expr, NULL)
+
+#define MARU_HASHMAP_DEFINE_IMPL_(name, key_type, val_type, hash_expr, eq_cb)                     \
+    typedef struct name { maru_hashmap_t base; } name##_t;                                        \
+                                                                                                  \
+    MARU_UNUSED_FUNC static uint64_t name##_hash_cb_(const void *k) {                             \
+        return hash_expr(*(key_type const*) k);                                                   \
+    }                                                                                             \
+                                                                                                  \
+    MARU_UNUSED_FUNC MARU_INLINE void name##_init(name##_t *m, const maru_allocator_t *alloc) {   \
+        maru_hashmap_init(&m->base, sizeof(key_type), sizeof(val_type),                           \
+                          name##_hash_cb_, eq_cb, alloc);                                         \
+    }                                                                                             \
+    MARU_UNUSED_FUNC MARU_INLINE void name##_destroy(name##_t *m) { maru_hashmap_destroy(&m->base); } \
+    MARU_UNUSED_FUNC MARU_INLINE void name##_clear(name##_t *m) { maru_hashmap_clear(&m->base); } \
+    MARU_UNUSED_FUNC MARU_INLINE size_t name##_count(const name##_t *m) { return m->base.count; } \
+                                                                                                  \
+    MARU_UNUSED_FUNC MARU_INLINE val_type *name##_find(const name##_t *m, key_type k) {           \
+        return (val_type*) maru_hashmap_find(&m->base, &k, hash_expr(k));                         \
+    }                                                                                             \
+    MARU_UNUSED_FUNC MARU_INLINE val_type name##_get(const name##_t *m, key_type k, val_type def) { \
+        val_type *v = name##_find(m, k);                                                          \
+        return v ? *v : def;                                                                      \
+    }                                                                                             \
+    MARU_UNUSED_FUNC MARU_INLINE int name##_put(name##_t *m, key_type k, val_type v) {            \
+        val_type *slot = (val_type*) maru_hashmap_insert(&m->base, &k, hash_expr(k), NULL);       \
+        if (!slot) return -1;                                                                     \
+        *slot = v;                                                                                \
+        return 0;                                                                                 \
+    }                                                                                             \
+    MARU_UNUSED_FUNC MARU_INLINE int name##_remove(name##_t *m, key_type k) {                     \
+        return maru_hashmap_erase(&m->base, &k, hash_expr(k));                                    \
+    }                                                                                             \
+    MARU_UNUSED_FUNC MARU_INLINE int name##_next(const name##_t *m, size_t *it, key_type *k, val_type *v) { \
+        void *pk, *pv;                                                                            \
+        if (!maru_hashmap_next(&m->base, it, &pk, &pv)) return 0;                                 \
+        if (k) *k = *(key_type*) pk;                                                              \
+        if (v) *v = *(val_type*) pv;                                                              \
+        return 1;                                                                                 \
+    }                                                                                             \
+    typedef int name##_semicolon_
+
+#define MARU_HASH_INT_(k)   maru_hash_mix64((uint64_t) (k))
+#define MARU_EQ_STR_(a, b)  (strcmp((a), (b)) == 0)
+
+/*
+ * Stock instances. String maps store the key pointer, not a copy: the string
+ * must outlive its entry.
+ */
+MARU_HASHMAP_DEFINE_POD(map_u32_u32, uint32_t, uint32_t, MARU_HASH_INT_);
+MARU_HASHMAP_DEFINE_POD(map_u64_ptr, uint64_t, void*, MARU_HASH_INT_);
+MARU_HASHMAP_DEFINE(map_str_u32, const char*, uint32_t, maru_hash_str, MARU_EQ_STR_);
+MARU_HASHMAP_DEFINE(map_str_ptr, const char*, void*, maru_hash_str, MARU_EQ_STR_);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_HASHMAP_H */
@@ -1,34 +1,36 @@
+
 #include "handle_pool.h"
+#include "handle_pool_layout.h"
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
 
 #include "mem/mem_diag.h"
+#include "mem/vm_arena.h"
+
+#define IDX_MASK  HANDLE_POOL_IDX_MASK
+#define GEN_SHIFT HANDLE_POOL_GEN_SHIFT
+#define FREE_END  ((uint32_t)0xFFFFFFFFu)
+
+/* How many handles ahead the batch paths prefetch slot metadata */
+#define PREFETCH_DIST 8
 
-typedef struct {
-    uint8_t gen;
-    uint8_t used;
-    uint32_t next;
-} slot_hdr_t;
-
-struct handle_pool {
-    size_t cap;
-    size_t obj_size;
-    size_t obj_align;
-    size_t stride;
-    size_t obj_off;
-    size_t alive;
-    uint32_t free_head;
-    uint8_t *blob;
-};
-
-#define IDX_MASK  ((uint32_t)0x00FFFFFFu)
-#define GEN_SHIFT (24u)
-
-#ifndef ALIGN_UP
-#define ALIGN_UP(_v,_a) ( ((_a) <= 1) ? (_v) : ( ((size_t)(_v) + ((size_t)(_a)-1)) & ~((size_t)(_a)-1) ) )
+/* handle_pool_create goes virtual from this payload size up */
+#ifndef HANDLE_POOL_VM_MIN_BYTES
+#define HANDLE_POOL_VM_MIN_BYTES ((size_t) 256 * 1024)
 #endif
 
+/* Commit step of a virtual pool's payload */
+#define VM_GROW_BYTES ((size_t) 64 * 1024)
+
+typedef struct handle_pool_vm {
+    vm_arena_t meta;
+    vm_arena_t data;
+    vm_arena_t dense;
+    uint32_t max_slots;
+    uint32_t grow_slots;
+} handle_pool_vm_t;
+
 static inline uint32_t get_handle_index(handle_t h) {
     return (h & IDX_MASK);
 }
@@ -37,12 +39,12 @@ static inline uint32_t get_handle_gen(handle_t h) {
     return (h >> GEN_SHIFT) & 0xFFu;
 }
 
-static inline slot_hdr_t *slot_hdr_at(const handle_pool_t *hp, uint32_t idx) {
-    return (slot_hdr_t*) (hp->blob + (hp->obj_size + sizeof(slot_hdr_t)) * (size_t) idx);
+static inline handle_pool_slot_t *slot_meta_at(const handle_pool_t *hp, uint32_t idx) {
+    return &hp->pages[idx >> hp->page_shift].meta[idx & hp->page_mask];
 }
 
 static inline void *slot_obj_at(const handle_pool_t *hp, uint32_t idx) {
-    return (void*) (hp->blob + (hp->obj_size + sizeof(slot_hdr_t)) * (size_t) idx + sizeof(slot_hdr_t));
+    return (void*) (hp->pages[idx >> hp->page_shift].data + hp->stride * (size_t) (idx & hp->page_mask));
 }
 
 static int safe_mul(size_t a, size_t b, size_t *out) {
@@ -65,88 +67,301 @@ static int safe_mul(size_t a, size_t b, size_t *out) {
     return 1;
 }
 
+/* Threads slots [from, to) of `page` onto the front of the free list, lowest index first. */
+static void link_free_range(handle_pool_t *hp, uint32_t page, uint32_t from, uint32_t to) {
+    uint32_t first = page << hp->page_shift;
+    handle_pool_slot_t *meta = hp->pages[page].meta;
 
-handle_pool_t *handle_pool_create(size_t capacity, size_t obj_size, size_t obj_align) {
-    if (capacity == 0 || obj_size == 0 || capacity > IDX_MASK) return NULL;
+    for (uint32_t s = from; s < to; ++s) {
+        meta[s].used = 0;
+        meta[s].link = (s + 1 < to) ? first + s + 1 : hp->free_head;
+    }
+
+#if defined(MARU_DEBUG)
+    memset(hp->pages[page].data + hp->stride * from, 0xDD, hp->stride * (to - from));
+#endif
+
+    if (from < to) hp->free_head = first + from;
+}
+
+static void page_link_free(handle_pool_t *hp, uint32_t page) {
+    link_free_range(hp, page, 0, hp->page_slots);
+}
+
+/*
+ * Extends a virtual pool's single page in place. Fresh pages read as zero,
+ * so a slot whose generation is still 0 has never been used; slots that
+ * come back after a trim keep theirs, and stale handles stay stale.
+ */
+static int grow_virtual(handle_pool_t *hp) {
+    handle_pool_vm_t *vm = hp->vm;
+    if (hp->cap >= vm->max_slots) return 0;
+
+    uint32_t from = (uint32_t) hp->cap;
+    uint32_t to = vm->max_slots - from > vm->grow_slots ? from + vm->grow_slots : vm->max_slots;
+
+    if (vm_arena_ensure(&vm->meta, sizeof(handle_pool_slot_t) * to) != 0 ||
+        vm_arena_ensure(&vm->data, hp->stride * to) != 0 ||
+        vm_arena_ensure(&vm->dense, sizeof(handle_t) * to) != 0) {
+        return 0;
+    }
+
+    handle_pool_slot_t *meta = hp->pages[0].meta;
+    for (uint32_t s = from; s < to; ++s) {
+        if (meta[s].gen == 0) meta[s].gen = 1;
+    }
 
-    handle_pool_t *hp = (handle_pool_t*) MARU_MALLOC(sizeof(*hp));
+    link_free_range(hp, 0, from, to);
+    hp->cap = to;
+    hp->page_slots = to;
+    return 1;
+}
+
+static int add_page(handle_pool_t *hp) {
+    if (hp->vm) return grow_virtual(hp);
+    if (hp->page_count >= hp->page_max) return 0;
+
+    if (hp->page_count == hp->page_table_cap) {
+        uint32_t new_cap = hp->page_table_cap ? hp->page_table_cap * 2 : 4;
+        if (new_cap > hp->page_max) new_cap = hp->page_max;
+
+        handle_pool_page_t *np = (handle_pool_page_t*) MARU_REALLOC_T(hp->mem_tag, hp->pages,
+                                                                      sizeof(handle_pool_page_t) * new_cap);
+        if (!np) return 0;
+        hp->pages = np;
+        hp->page_table_cap = new_cap;
+    }
+
+    size_t data_bytes = 0;
+    if (!safe_mul(hp->stride, hp->page_slots, &data_bytes)) return 0;
+
+    handle_t *dense = (handle_t*) MARU_REALLOC_T(hp->mem_tag, hp->dense, sizeof(handle_t) * (hp->cap + hp->page_slots));
+    if (!dense) return 0;
+    hp->dense = dense;
+
+    handle_pool_slot_t *meta = (handle_pool_slot_t*) MARU_MALLOC_T(hp->mem_tag, sizeof(handle_pool_slot_t) * hp->page_slots);
+    uint8_t *data = (uint8_t*) MARU_MALLOC_T(hp->mem_tag, data_bytes);
+    if (!meta || !data) {
+        MARU_FREE(meta);
+        MARU_FREE(data);
+        return 0;
+    }
+
+    uint32_t page = hp->page_count++;
+    hp->pages[page].meta = meta;
+    hp->pages[page].data = data;
+    hp->pages[page].alive = 0;
+
+    for (uint32_t s = 0; s < hp->page_slots; ++s) {
+        meta[s].gen = 1;
+    }
+
+    page_link_free(hp, page);
+    hp->cap += hp->page_slots;
+    return 1;
+}
+
+static handle_pool_t *pool_create(uint32_t page_slots, uint32_t page_shift, uint32_t page_max,
+                                  size_t obj_size, size_t obj_align, mem_tag_t tag) {
+    handle_pool_t *hp = (handle_pool_t*) MARU_CALLOC_T(tag, 1, sizeof(*hp));
     if (!hp) return NULL;
 
+    hp->mem_tag = tag;
+
     if (obj_align == 0) obj_align = 1;
 
-    size_t obj_off = ALIGN_UP(sizeof(slot_hdr_t), obj_align);
-    size_t slot_bytes = obj_off + obj_size;
-    size_t stride = ALIGN_UP(slot_bytes, obj_align);
+    hp->obj_size = obj_size;
+    hp->obj_align = obj_align;
+    hp->stride = ALIGN_UP(obj_size, obj_align);
+    hp->free_head = FREE_END;
+    hp->page_slots = page_slots;
+    hp->page_shift = page_shift;
+    hp->page_mask = (page_max == 1) ? IDX_MASK : (page_slots - 1);
+    hp->page_max = page_max;
+
+    if (!add_page(hp)) {
+        MARU_FREE(hp->dense);
+        MARU_FREE(hp->pages);
+        MARU_FREE(hp);
+        return NULL;
+    }
+
+    return hp;
+}
+
+static void pool_free_vm(handle_pool_vm_t *vm) {
+    vm_arena_destroy(&vm->meta);
+    vm_arena_destroy(&vm->data);
+    vm_arena_destroy(&vm->dense);
+    MARU_FREE(vm);
+}
+
+handle_pool_t *handle_pool_create_virtual(size_t max_capacity, size_t obj_size, size_t obj_align, mem_tag_t tag) {
+    if (max_capacity == 0 || obj_size == 0 || max_capacity > IDX_MASK) return NULL;
+    if (obj_align == 0) obj_align = 1;
 
-    size_t blob_bytes = 0;
-    if (!safe_mul(stride, capacity, &blob_bytes)) {
+    size_t stride = ALIGN_UP(obj_size, obj_align);
+    size_t data_bytes = 0;
+    if (!safe_mul(stride, max_capacity, &data_bytes)) return NULL;
+
+    handle_pool_t *hp = (handle_pool_t*) MARU_CALLOC_T(tag, 1, sizeof(*hp));
+    handle_pool_vm_t *vm = (handle_pool_vm_t*) MARU_CALLOC_T(tag, 1, sizeof(*vm));
+    handle_pool_page_t *pages = (handle_pool_page_t*) MARU_CALLOC_T(tag, 1, sizeof(*pages));
+    if (!hp || !vm || !pages) {
         MARU_FREE(hp);
+        MARU_FREE(vm);
+        MARU_FREE(pages);
         return NULL;
     }
 
-    hp->blob = (uint8_t*) MARU_MALLOC(blob_bytes);
-    if (!hp->blob) {
+    if (vm_arena_init(&vm->meta, sizeof(handle_pool_slot_t) * max_capacity, tag) != 0 ||
+        vm_arena_init(&vm->data, data_bytes, tag) != 0 ||
+        vm_arena_init(&vm->dense, sizeof(handle_t) * max_capacity, tag) != 0) {
+        pool_free_vm(vm);
+        MARU_FREE(pages);
         MARU_FREE(hp);
         return NULL;
     }
 
-    hp->cap = capacity;
+    /* payload is what foreach and batch lookups walk; big pools get huge pages */
+    vm_arena_set_huge_pages(&vm->data);
+
+    vm->max_slots = (uint32_t) max_capacity;
+    vm->grow_slots = (uint32_t) (VM_GROW_BYTES / stride);
+    if (vm->grow_slots < 64) vm->grow_slots = 64;
+
+    pages[0].meta = (handle_pool_slot_t*) vm->meta.base;
+    pages[0].data = vm->data.base;
+
+    hp->mem_tag = tag;
     hp->obj_size = obj_size;
     hp->obj_align = obj_align;
     hp->stride = stride;
-    hp->obj_off = obj_off;
-    hp->alive = 0;
+    hp->free_head = FREE_END;
+    hp->page_shift = GEN_SHIFT;
+    hp->page_mask = IDX_MASK;
+    hp->page_count = 1;
+    hp->page_max = 1;
+    hp->page_table_cap = 1;
+    hp->pages = pages;
+    hp->dense = (handle_t*) vm->dense.base;
+    hp->vm = vm;
+
+    if (!grow_virtual(hp)) {
+        handle_pool_destroy(hp);
+        return NULL;
+    }
 
-    for (uint32_t i = 0; i < (uint32_t) capacity; ++i) {
-        slot_hdr_t *h = slot_hdr_at(hp, i);
-        h->gen = 1;
-        h->used = 0;
-        h->next = i + 1;
-#if defined(MARU_DEBUG)
-        memset(slot_obj_at(hp, i), 0xDD, obj_size);
-#endif
+    return hp;
+}
+
+handle_pool_t *handle_pool_create(size_t capacity, size_t obj_size, size_t obj_align) {
+    if (capacity == 0 || obj_size == 0 || capacity > IDX_MASK) return NULL;
+
+    size_t bytes = 0;
+    if (safe_mul(capacity, obj_size, &bytes) && bytes >= HANDLE_POOL_VM_MIN_BYTES) {
+        handle_pool_t *hp = handle_pool_create_virtual(capacity, obj_size, obj_align, MEM_TAG_CORE);
+        if (hp) return hp;
     }
+    return pool_create((uint32_t) capacity, GEN_SHIFT, 1, obj_size, obj_align, MEM_TAG_CORE);
+}
 
-    slot_hdr_at(hp, (uint32_t) capacity - 1)->next = (uint32_t) capacity; /* end sentinel */
-    hp->free_head = 0;
+handle_pool_t *handle_pool_create_paged(size_t page_capacity, size_t max_pages, size_t obj_size, size_t obj_align) {
+    return handle_pool_create_paged_tagged(page_capacity, max_pages, obj_size, obj_align, MEM_TAG_CORE);
+}
 
-    return hp;
+handle_pool_t *handle_pool_create_paged_tagged(size_t page_capacity, size_t max_pages, size_t obj_size,
+                                               size_t obj_align, mem_tag_t tag) {
+    if (page_capacity == 0 || obj_size == 0 || page_capacity > IDX_MASK) return NULL;
+
+    uint32_t shift = 0;
+    while (((size_t) 1 << shift) < page_capacity) ++shift;
+
+    size_t limit = ((size_t) IDX_MASK + 1) >> shift;
+    if (max_pages == 0 || max_pages > limit) max_pages = limit;
+
+    return pool_create((uint32_t) 1 << shift, shift, (uint32_t) max_pages, obj_size, obj_align, tag);
 }
 
 void handle_pool_destroy(handle_pool_t *hp) {
     if (!hp) return;
-    MARU_FREE(hp->blob);
+    if (hp->vm) {
+        pool_free_vm(hp->vm);
+        MARU_FREE(hp->pages);
+        MARU_FREE(hp);
+        return;
+    }
+
+    for (uint32_t p = 0; p < hp->page_count; ++p) {
+        MARU_FREE(hp->pages[p].meta);
+        MARU_FREE(hp->pages[p].data);
+    }
+    MARU_FREE(hp->pages);
+    MARU_FREE(hp->dense);
     MARU_FREE(hp);
 }
 
 void handle_pool_reset(handle_pool_t *hp) {
     if (!hp) return;
-    for (uint32_t i = 0; i < (uint32_t) hp->cap; ++i) {
-        slot_hdr_t *h = slot_hdr_at(hp, i);
-        h->used = 0;
-        h->next = i + 1;
-        h->gen = (uint8_t) (h->gen + 1);
-        if (h->gen == 0) {
-            h->gen = 1;
+
+    hp->free_head = FREE_END;
+    for (uint32_t p = hp->page_count; p-- > 0;) {
+        handle_pool_slot_t *meta = hp->pages[p].meta;
+        for (uint32_t s = 0; s < hp->page_slots; ++s) {
+            meta[s].gen = (uint8_t) (meta[s].gen + 1);
+            if (meta[s].gen == 0) {
+                meta[s].gen = 1;
+            }
         }
 
-#if defined(MARU_DEBUG)
-        memset(slot_obj_at(hp, i), 0xDD, hp->obj_size);
-#endif
+        page_link_free(hp, p);
+        hp->pages[p].alive = 0;
     }
 
-    ((slot_hdr_t*) slot_hdr_at(hp, (uint32_t) hp->cap - 1))->next = (uint32_t) hp->cap;
-    hp->free_head = 0;
     hp->alive = 0;
 }
 
+void handle_pool_trim(handle_pool_t *hp) {
+    if (!hp || !hp->vm) return;
+
+    handle_pool_vm_t *vm = hp->vm;
+    uint32_t top = 0;
+    for (size_t i = 0; i < hp->alive; ++i) {
+        uint32_t idx = get_handle_index(hp->dense[i]);
+        if (idx + 1 > top) top = idx + 1;
+    }
+
+    /* keep whole grow steps so the next alloc doesn't recommit at once */
+    uint32_t keep = ((top + vm->grow_slots - 1) / vm->grow_slots) * vm->grow_slots;
+    if (keep < vm->grow_slots) keep = vm->grow_slots;
+    if (keep >= hp->cap) return;
+
+    /* metadata stays committed: it carries the generations */
+    vm_arena_trim(&vm->data, hp->stride * keep);
+    vm_arena_trim(&vm->dense, sizeof(handle_t) * keep);
+
+    /* relink the free slots that remain, lowest index first */
+    handle_pool_slot_t *meta = hp->pages[0].meta;
+    hp->free_head = FREE_END;
+    for (uint32_t s = keep; s-- > 0;) {
+        if (meta[s].used) continue;
+        meta[s].link = hp->free_head;
+        hp->free_head = s;
+    }
+
+    hp->cap = keep;
+    hp->page_slots = keep;
+}
+
 handle_t handle_pool_alloc(handle_pool_t *hp, const void *init_data) {
-    if (!hp || hp->free_head >= hp->cap) return HANDLE_INVALID;
+    if (!hp) return HANDLE_INVALID;
+    if (hp->free_head == FREE_END && !add_page(hp)) return HANDLE_INVALID;
+
     uint32_t idx = hp->free_head;
-    slot_hdr_t *h = slot_hdr_at(hp, idx);
-    hp->free_head = h->next;
+    handle_pool_slot_t *m = slot_meta_at(hp, idx);
+    hp->free_head = m->link;
 
-    h->used = 1;
+    m->used = 1;
     void *obj = slot_obj_at(hp, idx);
     if (init_data) {
         memcpy(obj, init_data, hp->obj_size);
@@ -154,32 +369,35 @@ handle_t handle_pool_alloc(handle_pool_t *hp, const void *init_data) {
         memset(obj, 0, hp->obj_size);
     }
 
-    ++hp->alive;
-    handle_t ret = make_handle(idx, h->gen);
+    handle_t ret = make_handle(idx, m->gen);
     if (ret == HANDLE_INVALID) {
-        h->gen = (uint8_t) (h->gen + 1);
-        if (h->gen == 0) {
-            h->gen = 1;
+        m->gen = (uint8_t) (m->gen + 1);
+        if (m->gen == 0) {
+            m->gen = 1;
         }
 
-        ret = make_handle(idx, h->gen);
+        ret = make_handle(idx, m->gen);
     }
 
+    m->link = (uint32_t) hp->alive;
+    hp->dense[hp->alive++] = ret;
+    ++hp->pages[idx >> hp->page_shift].alive;
+
     return ret;
 }
 
-static inline int validate(const handle_pool_t *hp, handle_t h, uint32_t *out_idx, slot_hdr_t **out_hdr) {
+static inline int validate(const handle_pool_t *hp, handle_t h, uint32_t *out_idx, handle_pool_slot_t **out_meta) {
     if (!hp || h == HANDLE_INVALID) return 0;
     uint32_t idx = get_handle_index(h);
     uint32_t gen = get_handle_gen(h);
 
     if (idx >= hp->cap) return 0;
-    slot_hdr_t *hdr = slot_hdr_at(hp, idx);
+    handle_pool_slot_t *m = slot_meta_at(hp, idx);
 
-    if (!hdr->used) return 0;
-    if (hdr->gen != (uint8_t) gen) return 0;
+    if (!m->used) return 0;
+    if (m->gen != (uint8_t) gen) return 0;
     if (out_idx) *out_idx = idx;
-    if (out_hdr) *out_hdr = hdr;
+    if (out_meta) *out_meta = m;
     return 1;
 }
 
@@ -197,28 +415,150 @@ const void *handle_pool_get_const(const handle_pool_t *hp, handle_t h) {
 
 void handle_pool_free(handle_pool_t *hp, handle_t h) {
     uint32_t idx;
-    const slot_hdr_t *chdr;
-    if (!validate(hp, h, &idx, &chdr)) return;
+    handle_pool_slot_t *m;
+    if (!validate(hp, h, &idx, &m)) return;
+
+    /* swap-remove from the dense array */
+    uint32_t pos = m->link;
+    handle_t last = hp->dense[--hp->alive];
+    if (pos != (uint32_t) hp->alive) {
+        hp->dense[pos] = last;
+        slot_meta_at(hp, get_handle_index(last))->link = pos;
+    }
 
-    slot_hdr_t *hdr = (slot_hdr_t*) chdr;
-    hdr->used = 0;
-    hdr->gen = (uint8_t) (hdr->gen + 1);
-    if (hdr->gen == 0) hdr->gen = 1;
+    m->used = 0;
+    m->gen = (uint8_t) (m->gen + 1);
+    if (m->gen == 0) m->gen = 1;
 
-    hdr->next = hp->free_head;
+    m->link = hp->free_head;
     hp->free_head = idx;
 
-    if (hp->alive) --hp->alive;
+    handle_pool_page_t *pg = &hp->pages[idx >> hp->page_shift];
+    if (pg->alive) --pg->alive;
+}
+
+static inline void prefetch_meta(const handle_pool_t *hp, handle_t h) {
+    uint32_t idx = get_handle_index(h);
+    if (idx < hp->cap) MARU_PREFETCH(slot_meta_at(hp, idx));
+}
+
+size_t handle_pool_get_many(handle_pool_t *hp, const handle_t *handles, size_t n, void **out) {
+    if (!out) return 0;
+    if (!hp || !handles) {
+        for (size_t i = 0; i < n; ++i) out[i] = NULL;
+        return 0;
+    }
+
+    size_t warm = n < PREFETCH_DIST ? n : PREFETCH_DIST;
+    for (size_t i = 0; i < warm; ++i) {
+        prefetch_meta(hp, handles[i]);
+    }
+
+    size_t resolved = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i + PREFETCH_DIST < n) prefetch_meta(hp, handles[i + PREFETCH_DIST]);
+
+        uint32_t idx;
+        if (validate(hp, handles[i], &idx, NULL)) {
+            void *obj = slot_obj_at(hp, idx);
+            MARU_PREFETCH(obj);
+            out[i] = obj;
+            ++resolved;
+        } else {
+            out[i] = NULL;
+        }
+    }
+
+    return resolved;
 }
 
-size_t handle_pool_capacity(handle_pool_t *hp) {
+size_t handle_pool_alloc_n(handle_pool_t *hp, size_t n, handle_t *out) {
+    if (!hp || !out) return 0;
+
+    /*
+     * Grow once up front instead of interleaving page adds with allocs.
+     * Virtual pools grow in place as they go, which keeps low slots first.
+     */
+    while (!hp->vm && hp->cap - hp->alive < n && add_page(hp)) {}
+
+    size_t i = 0;
+    for (; i < n; ++i) {
+        out[i] = handle_pool_alloc(hp, NULL);
+        if (out[i] == HANDLE_INVALID) break;
+    }
+
+    for (size_t j = i; j < n; ++j) out[j] = HANDLE_INVALID;
+    return i;
+}
+
+void handle_pool_free_n(handle_pool_t *hp, const handle_t *handles, size_t n) {
+    if (!hp || !handles) return;
+
+    size_t warm = n < PREFETCH_DIST ? n : PREFETCH_DIST;
+    for (size_t i = 0; i < warm; ++i) {
+        prefetch_meta(hp, handles[i]);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (i + PREFETCH_DIST < n) prefetch_meta(hp, handles[i + PREFETCH_DIST]);
+        handle_pool_free(hp, handles[i]);
+    }
+}
+
+void handle_pool_foreach(handle_pool_t *hp, handle_pool_foreach_fn fn, void *user) {
+    if (!hp || !fn) return;
+
+    for (size_t i = hp->alive; i-- > 0;) {
+        handle_t h = hp->dense[i];
+        fn(h, slot_obj_at(hp, get_handle_index(h)), user);
+    }
+}
+
+const handle_t *handle_pool_dense_view(const handle_pool_t *hp, size_t *out_count) {
+    if (out_count) *out_count = hp ? hp->alive : 0;
+    return hp ? hp->dense : NULL;
+}
+
+size_t handle_pool_capacity(const handle_pool_t *hp) {
     return hp ? hp->cap : 0;
 }
 
-size_t handle_pool_alive_count(handle_pool_t *hp) {
+size_t handle_pool_alive_count(const handle_pool_t *hp) {
     return hp ? hp->alive : 0;
 }
 
+size_t handle_pool_page_count(const handle_pool_t *hp) {
+    return hp ? hp->page_count : 0;
+}
+
+size_t handle_pool_page_alive(const handle_pool_t *hp, size_t page) {
+    if (!hp || page >= hp->page_count) return 0;
+    return hp->pages[page].alive;
+}
+
+void handle_pool_get_stats(const handle_pool_t *hp, handle_pool_stats_t *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!hp) return;
+
+    out->page_count = hp->page_count;
+    out->page_capacity = hp->page_slots;
+    out->capacity = hp->cap;
+    out->alive = hp->alive;
+    if (hp->vm) {
+        out->bytes_reserved = vm_arena_committed(&hp->vm->meta) + vm_arena_committed(&hp->vm->data)
+                              + vm_arena_committed(&hp->vm->dense);
+    } else {
+        out->bytes_reserved = (hp->stride + sizeof(handle_pool_slot_t)) * hp->page_slots * hp->page_count
+                              + sizeof(handle_t) * hp->cap;
+    }
+
+    for (uint32_t p = 0; p < hp->page_count; ++p) {
+        if (hp->pages[p].alive == 0) ++out->empty_pages;
+        else if (hp->pages[p].alive == hp->page_slots) ++out->full_pages;
+    }
+}
+
 handle_t make_handle(uint32_t idx, uint8_t gen) {
     handle_t v = (((handle_t)gen) << GEN_SHIFT) | (idx & IDX_MASK);
     if (v == HANDLE_INVALID) {
@@ -226,4 +566,4 @@ handle_t make_handle(uint32_t idx, uint8_t gen) {
     }
 
     return v;
-}
\ No newline at end of file
+}
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "mem/mem_diag.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -13,7 +15,44 @@ typedef uint32_t handle_t;
 
 typedef struct handle_pool handle_pool_t;
 
+typedef struct handle_pool_stats {
+    size_t page_count;
+    size_t page_capacity;   /* slots per page */
+    size_t capacity;        /* slots across all allocated pages */
+    size_t alive;
+    size_t empty_pages;     /* pages with no live object */
+    size_t full_pages;      /* pages with every slot in use */
+    size_t bytes_reserved;  /* payload + header bytes held by pages; committed bytes if virtual */
+} handle_pool_stats_t;
+
+/*
+ * Fixed pool: one page of `capacity` slots, alloc fails once it is full.
+ * Pools of HANDLE_POOL_VM_MIN_BYTES or more are created virtual, so
+ * capacity() reports the slots committed so far.
+ */
 handle_pool_t *handle_pool_create(size_t capacity, size_t obj_size, size_t obj_align);
+
+/*
+ * Virtual pool: reserves address space for `max_capacity` slots and commits
+ * it in 64 KB steps as slots are first needed (see vm_arena.h). Objects
+ * never move; alloc fails once max_capacity is reached. Past one huge page
+ * of payload it commits whole huge pages where available. handle_pool_trim
+ * decommits payload past the highest live slot.
+ */
+handle_pool_t *handle_pool_create_virtual(size_t max_capacity, size_t obj_size, size_t obj_align, mem_tag_t tag);
+void handle_pool_trim(handle_pool_t *hp);
+
+/*
+ * Paged pool: starts with one page and adds pages of `page_capacity` slots
+ * (rounded up to a power of two) on demand. Pages are never moved or freed
+ * before destroy, so pointers returned by get stay valid while the handle is.
+ * max_pages = 0 means "as many as the handle index space allows".
+ */
+handle_pool_t *handle_pool_create_paged(size_t page_capacity, size_t max_pages, size_t obj_size, size_t obj_align);
+
+/* Same, with page memory counted under `tag` instead of MEM_TAG_CORE */
+handle_pool_t *handle_pool_create_paged_tagged(size_t page_capacity, size_t max_pages, size_t obj_size,
+                                               size_t obj_align, mem_tag_t tag);
 void handle_pool_destroy(handle_pool_t *hp);
 
 void handle_pool_reset(handle_pool_t *hp);
@@ -25,9 +64,36 @@ const void *handle_pool_get_const(const handle_pool_t *hp, handle_t h);
 
 void handle_pool_free(handle_pool_t *hp, handle_t h);
 
+/*
+ * Batch variants. get_many validates handles[i] into out[i] (NULL when stale),
+ * prefetching slot metadata a few handles ahead and each resolved payload, so
+ * the caller's first touch of out[i] is usually a cache hit. Returns how many
+ * resolved. alloc_n zero-fills and returns how many were allocated (the rest
+ * of `out` is HANDLE_INVALID). free_n ignores invalid handles.
+ */
+size_t handle_pool_get_many(handle_pool_t *hp, const handle_t *handles, size_t n, void **out);
+size_t handle_pool_alloc_n(handle_pool_t *hp, size_t n, handle_t *out);
+void handle_pool_free_n(handle_pool_t *hp, const handle_t *handles, size_t n);
+
 size_t handle_pool_capacity(const handle_pool_t *hp);
 size_t handle_pool_alive_count(const handle_pool_t *hp);
 
+/* Page-level occupancy */
+size_t handle_pool_page_count(const handle_pool_t *hp);
+size_t handle_pool_page_alive(const handle_pool_t *hp, size_t page);
+void handle_pool_get_stats(const handle_pool_t *hp, handle_pool_stats_t *out);
+
+/*
+ * Dense iteration over live objects only. The dense array is a packed list of
+ * live handles (sparse-set); it is reordered by free, so views are invalidated
+ * by alloc/free. foreach walks it back to front, so `fn` may free the handle it
+ * is visiting but must not free others.
+ */
+typedef void (*handle_pool_foreach_fn)(handle_t h, void *obj, void *user);
+
+void handle_pool_foreach(handle_pool_t *hp, handle_pool_foreach_fn fn, void *user);
+const handle_t *handle_pool_dense_view(const handle_pool_t *hp, size_t *out_count);
+
 handle_t make_handle(uint32_t idx, uint8_t gen);
 
 
@@ -0,0 +1,86 @@
+#ifndef MARU_HANDLE_POOL_LAYOUT_H
+#define MARU_HANDLE_POOL_LAYOUT_H
+
+/*
+ * handle_pool_t memory layout. Exposed only so lookups can be inlined
+ * (typed_pool.h); everything else should go through handle_pool.h.
+ */
+
+#include "handle_pool.h"
+#include "macro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HANDLE_POOL_IDX_MASK  ((uint32_t)0x00FFFFFFu)
+#define HANDLE_POOL_GEN_SHIFT (24u)
+
+/*
+ * Slot metadata lives in its own array, apart from the payload, so validating
+ * a handle only touches an 8-byte record. `link` is the next free index while
+ * the slot is free and the slot's position in the dense array while it is used.
+ */
+typedef struct {
+    uint32_t link;
+    uint8_t gen;
+    uint8_t used;
+} handle_pool_slot_t;
+
+typedef struct {
+    handle_pool_slot_t *meta;
+    uint8_t *data;
+    uint32_t alive;
+} handle_pool_page_t;
+
+struct handle_pool {
+    size_t cap;
+    size_t obj_size;
+    size_t obj_align;
+    size_t stride;
+    size_t alive;
+    uint32_t free_head;
+
+    /*
+     * idx -> (page, slot). Fixed and virtual pools use a single page with
+     * page_shift = GEN_SHIFT; a virtual pool's page_slots grows with cap.
+     */
+    uint32_t page_shift;
+    uint32_t page_mask;
+    uint32_t page_slots;
+    uint32_t page_count;
+    uint32_t page_max;
+    uint32_t page_table_cap;
+    handle_pool_page_t *pages;
+
+    /* Packed live handles, alive entries long */
+    handle_t *dense;
+
+    /* Virtual pools: one page grown in place from reserved ranges, else NULL */
+    struct handle_pool_vm *vm;
+
+    mem_tag_t mem_tag;
+};
+
+/*
+ * Validating lookup. `stride` must equal the pool's stride; passing a
+ * compile-time constant (sizeof of the stored type) lets the multiply fold.
+ * HANDLE_INVALID never matches since live generations are never 0.
+ */
+MARU_INLINE void *handle_pool_lookup(const handle_pool_t *hp, handle_t h, size_t stride) {
+    uint32_t idx = h & HANDLE_POOL_IDX_MASK;
+    if (UNLIKELY(!hp || idx >= hp->cap)) return NULL;
+
+    const handle_pool_page_t *pg = &hp->pages[idx >> hp->page_shift];
+    uint32_t slot = idx & hp->page_mask;
+    const handle_pool_slot_t *m = &pg->meta[slot];
+    if (UNLIKELY(!m->used || m->gen != (uint8_t) (h >> HANDLE_POOL_GEN_SHIFT))) return NULL;
+
+    return (void*) (pg->data + stride * (size_t) slot);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_HANDLE_POOL_LAYOUT_H */
@@ -0,0 +1,149 @@
+
+#include "handle_pool_mt.h"
+#include <string.h>
+
+#include "mem/mem_diag.h"
+#include "thread/atomic.h"
+
+#define IDX_MASK   ((uint32_t)0x00FFFFFFu)
+#define GEN_SHIFT  (24u)
+#define FREE_END   ((uint32_t)0xFFFFFFFFu)
+
+/* state word: generation in the low byte, STATE_USED once the object is published */
+#define STATE_GEN(_s) ((uint8_t) ((_s) & 0xFFu))
+#define STATE_USED    (0x100u)
+
+#define CACHE_LINE (64)
+
+struct handle_pool_mt {
+    /* Free-list head: high 32 bits are a tag bumped on every push/pop (ABA guard), low 32 bits the index */
+    maru_atomic_u64_t head;
+    uint8_t pad0_[CACHE_LINE - sizeof(maru_atomic_u64_t)];
+
+    maru_atomic_u32_t alive;
+    uint8_t pad1_[CACHE_LINE - sizeof(maru_atomic_u32_t)];
+
+    size_t cap;
+    size_t obj_size;
+    size_t stride;
+
+    maru_atomic_u32_t *state;
+    maru_atomic_u32_t *next;
+    uint8_t *data;
+};
+
+static inline void *obj_at(const handle_pool_mt_t *hp, uint32_t idx) {
+    return (void*) (hp->data + hp->stride * (size_t) idx);
+}
+
+static inline uint64_t make_head(uint64_t prev, uint32_t idx) {
+    return (((prev >> 32) + 1) << 32) | (uint64_t) idx;
+}
+
+handle_pool_mt_t *handle_pool_mt_create(size_t capacity, size_t obj_size, size_t obj_align) {
+    if (capacity == 0 || obj_size == 0 || capacity > IDX_MASK) return NULL;
+    if (obj_align == 0) obj_align = 1;
+
+    handle_pool_mt_t *hp = (handle_pool_mt_t*) MARU_CALLOC_T(MEM_TAG_CORE, 1, sizeof(*hp));
+    if (!hp) return NULL;
+
+    hp->cap = capacity;
+    hp->obj_size = obj_size;
+    hp->stride = ALIGN_UP(obj_size, obj_align);
+
+    hp->state = (maru_atomic_u32_t*) MARU_MALLOC_T(MEM_TAG_CORE, sizeof(maru_atomic_u32_t) * capacity);
+    hp->next = (maru_atomic_u32_t*) MARU_MALLOC_T(MEM_TAG_CORE, sizeof(maru_atomic_u32_t) * capacity);
+    hp->data = (uint8_t*) MARU_MALLOC_T(MEM_TAG_CORE, hp->stride * capacity);
+    if (!hp->state || !hp->next || !hp->data) {
+        handle_pool_mt_destroy(hp);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < (uint32_t) capacity; ++i) {
+        hp->state[i].v = 1; /* gen 1, free */
+        hp->next[i].v = (i + 1 < (uint32_t) capacity) ? i + 1 : FREE_END;
+    }
+
+    maru_atomic_store_u64(&hp->head, 0, MARU_MO_RELEASE);
+    return hp;
+}
+
+void handle_pool_mt_destroy(handle_pool_mt_t *hp) {
+    if (!hp) return;
+    MARU_FREE(hp->state);
+    MARU_FREE(hp->next);
+    MARU_FREE(hp->data);
+    MARU_FREE(hp);
+}
+
+handle_t handle_pool_mt_alloc(handle_pool_mt_t *hp, const void *init_data) {
+    if (!hp) return HANDLE_INVALID;
+
+    uint64_t head = maru_atomic_load_u64(&hp->head, MARU_MO_ACQUIRE);
+    uint32_t idx;
+    for (;;) {
+        idx = (uint32_t) head;
+        if (idx == FREE_END) return HANDLE_INVALID;
+
+        /* May read a stale link if idx was popped meanwhile; the tag makes that CAS fail. */
+        uint32_t next = maru_atomic_load_u32(&hp->next[idx], MARU_MO_RELAXED);
+        if (maru_atomic_cas_u64(&hp->head, &head, make_head(head, next), MARU_MO_ACQUIRE)) break;
+    }
+
+    void *obj = obj_at(hp, idx);
+    if (init_data) {
+        memcpy(obj, init_data, hp->obj_size);
+    } else {
+        memset(obj, 0, hp->obj_size);
+    }
+
+    /* Publish: a get that sees STATE_USED also sees the initialized payload */
+    uint8_t gen = STATE_GEN(maru_atomic_load_u32(&hp->state[idx], MARU_MO_RELAXED));
+    maru_atomic_store_u32(&hp->state[idx], (uint32_t) gen | STATE_USED, MARU_MO_RELEASE);
+    maru_atomic_fetch_add_u32(&hp->alive, 1, MARU_MO_RELAXED);
+
+    return make_handle(idx, gen);
+}
+
+void *handle_pool_mt_get(handle_pool_mt_t *hp, handle_t h) {
+    if (!hp || h == HANDLE_INVALID) return NULL;
+
+    uint32_t idx = h & IDX_MASK;
+    if (idx >= hp->cap) return NULL;
+
+    uint32_t s = maru_atomic_load_u32(&hp->state[idx], MARU_MO_ACQUIRE);
+    if (!(s & STATE_USED) || STATE_GEN(s) != (uint8_t) (h >> GEN_SHIFT)) return NULL;
+
+    return obj_at(hp, idx);
+}
+
+int handle_pool_mt_free(handle_pool_mt_t *hp, handle_t h) {
+    if (!hp || h == HANDLE_INVALID) return 0;
+
+    uint32_t idx = h & IDX_MASK;
+    if (idx >= hp->cap) return 0;
+
+    /* Retire the generation first; of several racing frees exactly one wins the CAS. */
+    uint8_t gen = (uint8_t) (h >> GEN_SHIFT);
+    uint8_t next_gen = (uint8_t) (gen + 1);
+    if (next_gen == 0) next_gen = 1;
+
+    uint32_t expected = (uint32_t) gen | STATE_USED;
+    if (!maru_atomic_cas_u32(&hp->state[idx], &expected, next_gen, MARU_MO_ACQ_REL)) return 0;
+
+    uint64_t head = maru_atomic_load_u64(&hp->head, MARU_MO_RELAXED);
+    do {
+        maru_atomic_store_u32(&hp->next[idx], (uint32_t) head, MARU_MO_RELAXED);
+    } while (!maru_atomic_cas_u64(&hp->head, &head, make_head(head, idx), MARU_MO_RELEASE));
+
+    maru_atomic_fetch_add_u32(&hp->alive, (uint32_t) -1, MARU_MO_RELAXED);
+    return 1;
+}
+
+size_t handle_pool_mt_capacity(const handle_pool_mt_t *hp) {
+    return hp ? hp->cap : 0;
+}
+
+size_t handle_pool_mt_alive_count(const handle_pool_mt_t *hp) {
+    return hp ? maru_atomic_load_u32(&hp->alive, MARU_MO_RELAXED) : 0;
+}
@@ -0,0 +1,45 @@
+#ifndef MARU_HANDLE_POOL_MT_H
+#define MARU_HANDLE_POOL_MT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "handle_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Concurrent, fixed-capacity variant of handle_pool_t.
+ *
+ * alloc/free are lock-free (tagged free-list head, ABA-safe) and get is
+ * wait-free, so any thread may create or resolve objects while others do the
+ * same. Handles use the same index/generation encoding as handle_pool_t.
+ *
+ * The pool does not own object lifetimes across threads: a pointer returned by
+ * get stays valid only until some thread frees that handle. As with
+ * handle_pool_t the generation is 8 bits, so a stale handle is only detected
+ * until its slot has been reused 255 times. create/destroy must not race with
+ * any other call.
+ */
+typedef struct handle_pool_mt handle_pool_mt_t;
+
+handle_pool_mt_t *handle_pool_mt_create(size_t capacity, size_t obj_size, size_t obj_align);
+void handle_pool_mt_destroy(handle_pool_mt_t *hp);
+
+handle_t handle_pool_mt_alloc(handle_pool_mt_t *hp, const void *init_data);
+
+void *handle_pool_mt_get(handle_pool_mt_t *hp, handle_t h);
+
+/* Returns 1 if this call released the handle, 0 if it was stale or already freed. */
+int handle_pool_mt_free(handle_pool_mt_t *hp, handle_t h);
+
+size_t handle_pool_mt_capacity(const handle_pool_mt_t *hp);
+size_t handle_pool_mt_alive_count(const handle_pool_mt_t *hp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_HANDLE_POOL_MT_H */
@@ -0,0 +1,79 @@
+#ifndef MARU_TYPED_POOL_H
+#define MARU_TYPED_POOL_H
+
+/*
+ * Typed handle pool generator.
+ *
+ *   MARU_DEFINE_POOL(mesh, mesh_t)
+ *
+ * expands (at file scope, one per translation unit) to a private paged pool
+ * plus static inline accessors:
+ *
+ *   int       mesh_pool_init(size_t page_capacity);   0 / -1
+ *   void      mesh_pool_shutdown(void);               destroys the pool only
+ *   int       mesh_pool_ready(void);
+ *   handle_t  mesh_pool_alloc(const mesh_t *init);    NULL init zero-fills
+ *   mesh_t   *mesh_pool_get(handle_t h);              NULL on stale/invalid
+ *   void      mesh_pool_free(handle_t h);
+ *   size_t    mesh_pool_get_many(const handle_t *h, size_t n, mesh_t **out);
+ *   size_t    mesh_pool_alive(void);
+ *   void      mesh_pool_foreach(handle_pool_foreach_fn fn, void *user);
+ *
+ * MARU_DEFINE_POOL_TAGGED(name, type, tag) counts the pool's memory under a
+ * mem_diag tag (MARU_DEFINE_POOL uses MEM_TAG_CORE).
+ *
+ * get is the handle_pool_lookup fast path with the stride fixed to
+ * sizeof(type): bounds check, page index, generation compare.
+ */
+
+#include "handle_pool.h"
+#include "handle_pool_layout.h"
+#include "macro.h"
+
+#define MARU_DEFINE_POOL(name, type) MARU_DEFINE_POOL_TAGGED(name, type, MEM_TAG_CORE)
+
+#define MARU_DEFINE_POOL_TAGGED(name, type, tag)                                        \
+    static handle_pool_t *name##_pool_hp_ = NULL;                                       \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE int name##_pool_init(size_t page_capacity) {           \
+        if (name##_pool_hp_) return 0;                                                  \
+        name##_pool_hp_ = handle_pool_create_paged_tagged(page_capacity, 0, sizeof(type), \
+                                                          (size_t) MARU_ALIGNOF(type), (tag)); \
+        return name##_pool_hp_ ? 0 : -1;                                                \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE void name##_pool_shutdown(void) {                      \
+        handle_pool_destroy(name##_pool_hp_);                                           \
+        name##_pool_hp_ = NULL;                                                         \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE int name##_pool_ready(void) {                          \
+        return name##_pool_hp_ != NULL;                                                 \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE handle_t name##_pool_alloc(const type *init) {         \
+        return handle_pool_alloc(name##_pool_hp_, init);                                \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE type *name##_pool_get(handle_t h) {                    \
+        return (type*) handle_pool_lookup(name##_pool_hp_, h, sizeof(type));            \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE void name##_pool_free(handle_t h) {                    \
+        handle_pool_free(name##_pool_hp_, h);                                           \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE size_t name##_pool_get_many(const handle_t *h, size_t n, type **out) { \
+        return handle_pool_get_many(name##_pool_hp_, h, n, (void**) out);              \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE size_t name##_pool_alive(void) {                       \
+        return handle_pool_alive_count(name##_pool_hp_);                                \
+    }                                                                                   \
+                                                                                        \
+    MARU_UNUSED_FUNC MARU_INLINE void name##_pool_foreach(handle_pool_foreach_fn fn, void *user) { \
+        handle_pool_foreach(name##_pool_hp_, fn, user);                                 \
+    }                                                                                   \
+    typedef int name##_pool_semicolon_
+
+#endif /* MARU_TYPED_POOL_H */
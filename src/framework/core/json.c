@@ -13,24 +13,37 @@ struct json_value {
     cJSON *root;
 };
 
+/* Case-sensitive child lookup by a non-terminated key segment */
+static const cJSON *child_by_segment(const cJSON *obj, const char *seg, size_t len) {
+    if (!cJSON_IsObject((cJSON*) obj)) return NULL;
+
+    for (const cJSON *c = obj->child; c; c = c->next) {
+        if (c->string && strncmp(c->string, seg, len) == 0 && c->string[len] == '\0') {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+/* Walks "a.b.c" in place; empty segments are skipped like strtok did */
 static const cJSON *find_by_dotted(const cJSON *root, const char *dotted) {
     if (!root || !dotted) return NULL;
 
-    char *copy = strdup(dotted);
-    if (!copy) return NULL;
-
     const cJSON *cur = root;
-    char *tok = strtok(copy, ".");
-    while (tok) {
-        cur = cJSON_GetObjectItemCaseSensitive((cJSON*) cur, tok);
-        if (!cur) {
-            free(copy);
-            return NULL;
+    const char *p = dotted;
+    while (*p) {
+        const char *dot = strchr(p, '.');
+        size_t len = dot ? (size_t) (dot - p) : strlen(p);
+
+        if (len > 0) {
+            cur = child_by_segment(cur, p, len);
+            if (!cur) return NULL;
         }
-        tok = strtok(NULL, ".");
+
+        if (!dot) break;
+        p = dot + 1;
     }
 
-    free(copy);
     return cur;
 }
 
@@ -91,12 +104,31 @@ static void path_join(char *out, size_t out_sz, const char *dir, const char *nam
 }
 
 
+/* Route cJSON's own allocations through mem_diag so parsed trees count under MEM_TAG_JSON */
+static void *CJSON_CDECL json_malloc_hook(size_t sz) {
+    return MARU_MALLOC_T(MEM_TAG_JSON, sz);
+}
+
+static void CJSON_CDECL json_free_hook(void *p) {
+    MARU_FREE(p);
+}
+
+static void json_install_hooks(void) {
+    static int installed = 0;
+    if (installed) return;
+
+    cJSON_Hooks hooks = {json_malloc_hook, json_free_hook};
+    cJSON_InitHooks(&hooks);
+    installed = 1;
+}
+
 json_value_t *json_parse(const char *src) {
     if (!src) return NULL;
+    json_install_hooks();
     cJSON *r = cJSON_Parse(src);
     if (!r) return NULL;
 
-    json_value_t *v = (json_value_t*) malloc(sizeof(json_value_t));
+    json_value_t *v = (json_value_t*) MARU_MALLOC_T(MEM_TAG_JSON, sizeof(json_value_t));
     if (!v) {
         cJSON_Delete(r);
         return NULL;
@@ -124,7 +156,7 @@ static int json_merge_includes_for_file(cJSON *dst_root, const char *base_file_p
         size_t file_size = 0;
         if (fs_read_into(incpath, NULL, 0, &file_size, FALSE) != MARU_OK) continue;
 
-        char *buf = MARU_CALLOC(file_size + 1, sizeof(char));
+        char *buf = MARU_CALLOC_T(MEM_TAG_JSON, file_size + 1, sizeof(char));
         size_t sz = 0;
         if (fs_read_into(incpath, &buf, file_size + 1, &sz, TRUE) != MARU_OK) continue;
 
@@ -142,13 +174,14 @@ static int json_merge_includes_for_file(cJSON *dst_root, const char *base_file_p
 
 json_value_t *json_parse_file(const char *path) {
     if (!path) return NULL;
+    json_install_hooks();
 
     size_t file_size = 0;
     if (fs_read_into(path, NULL, 0, &file_size, FALSE) != MARU_OK || file_size == 0) {
         return NULL;
     }
 
-    char *buf = MARU_CALLOC(file_size + 1, sizeof(char));
+    char *buf = MARU_CALLOC_T(MEM_TAG_JSON, file_size + 1, sizeof(char));
     size_t sz = 0;
     if (fs_read_into(path, &buf, file_size + 1, &sz, TRUE) != MARU_OK) return NULL;
 
@@ -158,7 +191,7 @@ json_value_t *json_parse_file(const char *path) {
 
     json_merge_includes_for_file(r, path);
 
-    json_value_t *v = (json_value_t*) malloc(sizeof(json_value_t));
+    json_value_t *v = (json_value_t*) MARU_MALLOC_T(MEM_TAG_JSON, sizeof(json_value_t));
     if (!v) {
         cJSON_Delete(r);
         return NULL;
@@ -177,7 +210,7 @@ int json_deep_merge(json_value_t *dst, const json_value_t *src) {
 void json_free(json_value_t *v) {
     if (!v) return;
     if (v->root) cJSON_Delete(v->root);
-    free(v);
+    MARU_FREE(v);
 }
 
 const char *json_get_string(const json_value_t *v, const char *dotted_key, const char *defval) {
@@ -18,6 +18,19 @@ extern "C" {
 #define UNLIKELY(x) (x)
 #endif
 
+/* Read prefetch into all cache levels; a no-op where unsupported */
+#if defined(__GNUC__) || defined(__clang__)
+#define MARU_PREFETCH(p)   __builtin_prefetch((p), 0, 3)
+#define MARU_PREFETCH_W(p) __builtin_prefetch((p), 1, 3)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define MARU_PREFETCH(p)   _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#define MARU_PREFETCH_W(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define MARU_PREFETCH(p)   ((void)(p))
+#define MARU_PREFETCH_W(p) ((void)(p))
+#endif
+
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
 #define ALIGN_UP(x, align)   (((x) + ((align) - 1)) & ~((align) - 1))
@@ -37,6 +50,24 @@ extern "C" {
 #define MARU_UNUSED_FUNC
 #endif
 
+#if defined(_MSC_VER)
+#define MARU_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define MARU_THREAD_LOCAL __thread
+#else
+#define MARU_THREAD_LOCAL _Thread_local
+#endif
+
+/* Alignment of a type; _Alignof is C11 and MSVC only takes it under /std:c11 */
+#if defined(_MSC_VER)
+#define MARU_ALIGNOF(T) __alignof(T)
+#elif defined(__GNUC__) || defined(__clang__)
+#define MARU_ALIGNOF(T) __alignof__(T)
+#else
+#include <stddef.h>
+#define MARU_ALIGNOF(T) offsetof(struct { char c_; T t_; }, t_)
+#endif
+
 #define RETURN_IF_FAIL(cond, errcode) do { if (!(cond)) return (errcode); } while (0)
 #define GOTO_IF_FAIL(cond, label) do { if (!(cond)) goto label; } while (0)
 
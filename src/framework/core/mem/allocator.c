@@ -0,0 +1,76 @@
+#include "allocator.h"
+
+#include <stdint.h>
+
+#include "mem_diag.h"
+#include "mem_frame.h"
+#include "mem_scratch.h"
+
+/* What MARU_MALLOC already guarantees */
+#define NATURAL_ALIGN (sizeof(void*) * 2)
+
+/* user carries the mem_tag_t */
+static void *default_alloc(void *user, size_t size, size_t align) {
+    mem_tag_t tag = (mem_tag_t) (uintptr_t) user;
+    if (align <= NATURAL_ALIGN) {
+        return MARU_MALLOC_T(tag, size);
+    }
+
+    /* Over-aligned: stash the raw pointer just before the returned block */
+    uint8_t *raw = (uint8_t*) MARU_MALLOC_T(tag, size + align + sizeof(void*));
+    if (!raw) return NULL;
+
+    uintptr_t p = ((uintptr_t) raw + sizeof(void*) + align - 1) & ~(uintptr_t) (align - 1);
+    ((void**) p)[-1] = raw;
+    return (void*) p;
+}
+
+static void default_free(void *user, void *ptr, size_t size, size_t align) {
+    (void) user;
+    (void) size;
+    MARU_FREE(align <= NATURAL_ALIGN ? ptr : ((void**) ptr)[-1]);
+}
+
+static void *frame_alloc_cb(void *user, size_t size, size_t align) {
+    (void) user;
+    return frame_alloc(size, align);
+}
+
+#define TAGGED_(tag) {default_alloc, default_free, (void*) (uintptr_t) (tag)}
+
+static const maru_allocator_t s_tagged[MEM_TAG_COUNT] = {
+    TAGGED_(MEM_TAG_GENERAL),
+    TAGGED_(MEM_TAG_CORE),
+    TAGGED_(MEM_TAG_MESH),
+    TAGGED_(MEM_TAG_MATERIAL),
+    TAGGED_(MEM_TAG_TEXTURE_CPU),
+    TAGGED_(MEM_TAG_RENDERER),
+    TAGGED_(MEM_TAG_IMPORT),
+    TAGGED_(MEM_TAG_JSON),
+    TAGGED_(MEM_TAG_FRAME),
+    TAGGED_(MEM_TAG_ASSET),
+    TAGGED_(MEM_TAG_SCRATCH),
+};
+static void *scratch_alloc_cb(void *user, size_t size, size_t align) {
+    (void) user;
+    return scratch_alloc(size, align);
+}
+
+static const maru_allocator_t s_frame = {frame_alloc_cb, NULL, NULL};
+static const maru_allocator_t s_scratch = {scratch_alloc_cb, NULL, NULL};
+
+const maru_allocator_t *maru_default_allocator(void) {
+    return &s_tagged[MEM_TAG_GENERAL];
+}
+
+const maru_allocator_t *maru_tagged_allocator(mem_tag_t tag) {
+    return &s_tagged[((unsigned) tag < MEM_TAG_COUNT) ? tag : MEM_TAG_GENERAL];
+}
+
+const maru_allocator_t *maru_frame_allocator(void) {
+    return &s_frame;
+}
+
+const maru_allocator_t *maru_scratch_allocator(void) {
+    return &s_scratch;
+}
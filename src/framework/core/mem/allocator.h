@@ -0,0 +1,51 @@
+#ifndef MARU_ALLOCATOR_H
+#define MARU_ALLOCATOR_H
+
+#include <stddef.h>
+
+#include "mem_diag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pluggable allocator for containers and systems that should not hard-wire
+ * MARU_MALLOC. `free` receives the size and alignment passed to `alloc`, so
+ * backends need no per-block header; it may be NULL for arenas that are
+ * reset wholesale.
+ */
+typedef struct maru_allocator {
+    void *(*alloc)(void *user, size_t size, size_t align);
+    void (*free)(void *user, void *ptr, size_t size, size_t align);
+    void *user;
+} maru_allocator_t;
+
+/* MARU_MALLOC / MARU_FREE backed; honours any power-of-two alignment */
+const maru_allocator_t *maru_default_allocator(void);
+
+/* Same, counted under a mem_diag tag (default = MEM_TAG_GENERAL) */
+const maru_allocator_t *maru_tagged_allocator(mem_tag_t tag);
+
+/* frame_alloc backed; free is a no-op, memory dies with the frame buffer */
+const maru_allocator_t *maru_frame_allocator(void);
+
+/* scratch_alloc backed; free is a no-op, memory dies at the enclosing scratch_pop */
+const maru_allocator_t *maru_scratch_allocator(void);
+
+static inline void *maru_alloc(const maru_allocator_t *a, size_t size, size_t align) {
+    if (!a) a = maru_default_allocator();
+    return a->alloc(a->user, size, align);
+}
+
+static inline void maru_free(const maru_allocator_t *a, void *ptr, size_t size, size_t align) {
+    if (!ptr) return;
+    if (!a) a = maru_default_allocator();
+    if (a->free) a->free(a->user, ptr, size, align);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_ALLOCATOR_H */
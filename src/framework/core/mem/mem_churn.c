@@ -0,0 +1,218 @@
+#include "mem_churn.h"
+
+#ifdef MARU_ENABLE_MEM_DIAG
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+/*
+ * Per-site results, sorted by (file, line) for lookup. Kept in plain
+ * malloc memory like mem_diag's own tables, so the profiler never counts
+ * itself.
+ */
+static struct {
+    int enabled;
+    mem_snapshot_t *begin;
+    mem_churn_site_t *sites;
+    size_t count;
+    size_t cap;
+    mem_site_delta_t *deltas;
+    size_t delta_cap;
+    uint32_t frames;
+} g_churn;
+
+static int site_cmp(const char *file, int line, const mem_churn_site_t *s) {
+    if (file != s->file) return (uintptr_t) file < (uintptr_t) s->file ? -1 : 1;
+    if (line != s->line) return line < s->line ? -1 : 1;
+    return 0;
+}
+
+static mem_churn_site_t *site_get(const char *file, int line) {
+    size_t lo = 0, hi = g_churn.count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = site_cmp(file, line, &g_churn.sites[mid]);
+        if (c == 0) return &g_churn.sites[mid];
+        if (c < 0) hi = mid;
+        else lo = mid + 1;
+    }
+
+    if (g_churn.count == g_churn.cap) {
+        size_t cap = g_churn.cap ? g_churn.cap * 2 : 64;
+        mem_churn_site_t *n = (mem_churn_site_t*) realloc(g_churn.sites, sizeof(*n) * cap);
+        if (!n) return NULL;
+        g_churn.sites = n;
+        g_churn.cap = cap;
+    }
+
+    mem_churn_site_t *s = &g_churn.sites[lo];
+    memmove(s + 1, s, sizeof(*s) * (g_churn.count - lo));
+    memset(s, 0, sizeof(*s));
+    s->file = file;
+    s->line = line;
+    g_churn.count++;
+    return s;
+}
+
+static void churn_clear(void) {
+    mem_snapshot_free(g_churn.begin);
+    free(g_churn.sites);
+    free(g_churn.deltas);
+    memset(&g_churn, 0, sizeof(g_churn));
+}
+
+void mem_churn_enable(int on) {
+    if (on && !g_churn.enabled) churn_clear();
+    g_churn.enabled = on != 0;
+}
+
+int mem_churn_enabled(void) {
+    return g_churn.enabled;
+}
+
+void mem_churn_frame_begin(void) {
+    if (!g_churn.enabled) return;
+
+    mem_snapshot_free(g_churn.begin);
+    g_churn.begin = mem_snapshot();
+}
+
+uint64_t mem_churn_frame_end(void) {
+    if (!g_churn.enabled || !g_churn.begin) return 0;
+
+    mem_snapshot_t *end = mem_snapshot();
+    size_t need = mem_snapshot_site_count(end);
+    if (need > g_churn.delta_cap) {
+        mem_site_delta_t *d = (mem_site_delta_t*) realloc(g_churn.deltas, sizeof(*d) * need);
+        if (d) {
+            g_churn.deltas = d;
+            g_churn.delta_cap = need;
+        }
+    }
+
+    size_t n = mem_snapshot_diff(g_churn.begin, end, g_churn.deltas, g_churn.delta_cap);
+    if (n > g_churn.delta_cap) n = g_churn.delta_cap;
+
+    for (size_t i = 0; i < g_churn.count; ++i) g_churn.sites[i].last_count = 0;
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const mem_site_delta_t *d = &g_churn.deltas[i];
+        mem_churn_site_t *s = site_get(d->file, d->line);
+        total += d->count;
+        if (!s) continue;
+
+        s->frames++;
+        s->count += d->count;
+        s->bytes += d->bytes;
+        s->last_count = d->count;
+        if (d->count > s->max_count) s->max_count = d->count;
+    }
+
+    mem_snapshot_free(g_churn.begin);
+    mem_snapshot_free(end);
+    g_churn.begin = NULL;
+    g_churn.frames++;
+    return total;
+}
+
+uint32_t mem_churn_frames(void) {
+    return g_churn.frames;
+}
+
+static int churn_cmp_count_desc(const void *a, const void *b) {
+    const mem_churn_site_t *x = (const mem_churn_site_t*) a;
+    const mem_churn_site_t *y = (const mem_churn_site_t*) b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    if (x->bytes != y->bytes) return x->bytes < y->bytes ? 1 : -1;
+    return 0;
+}
+
+static int churn_cmp_last_desc(const void *a, const void *b) {
+    const mem_churn_site_t *x = (const mem_churn_site_t*) a;
+    const mem_churn_site_t *y = (const mem_churn_site_t*) b;
+    if (x->last_count != y->last_count) return x->last_count < y->last_count ? 1 : -1;
+    return churn_cmp_count_desc(a, b);
+}
+
+/* Sorted copy of the results; caller frees */
+static mem_churn_site_t *churn_sorted_by(int (*cmp)(const void*, const void*)) {
+    if (!g_churn.count) return NULL;
+
+    mem_churn_site_t *all = (mem_churn_site_t*) malloc(sizeof(*all) * g_churn.count);
+    if (!all) return NULL;
+    memcpy(all, g_churn.sites, sizeof(*all) * g_churn.count);
+    qsort(all, g_churn.count, sizeof(*all), cmp);
+    return all;
+}
+
+static mem_churn_site_t *churn_sorted(void) {
+    return churn_sorted_by(churn_cmp_count_desc);
+}
+
+size_t mem_churn_stats(mem_churn_site_t *out, size_t max) {
+    mem_churn_site_t *all = churn_sorted();
+    if (all && out) memcpy(out, all, sizeof(*all) * (g_churn.count < max ? g_churn.count : max));
+    free(all);
+    return g_churn.count;
+}
+
+size_t mem_churn_last_frame(mem_churn_site_t *out, size_t max) {
+    size_t n = 0;
+    for (size_t i = 0; i < g_churn.count; ++i) {
+        if (g_churn.sites[i].last_count) ++n;
+    }
+    if (!n || !out || !max) return n;
+
+    mem_churn_site_t *all = churn_sorted_by(churn_cmp_last_desc);
+    if (all) memcpy(out, all, sizeof(*all) * (n < max ? n : max));
+    free(all);
+    return n;
+}
+
+void mem_churn_dump(size_t top_n) {
+    mem_churn_site_t *all = churn_sorted();
+    size_t n = g_churn.count < top_n ? g_churn.count : top_n;
+
+    printf("[mem] churn over %u frames, %zu sites, top %zu by allocations:\n", g_churn.frames, g_churn.count, n);
+    for (size_t i = 0; all && i < n; ++i) {
+        const mem_churn_site_t *s = &all[i];
+        printf("  %8.2f allocs/frame (max %llu, last %llu) in %u frames, %12llu B total @ %s:%d\n",
+               g_churn.frames ? (double) s->count / g_churn.frames : 0.0,
+               (unsigned long long) s->max_count, (unsigned long long) s->last_count, s->frames,
+               (unsigned long long) s->bytes, s->file, s->line);
+    }
+    free(all);
+}
+
+int mem_churn_write_csv(const char *path, size_t top_n) {
+    if (!path) return -1;
+
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        ERROR("[mem] cannot write churn csv '%s'", path);
+        return -1;
+    }
+
+    mem_churn_site_t *all = churn_sorted();
+    size_t n = g_churn.count < top_n ? g_churn.count : top_n;
+
+    fprintf(f, "file,line,frames,allocs,bytes,allocs_per_frame,max_per_frame,last_frame\n");
+    for (size_t i = 0; all && i < n; ++i) {
+        const mem_churn_site_t *s = &all[i];
+        fprintf(f, "\"%s\",%d,%u,%llu,%llu,%.3f,%llu,%llu\n", s->file, s->line, s->frames,
+                (unsigned long long) s->count, (unsigned long long) s->bytes,
+                g_churn.frames ? (double) s->count / g_churn.frames : 0.0,
+                (unsigned long long) s->max_count, (unsigned long long) s->last_count);
+    }
+    free(all);
+
+    int rc = ferror(f) ? -1 : 0;
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+#endif /* MARU_ENABLE_MEM_DIAG */
@@ -0,0 +1,67 @@
+#ifndef MARU_MEM_CHURN_H
+#define MARU_MEM_CHURN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mem_diag.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Opt-in allocation churn profiler. While enabled, frame_begin/frame_end
+ * snapshot the call-site totals and fold the difference into per-site
+ * counters, so the sites that allocate every frame float to the top.
+ * Only what happens between the two calls is counted, on any thread; the
+ * profiler itself is driven from one thread (normally the main loop).
+ *
+ * Costs a merge of every call site per frame; leave it off in normal runs.
+ * Without MARU_ENABLE_MEM_DIAG everything here is a no-op.
+ */
+typedef struct mem_churn_site {
+    const char *file;
+    int line;
+    uint32_t frames;        /* profiled frames in which the site allocated */
+    uint64_t count;         /* allocations over all profiled frames */
+    uint64_t bytes;
+    uint64_t max_count;     /* most allocations in one frame */
+    uint64_t last_count;    /* allocations in the last profiled frame */
+} mem_churn_site_t;
+
+#ifdef MARU_ENABLE_MEM_DIAG
+/* Turning it on clears earlier results */
+void mem_churn_enable(int on);
+int mem_churn_enabled(void);
+
+void mem_churn_frame_begin(void);
+/* Returns the allocations made since frame_begin */
+uint64_t mem_churn_frame_end(void);
+uint32_t mem_churn_frames(void);
+
+/* Fills up to `max` sites, most allocations first; returns the number of sites seen */
+size_t mem_churn_stats(mem_churn_site_t *out, size_t max);
+/* Same for the sites that allocated in the last profiled frame, most there first; returns how many did */
+size_t mem_churn_last_frame(mem_churn_site_t *out, size_t max);
+void mem_churn_dump(size_t top_n);
+
+/* file,line,frames,allocs,bytes,allocs_per_frame,max_per_frame,last_frame; 0 or -1 */
+int mem_churn_write_csv(const char *path, size_t top_n);
+#else
+#define mem_churn_enable(on)              ((void) (on))
+#define mem_churn_enabled()               0
+#define mem_churn_frame_begin()           ((void) 0)
+static inline uint64_t mem_churn_frame_end(void) { return 0; }
+#define mem_churn_frames()                ((uint32_t) 0)
+#define mem_churn_stats(out, max)         ((void) (out), (void) (max), (size_t) 0)
+#define mem_churn_last_frame(out, max)    ((void) (out), (void) (max), (size_t) 0)
+#define mem_churn_dump(top_n)             ((void) (top_n))
+static inline int mem_churn_write_csv(const char *path, size_t top_n) { (void) path; (void) top_n; return -1; }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_MEM_CHURN_H */
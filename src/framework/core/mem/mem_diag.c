@@ -1,73 +1,627 @@
 #include "mem_diag.h"
 
+#include <stdio.h>
+#include <string.h>
+
+#include "container/hashmap.h"
+#include "thread/atomic.h"
+#include "log.h"
+
+/* Written once, before any allocation or by a backend with owns; read-only afterwards */
+static mem_backend_t g_backend;
+static maru_atomic_u32_t g_backend_used;
+
+static inline void backend_touch(void) {
+    if (!maru_atomic_load_u32(&g_backend_used, MARU_MO_RELAXED)) {
+        maru_atomic_store_u32(&g_backend_used, 1, MARU_MO_RELAXED);
+    }
+}
+
+/* Blocks from before a late install belong to libc */
+static inline int backend_foreign(const void *p) {
+    return g_backend.owns && p && !g_backend.owns(g_backend.user, p);
+}
+
+int mem_set_backend(const mem_backend_t *backend) {
+    if (maru_atomic_load_u32(&g_backend_used, MARU_MO_RELAXED) && (!backend || !backend->owns || g_backend.alloc)) {
+        ERROR("[mem] backend must be set before the first allocation");
+        return -1;
+    }
+    if (backend && (!backend->alloc || !backend->realloc || !backend->free)) return -1;
+
+    if (backend) {
+        g_backend = *backend;
+    } else {
+        memset(&g_backend, 0, sizeof(g_backend));
+    }
+    return 0;
+}
+
+void *mem_raw_alloc(size_t sz) {
+    backend_touch();
+    return g_backend.alloc ? g_backend.alloc(g_backend.user, sz) : malloc(sz);
+}
+
+void *mem_raw_calloc(size_t n, size_t sz) {
+    if (!g_backend.alloc) {
+        backend_touch();
+        return calloc(n, sz);
+    }
+    if (sz && n > (size_t) -1 / sz) return NULL;
+
+    void *p = mem_raw_alloc(n * sz);
+    if (p) memset(p, 0, n * sz);
+    return p;
+}
+
+void *mem_raw_realloc(void *p, size_t sz) {
+    backend_touch();
+    if (!g_backend.realloc || backend_foreign(p)) return realloc(p, sz);
+    return g_backend.realloc(g_backend.user, p, sz);
+}
+
+void mem_raw_free(void *p) {
+    if (g_backend.free && !backend_foreign(p)) {
+        g_backend.free(g_backend.user, p);
+    } else {
+        free(p);
+    }
+}
+
 #ifdef MARU_ENABLE_MEM_DIAG
 
-#include <stdio.h>
+/*
+ * Live allocations live in SHARD_COUNT hash maps keyed by pointer, each
+ * behind its own spinlock; the shard comes from the pointer hash, so alloc
+ * and free of one block always meet in the same shard and unrelated threads
+ * rarely contend. Each shard also keeps per file:line totals, merged on
+ * report.
+ *
+ * Per-tag counters are global atomics updated after the shard lock is
+ * dropped, so budget callbacks never run under a lock.
+ */
+#define SHARD_BITS  6
+#define SHARD_COUNT (1u << SHARD_BITS)
 
 typedef struct {
-    void *ptr;
     size_t size;
     const char *file;
     int line;
-} alloc_info_t;
+    mem_tag_t tag;
+} alloc_rec_t;
 
-static alloc_info_t g_allocs[8192];
-static int g_count = 0;
+typedef struct {
+    uintptr_t file;
+    uintptr_t line;
+} site_key_t;
 
-void *mem_alloc(size_t sz, const char *file, int line) {
-    void *p = malloc(sz);
-    if (p && g_count < (int) (sizeof(g_allocs) / sizeof(g_allocs[0]))) {
-        g_allocs[g_count++] = (alloc_info_t){p, sz, file, line};
+typedef struct {
+    size_t live_bytes;
+    size_t live_count;
+    uint64_t total_bytes;
+    uint64_t total_count;
+} site_val_t;
+
+#define SITE_HASH_(k) maru_hash_mix64((uint64_t) (k).file ^ ((uint64_t) (k).line << 48))
+
+MARU_HASHMAP_DEFINE_POD(alloc_map, uintptr_t, alloc_rec_t, MARU_HASH_INT_);
+MARU_HASHMAP_DEFINE_POD(site_map, site_key_t, site_val_t, SITE_HASH_);
+
+typedef struct {
+    maru_spinlock_t lock;
+    int ready;
+    alloc_map_t allocs;
+    site_map_t sites;
+    size_t live_bytes;
+    uint8_t pad_[MARU_CACHE_LINE];
+} shard_t;
+
+static shard_t g_shards[SHARD_COUNT];
+
+typedef struct {
+    maru_atomic_u64_t current;
+    maru_atomic_u64_t peak;
+    maru_atomic_u64_t count;
+    maru_atomic_u64_t total_count;
+    maru_atomic_u64_t budget;
+    maru_atomic_u64_t realloc_count;
+    maru_atomic_u32_t over_budget;
+    uint8_t pad_[MARU_CACHE_LINE - 6 * sizeof(maru_atomic_u64_t) - sizeof(maru_atomic_u32_t)];
+} tag_slot_t;
+
+static tag_slot_t g_tags[MEM_TAG_COUNT];
+
+/* Set at startup; read without synchronization on the allocation path */
+static mem_budget_fn g_budget_fn;
+static void *g_budget_user;
+
+static const char *g_tag_names[MEM_TAG_COUNT] = {
+    "general",
+    "core",
+    "mesh",
+    "material",
+    "texture_cpu",
+    "renderer",
+    "import",
+    "json",
+    "frame",
+    "asset",
+    "scratch",
+};
+
+/* The tracking tables must not allocate through MARU_MALLOC themselves */
+static void *raw_alloc(void *user, size_t size, size_t align) {
+    UNUSED(user);
+    UNUSED(align); /* hashmap asks for 16, which malloc already guarantees on 64-bit targets */
+    return malloc(size);
+}
+
+static void raw_free(void *user, void *ptr, size_t size, size_t align) {
+    UNUSED(user);
+    UNUSED(size);
+    UNUSED(align);
+    free(ptr);
+}
+
+static const maru_allocator_t g_raw = {raw_alloc, raw_free, NULL};
+
+static shard_t *shard_lock(const void *p) {
+    shard_t *s = &g_shards[MARU_HASH_INT_((uintptr_t) p) >> (64 - SHARD_BITS)];
+    maru_spinlock_lock(&s->lock);
+    if (!s->ready) {
+        alloc_map_init(&s->allocs, &g_raw);
+        site_map_init(&s->sites, &g_raw);
+        s->ready = 1;
     }
-    return p;
+    return s;
 }
 
-void *mem_calloc(size_t n, size_t sz, const char *file, int line) {
-    void *p = calloc(n, sz);
-    if (p && g_count < (int) (sizeof(g_allocs) / sizeof(g_allocs[0]))) {
-        g_allocs[g_count++] = (alloc_info_t){p, n * sz, file, line};
+static site_key_t site_key(const char *file, int line) {
+    site_key_t k;
+    k.file = (uintptr_t) file;
+    k.line = (uintptr_t) line;
+    return k;
+}
+
+static mem_tag_t tag_clamp(mem_tag_t tag) {
+    return ((unsigned) tag < MEM_TAG_COUNT) ? tag : MEM_TAG_GENERAL;
+}
+
+/* prev_size: bytes already counted for this block (realloc), or -1 for a new block */
+static void tag_add(mem_tag_t tag, size_t sz, size_t prev_size) {
+    tag_slot_t *t = &g_tags[tag];
+
+    if (prev_size == (size_t) -1) {
+        maru_atomic_fetch_add_u64(&t->count, 1, MARU_MO_RELAXED);
+        maru_atomic_fetch_add_u64(&t->total_count, 1, MARU_MO_RELAXED);
+        prev_size = 0;
+    }
+    if (sz <= prev_size) {
+        maru_atomic_fetch_add_u64(&t->current, (uint64_t) 0 - (prev_size - sz), MARU_MO_RELAXED);
+        return;
+    }
+
+    size_t grow = sz - prev_size;
+    uint64_t cur = maru_atomic_fetch_add_u64(&t->current, grow, MARU_MO_RELAXED) + grow;
+
+    uint64_t peak = maru_atomic_load_u64(&t->peak, MARU_MO_RELAXED);
+    while (cur > peak && !maru_atomic_cas_u64(&t->peak, &peak, cur, MARU_MO_RELAXED)) {}
+
+    uint64_t budget = maru_atomic_load_u64(&t->budget, MARU_MO_RELAXED);
+    if (budget && cur > budget && cur - grow <= budget) {
+        maru_atomic_fetch_add_u32(&t->over_budget, 1, MARU_MO_RELAXED);
+        WARN("[mem] tag '%s' over budget: %llu / %llu bytes", g_tag_names[tag],
+             (unsigned long long) cur, (unsigned long long) budget);
+        if (g_budget_fn) g_budget_fn(tag, (size_t) cur, (size_t) budget, g_budget_user);
     }
-    return p;
 }
 
-void *mem_realloc(void *old_p, size_t sz, const char *file, int line) {
-    void *p = realloc(old_p, sz);
-    if (p && old_p != p) {
-        // Remove old pointer
-        for (int i = 0; i < g_count; ++i) {
-            if (g_allocs[i].ptr == old_p) {
-                g_allocs[i] = g_allocs[--g_count];
-                break;
-            }
+static void tag_sub(mem_tag_t tag, size_t sz) {
+    tag_slot_t *t = &g_tags[tag];
+    maru_atomic_fetch_add_u64(&t->current, (uint64_t) 0 - sz, MARU_MO_RELAXED);
+    maru_atomic_fetch_add_u64(&t->count, (uint64_t) -1, MARU_MO_RELAXED);
+}
+
+static void site_sub(shard_t *s, const alloc_rec_t *rec) {
+    s->live_bytes -= rec->size;
+
+    site_val_t *v = site_map_find(&s->sites, site_key(rec->file, rec->line));
+    if (v) {
+        v->live_bytes -= rec->size;
+        v->live_count--;
+    }
+}
+
+/* prev: the record this block had before a realloc (its tag bytes are still counted), else NULL */
+static void track_add(void *p, size_t sz, mem_tag_t tag, const char *file, int line, const alloc_rec_t *prev) {
+    shard_t *s = shard_lock(p);
+
+    int inserted = 0, added = 0;
+    alloc_rec_t stale = {0};
+    uintptr_t key = (uintptr_t) p;
+    alloc_rec_t *rec = (alloc_rec_t*) maru_hashmap_insert(&s->allocs.base, &key, MARU_HASH_INT_(key), &inserted);
+    if (rec) {
+        /* a record already here means the block was freed behind our back (plain free()) */
+        if (!inserted) {
+            stale = *rec;
+            site_sub(s, &stale);
         }
-        // Add new pointer
-        if (g_count < (int) (sizeof(g_allocs) / sizeof(g_allocs[0]))) {
-            g_allocs[g_count++] = (alloc_info_t){p, sz, file, line};
+
+        rec->size = sz;
+        rec->file = file;
+        rec->line = line;
+        rec->tag = tag;
+        s->live_bytes += sz;
+        added = 1;
+
+        site_key_t k = site_key(file, line);
+        site_val_t *v = (site_val_t*) maru_hashmap_insert(&s->sites.base, &k, SITE_HASH_(k), NULL);
+        if (v) {
+            v->live_bytes += sz;
+            v->live_count++;
+            v->total_bytes += sz;
+            v->total_count++;
         }
     }
+
+    maru_spinlock_unlock(&s->lock);
+
+    if (!inserted && rec) tag_sub(stale.tag, stale.size);
+    if (added) {
+        if (prev) maru_atomic_fetch_add_u64(&g_tags[tag].realloc_count, 1, MARU_MO_RELAXED);
+        tag_add(tag, sz, prev ? prev->size : (size_t) -1);
+    } else if (prev) {
+        tag_sub(prev->tag, prev->size);
+    }
+}
+
+/*
+ * Removes p's record; 1 and *out filled if it was tracked. keep_tag leaves
+ * the tag counters alone for a following track_add(..., prev = out).
+ */
+static int track_take(void *p, alloc_rec_t *out, int keep_tag) {
+    shard_t *s = shard_lock(p);
+
+    alloc_rec_t *rec = alloc_map_find(&s->allocs, (uintptr_t) p);
+    int found = rec != NULL;
+    if (found) {
+        *out = *rec;
+        alloc_map_remove(&s->allocs, (uintptr_t) p);
+        site_sub(s, out);
+    }
+
+    maru_spinlock_unlock(&s->lock);
+
+    if (found && !keep_tag) tag_sub(out->tag, out->size);
+    return found;
+}
+
+void *mem_alloc(size_t sz, mem_tag_t tag, const char *file, int line) {
+    void *p = mem_raw_alloc(sz);
+    if (p) track_add(p, sz, tag_clamp(tag), file, line, NULL);
+    return p;
+}
+
+void *mem_calloc(size_t n, size_t sz, mem_tag_t tag, const char *file, int line) {
+    void *p = mem_raw_calloc(n, sz);
+    if (p) track_add(p, n * sz, tag_clamp(tag), file, line, NULL);
+    return p;
+}
+
+void *mem_realloc(void *old_p, size_t sz, mem_tag_t tag, const char *file, int line) {
+    if (!old_p) return mem_alloc(sz, tag, file, line);
+    if (sz == 0) {
+        mem_free(old_p);
+        return NULL;
+    }
+
+    /* Untrack first: once realloc moves the block, another thread may get old_p back */
+    alloc_rec_t old;
+    int tracked = track_take(old_p, &old, 1);
+
+    void *p = mem_raw_realloc(old_p, sz);
+    if (!p) {
+        if (tracked) track_add(old_p, old.size, old.tag, old.file, old.line, &old);
+        return NULL;
+    }
+
+    if (tracked) {
+        track_add(p, sz, old.tag, file, line, &old);
+    } else {
+        track_add(p, sz, tag_clamp(tag), file, line, NULL);
+    }
     return p;
 }
 
 void mem_free(void *p) {
     if (!p) return;
-    for (int i = 0; i < g_count; ++i) {
-        if (g_allocs[i].ptr == p) {
-            g_allocs[i] = g_allocs[--g_count];
-            break;
+
+    alloc_rec_t rec;
+    track_take(p, &rec, 0);
+    mem_raw_free(p);
+}
+
+size_t mem_live_bytes(void) {
+    size_t total = 0;
+    for (uint32_t i = 0; i < SHARD_COUNT; ++i) {
+        shard_t *s = &g_shards[i];
+        maru_spinlock_lock(&s->lock);
+        total += s->live_bytes;
+        maru_spinlock_unlock(&s->lock);
+    }
+    return total;
+}
+
+size_t mem_live_count(void) {
+    size_t total = 0;
+    for (uint32_t i = 0; i < SHARD_COUNT; ++i) {
+        shard_t *s = &g_shards[i];
+        maru_spinlock_lock(&s->lock);
+        if (s->ready) total += alloc_map_count(&s->allocs);
+        maru_spinlock_unlock(&s->lock);
+    }
+    return total;
+}
+
+const char *mem_tag_name(mem_tag_t tag) {
+    return ((unsigned) tag < MEM_TAG_COUNT) ? g_tag_names[tag] : "?";
+}
+
+int mem_tag_stats(mem_tag_t tag, mem_tag_stats_t *out) {
+    if ((unsigned) tag >= MEM_TAG_COUNT || !out) return -1;
+
+    tag_slot_t *t = &g_tags[tag];
+    out->current = (size_t) maru_atomic_load_u64(&t->current, MARU_MO_RELAXED);
+    out->peak = (size_t) maru_atomic_load_u64(&t->peak, MARU_MO_RELAXED);
+    out->count = (size_t) maru_atomic_load_u64(&t->count, MARU_MO_RELAXED);
+    out->total_count = maru_atomic_load_u64(&t->total_count, MARU_MO_RELAXED);
+    out->budget = (size_t) maru_atomic_load_u64(&t->budget, MARU_MO_RELAXED);
+    out->over_budget = maru_atomic_load_u32(&t->over_budget, MARU_MO_RELAXED);
+    return 0;
+}
+
+size_t mem_tag_current(mem_tag_t tag) {
+    if ((unsigned) tag >= MEM_TAG_COUNT) return 0;
+    return (size_t) maru_atomic_load_u64(&g_tags[tag].current, MARU_MO_RELAXED);
+}
+
+void mem_tag_reset_peak(mem_tag_t tag) {
+    if ((unsigned) tag >= MEM_TAG_COUNT) return;
+    tag_slot_t *t = &g_tags[tag];
+    maru_atomic_store_u64(&t->peak, maru_atomic_load_u64(&t->current, MARU_MO_RELAXED), MARU_MO_RELAXED);
+}
+
+void mem_tag_commit(mem_tag_t tag, size_t bytes) {
+    if (bytes) tag_add(tag_clamp(tag), bytes, 0);
+}
+
+void mem_tag_decommit(mem_tag_t tag, size_t bytes) {
+    tag_slot_t *t = &g_tags[tag_clamp(tag)];
+    maru_atomic_fetch_add_u64(&t->current, (uint64_t) 0 - bytes, MARU_MO_RELAXED);
+}
+
+void mem_tag_set_budget(mem_tag_t tag, size_t bytes) {
+    if ((unsigned) tag >= MEM_TAG_COUNT) return;
+    maru_atomic_store_u64(&g_tags[tag].budget, bytes, MARU_MO_RELAXED);
+}
+
+void mem_set_budget_callback(mem_budget_fn fn, void *user) {
+    g_budget_user = user;
+    g_budget_fn = fn;
+}
+
+uint32_t mem_budget_violations(void) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < MEM_TAG_COUNT; ++i) {
+        total += maru_atomic_load_u32(&g_tags[i].over_budget, MARU_MO_RELAXED);
+    }
+    return total;
+}
+
+void mem_dump_tags(void) {
+    printf("[mem] %-12s %12s %12s %8s %12s\n", "tag", "current", "peak", "blocks", "budget");
+    for (uint32_t i = 0; i < MEM_TAG_COUNT; ++i) {
+        mem_tag_stats_t st;
+        mem_tag_stats((mem_tag_t) i, &st);
+        if (st.total_count == 0 && st.budget == 0) continue;
+        printf("      %-12s %12zu %12zu %8zu %12zu%s\n", g_tag_names[i], st.current, st.peak, st.count,
+               st.budget, st.over_budget ? "  OVER" : "");
+    }
+}
+
+static int site_cmp_live_desc(const void *a, const void *b) {
+    const mem_site_stats_t *x = (const mem_site_stats_t*) a;
+    const mem_site_stats_t *y = (const mem_site_stats_t*) b;
+    if (x->live_bytes != y->live_bytes) return x->live_bytes < y->live_bytes ? 1 : -1;
+    if (x->total_bytes != y->total_bytes) return x->total_bytes < y->total_bytes ? 1 : -1;
+    return 0;
+}
+
+/* Folds every shard's per-site totals into `merged` */
+static void sites_merge(site_map_t *merged) {
+    for (uint32_t i = 0; i < SHARD_COUNT; ++i) {
+        shard_t *s = &g_shards[i];
+        maru_spinlock_lock(&s->lock);
+        if (s->ready) {
+            size_t it = 0;
+            site_key_t k;
+            site_val_t v;
+            while (site_map_next(&s->sites, &it, &k, &v)) {
+                site_val_t *m = (site_val_t*) maru_hashmap_insert(&merged->base, &k, SITE_HASH_(k), NULL);
+                if (!m) continue;
+                m->live_bytes += v.live_bytes;
+                m->live_count += v.live_count;
+                m->total_bytes += v.total_bytes;
+                m->total_count += v.total_count;
+            }
         }
+        maru_spinlock_unlock(&s->lock);
     }
-    free(p);
+}
+
+size_t mem_site_stats(mem_site_stats_t *out, size_t max) {
+    site_map_t merged;
+    site_map_init(&merged, &g_raw);
+    sites_merge(&merged);
+
+    size_t count = site_map_count(&merged);
+    mem_site_stats_t *all = count ? (mem_site_stats_t*) malloc(sizeof(*all) * count) : NULL;
+    if (all) {
+        size_t it = 0, n = 0;
+        site_key_t k;
+        site_val_t v;
+        while (site_map_next(&merged, &it, &k, &v)) {
+            all[n].file = (const char*) k.file;
+            all[n].line = (int) k.line;
+            all[n].live_bytes = v.live_bytes;
+            all[n].live_count = v.live_count;
+            all[n].total_bytes = v.total_bytes;
+            all[n].total_count = v.total_count;
+            ++n;
+        }
+        qsort(all, count, sizeof(*all), site_cmp_live_desc);
+        if (out) memcpy(out, all, sizeof(*all) * (count < max ? count : max));
+        free(all);
+    }
+
+    site_map_destroy(&merged);
+    return count;
+}
+
+uint64_t mem_alloc_total(void) {
+    uint64_t total = 0;
+    for (int i = 0; i < MEM_TAG_COUNT; ++i) {
+        total += maru_atomic_load_u64(&g_tags[i].total_count, MARU_MO_RELAXED);
+        total += maru_atomic_load_u64(&g_tags[i].realloc_count, MARU_MO_RELAXED);
+    }
+    return total;
+}
+
+typedef struct {
+    site_key_t key;
+    site_val_t val;
+} snap_site_t;
+
+struct mem_snapshot {
+    size_t count;
+    snap_site_t sites[];       /* sorted by key, for the merge in diff */
+};
+
+static int key_cmp(const site_key_t *a, const site_key_t *b) {
+    if (a->file != b->file) return a->file < b->file ? -1 : 1;
+    if (a->line != b->line) return a->line < b->line ? -1 : 1;
+    return 0;
+}
+
+static int snap_site_cmp(const void *a, const void *b) {
+    return key_cmp(&((const snap_site_t*) a)->key, &((const snap_site_t*) b)->key);
+}
+
+mem_snapshot_t *mem_snapshot(void) {
+    site_map_t merged;
+    site_map_init(&merged, &g_raw);
+    sites_merge(&merged);
+
+    size_t count = site_map_count(&merged);
+    mem_snapshot_t *snap = (mem_snapshot_t*) malloc(sizeof(*snap) + sizeof(snap_site_t) * count);
+    if (snap) {
+        size_t it = 0, n = 0;
+        while (n < count && site_map_next(&merged, &it, &snap->sites[n].key, &snap->sites[n].val)) ++n;
+        snap->count = n;
+        qsort(snap->sites, n, sizeof(snap_site_t), snap_site_cmp);
+    }
+
+    site_map_destroy(&merged);
+    return snap;
+}
+
+void mem_snapshot_free(mem_snapshot_t *snap) {
+    free(snap);
+}
+
+size_t mem_snapshot_site_count(const mem_snapshot_t *snap) {
+    return snap ? snap->count : 0;
+}
+
+static int delta_cmp_count_desc(const void *a, const void *b) {
+    const mem_site_delta_t *x = (const mem_site_delta_t*) a;
+    const mem_site_delta_t *y = (const mem_site_delta_t*) b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    if (x->bytes != y->bytes) return x->bytes < y->bytes ? 1 : -1;
+    return 0;
+}
+
+size_t mem_snapshot_diff(const mem_snapshot_t *a, const mem_snapshot_t *b, mem_site_delta_t *out, size_t max) {
+    if (!b) return 0;
+
+    /* sites are never dropped, so every site of a is also in b */
+    mem_site_delta_t *all = b->count ? (mem_site_delta_t*) malloc(sizeof(*all) * b->count) : NULL;
+    if (!all) return 0;
+
+    size_t n = 0, ai = 0;
+    for (size_t bi = 0; bi < b->count; ++bi) {
+        const snap_site_t *sb = &b->sites[bi];
+        while (a && ai < a->count && key_cmp(&a->sites[ai].key, &sb->key) < 0) ++ai;
+
+        site_val_t before = {0};
+        if (a && ai < a->count && key_cmp(&a->sites[ai].key, &sb->key) == 0) before = a->sites[ai].val;
+        if (sb->val.total_count == before.total_count) continue;
+
+        mem_site_delta_t *d = &all[n++];
+        d->file = (const char*) sb->key.file;
+        d->line = (int) sb->key.line;
+        d->count = sb->val.total_count - before.total_count;
+        d->bytes = sb->val.total_bytes - before.total_bytes;
+        d->live_bytes = (int64_t) sb->val.live_bytes - (int64_t) before.live_bytes;
+    }
+
+    qsort(all, n, sizeof(*all), delta_cmp_count_desc);
+    if (out) memcpy(out, all, sizeof(*all) * (n < max ? n : max));
+    free(all);
+    return n;
+}
+
+void mem_dump_sites(size_t top_n) {
+    if (top_n == 0) return;
+
+    mem_site_stats_t *sites = (mem_site_stats_t*) malloc(sizeof(*sites) * top_n);
+    if (!sites) return;
+
+    size_t count = mem_site_stats(sites, top_n);
+    size_t n = count < top_n ? count : top_n;
+
+    printf("[mem] %zu call sites, top %zu by live bytes:\n", count, n);
+    for (size_t i = 0; i < n; ++i) {
+        printf("  %10zu B live in %6zu blocks, %10llu B / %8llu allocs total @ %s:%d\n",
+               sites[i].live_bytes, sites[i].live_count,
+               (unsigned long long) sites[i].total_bytes, (unsigned long long) sites[i].total_count,
+               sites[i].file, sites[i].line);
+    }
+    free(sites);
 }
 
 void mem_dump_leaks(void) {
-    if (g_count == 0) {
+    size_t count = mem_live_count();
+    if (count == 0) {
         printf("[mem] no leaks.\n");
         return;
     }
-    printf("[mem] leaks: %d\n", g_count);
-    for (int i = 0; i < g_count; ++i) {
-        printf("  leak #%d: %p, %zu bytes @ %s:%d\n",
-               i, g_allocs[i].ptr, g_allocs[i].size, g_allocs[i].file, g_allocs[i].line);
+
+    printf("[mem] leaks: %zu\n", count);
+    size_t i = 0;
+    for (uint32_t si = 0; si < SHARD_COUNT; ++si) {
+        shard_t *s = &g_shards[si];
+        maru_spinlock_lock(&s->lock);
+        if (s->ready) {
+            size_t it = 0;
+            uintptr_t p;
+            alloc_rec_t rec;
+            while (alloc_map_next(&s->allocs, &it, &p, &rec)) {
+                printf("  leak #%zu: %p, %zu bytes [%s] @ %s:%d\n",
+                       i++, (void*) p, rec.size, g_tag_names[rec.tag], rec.file, rec.line);
+            }
+        }
+        maru_spinlock_unlock(&s->lock);
     }
 }
 
@@ -2,24 +2,187 @@
 #define MARU_MEM_DIAG
 
 #include <stdlib.h>
+#include <stdint.h>
 
+/*
+ * Allocation tracking is on unless the build defines MARU_DISABLE_MEM_DIAG
+ * (CMake: -DMARU_MEM_DIAG=OFF); then MARU_MALLOC & co. go straight to the
+ * backend (libc unless mem_set_backend installed another).
+ */
+#if !defined(MARU_DISABLE_MEM_DIAG) && !defined(MARU_ENABLE_MEM_DIAG)
 #define MARU_ENABLE_MEM_DIAG
+#endif
+
+/*
+ * Memory tags: which subsystem owns a block. Use the _T allocation macros to
+ * tag; plain MARU_MALLOC is MEM_TAG_GENERAL. A block keeps its tag for life,
+ * MARU_REALLOC included.
+ */
+typedef enum mem_tag {
+    MEM_TAG_GENERAL = 0,
+    MEM_TAG_CORE,           /* handle pools, containers, string table */
+    MEM_TAG_MESH,
+    MEM_TAG_MATERIAL,
+    MEM_TAG_TEXTURE_CPU,
+    MEM_TAG_RENDERER,
+    MEM_TAG_IMPORT,
+    MEM_TAG_JSON,
+    MEM_TAG_FRAME,
+    MEM_TAG_ASSET,
+    MEM_TAG_SCRATCH,        /* scratch_push/pop blocks */
+    MEM_TAG_COUNT
+} mem_tag_t;
+
+typedef struct mem_tag_stats {
+    size_t current;         /* live bytes */
+    size_t peak;
+    size_t count;           /* live blocks */
+    uint64_t total_count;   /* allocations ever made */
+    size_t budget;          /* 0 = none */
+    uint32_t over_budget;   /* times `current` crossed above the budget */
+} mem_tag_stats_t;
+
+/* Called (outside any mem_diag lock) each time a tag crosses above its budget */
+typedef void (*mem_budget_fn)(mem_tag_t tag, size_t current, size_t budget, void *user);
+
+/* Per call-site totals, merged over all threads */
+typedef struct mem_site_stats {
+    const char *file;
+    int line;
+    size_t live_bytes;
+    size_t live_count;
+    uint64_t total_bytes;   /* everything ever allocated here */
+    uint64_t total_count;
+} mem_site_stats_t;
+
+/* What one call site allocated between two snapshots */
+typedef struct mem_site_delta {
+    const char *file;
+    int line;
+    uint64_t count;         /* allocations and reallocs */
+    uint64_t bytes;
+    int64_t live_bytes;     /* change in live bytes; negative if it freed more */
+} mem_site_delta_t;
+
+/* Every call site's running totals at one point in time */
+typedef struct mem_snapshot mem_snapshot_t;
+
+/*
+ * Where MARU_MALLOC & co. get memory from, with or without tracking. The
+ * default is libc. A backend must be installed before the first allocation
+ * (blocks cannot move between heaps), so mem_set_backend returns -1 once
+ * anything was allocated; NULL restores libc under the same rule.
+ *
+ * A backend that can tell its own blocks apart (owns) may replace libc
+ * later, as long as no other thread allocates meanwhile: blocks it does not
+ * own keep being resized and freed by libc.
+ */
+typedef struct mem_backend {
+    void *(*alloc)(void *user, size_t size);
+    void *(*realloc)(void *user, void *ptr, size_t size);
+    void (*free)(void *user, void *ptr);
+    void *user;
+    int (*owns)(void *user, const void *ptr);   /* optional */
+} mem_backend_t;
+
+int mem_set_backend(const mem_backend_t *backend);
+
+/* Untracked calls into the current backend */
+void *mem_raw_alloc(size_t sz);
+void *mem_raw_calloc(size_t n, size_t sz);
+void *mem_raw_realloc(void *p, size_t sz);
+void mem_raw_free(void *p);
 
 #ifdef MARU_ENABLE_MEM_DIAG
-void *mem_alloc(size_t sz, const char *file, int line);
-void *mem_calloc(size_t n, size_t sz, const char *file, int line);
-void *mem_realloc(void *p, size_t sz, const char *file, int line);
+void *mem_alloc(size_t sz, mem_tag_t tag, const char *file, int line);
+void *mem_calloc(size_t n, size_t sz, mem_tag_t tag, const char *file, int line);
+/* `tag` only applies when p is NULL; an existing block keeps its tag */
+void *mem_realloc(void *p, size_t sz, mem_tag_t tag, const char *file, int line);
 void mem_free(void *p);
 void mem_dump_leaks(void);
-#define MARU_MALLOC(sz) mem_alloc((sz), __FILE__, __LINE__)
-#define MARU_CALLOC(n, sz) mem_calloc((n), (sz), __FILE__, __LINE__)
-#define MARU_REALLOC(p, sz) mem_realloc((p), (sz), __FILE__, __LINE__)
+
+const char *mem_tag_name(mem_tag_t tag);
+
+/* Returns 0, or -1 for an invalid tag */
+int mem_tag_stats(mem_tag_t tag, mem_tag_stats_t *out);
+size_t mem_tag_current(mem_tag_t tag);
+void mem_tag_reset_peak(mem_tag_t tag);
+
+/*
+ * Bytes a tag owns that MARU_MALLOC didn't hand out, e.g. committed virtual
+ * memory. They count toward current/peak/budget but not toward count.
+ */
+void mem_tag_commit(mem_tag_t tag, size_t bytes);
+void mem_tag_decommit(mem_tag_t tag, size_t bytes);
+
+/*
+ * Budgets: 0 disables. Crossing above logs a warning and calls the budget
+ * callback (one per process). mem_budget_violations() sums over_budget over
+ * all tags, e.g. for a CI run to fail on.
+ */
+void mem_tag_set_budget(mem_tag_t tag, size_t bytes);
+void mem_set_budget_callback(mem_budget_fn fn, void *user);
+uint32_t mem_budget_violations(void);
+void mem_dump_tags(void);
+
+/*
+ * Fills up to `max` sites, largest live_bytes first; returns the number of
+ * sites that exist (may exceed max).
+ */
+size_t mem_site_stats(mem_site_stats_t *out, size_t max);
+void mem_dump_sites(size_t top_n);
+
+size_t mem_live_bytes(void);
+size_t mem_live_count(void);
+
+/* Allocations and reallocs made so far; cheap enough to bracket a frame with */
+uint64_t mem_alloc_total(void);
+
+/*
+ * Snapshots are taken outside MARU_MALLOC, so they never show up in their
+ * own diffs. mem_snapshot_diff fills up to `max` sites that allocated
+ * between a and b (a taken first), most allocations first, and returns how
+ * many there are.
+ */
+mem_snapshot_t *mem_snapshot(void);
+void mem_snapshot_free(mem_snapshot_t *snap);
+size_t mem_snapshot_site_count(const mem_snapshot_t *snap);
+size_t mem_snapshot_diff(const mem_snapshot_t *a, const mem_snapshot_t *b, mem_site_delta_t *out, size_t max);
+
+#define MARU_MALLOC_T(tag, sz) mem_alloc((sz), (tag), __FILE__, __LINE__)
+#define MARU_CALLOC_T(tag, n, sz) mem_calloc((n), (sz), (tag), __FILE__, __LINE__)
+#define MARU_REALLOC_T(tag, p, sz) mem_realloc((p), (sz), (tag), __FILE__, __LINE__)
 #define MARU_FREE(p)    mem_free((p))
 #else
-#define MARU_MALLOC(sz) malloc((sz))
-#define MARU_CALLOC(n, sz) calloc((n), (sz))
-#define MARU_REALLOC(p, sz) realloc((p), (sz))
-#define MARU_FREE(p)    free((p))
+#define MARU_MALLOC_T(tag, sz) ((void) (tag), mem_raw_alloc((sz)))
+#define MARU_CALLOC_T(tag, n, sz) ((void) (tag), mem_raw_calloc((n), (sz)))
+#define MARU_REALLOC_T(tag, p, sz) ((void) (tag), mem_raw_realloc((p), (sz)))
+#define MARU_FREE(p)    mem_raw_free((p))
+
+#define mem_dump_leaks()          ((void) 0)
+#define mem_tag_name(tag)         ((void) (tag), "")
+#define mem_tag_stats(tag, out)   ((void) (tag), (void) (out), -1)
+#define mem_tag_current(tag)      ((void) (tag), (size_t) 0)
+#define mem_tag_reset_peak(tag)   ((void) (tag))
+#define mem_tag_commit(tag, bytes)         ((void) (tag), (void) (bytes))
+#define mem_tag_decommit(tag, bytes)       ((void) (tag), (void) (bytes))
+#define mem_tag_set_budget(tag, bytes)     ((void) (tag), (void) (bytes))
+#define mem_set_budget_callback(fn, user)  ((void) (fn), (void) (user))
+#define mem_budget_violations()   ((uint32_t) 0)
+#define mem_dump_tags()           ((void) 0)
+#define mem_site_stats(out, max)  ((void) (out), (void) (max), (size_t) 0)
+#define mem_dump_sites(top_n)     ((void) (top_n))
+#define mem_live_bytes()          ((size_t) 0)
+#define mem_live_count()          ((size_t) 0)
+#define mem_alloc_total()         ((uint64_t) 0)
+#define mem_snapshot()            ((mem_snapshot_t*) 0)
+#define mem_snapshot_free(snap)   ((void) (snap))
+#define mem_snapshot_site_count(snap)      ((void) (snap), (size_t) 0)
+#define mem_snapshot_diff(a, b, out, max)  ((void) (a), (void) (b), (void) (out), (void) (max), (size_t) 0)
 #endif
 
+#define MARU_MALLOC(sz) MARU_MALLOC_T(MEM_TAG_GENERAL, (sz))
+#define MARU_CALLOC(n, sz) MARU_CALLOC_T(MEM_TAG_GENERAL, (n), (sz))
+#define MARU_REALLOC(p, sz) MARU_REALLOC_T(MEM_TAG_GENERAL, (p), (sz))
+
 #endif /* MARU_MEM_DIAG */
@@ -7,29 +7,94 @@
 #include <assert.h>
 
 #include "mem_diag.h"
+#include "vm_arena.h"
+#include "thread/atomic.h"
 
-#ifndef ALIGN_UP
-#define ALIGN_UP(_v,_a) ( ((_a) <= 1) ? (_v) : ( ((size_t)(_v) + ((size_t)(_a)-1)) & ~((size_t)(_a)-1) ) )
+/* First-pass span for frame_vprintf; longer text takes a second pass */
+#ifndef FRAME_PRINTF_RESERVE
+#define FRAME_PRINTF_RESERVE 256
 #endif
 
-#ifndef FRAME_PRINTF_TMP_CAP
-#define FRAME_PRINTF_TMP_CAP (16 * 1024)
+/* Upper bound for the per-thread chunk; small arenas use less */
+#ifndef FRAME_CHUNK_BYTES
+#define FRAME_CHUNK_BYTES (64 * 1024)
 #endif
 
-typedef struct frame_block_t {
+/* Frames of one buffer between auto-resize decisions; 0 disables */
+#ifndef FRAME_RESIZE_WINDOW
+#define FRAME_RESIZE_WINDOW 120
+#endif
+
+/* Base block size granularity when auto-resizing */
+#define FRAME_RESIZE_GRAIN ((size_t) 64 * 1024)
+
+/* A bump region; threads take chunks from its shared cursor */
+typedef struct frame_region_t {
     uint8_t *base;
     size_t cap;
-    size_t offset;
+    maru_atomic_u64_t offset;
+    struct frame_region_t *next;    /* older overflow region */
+    vm_arena_t *vm;                 /* commits base..cap on demand, or NULL */
+} frame_region_t;
+
+#define REGION_HDR ALIGN_UP(sizeof(frame_region_t), (size_t) MARU_CACHE_LINE)
+
+typedef struct frame_block_t {
+    frame_region_t main;
+    vm_arena_t vm;                  /* backs main for virtual arenas */
+    maru_atomic_ptr_t overflow;     /* newest overflow region for this frame, or NULL */
+    maru_spinlock_t grow_lock;
+
+    size_t high_water;              /* most bytes one frame needed, since init */
+    size_t window_peak;             /* same, over the current resize window */
+    int window_frames;
+    int window_overflowed;
+    uint32_t overflow_frames;
+    uint32_t resizes;
 } frame_block_t;
 
+/* Written by the owning thread only; read by stats */
+typedef struct frame_slot_t {
+    maru_atomic_u64_t used;
+    maru_atomic_u64_t reserved;
+    maru_atomic_u32_t chunks;
+    size_t peak_used;
+    uint8_t pad_[MARU_CACHE_LINE];
+} frame_slot_t;
+
+#define SLOT_NONE     0u            /* not registered yet */
+#define SLOT_UNTRACKED UINT32_MAX    /* ran out of slots */
+
+typedef struct frame_tls_t {
+    uint8_t *cur;
+    uint8_t *end;
+    uint32_t epoch;
+    uint32_t slot;              /* index + 1 */
+} frame_tls_t;
+
 static struct {
     frame_block_t *blocks;
     int block_count;
     int cur;
     size_t bytes_each;
+    size_t chunk_bytes;
+    int resize_window;
+    int is_virtual;
     int initialized;
 } g_frame;
 
+/*
+ * Bumped whenever the current buffer is reset; a thread whose chunk carries
+ * an older epoch refills. Kept out of g_frame so shutdown/init can't repeat
+ * an epoch that a stale chunk still holds.
+ */
+static maru_atomic_u32_t g_epoch;
+
+static frame_slot_t g_slots[FRAME_MAX_THREADS];
+static maru_atomic_u32_t g_slot_count;
+
+static MARU_THREAD_LOCAL frame_tls_t t_frame;
+
 static frame_block_t *curblk(void) {
     if (!g_frame.initialized || g_frame.block_count <= 0) {
         return NULL;
@@ -38,48 +103,208 @@ static frame_block_t *curblk(void) {
     return &g_frame.blocks[g_frame.cur % g_frame.block_count];
 }
 
-int frame_arena_init(size_t bytes, int buffers) {
+static frame_slot_t *my_slot(void) {
+    frame_tls_t *t = &t_frame;
+    if (t->slot == SLOT_NONE) {
+        uint32_t idx = maru_atomic_fetch_add_u32(&g_slot_count, 1, MARU_MO_RELAXED);
+        t->slot = idx < FRAME_MAX_THREADS ? idx + 1 : SLOT_UNTRACKED;
+    }
+    return t->slot != SLOT_UNTRACKED ? &g_slots[t->slot - 1] : NULL;
+}
+
+static void slot_add(maru_atomic_u64_t *v, size_t n) {
+    /* single writer: a plain load/store pair, no RMW */
+    maru_atomic_store_u64(v, maru_atomic_load_u64(v, MARU_MO_RELAXED) + n, MARU_MO_RELAXED);
+}
+
+/* Closes the frame for every slot; caller guarantees no concurrent frame_alloc */
+static void slots_roll(void) {
+    uint32_t n = maru_atomic_load_u32(&g_slot_count, MARU_MO_RELAXED);
+    if (n > FRAME_MAX_THREADS) n = FRAME_MAX_THREADS;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        frame_slot_t *s = &g_slots[i];
+        size_t used = (size_t) maru_atomic_load_u64(&s->used, MARU_MO_RELAXED);
+        if (used > s->peak_used) s->peak_used = used;
+
+        maru_atomic_store_u64(&s->used, 0, MARU_MO_RELAXED);
+        maru_atomic_store_u64(&s->reserved, 0, MARU_MO_RELAXED);
+        maru_atomic_store_u32(&s->chunks, 0, MARU_MO_RELAXED);
+    }
+}
+
+static size_t region_used(const frame_region_t *r) {
+    uint64_t off = maru_atomic_load_u64(&r->offset, MARU_MO_RELAXED);
+    return off < r->cap ? (size_t) off : r->cap;
+}
+
+static frame_region_t *overflow_head(frame_block_t *b) {
+    return (frame_region_t*) maru_atomic_load_ptr(&b->overflow, MARU_MO_ACQUIRE);
+}
+
+/* Bytes this buffer has handed out in chunks, overflow included */
+static size_t block_reserved(frame_block_t *b) {
+    size_t total = region_used(&b->main);
+    for (frame_region_t *r = overflow_head(b); r; r = r->next) total += region_used(r);
+    return total;
+}
+
+/* Usable bytes of the main block: what is committed, for a virtual one */
+static size_t main_capacity(frame_block_t *b) {
+    return b->main.vm ? vm_arena_committed(b->main.vm) : b->main.cap;
+}
+
+static size_t block_capacity(frame_block_t *b) {
+    size_t total = main_capacity(b);
+    for (frame_region_t *r = overflow_head(b); r; r = r->next) total += r->cap;
+    return total;
+}
+
+static void block_free_overflow(frame_block_t *b) {
+    frame_region_t *r = overflow_head(b);
+    while (r) {
+        frame_region_t *next = r->next;
+        MARU_FREE(r);
+        r = next;
+    }
+    maru_atomic_store_ptr(&b->overflow, NULL, MARU_MO_RELAXED);
+}
+
+/*
+ * Closes the frame that last used b: records its high-water mark, drops the
+ * overflow chain and, at the end of a resize window, refits the main block.
+ */
+static void block_recycle(frame_block_t *b) {
+    size_t used = block_reserved(b);
+    int overflowed = overflow_head(b) != NULL;
+
+    if (used > b->high_water) b->high_water = used;
+    if (used > b->window_peak) b->window_peak = used;
+    if (overflowed) {
+        b->window_overflowed = 1;
+        b->overflow_frames++;
+    }
+    block_free_overflow(b);
+
+    /* virtual: growth is in place; the vm arena decommits after a quiet window */
+    if (b->main.vm) {
+        vm_arena_end_period(b->main.vm, used);
+        return;
+    }
+
+    if (g_frame.resize_window <= 0 || ++b->window_frames < g_frame.resize_window) return;
+
+    /* grow after any overflow; shrink only when the window used under half */
+    size_t want = ALIGN_UP(b->window_peak + b->window_peak / 8, FRAME_RESIZE_GRAIN);
+    if (want < g_frame.bytes_each) want = g_frame.bytes_each;
+    int grow = b->window_overflowed && want > b->main.cap;
+    int shrink = !b->window_overflowed && want < b->main.cap / 2;
+
+    b->window_frames = 0;
+    b->window_peak = 0;
+    b->window_overflowed = 0;
+    if (!grow && !shrink) return;
+
+    uint8_t *mem = (uint8_t*) MARU_MALLOC_T(MEM_TAG_FRAME, want);
+    if (!mem) return;
+
+    MARU_FREE(b->main.base);
+    b->main.base = mem;
+    b->main.cap = want;
+    b->resizes++;
+}
+
+static void block_free_main(frame_block_t *b) {
+    if (b->main.vm) {
+        vm_arena_destroy(b->main.vm);
+        b->main.vm = NULL;
+    } else if (b->main.base) {
+        MARU_FREE(b->main.base);
+    }
+    b->main.base = NULL;
+}
+
+static int arena_init(size_t bytes, int buffers, int is_virtual) {
     if (g_frame.initialized) return 0;
     if (buffers <= 0) buffers = 2;
     if (bytes < 1024) bytes = 1024;
 
-    g_frame.blocks = (frame_block_t*) MARU_CALLOC((size_t) buffers, sizeof(frame_block_t));
+    g_frame.blocks = (frame_block_t*) MARU_CALLOC_T(MEM_TAG_FRAME, (size_t) buffers, sizeof(frame_block_t));
     if (!g_frame.blocks) return -1;
 
     for (int i = 0; i < buffers; ++i) {
-        g_frame.blocks[i].base = (uint8_t*) MARU_MALLOC(bytes);
-        if (!g_frame.blocks[i].base) {
+        frame_block_t *b = &g_frame.blocks[i];
+        if (is_virtual) {
+            if (vm_arena_init(&b->vm, bytes, MEM_TAG_FRAME) == 0) {
+                vm_arena_set_decommit_window(&b->vm, (uint32_t) FRAME_RESIZE_WINDOW);
+                vm_arena_set_huge_pages(&b->vm);
+                b->main.vm = &b->vm;
+                b->main.base = b->vm.base;
+            }
+        } else {
+            b->main.base = (uint8_t*) MARU_MALLOC_T(MEM_TAG_FRAME, bytes);
+        }
+
+        if (!b->main.base) {
             for (int j = 0; j < i; ++j) {
-                MARU_FREE(g_frame.blocks[j].base);
+                block_free_main(&g_frame.blocks[j]);
             }
             MARU_FREE(g_frame.blocks);
             memset(&g_frame, 0, sizeof(g_frame));
             return -1;
         }
 
-        g_frame.blocks[i].cap = bytes;
-        g_frame.blocks[i].offset = 0;
+        b->main.cap = is_virtual ? b->vm.reserved : bytes;
     }
 
+    /* enough chunks per buffer that a handful of threads don't strand most of it */
+    size_t chunk = ALIGN_DOWN(bytes / 16, (size_t) MARU_CACHE_LINE);
+    if (chunk > FRAME_CHUNK_BYTES) chunk = FRAME_CHUNK_BYTES;
+    if (chunk < 256) chunk = 256;
+
     g_frame.block_count = buffers;
     g_frame.cur = 0;
     g_frame.bytes_each = bytes;
+    g_frame.chunk_bytes = chunk;
+    g_frame.resize_window = FRAME_RESIZE_WINDOW;
+    g_frame.is_virtual = is_virtual;
     g_frame.initialized = 1;
+
+    slots_roll();
+    for (uint32_t i = 0; i < FRAME_MAX_THREADS; ++i) g_slots[i].peak_used = 0;
+    maru_atomic_fetch_add_u32(&g_epoch, 1, MARU_MO_RELAXED);
     return 0;
 }
 
+int frame_arena_init(size_t bytes, int buffers) {
+    return arena_init(bytes, buffers, 0);
+}
+
+int frame_arena_init_virtual(size_t reserve_bytes, int buffers) {
+    return arena_init(reserve_bytes, buffers, 1);
+}
+
 void frame_arena_shutdown(void) {
     if (!g_frame.initialized) return;
 
     for (int i = 0; i < g_frame.block_count; ++i) {
-        if (g_frame.blocks[i].base) {
-            MARU_FREE(g_frame.blocks[i].base);
-            g_frame.blocks[i].base = NULL;
-        }
+        frame_block_t *b = &g_frame.blocks[i];
+        block_free_overflow(b);
+        block_free_main(b);
     }
 
     MARU_FREE(g_frame.blocks);
     memset(&g_frame, 0, sizeof(g_frame));
+    maru_atomic_fetch_add_u32(&g_epoch, 1, MARU_MO_RELAXED);
+}
+
+void frame_arena_set_resize_window(int frames) {
+    if (!g_frame.initialized) return;
+    g_frame.resize_window = frames;
+
+    for (int i = 0; g_frame.is_virtual && i < g_frame.block_count; ++i) {
+        vm_arena_set_decommit_window(&g_frame.blocks[i].vm, frames > 0 ? (uint32_t) frames : 0);
+    }
 }
 
 void frame_arena_begin(int frame_index) {
@@ -98,27 +323,153 @@ void frame_arena_reset(void) {
     frame_block_t *b = curblk();
     if (!b) return;
 
+    block_recycle(b);
+
 #ifdef MARU_DEBUG
-    memset(b->base, 0, b->cap);
+    memset(b->main.base, 0, main_capacity(b));
 #endif
 
-    b->offset = 0;
+    maru_atomic_store_u64(&b->main.offset, 0, MARU_MO_RELAXED);
+    maru_atomic_fetch_add_u32(&g_epoch, 1, MARU_MO_RELAXED);
+    slots_roll();
 }
 
-void *frame_alloc(size_t size, size_t align) {
+/*
+ * Takes `take` bytes from r's cursor and places `size` at `align` in them.
+ * The last chunk of a region may be cut short by its end.
+ */
+static int region_take(frame_region_t *r, size_t take, size_t size, size_t align,
+                       uint8_t **chunk, uint8_t **chunk_end, uintptr_t *out) {
+    uint64_t off = maru_atomic_fetch_add_u64(&r->offset, take, MARU_MO_RELAXED);
+    if (off >= r->cap) return 0;
+
+    size_t end = (off + take > r->cap) ? r->cap : (size_t) (off + take);
+    uintptr_t p = ALIGN_UP((uintptr_t) (r->base + off), (uintptr_t) align);
+    if (p + size > (uintptr_t) (r->base + end)) return 0;
+    if (r->vm && vm_arena_ensure(r->vm, end) != 0) return 0;
+
+    *chunk = r->base + off;
+    *chunk_end = r->base + end;
+    *out = p;
+    return 1;
+}
+
+/* Chains a new overflow region unless another thread already did since `seen` */
+static int block_grow(frame_block_t *b, frame_region_t *seen, size_t need) {
+    maru_spinlock_lock(&b->grow_lock);
+
+    int ok = 1;
+    if (overflow_head(b) == seen) {
+        size_t cap = g_frame.bytes_each / 4;
+        if (cap < need) cap = ALIGN_UP(need, (size_t) MARU_CACHE_LINE);
+
+        frame_region_t *r = (frame_region_t*) MARU_MALLOC_T(MEM_TAG_FRAME, REGION_HDR + cap);
+        if (r) {
+            r->base = (uint8_t*) r + REGION_HDR;
+            r->cap = cap;
+            maru_atomic_store_u64(&r->offset, 0, MARU_MO_RELAXED);
+            r->next = seen;
+            r->vm = NULL;
+            maru_atomic_store_ptr(&b->overflow, r, MARU_MO_RELEASE);
+        } else {
+            ok = 0;
+        }
+    }
+
+    maru_spinlock_unlock(&b->grow_lock);
+    return ok;
+}
+
+/*
+ * Slow path: takes a fresh chunk from the shared cursor, chaining an
+ * overflow region when the main block is spent. Requests larger than half a
+ * chunk get a dedicated range instead, so the thread keeps the tail of its
+ * current chunk. With `reserve`, the range becomes the thread's chunk and
+ * nothing is claimed: the caller gets at least `size` bytes to commit from.
+ */
+static void *frame_refill(size_t size, size_t align, int reserve) {
     frame_block_t *b = curblk();
-    if (!b || !b->base) return NULL;
+    if (!b || !b->main.base) return NULL;
+
+    frame_tls_t *t = &t_frame;
+    uint32_t epoch = maru_atomic_load_u32(&g_epoch, MARU_MO_RELAXED);
+    if (t->epoch != epoch) {
+        t->cur = t->end = NULL;
+        t->epoch = epoch;
+    }
 
+    size_t need = size + align - 1;
+    if (need < size) return NULL;
+    int dedicated = need > g_frame.chunk_bytes / 2;
+    size_t take = dedicated ? ALIGN_UP(need, (size_t) MARU_CACHE_LINE) : g_frame.chunk_bytes;
+
+    uint8_t *chunk, *chunk_end;
+    uintptr_t p;
+    for (;;) {
+        frame_region_t *head = overflow_head(b);
+        frame_region_t *r = head ? head : &b->main;
+        if (region_take(r, take, size, align, &chunk, &chunk_end, &p)) break;
+        if (!block_grow(b, head, take)) return NULL;
+    }
+
+    frame_slot_t *s = my_slot();
+    if (s) {
+        slot_add(&s->reserved, (size_t) (chunk_end - chunk));
+        maru_atomic_store_u32(&s->chunks, maru_atomic_load_u32(&s->chunks, MARU_MO_RELAXED) + 1, MARU_MO_RELAXED);
+        if (!reserve) slot_add(&s->used, (size_t) (p + size - (uintptr_t) chunk));
+    }
+
+    if (reserve) {
+        t->cur = (uint8_t*) p;
+        t->end = chunk_end;
+    } else if (!dedicated) {
+        t->cur = (uint8_t*) p + size;
+        t->end = chunk_end;
+    }
+    return (void*) p;
+}
+
+void *frame_alloc(size_t size, size_t align) {
     if (align == 0) align = 1;
-    size_t off_aligned = ALIGN_UP(b->offset, align);
 
-    if (off_aligned + size > b->cap) {
-        return NULL;
+    frame_tls_t *t = &t_frame;
+    if (LIKELY(t->epoch == maru_atomic_load_u32(&g_epoch, MARU_MO_RELAXED) && t->cur)) {
+        uintptr_t p = ALIGN_UP((uintptr_t) t->cur, (uintptr_t) align);
+        if (p <= (uintptr_t) t->end && size <= (size_t) ((uintptr_t) t->end - p)) {
+            frame_slot_t *s = my_slot();
+            if (s) slot_add(&s->used, (size_t) (p + size - (uintptr_t) t->cur));
+            t->cur = (uint8_t*) p + size;
+            return (void*) p;
+        }
     }
 
-    void *p = (void*) (b->base + off_aligned);
-    b->offset = off_aligned + size;
-    return p;
+    return frame_refill(size, align, 0);
+}
+
+void *frame_reserve(size_t max, size_t *avail) {
+    frame_tls_t *t = &t_frame;
+    if (!(t->epoch == maru_atomic_load_u32(&g_epoch, MARU_MO_RELAXED) && t->cur &&
+          (size_t) (t->end - t->cur) >= max)) {
+        if (!frame_refill(max, 1, 1)) {
+            if (avail) *avail = 0;
+            return NULL;
+        }
+    }
+
+    if (avail) *avail = (size_t) (t->end - t->cur);
+    return t->cur;
+}
+
+void frame_commit(size_t used) {
+    frame_tls_t *t = &t_frame;
+    if (!t->cur || used == 0) return;
+
+    assert(used <= (size_t) (t->end - t->cur));
+    if (used > (size_t) (t->end - t->cur)) used = (size_t) (t->end - t->cur);
+
+    frame_slot_t *s = my_slot();
+    if (s) slot_add(&s->used, used);
+    t->cur += used;
 }
 
 char *frame_strdup(const char *s) {
@@ -150,40 +501,89 @@ char *frame_strndup(const char *s, size_t n) {
     return p;
 }
 
-char *frame_printf(const char *fmt, ...) {
+char *frame_vprintf(const char *fmt, va_list ap) {
     if (!fmt) return NULL;
 
-    char tmp[FRAME_PRINTF_TMP_CAP];
+    size_t avail;
+    char *p = (char*) frame_reserve(FRAME_PRINTF_RESERVE, &avail);
+    if (!p) return NULL;
+
+    va_list ap2;
+    va_copy(ap2, ap);
+    int cnt = vsnprintf(p, avail, fmt, ap2);
+    va_end(ap2);
+    if (cnt < 0) return NULL;
+
+    /* didn't fit the span: reserve the exact size and format again */
+    if ((size_t) cnt >= avail) {
+        p = (char*) frame_reserve((size_t) cnt + 1, NULL);
+        if (!p) return NULL;
+        vsnprintf(p, (size_t) cnt + 1, fmt, ap);
+    }
+
+    frame_commit((size_t) cnt + 1);
+    return p;
+}
+
+char *frame_printf(const char *fmt, ...) {
     va_list ap;
     va_start(ap, fmt);
-
-#if defined(_MSC_VER)
-    int cnt = _vsnprintf_s(tmp, FRAME_PRINTF_TMP_CAP, _TRUNCATE, fmt, ap);
-    if (cnt < 0) cnt = (int) strlen(tmp);
-#else
-    int cnt = vsnprintf(tmp, FRAME_PRINTF_TMP_CAP, fmt, ap);
-    if (cnt < 0) { va_end(ap); return NULL; }
-    if ((size_t)cnt >= FRAME_PRINTF_TMP_CAP) cnt = (int)(FRAME_PRINTF_TMP_CAP - 1);
-#endif
+    char *p = frame_vprintf(fmt, ap);
     va_end(ap);
-
-    char *p = (char*) frame_alloc((size_t) cnt + 1, 1);
-    if (!p) return NULL;
-    memcpy(p, tmp, (size_t) cnt);
-    p[cnt] = '\0';
     return p;
 }
 
 size_t frame_bytes_used(void) {
-    frame_block_t *b = curblk();
-    return b ? b->offset : 0;
+    if (!g_frame.initialized) return 0;
+
+    uint32_t n = maru_atomic_load_u32(&g_slot_count, MARU_MO_RELAXED);
+    if (n > FRAME_MAX_THREADS) n = FRAME_MAX_THREADS;
+
+    size_t total = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        total += (size_t) maru_atomic_load_u64(&g_slots[i].used, MARU_MO_RELAXED);
+    }
+    return total;
 }
 
 size_t frame_bytes_capacity(void) {
     frame_block_t *b = curblk();
-    return b ? b->cap : 0;
+    return b ? block_capacity(b) : 0;
 }
 
 int frame_current_buffer(void) {
     return g_frame.initialized ? g_frame.cur : -1;
 }
+
+size_t frame_thread_stats(frame_thread_stats_t *out, size_t max) {
+    uint32_t n = maru_atomic_load_u32(&g_slot_count, MARU_MO_RELAXED);
+    if (n > FRAME_MAX_THREADS) n = FRAME_MAX_THREADS;
+
+    for (uint32_t i = 0; out && i < n && i < max; ++i) {
+        frame_slot_t *s = &g_slots[i];
+        out[i].slot = i;
+        out[i].used = (size_t) maru_atomic_load_u64(&s->used, MARU_MO_RELAXED);
+        out[i].reserved = (size_t) maru_atomic_load_u64(&s->reserved, MARU_MO_RELAXED);
+        out[i].chunks = maru_atomic_load_u32(&s->chunks, MARU_MO_RELAXED);
+        out[i].peak_used = s->peak_used > out[i].used ? s->peak_used : out[i].used;
+    }
+    return n;
+}
+
+int frame_arena_stats(int buffer, frame_arena_stats_t *out) {
+    if (!g_frame.initialized || !out || buffer < 0 || buffer >= g_frame.block_count) return -1;
+
+    frame_block_t *b = &g_frame.blocks[buffer];
+    memset(out, 0, sizeof(*out));
+    out->capacity = main_capacity(b);
+    out->address_space = b->main.vm ? b->main.cap : 0;
+    out->reserved = block_reserved(b);
+    out->high_water = b->high_water > out->reserved ? b->high_water : out->reserved;
+    for (frame_region_t *r = overflow_head(b); r; r = r->next) {
+        out->overflow_bytes += r->cap;
+        out->overflow_regions++;
+    }
+    out->overflow_frames = b->overflow_frames;
+    out->resizes = b->resizes;
+    return 0;
+}
@@ -3,15 +3,65 @@
 
 #include "core.h"
 #include "macro.h"
+#include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * Per-frame bump allocator. frame_alloc is safe from any thread: each
+ * thread bumps through its own chunk of the current buffer and takes a new
+ * chunk with one atomic add when it runs out.
+ *
+ * init/shutdown/begin/reset must be called while no other thread is inside
+ * frame_alloc (normally from the main thread between frames). They
+ * invalidate every thread's chunk at once.
+ *
+ * A buffer that runs out chains overflow regions for the rest of its frame
+ * instead of failing; they are freed when the buffer is reused. Every
+ * resize window (default FRAME_RESIZE_WINDOW frames of that buffer) the
+ * main block is refit to the window's peak plus 1/8, so steady frames stay
+ * in one block. It grows only after an overflow and shrinks only below
+ * half use, and never under the size given to init.
+ *
+ * frame_arena_init_virtual instead reserves `reserve_bytes` of address
+ * space per buffer (see vm_arena.h) and commits it as threads take chunks,
+ * so a buffer costs what its busiest recent frame used and grows in place
+ * without overflow regions. After a resize window of frames using under
+ * half of what is committed, the tail is decommitted. Past one huge page
+ * (2 MB on x86-64) a buffer commits whole huge pages where available.
+ */
+#define FRAME_MAX_THREADS 64
+
+typedef struct frame_thread_stats {
+    uint32_t slot;          /* registration order; 0 = first thread to allocate */
+    size_t used;            /* bytes handed out this frame, alignment included */
+    size_t reserved;        /* bytes of chunks taken this frame */
+    uint32_t chunks;        /* chunk refills this frame */
+    size_t peak_used;       /* highest `used` over past frames */
+} frame_thread_stats_t;
+
+typedef struct frame_arena_stats {
+    size_t capacity;            /* main block; committed part for a virtual arena */
+    size_t address_space;       /* reserved range of a virtual arena, else 0 */
+    size_t reserved;            /* bytes handed out this frame, overflow included */
+    size_t high_water;          /* most any frame needed since init */
+    size_t overflow_bytes;      /* overflow regions chained this frame */
+    uint32_t overflow_regions;
+    uint32_t overflow_frames;   /* frames that needed overflow since init */
+    uint32_t resizes;
+} frame_arena_stats_t;
+
 int frame_arena_init(size_t bytes, int buffers);
+int frame_arena_init_virtual(size_t reserve_bytes, int buffers);
 void frame_arena_shutdown(void);
 
+/* Frames per buffer between refits (decommit checks when virtual); 0 or less keeps the main block's size */
+void frame_arena_set_resize_window(int frames);
+
 void frame_arena_begin(int frame_index);
 
 void frame_arena_reset(void);
@@ -21,11 +71,34 @@ void *frame_alloc(size_t size, size_t align);
 char *frame_strdup(const char *s);
 char *frame_strndup(const char *s, size_t n);
 char *frame_printf(const char *fmt, ...);
+char *frame_vprintf(const char *fmt, va_list ap);
 
+/*
+ * Build data in place: frame_reserve returns at least `max` writable bytes
+ * at the calling thread's cursor (*avail, if given, gets the full span,
+ * which may be larger) without claiming them; frame_commit(used) then
+ * claims the first `used` bytes. Nothing else may allocate from the frame
+ * arena on this thread in between. Unaligned; NULL if out of memory.
+ */
+void *frame_reserve(size_t max, size_t *avail);
+void frame_commit(size_t used);
+
+/* Sum over threads of bytes handed out this frame */
 size_t frame_bytes_used(void);
+/* Main block plus overflow regions of the current buffer */
 size_t frame_bytes_capacity(void);
 int frame_current_buffer(void);
 
+/*
+ * Fills up to `max` entries, one per thread that has allocated since init;
+ * returns the number of such threads. Threads past FRAME_MAX_THREADS still
+ * allocate but are not tracked.
+ */
+size_t frame_thread_stats(frame_thread_stats_t *out, size_t max);
+
+/* Returns 0, or -1 if the arena is down or `buffer` is out of range */
+int frame_arena_stats(int buffer, frame_arena_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
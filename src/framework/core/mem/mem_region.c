@@ -0,0 +1,144 @@
+#include "mem_region.h"
+
+#include <string.h>
+
+#include "log.h"
+#include "macro.h"
+
+/* Lifetimes in a row that may stay under half the committed pages before the tail goes back */
+#define REGION_DECOMMIT_WINDOW 4
+
+static void *region_alloc_cb(void *user, size_t size, size_t align) {
+    return region_alloc((mem_region_t*) user, size, align);
+}
+
+int region_init(mem_region_t *r, const char *name, size_t reserve_bytes, mem_tag_t tag) {
+    if (!r) return -1;
+
+    memset(r, 0, sizeof(*r));
+    if (vm_arena_init(&r->vm, reserve_bytes, tag) != 0) {
+        ERROR("[region] %s: failed to reserve %zu bytes", name ? name : "?", reserve_bytes);
+        return -1;
+    }
+    vm_arena_set_decommit_window(&r->vm, REGION_DECOMMIT_WINDOW);
+
+    r->name = name ? name : "region";
+    r->allocator.alloc = region_alloc_cb;
+    r->allocator.free = NULL;
+    r->allocator.user = r;
+    return 0;
+}
+
+void region_destroy(mem_region_t *r) {
+    if (!r) return;
+    vm_arena_destroy(&r->vm);
+    memset(r, 0, sizeof(*r));
+}
+
+void *region_alloc(mem_region_t *r, size_t size, size_t align) {
+    if (!r) return NULL;
+    if (align == 0) align = 16;
+
+    maru_spinlock_lock(&r->lock);
+    void *p = vm_arena_alloc(&r->vm, size ? size : 1, align);
+    if (p) r->allocs++;
+    maru_spinlock_unlock(&r->lock);
+
+    if (UNLIKELY(!p)) ERROR("[region] %s: out of memory (%zu bytes)", r->name, size);
+    return p;
+}
+
+void *region_calloc(mem_region_t *r, size_t n, size_t size) {
+    if (size && n > SIZE_MAX / size) return NULL;
+
+    /* recycled pages may hold the previous lifetime's bytes */
+    void *p = region_alloc(r, n * size, 0);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+void *region_realloc(mem_region_t *r, void *p, size_t old_size, size_t new_size, size_t align) {
+    if (!p) return region_alloc(r, new_size, align);
+    if (!r) return NULL;
+
+    uint8_t *b = (uint8_t*) p;
+    maru_spinlock_lock(&r->lock);
+    if (b + old_size == r->vm.base + r->vm.used) {
+        size_t off = (size_t) (b - r->vm.base);
+        if (new_size <= old_size || vm_arena_ensure(&r->vm, off + new_size) == 0) {
+            r->vm.used = off + new_size;
+            maru_spinlock_unlock(&r->lock);
+            return p;
+        }
+    }
+    maru_spinlock_unlock(&r->lock);
+
+    void *n = region_alloc(r, new_size, align);
+    if (n) memcpy(n, p, old_size < new_size ? old_size : new_size);
+    return n;
+}
+
+char *region_strdup(mem_region_t *r, const char *s) {
+    if (!s) return NULL;
+
+    size_t n = strlen(s) + 1;
+    char *d = (char*) region_alloc(r, n, 1);
+    if (d) memcpy(d, s, n);
+    return d;
+}
+
+region_marker_t region_mark(mem_region_t *r) {
+    region_marker_t m = {0, 0};
+    if (!r) return m;
+
+    maru_spinlock_lock(&r->lock);
+    m.pos = vm_arena_pos(&r->vm);
+    m.generation = r->generation;
+    maru_spinlock_unlock(&r->lock);
+    return m;
+}
+
+void region_rewind(mem_region_t *r, region_marker_t m) {
+    if (!r) return;
+
+    maru_spinlock_lock(&r->lock);
+    /* a reset in between already dropped everything */
+    if (m.generation == r->generation) vm_arena_rewind(&r->vm, m.pos);
+    maru_spinlock_unlock(&r->lock);
+}
+
+void region_reset(mem_region_t *r) {
+    if (!r) return;
+
+    maru_spinlock_lock(&r->lock);
+    vm_arena_reset(&r->vm);
+    r->allocs = 0;
+    r->generation++;
+    maru_spinlock_unlock(&r->lock);
+}
+
+int region_owns(const mem_region_t *r, const void *p) {
+    if (!r || !r->vm.base || !p) return 0;
+    const uint8_t *b = (const uint8_t*) p;
+    return b >= r->vm.base && b < r->vm.base + r->vm.reserved;
+}
+
+const maru_allocator_t *region_allocator(mem_region_t *r) {
+    return r ? &r->allocator : NULL;
+}
+
+void region_stats(const mem_region_t *r, region_stats_t *out) {
+    if (!out) return;
+
+    memset(out, 0, sizeof(*out));
+    if (!r) return;
+
+    vm_arena_stats_t vs;
+    vm_arena_stats(&r->vm, &vs);
+    out->used = vs.used;
+    out->committed = vs.committed;
+    out->reserved = vs.reserved;
+    out->high_water = vs.high_water;
+    out->allocs = r->allocs;
+    out->generation = r->generation;
+}
@@ -0,0 +1,77 @@
+#ifndef MARU_MEM_REGION_H
+#define MARU_MEM_REGION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "mem_diag.h"
+#include "vm_arena.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Region (zone) allocator for memory that shares one owner's lifetime: a
+ * subsystem, a loaded level. Allocation bumps a cursor in a reserved
+ * vm_arena; nothing is freed on its own. region_reset drops everything at
+ * once in O(1) and keeps the committed pages for the next owner (trimmed by
+ * the decommit window if later lifetimes need less).
+ *
+ * Safe to allocate from several threads. Whoever calls region_reset must
+ * know nobody still holds a pointer into the region; the managers that take
+ * a region provide *_release_region for that.
+ */
+typedef struct mem_region {
+    vm_arena_t vm;
+    maru_spinlock_t lock;
+    maru_allocator_t allocator;     /* alloc from the region; free is a no-op */
+    const char *name;
+    uint32_t generation;            /* bumped by every reset */
+    size_t allocs;                  /* since the last reset */
+} mem_region_t;
+
+typedef struct region_marker {
+    size_t pos;
+    uint32_t generation;
+} region_marker_t;
+
+typedef struct region_stats {
+    size_t used;
+    size_t committed;
+    size_t reserved;
+    size_t high_water;              /* most any lifetime needed */
+    size_t allocs;
+    uint32_t generation;
+} region_stats_t;
+
+/* Reserves address space only; pages are committed as they are used. Returns 0 or -1 */
+int region_init(mem_region_t *r, const char *name, size_t reserve_bytes, mem_tag_t tag);
+void region_destroy(mem_region_t *r);
+
+/* align 0 means 16. NULL on out of memory or past the reservation */
+void *region_alloc(mem_region_t *r, size_t size, size_t align);
+void *region_calloc(mem_region_t *r, size_t n, size_t size);
+
+/* In place when p is the latest allocation, otherwise copies; the old bytes stay until reset */
+void *region_realloc(mem_region_t *r, void *p, size_t old_size, size_t new_size, size_t align);
+char *region_strdup(mem_region_t *r, const char *s);
+
+/* Rewind undoes everything allocated since the mark (single owner only) */
+region_marker_t region_mark(mem_region_t *r);
+void region_rewind(mem_region_t *r, region_marker_t m);
+
+void region_reset(mem_region_t *r);
+int region_owns(const mem_region_t *r, const void *p);
+
+/* Adapter for containers taking a maru_allocator_t */
+const maru_allocator_t *region_allocator(mem_region_t *r);
+
+void region_stats(const mem_region_t *r, region_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_MEM_REGION_H */
@@ -0,0 +1,221 @@
+#include "mem_scratch.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "macro.h"
+#include "mem_diag.h"
+#include "vm_arena.h"
+
+/* Smallest block; a scope that needs more gets a block sized to fit */
+#ifndef SCRATCH_BLOCK_BYTES
+#define SCRATCH_BLOCK_BYTES (256 * 1024)
+#endif
+
+#define SCRATCH_DEFAULT_ALIGN 16
+#define SCRATCH_GRAIN ((size_t) 64 * 1024)
+
+typedef struct scratch_block_t {
+    struct scratch_block_t *prev;
+    size_t cap;
+    size_t offset;
+} scratch_block_t;
+
+#define BLOCK_HDR ALIGN_UP(sizeof(scratch_block_t), (size_t) 64)
+
+typedef struct scratch_tls_t {
+    scratch_block_t *top;
+    scratch_block_t *spare;
+    size_t below;           /* bytes used in the blocks under top */
+    size_t high_water;
+} scratch_tls_t;
+
+static MARU_THREAD_LOCAL scratch_tls_t t_scratch;
+
+static inline uint8_t *block_data(scratch_block_t *b) {
+    return (uint8_t*) b + BLOCK_HDR;
+}
+
+/*
+ * Blocks of a huge page or more (big image decodes) are mapped on huge
+ * pages; the size alone tells which way a block was allocated.
+ */
+static int block_is_large(size_t cap) {
+    size_t huge = vm_huge_page_size();
+    return huge && BLOCK_HDR + cap >= huge;
+}
+
+static scratch_block_t *block_alloc(size_t cap) {
+    if (block_is_large(cap)) {
+        return (scratch_block_t*) vm_alloc_large(BLOCK_HDR + cap, MEM_TAG_SCRATCH, 0);
+    }
+    return (scratch_block_t*) MARU_MALLOC_T(MEM_TAG_SCRATCH, BLOCK_HDR + cap);
+}
+
+static void block_free(scratch_block_t *b) {
+    if (block_is_large(b->cap)) {
+        vm_free_large(b, BLOCK_HDR + b->cap, MEM_TAG_SCRATCH);
+    } else {
+        MARU_FREE(b);
+    }
+}
+
+/* Keeps one default-sized block for the next scope; oversized ones (a one-off decode) go back */
+static void block_release(scratch_tls_t *t, scratch_block_t *b) {
+    if (!t->spare && b->cap <= SCRATCH_BLOCK_BYTES) {
+        t->spare = b;
+    } else {
+        block_free(b);
+    }
+}
+
+static scratch_block_t *block_push(scratch_tls_t *t, size_t need) {
+    size_t cap = need > SCRATCH_BLOCK_BYTES ? need : SCRATCH_BLOCK_BYTES;
+    cap = ALIGN_UP(cap, SCRATCH_GRAIN);
+    if (block_is_large(cap)) {
+        /* the mapping is rounded to whole huge pages anyway; use the slack */
+        size_t huge = vm_huge_page_size();
+        cap = ALIGN_UP(BLOCK_HDR + cap, huge) - BLOCK_HDR;
+    }
+
+    scratch_block_t *b;
+    if (t->spare && t->spare->cap >= cap) {
+        b = t->spare;
+        t->spare = NULL;
+    } else {
+        b = block_alloc(cap);
+        if (!b) return NULL;
+        b->cap = cap;
+    }
+
+    if (t->top) t->below += t->top->offset;
+    b->prev = t->top;
+    b->offset = 0;
+    t->top = b;
+    return b;
+}
+
+scratch_marker_t scratch_push(void) {
+    scratch_tls_t *t = &t_scratch;
+    scratch_marker_t m;
+    m.block = t->top;
+    m.offset = t->top ? t->top->offset : 0;
+    return m;
+}
+
+void scratch_pop(scratch_marker_t marker) {
+    scratch_tls_t *t = &t_scratch;
+
+    while (t->top && t->top != (scratch_block_t*) marker.block) {
+        scratch_block_t *b = t->top;
+        t->top = b->prev;
+        if (t->top) t->below -= t->top->offset;
+        block_release(t, b);
+    }
+
+    assert(t->top == (scratch_block_t*) marker.block);
+    if (t->top) {
+        assert(marker.offset <= t->top->offset);
+        t->top->offset = marker.offset;
+    } else {
+        t->below = 0;
+    }
+}
+
+void *scratch_alloc(size_t size, size_t align) {
+    scratch_tls_t *t = &t_scratch;
+    if (align == 0) align = SCRATCH_DEFAULT_ALIGN;
+
+    scratch_block_t *b = t->top;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (b) {
+            uint8_t *data = block_data(b);
+            uintptr_t p = ALIGN_UP((uintptr_t) (data + b->offset), (uintptr_t) align);
+            if (p <= (uintptr_t) (data + b->cap) && size <= (size_t) ((uintptr_t) (data + b->cap) - p)) {
+                b->offset = (size_t) (p + size - (uintptr_t) data);
+
+                size_t used = t->below + b->offset;
+                if (used > t->high_water) t->high_water = used;
+                return (void*) p;
+            }
+        }
+
+        size_t need = size + align - 1;
+        if (need < size) return NULL;
+        b = block_push(t, need);
+        if (!b) return NULL;
+    }
+    return NULL;
+}
+
+void *scratch_calloc(size_t n, size_t size) {
+    if (size && n > (size_t) -1 / size) return NULL;
+
+    void *p = scratch_alloc(n * size, 0);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+void *scratch_realloc(void *p, size_t old_size, size_t new_size, size_t align) {
+    if (!p) return scratch_alloc(new_size, align);
+
+    scratch_tls_t *t = &t_scratch;
+    scratch_block_t *b = t->top;
+    if (b) {
+        uint8_t *data = block_data(b);
+        uint8_t *q = (uint8_t*) p;
+        /* most recent allocation: move the cursor instead of copying */
+        if (q + old_size == data + b->offset && new_size <= (size_t) (data + b->cap - q)) {
+            b->offset = (size_t) (q - data) + new_size;
+
+            size_t used = t->below + b->offset;
+            if (used > t->high_water) t->high_water = used;
+            return p;
+        }
+    }
+    if (new_size <= old_size) return p;
+
+    void *np = scratch_alloc(new_size, align);
+    if (np) memcpy(np, p, old_size);
+    return np;
+}
+
+char *scratch_strdup(const char *s) {
+    if (!s) return NULL;
+
+    size_t n = strlen(s);
+    char *p = (char*) scratch_alloc(n + 1, 1);
+    if (!p) return NULL;
+
+    memcpy(p, s, n + 1);
+    return p;
+}
+
+void scratch_stats(scratch_stats_t *out) {
+    if (!out) return;
+
+    scratch_tls_t *t = &t_scratch;
+    memset(out, 0, sizeof(*out));
+    out->used = t->below + (t->top ? t->top->offset : 0);
+    out->high_water = t->high_water;
+    for (scratch_block_t *b = t->top; b; b = b->prev) {
+        out->capacity += b->cap;
+        out->blocks++;
+    }
+    if (t->spare) {
+        out->capacity += t->spare->cap;
+        out->blocks++;
+    }
+}
+
+void scratch_thread_release(void) {
+    scratch_tls_t *t = &t_scratch;
+
+    scratch_marker_t empty = {NULL, 0};
+    scratch_pop(empty);
+    if (t->spare) {
+        block_free(t->spare);
+        t->spare = NULL;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef MARU_MEM_SCRATCH_H
+#define MARU_MEM_SCRATCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Thread-local linear scratch with markers, for temporary memory whose
+ * lifetime is a scope (importers, file buffers, decode buffers):
+ *
+ *     scratch_marker_t m = scratch_push();
+ *     char *buf = scratch_alloc(n, 16);
+ *     ...
+ *     scratch_pop(m);     everything allocated since push is gone
+ *
+ * Scopes nest. Each thread has its own chain of blocks, so there is no
+ * locking. When a scope outgrows its block another is chained, sized to
+ * fit. One spare default-sized block is kept per thread to avoid churn;
+ * bigger blocks are freed as soon as their scope pops, so a one-off large
+ * decode does not stay resident. scratch_thread_release frees everything
+ * (threads from maru_thread_create do this on exit).
+ */
+typedef struct scratch_marker {
+    void *block;
+    size_t offset;
+} scratch_marker_t;
+
+typedef struct scratch_stats {
+    size_t used;            /* bytes allocated on this thread right now */
+    size_t capacity;        /* bytes of blocks held, spare included */
+    size_t high_water;      /* most `used` ever reached on this thread */
+    size_t blocks;
+} scratch_stats_t;
+
+scratch_marker_t scratch_push(void);
+void scratch_pop(scratch_marker_t marker);
+
+/* align 0 means 16. NULL on out of memory. */
+void *scratch_alloc(size_t size, size_t align);
+void *scratch_calloc(size_t n, size_t size);
+
+/*
+ * Grows or shrinks a scratch block. In place when p is the most recent
+ * allocation and fits; otherwise copies and leaves the old bytes until pop.
+ */
+void *scratch_realloc(void *p, size_t old_size, size_t new_size, size_t align);
+
+/* Length + 1 bytes, NUL-terminated */
+char *scratch_strdup(const char *s);
+
+void scratch_stats(scratch_stats_t *out);
+void scratch_thread_release(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_MEM_SCRATCH_H */
@@ -0,0 +1,244 @@
+#include "mem_slab.h"
+
+#include <string.h>
+
+#include "macro.h"
+#include "mem_diag.h"
+#include "thread/atomic.h"
+
+#define SLAB_PAGE_BYTES (64 * 1024)
+#define CLASS_COUNT 8
+
+/* Objects per refill from the shared list; a cache spills half once it holds twice this */
+#define CACHE_BATCH 32
+
+static const uint16_t k_class_size[CLASS_COUNT] = {16, 32, 48, 64, 96, 128, 192, 256};
+
+/* (size + 15) / 16 -> class */
+static const uint8_t k_class_of[SLAB_MAX_SIZE / 16 + 1] = {
+    0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7
+};
+
+typedef struct slab_node_t {
+    struct slab_node_t *next;
+} slab_node_t;
+
+typedef struct slab_page_t {
+    struct slab_page_t *next;
+} slab_page_t;
+
+#define PAGE_HDR ALIGN_UP(sizeof(slab_page_t), (size_t) 16)
+
+typedef slab_pool_t slab_class_t;
+
+static slab_class_t g_classes[CLASS_COUNT] = {
+    SLAB_POOL_INIT(16, MEM_TAG_CORE),  SLAB_POOL_INIT(32, MEM_TAG_CORE),
+    SLAB_POOL_INIT(48, MEM_TAG_CORE),  SLAB_POOL_INIT(64, MEM_TAG_CORE),
+    SLAB_POOL_INIT(96, MEM_TAG_CORE),  SLAB_POOL_INIT(128, MEM_TAG_CORE),
+    SLAB_POOL_INIT(192, MEM_TAG_CORE), SLAB_POOL_INIT(256, MEM_TAG_CORE),
+};
+
+static inline int class_of(size_t size) {
+    return k_class_of[(size + 15) >> 4];
+}
+
+/* Takes up to `want` objects off the shared side as a linked chain; caller holds the lock */
+static slab_node_t *class_take(slab_class_t *c, uint32_t obj_size, uint32_t want, uint32_t *got) {
+    slab_node_t *head = NULL;
+    uint32_t n = 0;
+
+    while (n < want && c->free) {
+        slab_node_t *node = c->free;
+        c->free = node->next;
+        node->next = head;
+        head = node;
+        ++n;
+    }
+    c->free_count -= n;
+
+    while (n < want) {
+        if (c->bump + obj_size > c->bump_end) {
+            slab_page_t *page = (slab_page_t*) MARU_MALLOC_T(c->tag, SLAB_PAGE_BYTES);
+            if (!page) break;
+
+            page->next = c->pages;
+            c->pages = page;
+            c->page_count++;
+            c->bump = (uint8_t*) page + PAGE_HDR;
+            c->bump_end = (uint8_t*) page + SLAB_PAGE_BYTES;
+        }
+
+        slab_node_t *node = (slab_node_t*) c->bump;
+        c->bump += obj_size;
+        node->next = head;
+        head = node;
+        ++n;
+    }
+
+    c->in_use += n;
+    *got = n;
+    return head;
+}
+
+/* Caller holds the lock */
+static void class_give(slab_class_t *c, slab_node_t *head, slab_node_t *tail, uint32_t n) {
+    tail->next = c->free;
+    c->free = head;
+    c->free_count += n;
+    c->in_use -= n;
+}
+
+#ifndef MARU_SLAB_NO_TLS_CACHE
+
+typedef struct slab_cache_t {
+    slab_node_t *head;
+    uint32_t count;
+} slab_cache_t;
+
+static MARU_THREAD_LOCAL slab_cache_t t_cache[CLASS_COUNT];
+
+static void cache_spill(slab_cache_t *cache, slab_class_t *c, uint32_t n) {
+    slab_node_t *head = cache->head;
+    slab_node_t *tail = head;
+    for (uint32_t i = 1; i < n; ++i) tail = tail->next;
+
+    cache->head = tail->next;
+    cache->count -= n;
+
+    maru_spinlock_lock(&c->lock);
+    class_give(c, head, tail, n);
+    maru_spinlock_unlock(&c->lock);
+}
+
+void *slab_alloc(size_t size) {
+    if (size > SLAB_MAX_SIZE) return MARU_MALLOC(size);
+
+    int ci = class_of(size);
+    slab_cache_t *cache = &t_cache[ci];
+    if (UNLIKELY(!cache->head)) {
+        slab_class_t *c = &g_classes[ci];
+        maru_spinlock_lock(&c->lock);
+        cache->head = class_take(c, k_class_size[ci], CACHE_BATCH, &cache->count);
+        maru_spinlock_unlock(&c->lock);
+        if (!cache->head) return NULL;
+    }
+
+    slab_node_t *node = cache->head;
+    cache->head = node->next;
+    cache->count--;
+    return node;
+}
+
+void slab_free(void *p, size_t size) {
+    if (!p) return;
+    if (size > SLAB_MAX_SIZE) {
+        MARU_FREE(p);
+        return;
+    }
+
+    int ci = class_of(size);
+#ifdef MARU_DEBUG
+    memset(p, 0xDD, k_class_size[ci]);
+#endif
+
+    slab_cache_t *cache = &t_cache[ci];
+    slab_node_t *node = (slab_node_t*) p;
+    node->next = cache->head;
+    cache->head = node;
+
+    if (UNLIKELY(++cache->count >= 2 * CACHE_BATCH)) {
+        cache_spill(cache, &g_classes[ci], CACHE_BATCH);
+    }
+}
+
+void slab_thread_flush(void) {
+    for (int ci = 0; ci < CLASS_COUNT; ++ci) {
+        slab_cache_t *cache = &t_cache[ci];
+        if (cache->count) cache_spill(cache, &g_classes[ci], cache->count);
+    }
+}
+
+#else
+
+void *slab_alloc(size_t size) {
+    if (size > SLAB_MAX_SIZE) return MARU_MALLOC(size);
+
+    int ci = class_of(size);
+    slab_class_t *c = &g_classes[ci];
+    uint32_t got;
+
+    maru_spinlock_lock(&c->lock);
+    slab_node_t *node = class_take(c, k_class_size[ci], 1, &got);
+    maru_spinlock_unlock(&c->lock);
+    return node;
+}
+
+void slab_free(void *p, size_t size) {
+    if (!p) return;
+    if (size > SLAB_MAX_SIZE) {
+        MARU_FREE(p);
+        return;
+    }
+
+    int ci = class_of(size);
+#ifdef MARU_DEBUG
+    memset(p, 0xDD, k_class_size[ci]);
+#endif
+
+    slab_class_t *c = &g_classes[ci];
+    slab_node_t *node = (slab_node_t*) p;
+    maru_spinlock_lock(&c->lock);
+    class_give(c, node, node, 1);
+    maru_spinlock_unlock(&c->lock);
+}
+
+void slab_thread_flush(void) {
+}
+
+#endif /* MARU_SLAB_NO_TLS_CACHE */
+
+void *slab_calloc(size_t size) {
+    void *p = slab_alloc(size);
+    if (p) memset(p, 0, size);
+    return p;
+}
+
+void *slab_pool_alloc(slab_pool_t *pool) {
+    uint32_t got;
+    maru_spinlock_lock(&pool->lock);
+    slab_node_t *node = class_take(pool, pool->obj_size, 1, &got);
+    maru_spinlock_unlock(&pool->lock);
+    return node;
+}
+
+void slab_pool_free(slab_pool_t *pool, void *p) {
+    if (!p) return;
+#ifdef MARU_DEBUG
+    memset(p, 0xDD, pool->obj_size);
+#endif
+
+    slab_node_t *node = (slab_node_t*) p;
+    maru_spinlock_lock(&pool->lock);
+    class_give(pool, node, node, 1);
+    maru_spinlock_unlock(&pool->lock);
+}
+
+static void pool_stats(slab_pool_t *c, slab_class_stats_t *out) {
+    maru_spinlock_lock(&c->lock);
+    out->size = c->obj_size;
+    out->pages = c->page_count;
+    out->in_use = c->in_use;
+    out->free = c->free_count + (size_t) (c->bump_end - c->bump) / c->obj_size;
+    maru_spinlock_unlock(&c->lock);
+}
+
+void slab_pool_stats(slab_pool_t *pool, slab_class_stats_t *out) {
+    if (pool && out) pool_stats(pool, out);
+}
+
+size_t slab_stats(slab_class_stats_t *out, size_t max) {
+    for (size_t i = 0; out && i < CLASS_COUNT && i < max; ++i) {
+        pool_stats(&g_classes[i], &out[i]);
+    }
+    return CLASS_COUNT;
+}
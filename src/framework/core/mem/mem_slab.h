@@ -0,0 +1,81 @@
+#ifndef MARU_MEM_SLAB_H
+#define MARU_MEM_SLAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mem_diag.h"
+#include "thread/atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Size-class slab allocator for small fixed-size objects (backend handles,
+ * command lists, tiny wrappers). Sizes up to SLAB_MAX_SIZE round up to one
+ * of a few classes; each class carves objects out of 64 KB pages with no
+ * per-object header and keeps a free list. Larger sizes fall through to
+ * MARU_MALLOC.
+ *
+ * Frees are sized: pass the size given to slab_alloc. Each thread keeps a
+ * small cache per class so the common alloc/free is a list pop/push with no
+ * lock; the cache refills from and spills back to the shared class in
+ * batches. Define MARU_SLAB_NO_TLS_CACHE to go straight to the shared lists.
+ *
+ * Pages are kept for the life of the process and counted under MEM_TAG_CORE.
+ * A type that should count under its own tag gets a slab_pool_t instead.
+ */
+#define SLAB_MAX_SIZE 256
+
+void *slab_alloc(size_t size);
+void *slab_calloc(size_t size);
+void slab_free(void *p, size_t size);
+
+/* Returns this thread's cached objects to the shared lists, e.g. before the thread exits */
+void slab_thread_flush(void);
+
+typedef struct slab_class_stats {
+    size_t size;            /* object size of the class */
+    size_t pages;
+    size_t in_use;          /* objects handed out, thread caches included */
+    size_t free;            /* carved or not, on the shared side */
+} slab_class_stats_t;
+
+/* Fills up to `max` classes, smallest first; returns the number of classes */
+size_t slab_stats(slab_class_stats_t *out, size_t max);
+
+/*
+ * One size class of its own, its pages counted under `tag`. No thread
+ * cache: every alloc/free takes the pool's spinlock. Meant to be a static:
+ *
+ *     static slab_pool_t s_pool = SLAB_POOL_INIT(sizeof(thing_t), MEM_TAG_MESH);
+ */
+typedef struct slab_pool {
+    maru_spinlock_t lock;
+    struct slab_node_t *free;
+    size_t free_count;
+    uint8_t *bump;              /* uncarved tail of the newest page */
+    uint8_t *bump_end;
+    struct slab_page_t *pages;
+    size_t page_count;
+    size_t in_use;
+    uint32_t obj_size;
+    mem_tag_t tag;
+    uint8_t pad_[MARU_CACHE_LINE];
+} slab_pool_t;
+
+#define SLAB_POOL_INIT(size, mem_tag) {.obj_size = (uint32_t) (((size) + 15) & ~(size_t) 15), .tag = (mem_tag)}
+
+void *slab_pool_alloc(slab_pool_t *pool);
+void slab_pool_free(slab_pool_t *pool, void *p);
+void slab_pool_stats(slab_pool_t *pool, slab_class_stats_t *out);
+
+#define MARU_SLAB_NEW(type)  ((type*) slab_calloc(sizeof(type)))
+#define MARU_SLAB_DELETE(p)  slab_free((p), sizeof(*(p)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_MEM_SLAB_H */
@@ -0,0 +1,589 @@
+#include "tlsf.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macro.h"
+#include "mem_diag.h"
+#include "thread/atomic.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/*
+ * Size classes: sizes below SMALL_BLOCK map linearly onto first-level 0 in
+ * ALIGN-byte steps; above it, first level = log2(size) and second level =
+ * the next SL_LOG2 bits.
+ */
+#define ALIGN_LOG2   4
+#define TLSF_ALIGN   (1u << ALIGN_LOG2)
+#define SL_LOG2      5
+#define SL_COUNT     (1u << SL_LOG2)
+#define FL_SHIFT     (SL_LOG2 + ALIGN_LOG2)
+#define SMALL_BLOCK  ((size_t) 1 << FL_SHIFT)
+
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define FL_MAX_LOG2  32
+#else
+#define FL_MAX_LOG2  30
+#endif
+#define FL_COUNT     (FL_MAX_LOG2 - FL_SHIFT + 1)
+
+#define BLOCK_FREE       ((size_t) 1)
+#define BLOCK_PREV_FREE  ((size_t) 2)
+#define BLOCK_FLAGS      (BLOCK_FREE | BLOCK_PREV_FREE)
+
+/*
+ * Physical block. prev_phys is kept valid for every block; next_free and
+ * prev_free overlay the payload and only mean something while the block is
+ * free. The header is padded to TLSF_ALIGN so payloads stay aligned.
+ */
+typedef struct tlsf_block {
+    struct tlsf_block *prev_phys;
+    size_t size;                    /* payload bytes | flags */
+#if UINTPTR_MAX <= 0xFFFFFFFFu
+    uint8_t pad_[8];
+#endif
+    struct tlsf_block *next_free;
+    struct tlsf_block *prev_free;
+} tlsf_block_t;
+
+#define BLOCK_HDR      offsetof(tlsf_block_t, next_free)
+#define BLOCK_MIN      (sizeof(tlsf_block_t) - BLOCK_HDR)
+
+/* Start of every region; the first block follows it */
+typedef struct tlsf_pool {
+    struct tlsf_pool *next;
+    size_t bytes;
+} tlsf_pool_t;
+
+#define POOL_HDR       ALIGN_UP(sizeof(tlsf_pool_t), (size_t) TLSF_ALIGN)
+
+struct tlsf {
+    uint32_t fl_bitmap;
+    uint32_t sl_bitmap[FL_COUNT];
+    tlsf_block_t *heads[FL_COUNT][SL_COUNT];
+
+    tlsf_pool_t *pools;
+    size_t pool_bytes;
+    size_t used_bytes;
+    size_t used_blocks;
+};
+
+#define CONTROL_SIZE   ALIGN_UP(sizeof(struct tlsf), (size_t) TLSF_ALIGN)
+
+/* ---- bit helpers ---- */
+
+static inline uint32_t bit_ffs(uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return (uint32_t) i;
+#else
+    return (uint32_t) __builtin_ctz(v);
+#endif
+}
+
+static inline uint32_t bit_fls_size(size_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanReverse64(&i, (unsigned __int64) v);
+#else
+    _BitScanReverse(&i, (unsigned long) v);
+#endif
+    return (uint32_t) i;
+#else
+    return (uint32_t) (63 - __builtin_clzll((unsigned long long) v));
+#endif
+}
+
+/* ---- block helpers ---- */
+
+static inline size_t block_size(const tlsf_block_t *b) {
+    return b->size & ~BLOCK_FLAGS;
+}
+
+static inline void block_set_size(tlsf_block_t *b, size_t size) {
+    b->size = size | (b->size & BLOCK_FLAGS);
+}
+
+static inline int block_is_free(const tlsf_block_t *b) {
+    return (b->size & BLOCK_FREE) != 0;
+}
+
+static inline int block_is_prev_free(const tlsf_block_t *b) {
+    return (b->size & BLOCK_PREV_FREE) != 0;
+}
+
+static inline void *block_payload(const tlsf_block_t *b) {
+    return (uint8_t*) b + BLOCK_HDR;
+}
+
+static inline tlsf_block_t *block_from_ptr(const void *p) {
+    return (tlsf_block_t*) ((uint8_t*) p - BLOCK_HDR);
+}
+
+static inline tlsf_block_t *block_next(const tlsf_block_t *b) {
+    return (tlsf_block_t*) ((uint8_t*) block_payload(b) + block_size(b));
+}
+
+static inline void block_mark_free(tlsf_block_t *b) {
+    b->size |= BLOCK_FREE;
+    block_next(b)->size |= BLOCK_PREV_FREE;
+}
+
+static inline void block_mark_used(tlsf_block_t *b) {
+    b->size &= ~BLOCK_FREE;
+    block_next(b)->size &= ~BLOCK_PREV_FREE;
+}
+
+/* ---- size class mapping ---- */
+
+static inline void mapping_insert(size_t size, uint32_t *fl, uint32_t *sl) {
+    if (size < SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (uint32_t) (size / (SMALL_BLOCK / SL_COUNT));
+    } else {
+        uint32_t f = bit_fls_size(size);
+        *sl = (uint32_t) (size >> (f - SL_LOG2)) ^ SL_COUNT;
+        *fl = f - (FL_SHIFT - 1);
+    }
+}
+
+/* Rounds up to the next class boundary so any block in the class fits */
+static inline void mapping_search(size_t size, uint32_t *fl, uint32_t *sl) {
+    if (size >= SMALL_BLOCK) {
+        size += ((size_t) 1 << (bit_fls_size(size) - SL_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static tlsf_block_t *search_suitable(const tlsf_t *t, uint32_t *fl, uint32_t *sl) {
+    uint32_t sl_map = t->sl_bitmap[*fl] & (~0u << *sl);
+    if (!sl_map) {
+        uint32_t fl_map = t->fl_bitmap & (~0u << (*fl + 1));
+        if (!fl_map) return NULL;
+        *fl = bit_ffs(fl_map);
+        sl_map = t->sl_bitmap[*fl];
+    }
+    *sl = bit_ffs(sl_map);
+    return t->heads[*fl][*sl];
+}
+
+static void remove_free(tlsf_t *t, tlsf_block_t *b, uint32_t fl, uint32_t sl) {
+    tlsf_block_t *prev = b->prev_free;
+    tlsf_block_t *next = b->next_free;
+    if (next) next->prev_free = prev;
+    if (prev) {
+        prev->next_free = next;
+    } else {
+        t->heads[fl][sl] = next;
+        if (!next) {
+            t->sl_bitmap[fl] &= ~(1u << sl);
+            if (!t->sl_bitmap[fl]) t->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
+
+static void remove_free_block(tlsf_t *t, tlsf_block_t *b) {
+    uint32_t fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+    remove_free(t, b, fl, sl);
+}
+
+static void insert_free(tlsf_t *t, tlsf_block_t *b) {
+    uint32_t fl, sl;
+    mapping_insert(block_size(b), &fl, &sl);
+
+    tlsf_block_t *head = t->heads[fl][sl];
+    b->prev_free = NULL;
+    b->next_free = head;
+    if (head) head->prev_free = b;
+    t->heads[fl][sl] = b;
+
+    t->fl_bitmap |= 1u << fl;
+    t->sl_bitmap[fl] |= 1u << sl;
+}
+
+/* ---- split / merge ---- */
+
+/* Cuts b down to `size` payload bytes; the tail becomes a new block marked free (not yet listed) */
+static tlsf_block_t *block_split(tlsf_block_t *b, size_t size) {
+    tlsf_block_t *rest = (tlsf_block_t*) ((uint8_t*) block_payload(b) + size);
+    rest->size = (block_size(b) - size - BLOCK_HDR) | BLOCK_FREE;
+    rest->prev_phys = b;
+    block_set_size(b, size);
+
+    tlsf_block_t *next = block_next(rest);
+    next->prev_phys = rest;
+    next->size |= BLOCK_PREV_FREE;
+    return rest;
+}
+
+static inline int block_can_split(const tlsf_block_t *b, size_t size) {
+    return block_size(b) >= size + BLOCK_HDR + BLOCK_MIN;
+}
+
+/* Absorbs the physically next block into b */
+static void block_absorb(tlsf_block_t *b, tlsf_block_t *next) {
+    block_set_size(b, block_size(b) + BLOCK_HDR + block_size(next));
+    block_next(b)->prev_phys = b;
+}
+
+static tlsf_block_t *merge_prev(tlsf_t *t, tlsf_block_t *b) {
+    if (block_is_prev_free(b)) {
+        tlsf_block_t *prev = b->prev_phys;
+        remove_free_block(t, prev);
+        block_absorb(prev, b);
+        b = prev;
+    }
+    return b;
+}
+
+static tlsf_block_t *merge_next(tlsf_t *t, tlsf_block_t *b) {
+    tlsf_block_t *next = block_next(b);
+    if (block_is_free(next)) {
+        remove_free_block(t, next);
+        block_absorb(b, next);
+    }
+    return b;
+}
+
+/* Gives the tail of a used block beyond `size` back to the free lists */
+static void trim_used(tlsf_t *t, tlsf_block_t *b, size_t size) {
+    if (!block_can_split(b, size)) return;
+
+    tlsf_block_t *rest = block_split(b, size);
+    rest = merge_next(t, rest);
+    insert_free(t, rest);
+}
+
+static inline size_t adjust_request(size_t size) {
+    if (size > tlsf_max_alloc()) return 0;
+    size_t adj = ALIGN_UP(size, (size_t) TLSF_ALIGN);
+    return adj < BLOCK_MIN ? BLOCK_MIN : adj;
+}
+
+/* ---- public ---- */
+
+size_t tlsf_control_size(void) {
+    return CONTROL_SIZE;
+}
+
+size_t tlsf_pool_overhead(void) {
+    /* pool header, first block header, sentinel header */
+    return POOL_HDR + 2 * BLOCK_HDR;
+}
+
+size_t tlsf_max_alloc(void) {
+    return ((size_t) 1 << (FL_MAX_LOG2 - 1)) - TLSF_ALIGN;
+}
+
+tlsf_t *tlsf_create(void *mem, size_t bytes) {
+    if (!mem) return NULL;
+
+    uintptr_t start = ALIGN_UP((uintptr_t) mem, (uintptr_t) TLSF_ALIGN);
+    size_t lost = (size_t) (start - (uintptr_t) mem);
+    if (bytes < lost + CONTROL_SIZE) return NULL;
+
+    tlsf_t *t = (tlsf_t*) start;
+    memset(t, 0, sizeof(*t));
+
+    size_t rest = bytes - lost - CONTROL_SIZE;
+    if (rest > tlsf_pool_overhead() + BLOCK_MIN) {
+        if (tlsf_add_pool(t, (uint8_t*) t + CONTROL_SIZE, rest) != 0) return NULL;
+    }
+    return t;
+}
+
+int tlsf_add_pool(tlsf_t *t, void *mem, size_t bytes) {
+    if (!t || !mem) return -1;
+
+    uintptr_t start = ALIGN_UP((uintptr_t) mem, (uintptr_t) TLSF_ALIGN);
+    size_t lost = (size_t) (start - (uintptr_t) mem);
+    if (bytes <= lost + tlsf_pool_overhead() + BLOCK_MIN) return -1;
+
+    size_t payload = ALIGN_DOWN(bytes - lost - tlsf_pool_overhead(), (size_t) TLSF_ALIGN);
+    if (payload > tlsf_max_alloc()) return -1;
+
+    tlsf_pool_t *pool = (tlsf_pool_t*) start;
+    pool->bytes = bytes - lost;
+    pool->next = t->pools;
+    t->pools = pool;
+    t->pool_bytes += bytes;
+
+    tlsf_block_t *b = (tlsf_block_t*) (start + POOL_HDR);
+    b->prev_phys = NULL;
+    b->size = payload | BLOCK_FREE;
+
+    /* zero-size used sentinel stops merges at the end of the region */
+    tlsf_block_t *sentinel = block_next(b);
+    sentinel->prev_phys = b;
+    sentinel->size = BLOCK_PREV_FREE;
+
+    insert_free(t, b);
+    return 0;
+}
+
+void *tlsf_malloc(tlsf_t *t, size_t size) {
+    size_t adj = adjust_request(size);
+    if (!t || !adj) return NULL;
+
+    uint32_t fl, sl;
+    mapping_search(adj, &fl, &sl);
+    if (fl >= FL_COUNT) return NULL;
+
+    tlsf_block_t *b = search_suitable(t, &fl, &sl);
+    if (!b) return NULL;
+    remove_free(t, b, fl, sl);
+
+    if (block_can_split(b, adj)) {
+        insert_free(t, block_split(b, adj));
+    }
+    block_mark_used(b);
+
+    t->used_bytes += block_size(b);
+    t->used_blocks++;
+    return block_payload(b);
+}
+
+void tlsf_free(tlsf_t *t, void *ptr) {
+    if (!t || !ptr) return;
+
+    tlsf_block_t *b = block_from_ptr(ptr);
+    t->used_bytes -= block_size(b);
+    t->used_blocks--;
+
+    block_mark_free(b);
+    b = merge_prev(t, b);
+    b = merge_next(t, b);
+    insert_free(t, b);
+}
+
+void *tlsf_realloc(tlsf_t *t, void *ptr, size_t size) {
+    if (!ptr) return tlsf_malloc(t, size);
+    if (size == 0) {
+        tlsf_free(t, ptr);
+        return NULL;
+    }
+
+    size_t adj = adjust_request(size);
+    if (!t || !adj) return NULL;
+
+    tlsf_block_t *b = block_from_ptr(ptr);
+    size_t cur = block_size(b);
+    t->used_bytes -= cur;
+
+    if (adj > cur) {
+        tlsf_block_t *next = block_next(b);
+        if (!block_is_free(next) || cur + BLOCK_HDR + block_size(next) < adj) {
+            t->used_bytes += cur;
+
+            void *np = tlsf_malloc(t, size);
+            if (!np) return NULL;
+            memcpy(np, ptr, cur);
+            tlsf_free(t, ptr);
+            return np;
+        }
+
+        /* grow in place into the free neighbour */
+        remove_free_block(t, next);
+        block_absorb(b, next);
+        block_next(b)->size &= ~BLOCK_PREV_FREE;
+    }
+
+    trim_used(t, b, adj);
+    t->used_bytes += block_size(b);
+    return ptr;
+}
+
+size_t tlsf_block_size(const void *ptr) {
+    return ptr ? block_size(block_from_ptr(ptr)) : 0;
+}
+
+static tlsf_block_t *pool_first(const tlsf_pool_t *pool) {
+    return (tlsf_block_t*) ((uint8_t*) pool + POOL_HDR);
+}
+
+int tlsf_owns(const tlsf_t *t, const void *ptr) {
+    if (!t || !ptr) return 0;
+
+    const uint8_t *p = (const uint8_t*) ptr;
+    for (const tlsf_pool_t *pool = t->pools; pool; pool = pool->next) {
+        const uint8_t *base = (const uint8_t*) pool;
+        if (p >= base && p < base + pool->bytes) return 1;
+    }
+    return 0;
+}
+
+void tlsf_get_stats(const tlsf_t *t, tlsf_stats_t *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!t) return;
+
+    out->pool_bytes = t->pool_bytes;
+    for (const tlsf_pool_t *pool = t->pools; pool; pool = pool->next) {
+        for (tlsf_block_t *b = pool_first(pool); block_size(b) != 0; b = block_next(b)) {
+            size_t sz = block_size(b);
+            if (block_is_free(b)) {
+                out->free_bytes += sz;
+                out->free_blocks++;
+                if (sz > out->largest_free) out->largest_free = sz;
+            } else {
+                out->used_bytes += sz;
+                out->used_blocks++;
+            }
+        }
+    }
+
+    out->overhead_bytes = out->pool_bytes - out->used_bytes - out->free_bytes;
+    out->fragmentation = out->free_bytes
+                             ? 1.0f - (float) out->largest_free / (float) out->free_bytes
+                             : 0.0f;
+}
+
+int tlsf_check(const tlsf_t *t) {
+    if (!t) return -1;
+
+    size_t free_walk = 0;
+    for (const tlsf_pool_t *pool = t->pools; pool; pool = pool->next) {
+        tlsf_block_t *prev = NULL;
+        int prev_free = 0;
+
+        for (tlsf_block_t *b = pool_first(pool);; b = block_next(b)) {
+            if (b->prev_phys != prev) return -1;
+            if (block_is_prev_free(b) != prev_free) return -1;
+            if (block_size(b) == 0) break; /* sentinel */
+
+            if (((uintptr_t) block_payload(b) & (TLSF_ALIGN - 1)) != 0) return -1;
+            if (block_is_free(b)) {
+                if (prev_free) return -1; /* unmerged neighbours */
+                ++free_walk;
+            }
+
+            prev_free = block_is_free(b);
+            prev = b;
+        }
+    }
+
+    size_t free_listed = 0;
+    for (uint32_t fl = 0; fl < FL_COUNT; ++fl) {
+        if (((t->fl_bitmap >> fl) & 1u) != (t->sl_bitmap[fl] != 0)) return -1;
+
+        for (uint32_t sl = 0; sl < SL_COUNT; ++sl) {
+            tlsf_block_t *head = t->heads[fl][sl];
+            if (((t->sl_bitmap[fl] >> sl) & 1u) != (head != NULL)) return -1;
+
+            for (tlsf_block_t *b = head; b; b = b->next_free) {
+                uint32_t bfl, bsl;
+                mapping_insert(block_size(b), &bfl, &bsl);
+                if (!block_is_free(b) || bfl != fl || bsl != sl) return -1;
+                if (b->next_free && b->next_free->prev_free != b) return -1;
+                ++free_listed;
+            }
+        }
+    }
+
+    return free_walk == free_listed ? 0 : -1;
+}
+
+/* ---- MARU_MALLOC backend ---- */
+
+static struct {
+    maru_spinlock_t lock;
+    tlsf_t *heap;
+    size_t region_bytes;
+} g_backend;
+
+/* Regions are never returned; they live as long as the process */
+static int backend_grow(size_t need) {
+    size_t bytes = g_backend.region_bytes;
+    size_t min = need + tlsf_pool_overhead() + TLSF_ALIGN;
+    if (need >= SMALL_BLOCK) min += (size_t) 1 << (bit_fls_size(need) - SL_LOG2); /* class round-up */
+    if (bytes < min) bytes = min;
+
+    void *mem = malloc(bytes);
+    if (!mem) return -1;
+    if (tlsf_add_pool(g_backend.heap, mem, bytes) != 0) {
+        free(mem);
+        return -1;
+    }
+    return 0;
+}
+
+static void *backend_alloc(void *user, size_t size) {
+    UNUSED(user);
+    maru_spinlock_lock(&g_backend.lock);
+    void *p = tlsf_malloc(g_backend.heap, size);
+    if (!p && size <= tlsf_max_alloc() && backend_grow(size) == 0) {
+        p = tlsf_malloc(g_backend.heap, size);
+    }
+    maru_spinlock_unlock(&g_backend.lock);
+    return p;
+}
+
+static void *backend_realloc(void *user, void *ptr, size_t size) {
+    UNUSED(user);
+    maru_spinlock_lock(&g_backend.lock);
+    void *p = tlsf_realloc(g_backend.heap, ptr, size);
+    if (!p && size && size <= tlsf_max_alloc() && backend_grow(size) == 0) {
+        p = tlsf_realloc(g_backend.heap, ptr, size);
+    }
+    maru_spinlock_unlock(&g_backend.lock);
+    return p;
+}
+
+static void backend_free(void *user, void *ptr) {
+    UNUSED(user);
+    maru_spinlock_lock(&g_backend.lock);
+    tlsf_free(g_backend.heap, ptr);
+    maru_spinlock_unlock(&g_backend.lock);
+}
+
+static int backend_owns(void *user, const void *ptr) {
+    UNUSED(user);
+    maru_spinlock_lock(&g_backend.lock);
+    int owned = tlsf_owns(g_backend.heap, ptr);
+    maru_spinlock_unlock(&g_backend.lock);
+    return owned;
+}
+
+int mem_tlsf_backend_init(size_t region_bytes) {
+    if (g_backend.heap) return 0;
+    if (region_bytes < 64 * 1024) region_bytes = 64 * 1024;
+
+    void *mem = malloc(region_bytes);
+    if (!mem) return -1;
+
+    tlsf_t *heap = tlsf_create(mem, region_bytes);
+    if (!heap) {
+        free(mem);
+        return -1;
+    }
+
+    g_backend.heap = heap;
+    g_backend.region_bytes = region_bytes;
+
+    mem_backend_t be = {backend_alloc, backend_realloc, backend_free, NULL, backend_owns};
+    if (mem_set_backend(&be) != 0) {
+        g_backend.heap = NULL;
+        free(mem);
+        return -1;
+    }
+    return 0;
+}
+
+void mem_tlsf_backend_stats(tlsf_stats_t *out) {
+    if (!out) return;
+    if (!g_backend.heap) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+
+    maru_spinlock_lock(&g_backend.lock);
+    tlsf_get_stats(g_backend.heap, out);
+    maru_spinlock_unlock(&g_backend.lock);
+}
@@ -0,0 +1,78 @@
+#ifndef MARU_TLSF_H
+#define MARU_TLSF_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Two-level segregated fit allocator over caller-provided regions.
+ *
+ * Free blocks sit in 32 size classes per power of two, indexed by two
+ * bitmaps, so malloc and free are O(1): a couple of bit scans, no list walk
+ * beyond the head. Adjacent free blocks merge immediately. Blocks carry a
+ * 16-byte header and payloads are 16-byte aligned.
+ *
+ * Not thread-safe; wrap it in a lock (see mem_tlsf_backend_init) when shared.
+ */
+typedef struct tlsf tlsf_t;
+
+typedef struct tlsf_stats {
+    size_t pool_bytes;      /* sum of every region handed to the allocator */
+    size_t used_bytes;      /* payload bytes in allocated blocks */
+    size_t free_bytes;      /* payload bytes in free blocks */
+    size_t overhead_bytes;  /* headers, sentinels, control structure */
+    size_t used_blocks;
+    size_t free_blocks;
+    size_t largest_free;
+    float fragmentation;    /* 1 - largest_free / free_bytes; 0 = one free run */
+} tlsf_stats_t;
+
+/* Control structure at the start of `mem`; the rest becomes the first pool. NULL if too small. */
+tlsf_t *tlsf_create(void *mem, size_t bytes);
+
+/* Adds another region. Returns 0, or -1 if it is too small or too large. */
+int tlsf_add_pool(tlsf_t *t, void *mem, size_t bytes);
+
+/* Bytes tlsf_create needs before the first pool starts */
+size_t tlsf_control_size(void);
+
+/* Per-region bookkeeping; a region must be larger than this to hold anything */
+size_t tlsf_pool_overhead(void);
+
+/* Largest single request the allocator can represent */
+size_t tlsf_max_alloc(void);
+
+void *tlsf_malloc(tlsf_t *t, size_t size);
+void *tlsf_realloc(tlsf_t *t, void *ptr, size_t size);
+void tlsf_free(tlsf_t *t, void *ptr);
+
+/* Whether ptr lies in one of t's regions; O(regions) */
+int tlsf_owns(const tlsf_t *t, const void *ptr);
+
+/* Usable payload of an allocated block (>= the requested size) */
+size_t tlsf_block_size(const void *ptr);
+
+/* Walks every pool; O(blocks) */
+void tlsf_get_stats(const tlsf_t *t, tlsf_stats_t *out);
+
+/* Validates block links, flags and free lists. 0 if consistent, else -1 */
+int tlsf_check(const tlsf_t *t);
+
+/*
+ * Installs a TLSF heap as the MARU_MALLOC backend (see mem_set_backend).
+ * Regions come from the system allocator, `region_bytes` at a time, with
+ * more added on demand; a spinlock serializes access. It may be installed
+ * after allocations were made, while no other thread allocates; earlier
+ * blocks stay with libc. Returns 0, or -1.
+ */
+int mem_tlsf_backend_init(size_t region_bytes);
+void mem_tlsf_backend_stats(tlsf_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_TLSF_H */
@@ -0,0 +1,374 @@
+#include "vm_arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#   define VM_WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   define NOGDI               /* wingdi's ERROR clashes with log.h */
+#   include <windows.h>
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#   define VM_POSIX
+#   include <sys/mman.h>
+#   include <unistd.h>
+#   ifndef MAP_ANONYMOUS
+#       define MAP_ANONYMOUS MAP_ANON
+#   endif
+#   ifndef MAP_NORESERVE
+#       define MAP_NORESERVE 0
+#   endif
+#endif
+
+#include "log.h"
+#include "macro.h"
+
+#define VM_DEFAULT_GRAIN ((size_t) 64 * 1024)
+
+#if defined(VM_POSIX) && defined(__linux__) && defined(MADV_HUGEPAGE)
+#   define VM_THP
+#endif
+
+static size_t g_page_size;
+static size_t g_huge_size;
+static int g_huge_probed;
+
+size_t vm_page_size(void) {
+    if (g_page_size) return g_page_size;
+
+    size_t sz = 4096;
+#if defined(VM_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    sz = (size_t) si.dwPageSize;
+#elif defined(VM_POSIX)
+    long v = sysconf(_SC_PAGESIZE);
+    if (v > 0) sz = (size_t) v;
+#endif
+    g_page_size = sz;
+    return sz;
+}
+
+size_t vm_huge_page_size(void) {
+#if defined(VM_THP)
+    if (g_huge_probed) return g_huge_size;
+
+    /* THP in "never" mode ignores madvise; anything else honours it */
+    size_t sz = 0;
+    char mode[64] = {0};
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (f) {
+        if (fgets(mode, sizeof(mode), f) && !strstr(mode, "[never]")) sz = (size_t) 2 * 1024 * 1024;
+        fclose(f);
+    }
+
+    f = sz ? fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r") : NULL;
+    if (f) {
+        unsigned long v = 0;
+        if (fscanf(f, "%lu", &v) == 1 && v && (v & (v - 1)) == 0) sz = (size_t) v;
+        fclose(f);
+    }
+
+    g_huge_size = sz;
+    g_huge_probed = 1;
+    return sz;
+#else
+    return 0;
+#endif
+}
+
+#if defined(VM_POSIX)
+/* Reserves `bytes` at an `align` boundary by over-mapping and trimming both ends */
+static void *reserve_aligned(size_t bytes, size_t align) {
+    if (align <= vm_page_size()) return vm_reserve(bytes);
+
+    size_t span = bytes + align;
+    uint8_t *raw = (uint8_t*) vm_reserve(span);
+    if (!raw) return NULL;
+
+    uint8_t *p = (uint8_t*) ALIGN_UP((uintptr_t) raw, (uintptr_t) align);
+    if (p > raw) munmap(raw, (size_t) (p - raw));
+    size_t tail = (size_t) (raw + span - (p + bytes));
+    if (tail) munmap(p + bytes, tail);
+    return p;
+}
+#endif
+
+/* Bytes a large allocation really maps, so alloc and free agree */
+static size_t large_size(size_t bytes) {
+    size_t huge = vm_huge_page_size();
+    return (huge && bytes >= huge) ? ALIGN_UP(bytes, huge) : ALIGN_UP(bytes, vm_page_size());
+}
+
+void *vm_alloc_large(size_t bytes, mem_tag_t tag, unsigned flags) {
+    if (bytes == 0) return NULL;
+
+    size_t sz = large_size(bytes);
+    void *p = NULL;
+#if defined(VM_POSIX)
+    size_t huge = vm_huge_page_size();
+    int use_huge = huge && sz >= huge;
+#   if defined(MAP_HUGETLB)
+    if (use_huge && (flags & VM_LARGE_HUGETLB)) {
+        p = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED) p = NULL;
+    }
+#   else
+    UNUSED(flags);
+#   endif
+    if (!p) {
+        p = reserve_aligned(sz, use_huge ? huge : vm_page_size());
+        if (p && vm_commit(p, sz) != 0) {
+            vm_release(p, sz);
+            p = NULL;
+        }
+#   if defined(VM_THP)
+        if (p && use_huge) madvise(p, sz, MADV_HUGEPAGE);
+#   endif
+    }
+#elif defined(VM_WIN32)
+    /* large pages need SeLockMemoryPrivilege; normal pages are the fallback */
+    UNUSED(flags);
+    p = VirtualAlloc(NULL, sz, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    UNUSED(flags);
+    p = calloc(1, sz);
+#endif
+
+    if (p) mem_tag_commit(tag, sz);
+    return p;
+}
+
+void vm_free_large(void *p, size_t bytes, mem_tag_t tag) {
+    if (!p) return;
+
+    size_t sz = large_size(bytes);
+    mem_tag_decommit(tag, sz);
+#if defined(VM_POSIX) || defined(VM_WIN32)
+    vm_release(p, sz);
+#else
+    free(p);
+#endif
+}
+
+void *vm_reserve(size_t bytes) {
+    if (bytes == 0) return NULL;
+#if defined(VM_WIN32)
+    return VirtualAlloc(NULL, bytes, MEM_RESERVE, PAGE_NOACCESS);
+#elif defined(VM_POSIX)
+    void *p = mmap(NULL, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+#else
+    /* no virtual memory: the whole range is real from the start */
+    return calloc(1, bytes);
+#endif
+}
+
+int vm_commit(void *p, size_t bytes) {
+    if (!p || bytes == 0) return 0;
+#if defined(VM_WIN32)
+    return VirtualAlloc(p, bytes, MEM_COMMIT, PAGE_READWRITE) ? 0 : -1;
+#elif defined(VM_POSIX)
+    return mprotect(p, bytes, PROT_READ | PROT_WRITE) == 0 ? 0 : -1;
+#else
+    return 0;
+#endif
+}
+
+void vm_decommit(void *p, size_t bytes) {
+    if (!p || bytes == 0) return;
+#if defined(VM_WIN32)
+    VirtualFree(p, bytes, MEM_DECOMMIT);
+#elif defined(VM_POSIX)
+    /* remapping drops the pages at once, where MADV_DONTNEED may be lazy */
+    mmap(p, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+#endif
+}
+
+void vm_release(void *p, size_t bytes) {
+    if (!p) return;
+#if defined(VM_WIN32)
+    UNUSED(bytes);
+    VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(VM_POSIX)
+    munmap(p, bytes);
+#else
+    UNUSED(bytes);
+    free(p);
+#endif
+}
+
+int vm_arena_init(vm_arena_t *a, size_t reserve_bytes, mem_tag_t tag) {
+    if (!a || reserve_bytes == 0) return -1;
+
+    memset(a, 0, sizeof(*a));
+    a->grain = ALIGN_UP(VM_DEFAULT_GRAIN, vm_page_size());
+    a->reserved = ALIGN_UP(reserve_bytes, a->grain);
+    a->tag = tag;
+#if defined(VM_POSIX)
+    /* align big ranges so vm_arena_set_huge_pages can work on whole huge pages */
+    size_t huge = vm_huge_page_size();
+    a->base = (uint8_t*) reserve_aligned(a->reserved, (huge && a->reserved >= huge) ? huge : 0);
+#else
+    a->base = (uint8_t*) vm_reserve(a->reserved);
+#endif
+    if (!a->base) {
+        ERROR("[vm] failed to reserve %zu bytes", a->reserved);
+        memset(a, 0, sizeof(*a));
+        return -1;
+    }
+    return 0;
+}
+
+void vm_arena_destroy(vm_arena_t *a) {
+    if (!a || !a->base) return;
+
+    mem_tag_decommit(a->tag, vm_arena_committed(a));
+    vm_release(a->base, a->reserved);
+    memset(a, 0, sizeof(*a));
+}
+
+void vm_arena_set_grain(vm_arena_t *a, size_t grain) {
+    if (!a || grain == 0) return;
+    a->grain = ALIGN_UP(grain, vm_page_size());
+}
+
+void vm_arena_set_decommit_window(vm_arena_t *a, uint32_t periods) {
+    if (!a) return;
+    a->decommit_window = periods;
+    a->low_periods = 0;
+    a->window_peak = 0;
+}
+
+int vm_arena_set_huge_pages(vm_arena_t *a) {
+    size_t huge = vm_huge_page_size();
+    if (!a || !a->base || !huge || a->reserved < huge || ((uintptr_t) a->base & (huge - 1))) return -1;
+
+#if defined(VM_THP)
+    if (madvise(a->base, a->reserved, MADV_HUGEPAGE) != 0) return -1;
+#endif
+    a->huge = 1;
+    return 0;
+}
+
+/* Commit boundary for `bytes`: grain steps, whole huge pages past the first */
+static size_t commit_round(const vm_arena_t *a, size_t bytes) {
+    size_t want = ALIGN_UP(bytes, a->grain);
+    if (a->huge) {
+        size_t huge = vm_huge_page_size();
+        if (want > huge) want = ALIGN_UP(bytes, huge);
+    }
+    return want > a->reserved ? a->reserved : want;
+}
+
+size_t vm_arena_committed(const vm_arena_t *a) {
+    return a ? (size_t) maru_atomic_load_u64(&a->committed, MARU_MO_ACQUIRE) : 0;
+}
+
+int vm_arena_ensure(vm_arena_t *a, size_t bytes) {
+    if (LIKELY(bytes <= vm_arena_committed(a))) return 0;
+    if (!a || !a->base || bytes > a->reserved) return -1;
+
+    int rc = 0;
+    maru_spinlock_lock(&a->commit_lock);
+
+    size_t have = (size_t) maru_atomic_load_u64(&a->committed, MARU_MO_RELAXED);
+    if (bytes > have) {
+        size_t want = commit_round(a, bytes);
+        if (vm_commit(a->base + have, want - have) == 0) {
+            mem_tag_commit(a->tag, want - have);
+            /* release: other threads may use the pages once they see the new size */
+            maru_atomic_store_u64(&a->committed, want, MARU_MO_RELEASE);
+        } else {
+            ERROR("[vm] failed to commit %zu bytes", want - have);
+            rc = -1;
+        }
+    }
+
+    maru_spinlock_unlock(&a->commit_lock);
+    return rc;
+}
+
+void *vm_arena_alloc(vm_arena_t *a, size_t size, size_t align) {
+    if (!a || !a->base) return NULL;
+    if (align == 0) align = 1;
+
+    size_t off = ALIGN_UP(a->used, align);
+    if (off < a->used || off > a->reserved || size > a->reserved - off) return NULL;
+    if (vm_arena_ensure(a, off + size) != 0) return NULL;
+
+    a->used = off + size;
+    return a->base + off;
+}
+
+size_t vm_arena_pos(const vm_arena_t *a) {
+    return a ? a->used : 0;
+}
+
+void vm_arena_rewind(vm_arena_t *a, size_t pos) {
+    if (!a || pos > a->used) return;
+    a->used = pos;
+}
+
+void vm_arena_reset(vm_arena_t *a) {
+    if (!a) return;
+    size_t used = a->used;
+    a->used = 0;
+    vm_arena_end_period(a, used);
+}
+
+static void arena_decommit_past(vm_arena_t *a, size_t keep) {
+    keep = commit_round(a, keep);
+
+    maru_spinlock_lock(&a->commit_lock);
+    size_t have = (size_t) maru_atomic_load_u64(&a->committed, MARU_MO_RELAXED);
+    if (keep < have) {
+        vm_decommit(a->base + keep, have - keep);
+#if defined(VM_THP)
+        /* decommit remaps the range, which drops the advice */
+        if (a->huge) madvise(a->base + keep, have - keep, MADV_HUGEPAGE);
+#endif
+        mem_tag_decommit(a->tag, have - keep);
+        maru_atomic_store_u64(&a->committed, keep, MARU_MO_RELEASE);
+        a->decommits++;
+    }
+    maru_spinlock_unlock(&a->commit_lock);
+}
+
+void vm_arena_end_period(vm_arena_t *a, size_t used) {
+    if (!a || !a->base) return;
+
+    if (used > a->high_water) a->high_water = used;
+    if (a->decommit_window == 0) return;
+
+    if (used > a->window_peak) a->window_peak = used;
+    if (used >= vm_arena_committed(a) / 2) {
+        a->low_periods = 0;
+        a->window_peak = 0;
+        return;
+    }
+    if (++a->low_periods < a->decommit_window) return;
+
+    /* keep the window's peak plus 1/8 so the next busy period doesn't recommit at once */
+    arena_decommit_past(a, a->window_peak + a->window_peak / 8);
+    a->low_periods = 0;
+    a->window_peak = 0;
+}
+
+void vm_arena_trim(vm_arena_t *a, size_t keep) {
+    if (!a || !a->base) return;
+    arena_decommit_past(a, keep > a->used ? keep : a->used);
+}
+
+void vm_arena_stats(const vm_arena_t *a, vm_arena_stats_t *out) {
+    if (!out) return;
+
+    memset(out, 0, sizeof(*out));
+    if (!a) return;
+    out->reserved = a->reserved;
+    out->committed = vm_arena_committed(a);
+    out->used = a->used;
+    out->high_water = a->high_water > a->used ? a->high_water : a->used;
+    out->decommits = a->decommits;
+}
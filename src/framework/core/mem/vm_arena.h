@@ -0,0 +1,121 @@
+#ifndef MARU_VM_ARENA_H
+#define MARU_VM_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mem_diag.h"
+#include "thread/atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Address-space primitives. vm_reserve maps a range with no access and no
+ * backing; vm_commit makes part of it readable/writable (the OS supplies
+ * zeroed pages on first touch); vm_decommit hands the pages back but keeps
+ * the range reserved. Sizes and offsets are multiples of vm_page_size().
+ * Platforms without virtual memory get a malloc'd range that is always
+ * committed.
+ */
+size_t vm_page_size(void);
+void *vm_reserve(size_t bytes);
+int vm_commit(void *p, size_t bytes);
+void vm_decommit(void *p, size_t bytes);
+void vm_release(void *p, size_t bytes);
+
+/*
+ * Huge pages. vm_huge_page_size is 0 where the engine can't ask for them
+ * (only Linux transparent huge pages are wired up). vm_alloc_large maps a
+ * committed, zeroed region aligned to the huge page size and advises huge
+ * pages on it; with VM_LARGE_HUGETLB it first tries explicit MAP_HUGETLB
+ * pages, which only exist if the admin reserved some. Falls back to normal
+ * pages (malloc where there is no virtual memory). Free with the same size
+ * and tag.
+ */
+#define VM_LARGE_HUGETLB 1u
+
+size_t vm_huge_page_size(void);
+void *vm_alloc_large(size_t bytes, mem_tag_t tag, unsigned flags);
+void vm_free_large(void *p, size_t bytes, mem_tag_t tag);
+
+/*
+ * A reserved range committed from the front as it is used, so a large
+ * reservation costs only what is touched and never moves. Commit happens
+ * in `grain` steps (64 KB by default) and is counted under the arena's tag.
+ *
+ * vm_arena_alloc/rewind/reset bump a single-threaded cursor. Callers that
+ * manage their own cursor (frame arena, pools) use vm_arena_ensure instead,
+ * which is safe from any thread.
+ *
+ * With a decommit window set, each vm_arena_reset (or vm_arena_end_period
+ * for external cursors) records the period's use; after `window` periods in
+ * a row under half of what is committed, the tail past the window's peak
+ * is decommitted.
+ *
+ * vm_arena_set_huge_pages marks the range for huge pages. Reservations of
+ * at least one huge page are aligned to it, and once the committed size
+ * passes a huge page, commits round up to whole huge pages so each can be
+ * backed by one TLB entry. Small arenas stay on `grain` steps.
+ */
+typedef struct vm_arena {
+    uint8_t *base;
+    size_t reserved;
+    maru_atomic_u64_t committed;
+    maru_spinlock_t commit_lock;
+    size_t grain;
+    size_t used;                /* vm_arena_alloc cursor */
+    mem_tag_t tag;
+    int huge;
+
+    uint32_t decommit_window;   /* periods; 0 = never decommit */
+    uint32_t low_periods;
+    size_t window_peak;
+    size_t high_water;
+    uint32_t decommits;
+} vm_arena_t;
+
+typedef struct vm_arena_stats {
+    size_t reserved;
+    size_t committed;
+    size_t used;
+    size_t high_water;          /* most one period needed since init */
+    uint32_t decommits;
+} vm_arena_stats_t;
+
+/* Reserves `reserve_bytes` (rounded up to the grain); commits nothing. Returns 0 or -1 */
+int vm_arena_init(vm_arena_t *a, size_t reserve_bytes, mem_tag_t tag);
+void vm_arena_destroy(vm_arena_t *a);
+
+/* Commit step; a multiple of the page size. Call before first use */
+void vm_arena_set_grain(vm_arena_t *a, size_t grain);
+void vm_arena_set_decommit_window(vm_arena_t *a, uint32_t periods);
+/* Returns 0, or -1 if huge pages aren't available (the arena still works) */
+int vm_arena_set_huge_pages(vm_arena_t *a);
+
+/* Makes [base, base + bytes) usable. Returns 0, or -1 past the reservation or if the OS refuses */
+int vm_arena_ensure(vm_arena_t *a, size_t bytes);
+
+void *vm_arena_alloc(vm_arena_t *a, size_t size, size_t align);
+size_t vm_arena_pos(const vm_arena_t *a);
+void vm_arena_rewind(vm_arena_t *a, size_t pos);
+void vm_arena_reset(vm_arena_t *a);
+
+/*
+ * Closes a period that needed `used` bytes and applies the decommit window.
+ * Caller guarantees nobody touches memory past `used` until it ensures it again.
+ */
+void vm_arena_end_period(vm_arena_t *a, size_t used);
+
+/* Decommits everything past max(keep, cursor) right away */
+void vm_arena_trim(vm_arena_t *a, size_t keep);
+
+size_t vm_arena_committed(const vm_arena_t *a);
+void vm_arena_stats(const vm_arena_t *a, vm_arena_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_VM_ARENA_H */
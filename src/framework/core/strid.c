@@ -0,0 +1,113 @@
+#include "strid.h"
+
+#include <string.h>
+
+#include "container/hashmap.h"
+#include "thread/mutex.h"
+#include "mem/mem_diag.h"
+#include "log.h"
+
+#define STRID_BLOCK_SIZE (16 * 1024)
+
+/* Interned characters live in blocks that are never moved or freed before shutdown */
+typedef struct strid_block {
+    struct strid_block *next;
+    size_t used;
+    size_t cap;
+    char data[];
+} strid_block_t;
+
+static struct {
+    map_u64_ptr_t by_id;     /* strid_t -> interned chars */
+    strid_block_t *blocks;
+    mutex_t *lock;
+    int initialized;
+} g_strid;
+
+int strid_system_init(void) {
+    if (g_strid.initialized) return 0;
+
+    g_strid.lock = maru_mutex_create();
+    if (!g_strid.lock) return -1;
+
+    map_u64_ptr_init(&g_strid.by_id, maru_tagged_allocator(MEM_TAG_CORE));
+    g_strid.blocks = NULL;
+    g_strid.initialized = 1;
+    return 0;
+}
+
+void strid_system_shutdown(void) {
+    if (!g_strid.initialized) return;
+
+    map_u64_ptr_destroy(&g_strid.by_id);
+
+    strid_block_t *b = g_strid.blocks;
+    while (b) {
+        strid_block_t *next = b->next;
+        MARU_FREE(b);
+        b = next;
+    }
+
+    maru_mutex_destroy(g_strid.lock);
+    memset(&g_strid, 0, sizeof(g_strid));
+}
+
+static char *store(const char *s, size_t len) {
+    strid_block_t *b = g_strid.blocks;
+    if (!b || b->cap - b->used < len + 1) {
+        size_t cap = len + 1 > STRID_BLOCK_SIZE ? len + 1 : STRID_BLOCK_SIZE;
+        b = (strid_block_t*) MARU_MALLOC_T(MEM_TAG_CORE, sizeof(strid_block_t) + cap);
+        if (!b) return NULL;
+
+        b->used = 0;
+        b->cap = cap;
+        b->next = g_strid.blocks;
+        g_strid.blocks = b;
+    }
+
+    char *dst = b->data + b->used;
+    memcpy(dst, s, len + 1);
+    b->used += len + 1;
+    return dst;
+}
+
+const char *strid_intern_str(const char *s) {
+    if (!s) return NULL;
+    if (!g_strid.initialized && strid_system_init() != 0) return NULL;
+
+    strid_t id = strid_hash(s);
+
+    maru_mutex_lock(g_strid.lock);
+
+    const char *str = (const char*) map_u64_ptr_get(&g_strid.by_id, id, NULL);
+    if (str) {
+        if (strcmp(str, s) != 0) {
+            /* The ID stays mapped to the first string; s still gets a stable copy */
+            ERROR("strid: hash collision 0x%08x between \"%s\" and \"%s\"", id, str, s);
+            str = store(s, strlen(s));
+        }
+    } else {
+        char *copy = store(s, strlen(s));
+        if (copy && map_u64_ptr_put(&g_strid.by_id, id, copy) == 0) {
+            str = copy;
+        }
+    }
+
+    maru_mutex_unlock(g_strid.lock);
+    return str;
+}
+
+strid_t strid_intern(const char *s) {
+    if (!s) return STRID_NONE;
+    strid_intern_str(s);
+    return strid_hash(s);
+}
+
+const char *strid_str(strid_t id) {
+    if (!g_strid.initialized) return NULL;
+
+    maru_mutex_lock(g_strid.lock);
+    const char *str = (const char*) map_u64_ptr_get(&g_strid.by_id, id, NULL);
+    maru_mutex_unlock(g_strid.lock);
+    return str;
+}
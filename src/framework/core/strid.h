@@ -0,0 +1,96 @@
+#ifndef MARU_STRID_H
+#define MARU_STRID_H
+
+/*
+ * String IDs: FNV-1a hashes of names, 32-bit (strid_t) or 64-bit (strid64_t).
+ *
+ * MARU_SID("uMVP") hashes a string literal with the same function as
+ * strid_hash, but written as one expression the compiler folds to a constant
+ * (any optimisation level above -O0). Literals longer than MARU_SID_MAX_LEN
+ * fall back to the runtime hash. Non-literals do not compile.
+ *
+ * strid_intern additionally remembers the string, so the ID can be mapped back
+ * (strid_str) and callers can hold one shared copy instead of duplicating it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t strid_t;
+typedef uint64_t strid64_t;
+
+#define STRID_NONE ((strid_t)0)
+
+#define STRID_FNV32_BASIS 2166136261u
+#define STRID_FNV32_PRIME 16777619u
+#define STRID_FNV64_BASIS 14695981039346656037ull
+#define STRID_FNV64_PRIME 1099511628211ull
+
+static inline strid_t strid_hash(const char *s) {
+    uint32_t h = STRID_FNV32_BASIS;
+    if (!s) return STRID_NONE;
+    for (; *s; ++s) {
+        h = (h ^ (uint8_t) *s) * STRID_FNV32_PRIME;
+    }
+    return h;
+}
+
+static inline strid64_t strid_hash64(const char *s) {
+    uint64_t h = STRID_FNV64_BASIS;
+    if (!s) return 0;
+    for (; *s; ++s) {
+        h = (h ^ (uint8_t) *s) * STRID_FNV64_PRIME;
+    }
+    return h;
+}
+
+#define MARU_SID_MAX_LEN 64
+
+#define MARU_SID(lit) \
+    ((strid_t) (sizeof("" lit) - 1 <= MARU_SID_MAX_LEN \
+        ? MARU_SID_64_(32, lit, STRID_FNV32_BASIS) : strid_hash(lit)))
+
+#define MARU_SID64(lit) \
+    ((strid64_t) (sizeof("" lit) - 1 <= MARU_SID_MAX_LEN \
+        ? MARU_SID_64_(64, lit, STRID_FNV64_BASIS) : strid_hash64(lit)))
+
+/*
+ * One FNV-1a step per character index. Past the end of the literal a step is
+ * (h ^ 0) * 1, i.e. the identity, and `h` appears once per step, so the
+ * expansion stays linear in MARU_SID_MAX_LEN.
+ */
+#define MARU_SID_IN_(s, i)  ((size_t) (i) < sizeof(s) - 1)
+#define MARU_SID_CH_(s, i)  (MARU_SID_IN_(s, i) ? (uint8_t) (s)[MARU_SID_IN_(s, i) ? (i) : 0] : 0u)
+#define MARU_SID_S32_(s, i, h) \
+    (((uint32_t) (h) ^ MARU_SID_CH_(s, i)) * (MARU_SID_IN_(s, i) ? STRID_FNV32_PRIME : 1u))
+#define MARU_SID_S64_(s, i, h) \
+    (((uint64_t) (h) ^ MARU_SID_CH_(s, i)) * (MARU_SID_IN_(s, i) ? STRID_FNV64_PRIME : 1ull))
+
+#define MARU_SID_4_(w, s, i, h) \
+    MARU_SID_S##w##_(s, (i) + 3, MARU_SID_S##w##_(s, (i) + 2, MARU_SID_S##w##_(s, (i) + 1, MARU_SID_S##w##_(s, (i), h))))
+#define MARU_SID_16_(w, s, i, h) \
+    MARU_SID_4_(w, s, (i) + 12, MARU_SID_4_(w, s, (i) + 8, MARU_SID_4_(w, s, (i) + 4, MARU_SID_4_(w, s, (i), h))))
+#define MARU_SID_64_(w, s, h) \
+    MARU_SID_16_(w, s, 48, MARU_SID_16_(w, s, 32, MARU_SID_16_(w, s, 16, MARU_SID_16_(w, s, 0, h))))
+
+/* Intern table. init is optional (first use initialises); call it before other threads intern. */
+int strid_system_init(void);
+void strid_system_shutdown(void);
+
+strid_t strid_intern(const char *s);
+
+/* Stable pointer to the interned copy of s (valid until shutdown) */
+const char *strid_intern_str(const char *s);
+
+/* The interned string for id, or NULL if it was only ever hashed */
+const char *strid_str(strid_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_STRID_H */
@@ -0,0 +1,40 @@
+#include "atomic.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__) || defined(__linux__)
+#include <sched.h>
+#else
+#error "Unsupported platform for maru_thread_yield"
+#endif
+
+/* Pause-loop iterations before a waiter starts yielding its time slice */
+#define SPIN_LIMIT 64
+
+void maru_thread_yield(void) {
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+void maru_spinlock_lock_slow(maru_spinlock_t *l) {
+    uint32_t spins = 0;
+    uint32_t backoff = 1;
+
+    for (;;) {
+        /* wait on a plain load so the line stays shared until the holder releases it */
+        while (maru_atomic_load_u32(&l->locked, MARU_MO_RELAXED) != 0) {
+            if (spins < SPIN_LIMIT) {
+                for (uint32_t i = 0; i < backoff; ++i) maru_cpu_pause();
+                spins += backoff;
+                if (backoff < 16) backoff <<= 1;
+            } else {
+                maru_thread_yield();
+            }
+        }
+
+        if (maru_spinlock_trylock(l)) return;
+    }
+}
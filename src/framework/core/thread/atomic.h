@@ -0,0 +1,301 @@
+#ifndef MARU_ATOMIC_H
+#define MARU_ATOMIC_H
+
+#include <stdint.h>
+
+#include "macro.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MARU_ATOMIC_MSVC 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Memory orders, same meaning as C11 memory_order_*. In short:
+ *   RELAXED  atomicity only; no ordering against other memory.
+ *   ACQUIRE  (loads) later reads/writes stay after it.
+ *   RELEASE  (stores) earlier reads/writes stay before it. A thread whose
+ *            acquire load observes the value sees everything written
+ *            before the release.
+ *   ACQ_REL  both, for read-modify-write.
+ *   SEQ_CST  acq_rel plus one total order over all seq_cst operations.
+ * Publish data with a release store and consume it with an acquire load of
+ * the same variable; relaxed is only for counters and statistics.
+ */
+typedef enum {
+    MARU_MO_RELAXED,
+    MARU_MO_ACQUIRE,
+    MARU_MO_RELEASE,
+    MARU_MO_ACQ_REL,
+    MARU_MO_SEQ_CST
+} maru_memory_order;
+
+typedef struct { volatile uint32_t v; } maru_atomic_u32_t;
+typedef struct { volatile uint64_t v; } maru_atomic_u64_t;
+typedef struct { void *volatile v; } maru_atomic_ptr_t;
+
+/* Keep independently written hot fields this far apart to avoid false sharing */
+#define MARU_CACHE_LINE 64
+
+#if defined(MARU_ATOMIC_MSVC)
+
+/* x86/x64 loads and stores are already acquire/release; only the compiler must not reorder. */
+#define MARU_ATOMIC_BARRIER_() _ReadWriteBarrier()
+
+/*
+ * ARM64 reorders plain loads and stores in hardware, so there acquire
+ * loads are followed and release stores preceded by a dmb. The Interlocked
+ * intrinsics are full barriers on both.
+ */
+#if defined(_M_ARM64)
+#define MARU_ATOMIC_ACQUIRE_(mo) do { if ((mo) != MARU_MO_RELAXED) __dmb(_ARM64_BARRIER_ISH); else _ReadWriteBarrier(); } while (0)
+#define MARU_ATOMIC_RELEASE_(mo) MARU_ATOMIC_ACQUIRE_(mo)
+#else
+#define MARU_ATOMIC_ACQUIRE_(mo) ((void) (mo), MARU_ATOMIC_BARRIER_())
+#define MARU_ATOMIC_RELEASE_(mo) ((void) (mo), MARU_ATOMIC_BARRIER_())
+#endif
+
+MARU_INLINE uint32_t maru_atomic_load_u32(const maru_atomic_u32_t *a, maru_memory_order mo) {
+    uint32_t v = a->v;
+    MARU_ATOMIC_ACQUIRE_(mo);
+    return v;
+}
+
+MARU_INLINE void maru_atomic_store_u32(maru_atomic_u32_t *a, uint32_t v, maru_memory_order mo) {
+    if (mo == MARU_MO_SEQ_CST) {
+        _InterlockedExchange((volatile long*) &a->v, (long) v);
+        return;
+    }
+    MARU_ATOMIC_RELEASE_(mo);
+    a->v = v;
+}
+
+MARU_INLINE uint32_t maru_atomic_fetch_add_u32(maru_atomic_u32_t *a, uint32_t d, maru_memory_order mo) {
+    UNUSED(mo);
+    return (uint32_t) _InterlockedExchangeAdd((volatile long*) &a->v, (long) d);
+}
+
+MARU_INLINE int maru_atomic_cas_u32(maru_atomic_u32_t *a, uint32_t *expected, uint32_t desired, maru_memory_order mo) {
+    UNUSED(mo);
+    uint32_t prev = (uint32_t) _InterlockedCompareExchange((volatile long*) &a->v, (long) desired, (long) *expected);
+    if (prev == *expected) return 1;
+    *expected = prev;
+    return 0;
+}
+
+MARU_INLINE uint64_t maru_atomic_load_u64(const maru_atomic_u64_t *a, maru_memory_order mo) {
+#if defined(_M_X64) || defined(_M_ARM64)
+    uint64_t v = a->v;
+    MARU_ATOMIC_ACQUIRE_(mo);
+    return v;
+#else
+    UNUSED(mo);
+    return (uint64_t) _InterlockedCompareExchange64((volatile __int64*) &a->v, 0, 0);
+#endif
+}
+
+MARU_INLINE void maru_atomic_store_u64(maru_atomic_u64_t *a, uint64_t v, maru_memory_order mo) {
+    UNUSED(mo);
+    _InterlockedExchange64((volatile __int64*) &a->v, (__int64) v);
+}
+
+MARU_INLINE uint64_t maru_atomic_fetch_add_u64(maru_atomic_u64_t *a, uint64_t d, maru_memory_order mo) {
+    UNUSED(mo);
+    return (uint64_t) _InterlockedExchangeAdd64((volatile __int64*) &a->v, (__int64) d);
+}
+
+MARU_INLINE int maru_atomic_cas_u64(maru_atomic_u64_t *a, uint64_t *expected, uint64_t desired, maru_memory_order mo) {
+    UNUSED(mo);
+    uint64_t prev = (uint64_t) _InterlockedCompareExchange64((volatile __int64*) &a->v, (__int64) desired, (__int64) *expected);
+    if (prev == *expected) return 1;
+    *expected = prev;
+    return 0;
+}
+
+MARU_INLINE uint32_t maru_atomic_exchange_u32(maru_atomic_u32_t *a, uint32_t v, maru_memory_order mo) {
+    UNUSED(mo);
+    return (uint32_t) _InterlockedExchange((volatile long*) &a->v, (long) v);
+}
+
+MARU_INLINE uint64_t maru_atomic_exchange_u64(maru_atomic_u64_t *a, uint64_t v, maru_memory_order mo) {
+    UNUSED(mo);
+    return (uint64_t) _InterlockedExchange64((volatile __int64*) &a->v, (__int64) v);
+}
+
+MARU_INLINE void *maru_atomic_load_ptr(const maru_atomic_ptr_t *a, maru_memory_order mo) {
+    void *v = a->v;
+    MARU_ATOMIC_ACQUIRE_(mo);
+    return v;
+}
+
+MARU_INLINE void maru_atomic_store_ptr(maru_atomic_ptr_t *a, void *v, maru_memory_order mo) {
+    if (mo == MARU_MO_SEQ_CST) {
+        _InterlockedExchangePointer((void *volatile*) &a->v, v);
+        return;
+    }
+    MARU_ATOMIC_RELEASE_(mo);
+    a->v = v;
+}
+
+MARU_INLINE void *maru_atomic_exchange_ptr(maru_atomic_ptr_t *a, void *v, maru_memory_order mo) {
+    UNUSED(mo);
+    return _InterlockedExchangePointer((void *volatile*) &a->v, v);
+}
+
+MARU_INLINE int maru_atomic_cas_ptr(maru_atomic_ptr_t *a, void **expected, void *desired, maru_memory_order mo) {
+    UNUSED(mo);
+    void *prev = _InterlockedCompareExchangePointer((void *volatile*) &a->v, desired, *expected);
+    if (prev == *expected) return 1;
+    *expected = prev;
+    return 0;
+}
+
+MARU_INLINE void maru_atomic_fence(maru_memory_order mo) {
+    if (mo == MARU_MO_SEQ_CST) {
+#if defined(_M_X64) || defined(_M_IX86)
+        _mm_mfence();
+#else
+        __dmb(_ARM64_BARRIER_ISH);
+#endif
+        return;
+    }
+#if defined(_M_ARM64)
+    if (mo != MARU_MO_RELAXED) __dmb(_ARM64_BARRIER_ISH);
+#endif
+    MARU_ATOMIC_BARRIER_();
+}
+
+/* Spin-wait hint: lets the sibling hyperthread run and saves power */
+MARU_INLINE void maru_cpu_pause(void) {
+#if defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#else
+    __yield();
+#endif
+}
+
+#else /* GCC / Clang */
+
+/* Folds to a constant once inlined; a non-constant order degrades to seq_cst. */
+#define MARU__MO(mo) \
+    ((mo) == MARU_MO_RELAXED ? __ATOMIC_RELAXED : \
+     (mo) == MARU_MO_ACQUIRE ? __ATOMIC_ACQUIRE : \
+     (mo) == MARU_MO_RELEASE ? __ATOMIC_RELEASE : \
+     (mo) == MARU_MO_ACQ_REL ? __ATOMIC_ACQ_REL : __ATOMIC_SEQ_CST)
+
+/* Failure side of a CAS may not carry a release component */
+#define MARU__MO_FAIL(mo) \
+    ((mo) == MARU_MO_ACQUIRE || (mo) == MARU_MO_ACQ_REL ? __ATOMIC_ACQUIRE : \
+     (mo) == MARU_MO_SEQ_CST ? __ATOMIC_SEQ_CST : __ATOMIC_RELAXED)
+
+MARU_INLINE uint32_t maru_atomic_load_u32(const maru_atomic_u32_t *a, maru_memory_order mo) {
+    return __atomic_load_n(&a->v, MARU__MO(mo));
+}
+
+MARU_INLINE void maru_atomic_store_u32(maru_atomic_u32_t *a, uint32_t v, maru_memory_order mo) {
+    __atomic_store_n(&a->v, v, MARU__MO(mo));
+}
+
+MARU_INLINE uint32_t maru_atomic_fetch_add_u32(maru_atomic_u32_t *a, uint32_t d, maru_memory_order mo) {
+    return __atomic_fetch_add(&a->v, d, MARU__MO(mo));
+}
+
+MARU_INLINE int maru_atomic_cas_u32(maru_atomic_u32_t *a, uint32_t *expected, uint32_t desired, maru_memory_order mo) {
+    return __atomic_compare_exchange_n(&a->v, expected, desired, 0, MARU__MO(mo), MARU__MO_FAIL(mo));
+}
+
+MARU_INLINE uint64_t maru_atomic_load_u64(const maru_atomic_u64_t *a, maru_memory_order mo) {
+    return __atomic_load_n(&a->v, MARU__MO(mo));
+}
+
+MARU_INLINE void maru_atomic_store_u64(maru_atomic_u64_t *a, uint64_t v, maru_memory_order mo) {
+    __atomic_store_n(&a->v, v, MARU__MO(mo));
+}
+
+MARU_INLINE uint64_t maru_atomic_fetch_add_u64(maru_atomic_u64_t *a, uint64_t d, maru_memory_order mo) {
+    return __atomic_fetch_add(&a->v, d, MARU__MO(mo));
+}
+
+MARU_INLINE int maru_atomic_cas_u64(maru_atomic_u64_t *a, uint64_t *expected, uint64_t desired, maru_memory_order mo) {
+    return __atomic_compare_exchange_n(&a->v, expected, desired, 0, MARU__MO(mo), MARU__MO_FAIL(mo));
+}
+
+
+MARU_INLINE uint32_t maru_atomic_exchange_u32(maru_atomic_u32_t *a, uint32_t v, maru_memory_order mo) {
+    return __atomic_exchange_n(&a->v, v, MARU__MO(mo));
+}
+
+MARU_INLINE uint64_t maru_atomic_exchange_u64(maru_atomic_u64_t *a, uint64_t v, maru_memory_order mo) {
+    return __atomic_exchange_n(&a->v, v, MARU__MO(mo));
+}
+
+MARU_INLINE void *maru_atomic_load_ptr(const maru_atomic_ptr_t *a, maru_memory_order mo) {
+    return __atomic_load_n(&a->v, MARU__MO(mo));
+}
+
+MARU_INLINE void maru_atomic_store_ptr(maru_atomic_ptr_t *a, void *v, maru_memory_order mo) {
+    __atomic_store_n(&a->v, v, MARU__MO(mo));
+}
+
+MARU_INLINE void *maru_atomic_exchange_ptr(maru_atomic_ptr_t *a, void *v, maru_memory_order mo) {
+    return __atomic_exchange_n(&a->v, v, MARU__MO(mo));
+}
+
+MARU_INLINE int maru_atomic_cas_ptr(maru_atomic_ptr_t *a, void **expected, void *desired, maru_memory_order mo) {
+    return __atomic_compare_exchange_n(&a->v, expected, desired, 0, MARU__MO(mo), MARU__MO_FAIL(mo));
+}
+
+MARU_INLINE void maru_atomic_fence(maru_memory_order mo) {
+    __atomic_thread_fence(MARU__MO(mo));
+}
+
+/* Spin-wait hint: lets the sibling hyperthread run and saves power */
+MARU_INLINE void maru_cpu_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+#endif
+
+/*
+ * Spin-then-yield lock for short critical sections (a few dozen
+ * instructions). Lock is acquire, unlock is release. Contended waiters spin
+ * on a plain load with pause hints, then start yielding the time slice, so
+ * an oversubscribed machine does not burn a whole quantum. Not recursive.
+ */
+typedef struct { maru_atomic_u32_t locked; } maru_spinlock_t;
+
+#define MARU_SPINLOCK_INIT {{0}}
+
+void maru_spinlock_lock_slow(maru_spinlock_t *l);
+
+/* Gives up the rest of the time slice */
+void maru_thread_yield(void);
+
+MARU_INLINE int maru_spinlock_trylock(maru_spinlock_t *l) {
+    uint32_t expected = 0;
+    return maru_atomic_load_u32(&l->locked, MARU_MO_RELAXED) == 0 &&
+           maru_atomic_cas_u32(&l->locked, &expected, 1, MARU_MO_ACQUIRE);
+}
+
+MARU_INLINE void maru_spinlock_lock(maru_spinlock_t *l) {
+    if (LIKELY(maru_spinlock_trylock(l))) return;
+    maru_spinlock_lock_slow(l);
+}
+
+MARU_INLINE void maru_spinlock_unlock(maru_spinlock_t *l) {
+    maru_atomic_store_u32(&l->locked, 0, MARU_MO_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_ATOMIC_H */
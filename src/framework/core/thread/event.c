@@ -0,0 +1,73 @@
+#include "event.h"
+
+#include "time.h"
+
+#define EVENT_CLEAR 0u
+#define EVENT_SET 1u
+#define EVENT_SLEEPERS 2u
+
+/* Pause rounds before a waiter goes to the kernel; covers a set that is already on its way */
+#define EVENT_SPIN_ROUNDS 64
+
+/* Takes the event if it is set; an auto-reset event is cleared to `cleared` */
+static int event_take(maru_event_t *e, uint32_t cleared) {
+    if (!e->auto_reset) return maru_atomic_load_u32(&e->state, MARU_MO_ACQUIRE) == EVENT_SET;
+
+    uint32_t expected = EVENT_SET;
+    return maru_atomic_cas_u32(&e->state, &expected, cleared, MARU_MO_ACQUIRE);
+}
+
+void maru_event_init(maru_event_t *e, int auto_reset, int initially_set) {
+    if (!e) return;
+    e->auto_reset = auto_reset ? 1u : 0u;
+    maru_atomic_store_u32(&e->state, initially_set ? EVENT_SET : EVENT_CLEAR, MARU_MO_RELEASE);
+}
+
+void maru_event_set(maru_event_t *e) {
+    if (!e) return;
+    if (maru_atomic_exchange_u32(&e->state, EVENT_SET, MARU_MO_RELEASE) == EVENT_SLEEPERS) {
+        maru_futex_wake(&e->state, e->auto_reset ? 1u : MARU_WAIT_INFINITE);
+    }
+}
+
+void maru_event_reset(maru_event_t *e) {
+    if (!e) return;
+    /* a sleeper mark already means clear */
+    uint32_t expected = EVENT_SET;
+    maru_atomic_cas_u32(&e->state, &expected, EVENT_CLEAR, MARU_MO_RELAXED);
+}
+
+int maru_event_is_set(const maru_event_t *e) {
+    return e && maru_atomic_load_u32(&e->state, MARU_MO_ACQUIRE) == EVENT_SET;
+}
+
+int maru_event_wait_timeout(maru_event_t *e, uint32_t timeout_ms) {
+    if (!e) return 1;
+
+    for (int i = 0; i < EVENT_SPIN_ROUNDS; ++i) {
+        if (event_take(e, EVENT_CLEAR)) return 0;
+        maru_cpu_pause();
+    }
+    if (timeout_ms == 0) return 1;
+
+    uint64_t deadline = timeout_ms == MARU_WAIT_INFINITE ? 0 : time_now_ms() + timeout_ms;
+    for (;;) {
+        /* other auto-reset waiters may still be asleep: keep the mark so the next set wakes one */
+        if (event_take(e, EVENT_SLEEPERS)) return 0;
+
+        uint32_t s = EVENT_CLEAR;
+        if (!maru_atomic_cas_u32(&e->state, &s, EVENT_SLEEPERS, MARU_MO_RELAXED) && s == EVENT_SET) continue;
+
+        uint32_t wait_ms = MARU_WAIT_INFINITE;
+        if (timeout_ms != MARU_WAIT_INFINITE) {
+            uint64_t now = time_now_ms();
+            if (now >= deadline) return 1;
+            wait_ms = (uint32_t) (deadline - now);
+        }
+        maru_futex_wait(&e->state, EVENT_SLEEPERS, wait_ms);
+    }
+}
+
+void maru_event_wait(maru_event_t *e) {
+    maru_event_wait_timeout(e, MARU_WAIT_INFINITE);
+}
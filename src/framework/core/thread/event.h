@@ -0,0 +1,39 @@
+#ifndef MARU_EVENT_H
+#define MARU_EVENT_H
+
+#include <stdint.h>
+
+#include "futex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lightweight event on a futex word; no OS object, so it can live in any
+ * struct and needs no destroy. Set and wait stay in user space unless a
+ * thread actually has to sleep.
+ *
+ * Manual-reset: set releases every waiter and stays set until reset.
+ * Auto-reset: set releases one waiter and the event clears again.
+ */
+typedef struct maru_event {
+    maru_atomic_u32_t state;    /* 0 clear, 1 set, 2 clear with sleepers */
+    uint32_t auto_reset;
+} maru_event_t;
+
+void maru_event_init(maru_event_t *e, int auto_reset, int initially_set);
+
+void maru_event_set(maru_event_t *e);
+void maru_event_reset(maru_event_t *e);
+int maru_event_is_set(const maru_event_t *e);
+
+void maru_event_wait(maru_event_t *e);
+/* Returns 0 once the event was set, 1 on timeout */
+int maru_event_wait_timeout(maru_event_t *e, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_EVENT_H */
@@ -0,0 +1,123 @@
+#include "futex.h"
+
+#if defined(_WIN32)
+#if !defined(_WIN32_WINNT) || _WIN32_WINNT < 0x0602
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602 /* WaitOnAddress: Windows 8 */
+#endif
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#include <windows.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "Synchronization.lib")
+#endif
+#elif defined(__linux__)
+#include <sys/types.h> /* struct timespec: core/time.h shadows <time.h> on the include path */
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <pthread.h>
+#else
+#error "Unsupported platform for maru_futex"
+#endif
+
+#if defined(_WIN32)
+
+int maru_futex_wait(maru_atomic_u32_t *addr, uint32_t expected, uint32_t timeout_ms) {
+    DWORD ms = timeout_ms == MARU_WAIT_INFINITE ? INFINITE : (DWORD) timeout_ms;
+    if (WaitOnAddress((volatile VOID*) &addr->v, &expected, sizeof(expected), ms)) return 0;
+    return GetLastError() == ERROR_TIMEOUT ? 1 : 0;
+}
+
+void maru_futex_wake(maru_atomic_u32_t *addr, uint32_t count) {
+    if (count == 1) WakeByAddressSingle((PVOID) &addr->v);
+    else WakeByAddressAll((PVOID) &addr->v);
+}
+
+#elif defined(__linux__)
+
+int maru_futex_wait(maru_atomic_u32_t *addr, uint32_t expected, uint32_t timeout_ms) {
+    struct timespec ts, *pts = NULL;
+    if (timeout_ms != MARU_WAIT_INFINITE) {
+        ts.tv_sec = (time_t) (timeout_ms / 1000);
+        ts.tv_nsec = (long) (timeout_ms % 1000) * 1000000L;
+        pts = &ts;
+    }
+    /* EAGAIN (value differed) and EINTR count as wakes */
+    long r = syscall(SYS_futex, (uint32_t*) &addr->v, FUTEX_WAIT_PRIVATE, expected, pts, NULL, 0);
+    return (r == -1 && errno == ETIMEDOUT) ? 1 : 0;
+}
+
+void maru_futex_wake(maru_atomic_u32_t *addr, uint32_t count) {
+    int n = count > 0x7fffffffu ? 0x7fffffff : (int) count;
+    syscall(SYS_futex, (uint32_t*) &addr->v, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+#else
+
+/*
+ * Parking buckets: the value is checked under the bucket lock, and wakers
+ * take the same lock after changing it, so a wake cannot slip in between
+ * the check and the sleep. Every wake is a broadcast on the bucket.
+ */
+#define FUTEX_BUCKETS 64
+
+typedef struct futex_bucket {
+    pthread_mutex_t m;
+    pthread_cond_t c;
+} futex_bucket_t;
+
+static futex_bucket_t s_buckets[FUTEX_BUCKETS];
+static pthread_once_t s_buckets_once = PTHREAD_ONCE_INIT;
+
+static void buckets_init(void) {
+    for (int i = 0; i < FUTEX_BUCKETS; ++i) {
+        pthread_mutex_init(&s_buckets[i].m, NULL);
+        pthread_cond_init(&s_buckets[i].c, NULL);
+    }
+}
+
+static futex_bucket_t *bucket_of(const void *addr) {
+    pthread_once(&s_buckets_once, buckets_init);
+    uintptr_t h = (uintptr_t) addr >> 2;
+    h ^= h >> 7;
+    return &s_buckets[h % FUTEX_BUCKETS];
+}
+
+int maru_futex_wait(maru_atomic_u32_t *addr, uint32_t expected, uint32_t timeout_ms) {
+    futex_bucket_t *b = bucket_of(addr);
+    int timed_out = 0;
+
+    pthread_mutex_lock(&b->m);
+    if (maru_atomic_load_u32(addr, MARU_MO_SEQ_CST) == expected) {
+        if (timeout_ms == MARU_WAIT_INFINITE) {
+            pthread_cond_wait(&b->c, &b->m);
+        } else {
+            struct timeval now;
+            struct timespec until;
+            gettimeofday(&now, NULL);
+            uint64_t ns = (uint64_t) now.tv_usec * 1000u + (uint64_t) (timeout_ms % 1000) * 1000000u;
+            until.tv_sec = now.tv_sec + (time_t) (timeout_ms / 1000) + (time_t) (ns / 1000000000u);
+            until.tv_nsec = (long) (ns % 1000000000u);
+            timed_out = pthread_cond_timedwait(&b->c, &b->m, &until) == ETIMEDOUT;
+        }
+    }
+    pthread_mutex_unlock(&b->m);
+    return timed_out;
+}
+
+void maru_futex_wake(maru_atomic_u32_t *addr, uint32_t count) {
+    futex_bucket_t *b = bucket_of(addr);
+    (void) count;
+
+    pthread_mutex_lock(&b->m);
+    pthread_cond_broadcast(&b->c);
+    pthread_mutex_unlock(&b->m);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef MARU_FUTEX_H
+#define MARU_FUTEX_H
+
+#include <stdint.h>
+
+#include "atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sleep/wake on a 32-bit word: futex on Linux, WaitOnAddress on Windows,
+ * a small table of hashed mutex+condvar buckets elsewhere. The building
+ * block under maru_event_t and maru_sem_t; waits may return spuriously,
+ * so callers re-check their condition in a loop.
+ */
+#define MARU_WAIT_INFINITE 0xffffffffu
+
+/* Sleeps while *addr == expected, for at most timeout_ms. Returns 0 when woken (or the value differed), 1 on timeout */
+int maru_futex_wait(maru_atomic_u32_t *addr, uint32_t expected, uint32_t timeout_ms);
+
+/* Wakes up to count waiters on addr (MARU_WAIT_INFINITE = all) */
+void maru_futex_wake(maru_atomic_u32_t *addr, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_FUTEX_H */
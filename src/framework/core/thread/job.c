@@ -0,0 +1,469 @@
+#include "job.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mpmc_ring.h"
+#include "semaphore.h"
+#include "thread.h"
+#include "mem/allocator.h"
+#include "mem/mem_diag.h"
+#include "log.h"
+#include "macro.h"
+
+/* Per-thread deque slots (power of two); a full deque runs the job inline */
+#define JOB_DEQUE_CAP 4096u
+#define JOB_DEQUE_MASK (JOB_DEQUE_CAP - 1)
+/* Submissions from threads outside the pool */
+#define JOB_INJECT_CAP 1024u
+/* Idle rounds before a worker yields, then before it sleeps */
+#define JOB_SPIN_ROUNDS 64
+#define JOB_YIELD_ROUNDS 16
+/* parallel_for aims for this many chunks per thread */
+#define JOB_CHUNKS_PER_THREAD 4
+
+typedef struct job_item {
+    maru_job_fn fn;
+    void *user;
+    maru_job_counter_t *counter;
+    uint32_t index;
+} job_item_t;
+
+/*
+ * Every field is atomic so a thief may read a slot the owner is
+ * overwriting; the top CAS then fails and the torn copy is dropped.
+ */
+typedef struct job_slot {
+    maru_atomic_ptr_t fn;
+    maru_atomic_ptr_t user;
+    maru_atomic_ptr_t counter;
+    maru_atomic_u32_t index;
+} job_slot_t;
+
+typedef struct job_thread {
+    /* thieves */
+    maru_atomic_u64_t top;
+    uint8_t pad0_[MARU_CACHE_LINE - sizeof(maru_atomic_u64_t)];
+
+    /* owner */
+    maru_atomic_u64_t bottom;
+    job_slot_t *slots;
+    maru_thread_t *thread;
+    uint32_t index;
+    uint32_t rng;
+
+    maru_atomic_u64_t executed;
+    maru_atomic_u64_t stolen;
+    maru_atomic_u64_t sleeps;
+    uint8_t pad1_[MARU_CACHE_LINE];
+} job_thread_t;
+
+static struct {
+    job_thread_t *threads;      /* [0] is the init thread */
+    uint32_t capacity;          /* entries in threads */
+    maru_atomic_u32_t count;    /* threads actually running, [0] included */
+    maru_mpmc_ring_t inject;
+    maru_sem_t sem;             /* idle workers sleep here */
+    maru_atomic_u32_t sleepers;
+    maru_atomic_u32_t quit;
+    maru_atomic_u64_t inline_runs;
+    maru_atomic_u64_t external_executed;
+    int running;
+} g_jobs;
+
+static MARU_THREAD_LOCAL job_thread_t *t_self;
+
+static void parallel_run(void *user, uint32_t task_count, maru_parallel_task_fn fn, void *ctx);
+static maru_parallel_t g_parallel = {parallel_run, NULL, 1};
+
+/* ===== Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models") ===== */
+
+static void slot_store(job_slot_t *s, const job_item_t *j) {
+    union { maru_job_fn fn; void *p; } u;
+    u.fn = j->fn;
+    maru_atomic_store_ptr(&s->fn, u.p, MARU_MO_RELAXED);
+    maru_atomic_store_ptr(&s->user, j->user, MARU_MO_RELAXED);
+    maru_atomic_store_ptr(&s->counter, j->counter, MARU_MO_RELAXED);
+    maru_atomic_store_u32(&s->index, j->index, MARU_MO_RELAXED);
+}
+
+static void slot_load(const job_slot_t *s, job_item_t *j) {
+    union { maru_job_fn fn; void *p; } u;
+    u.p = maru_atomic_load_ptr(&s->fn, MARU_MO_RELAXED);
+    j->fn = u.fn;
+    j->user = maru_atomic_load_ptr(&s->user, MARU_MO_RELAXED);
+    j->counter = (maru_job_counter_t*) maru_atomic_load_ptr(&s->counter, MARU_MO_RELAXED);
+    j->index = maru_atomic_load_u32(&s->index, MARU_MO_RELAXED);
+}
+
+/* Owner only. Returns 0 when full */
+static int deque_push(job_thread_t *q, const job_item_t *j) {
+    uint64_t b = maru_atomic_load_u64(&q->bottom, MARU_MO_RELAXED);
+    uint64_t t = maru_atomic_load_u64(&q->top, MARU_MO_ACQUIRE);
+    if (b - t >= JOB_DEQUE_CAP) return 0;
+
+    slot_store(&q->slots[b & JOB_DEQUE_MASK], j);
+    /* release: a thief that sees the new bottom sees the slot and the job's data */
+    maru_atomic_store_u64(&q->bottom, b + 1, MARU_MO_RELEASE);
+    return 1;
+}
+
+/* Owner only, newest first */
+static int deque_pop(job_thread_t *q, job_item_t *out) {
+    uint64_t b = maru_atomic_load_u64(&q->bottom, MARU_MO_RELAXED) - 1;
+    maru_atomic_store_u64(&q->bottom, b, MARU_MO_RELAXED);
+    maru_atomic_fence(MARU_MO_SEQ_CST);
+    uint64_t t = maru_atomic_load_u64(&q->top, MARU_MO_RELAXED);
+
+    if ((int64_t) (t - b) > 0) {
+        /* empty */
+        maru_atomic_store_u64(&q->bottom, b + 1, MARU_MO_RELAXED);
+        return 0;
+    }
+
+    slot_load(&q->slots[b & JOB_DEQUE_MASK], out);
+    if (t != b) return 1;
+
+    /* last one: thieves may be after it too */
+    int won = maru_atomic_cas_u64(&q->top, &t, t + 1, MARU_MO_SEQ_CST);
+    maru_atomic_store_u64(&q->bottom, b + 1, MARU_MO_RELAXED);
+    return won;
+}
+
+/* Any thread, oldest first. 1 = got one, 0 = empty, -1 = lost a race */
+static int deque_steal(job_thread_t *q, job_item_t *out) {
+    uint64_t t = maru_atomic_load_u64(&q->top, MARU_MO_ACQUIRE);
+    maru_atomic_fence(MARU_MO_SEQ_CST);
+    uint64_t b = maru_atomic_load_u64(&q->bottom, MARU_MO_ACQUIRE);
+    if ((int64_t) (b - t) <= 0) return 0;
+
+    slot_load(&q->slots[t & JOB_DEQUE_MASK], out);
+    return maru_atomic_cas_u64(&q->top, &t, t + 1, MARU_MO_SEQ_CST) ? 1 : -1;
+}
+
+/* ===== scheduling ===== */
+
+static void run_job(job_thread_t *self, const job_item_t *j) {
+    j->fn(j->user, j->index);
+
+    if (self) maru_atomic_fetch_add_u64(&self->executed, 1, MARU_MO_RELAXED);
+    else maru_atomic_fetch_add_u64(&g_jobs.external_executed, 1, MARU_MO_RELAXED);
+
+    /* release: the waiter that sees zero sees everything the job wrote */
+    if (j->counter) maru_atomic_fetch_add_u32(&j->counter->pending, (uint32_t) -1, MARU_MO_RELEASE);
+}
+
+static uint32_t next_rand(job_thread_t *self) {
+    /* xorshift32; external threads share a fixed start, which is fine for picking victims */
+    uint32_t x = self ? self->rng : 0x9e3779b9u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    if (self) self->rng = x;
+    return x;
+}
+
+static int find_job(job_thread_t *self, job_item_t *out) {
+    if (self && deque_pop(self, out)) return 1;
+    if (maru_mpmc_pop(&g_jobs.inject, out)) return 1;
+
+    uint32_t n = maru_atomic_load_u32(&g_jobs.count, MARU_MO_ACQUIRE);
+    uint32_t start = next_rand(self) % n;
+    for (uint32_t k = 0; k < n; ++k) {
+        job_thread_t *victim = &g_jobs.threads[(start + k) % n];
+        if (victim == self) continue;
+
+        int rc = deque_steal(victim, out);
+        if (rc == -1) rc = deque_steal(victim, out);
+        if (rc == 1) {
+            if (self) maru_atomic_fetch_add_u64(&self->stolen, 1, MARU_MO_RELAXED);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void wake_workers(uint32_t jobs) {
+    /* pairs with the fence in worker_main: either we see its sleeper count or it sees our job */
+    maru_atomic_fence(MARU_MO_SEQ_CST);
+    uint32_t sleeping = maru_atomic_load_u32(&g_jobs.sleepers, MARU_MO_RELAXED);
+    if (sleeping) maru_sem_post(&g_jobs.sem, jobs < sleeping ? jobs : sleeping);
+}
+
+static int worker_main(void *arg) {
+    job_thread_t *self = (job_thread_t*) arg;
+    t_self = self;
+
+    uint32_t idle = 0;
+    for (;;) {
+        job_item_t j;
+        if (find_job(self, &j)) {
+            run_job(self, &j);
+            idle = 0;
+            continue;
+        }
+        if (maru_atomic_load_u32(&g_jobs.quit, MARU_MO_ACQUIRE)) break;
+
+        if (++idle < JOB_SPIN_ROUNDS) {
+            maru_cpu_pause();
+            continue;
+        }
+        if (idle < JOB_SPIN_ROUNDS + JOB_YIELD_ROUNDS) {
+            maru_thread_yield();
+            continue;
+        }
+
+        maru_atomic_fetch_add_u32(&g_jobs.sleepers, 1, MARU_MO_ACQ_REL);
+        maru_atomic_fence(MARU_MO_SEQ_CST);
+        int found = find_job(self, &j);
+        if (!found && !maru_atomic_load_u32(&g_jobs.quit, MARU_MO_ACQUIRE)) {
+            maru_atomic_fetch_add_u64(&self->sleeps, 1, MARU_MO_RELAXED);
+            maru_sem_wait(&g_jobs.sem);
+        }
+        maru_atomic_fetch_add_u32(&g_jobs.sleepers, (uint32_t) -1, MARU_MO_ACQ_REL);
+
+        if (found) run_job(self, &j);
+        idle = 0;
+    }
+
+    t_self = NULL;
+    return 0;
+}
+
+/* ===== public ===== */
+
+/* The n-th set bit of mask, as a single-CPU mask */
+static maru_cpu_mask_t nth_cpu(maru_cpu_mask_t mask, uint32_t n) {
+    while (n--) mask &= mask - 1;
+    return mask & (~mask + 1);
+}
+
+int maru_job_system_init(int workers) {
+    if (g_jobs.running) return 0;
+
+    uint32_t cpus = maru_cpu_count();
+    if (workers < 0) workers = cpus > 1 ? (int) cpus - 1 : 0;
+
+    memset(&g_jobs, 0, sizeof(g_jobs));
+    g_jobs.capacity = (uint32_t) workers + 1;
+    g_jobs.threads = (job_thread_t*) maru_alloc(maru_tagged_allocator(MEM_TAG_CORE),
+                                                sizeof(job_thread_t) * g_jobs.capacity, MARU_CACHE_LINE);
+    if (!g_jobs.threads) return -1;
+    memset(g_jobs.threads, 0, sizeof(job_thread_t) * g_jobs.capacity);
+    maru_atomic_store_u32(&g_jobs.count, 1, MARU_MO_RELAXED);
+
+    if (maru_mpmc_init(&g_jobs.inject, JOB_INJECT_CAP, sizeof(job_item_t)) != 0) goto fail;
+    maru_sem_init(&g_jobs.sem, 0);
+
+    for (uint32_t i = 0; i < g_jobs.capacity; ++i) {
+        job_thread_t *jt = &g_jobs.threads[i];
+        jt->index = i;
+        jt->rng = 0x9e3779b9u * (i + 1);
+        jt->slots = (job_slot_t*) MARU_CALLOC_T(MEM_TAG_CORE, JOB_DEQUE_CAP, sizeof(job_slot_t));
+        if (!jt->slots) {
+            /* nothing started yet; shutdown frees what was made */
+            g_jobs.running = 1;
+            maru_job_system_shutdown();
+            return -1;
+        }
+    }
+
+    t_self = &g_jobs.threads[0];
+    g_jobs.running = 1;
+
+    /*
+     * The init thread keeps the first CPU the process may use to itself;
+     * workers take one allowed CPU each after it, by position in the
+     * process mask rather than CPU number, so a cpuset like {4..7} is
+     * honoured. count only grows past a worker once its thread exists, so
+     * stealing, wake-ups and shutdown never wait on one that failed to start.
+     */
+    maru_cpu_mask_t allowed = maru_cpu_process_mask();
+    uint32_t allowed_count = 0;
+    for (maru_cpu_mask_t m = allowed; m; m &= m - 1) allowed_count++;
+
+    uint32_t pinned = 0;
+    for (uint32_t i = 1; i < g_jobs.capacity; ++i) {
+        char name[24];
+        snprintf(name, sizeof(name), "maru-job-%u", i);
+
+        job_thread_t *jt = &g_jobs.threads[i];
+        jt->thread = maru_thread_create(worker_main, jt, name);
+        if (!jt->thread) {
+            WARN("[job] only %u of %d workers started", i - 1, workers);
+            break;
+        }
+        maru_atomic_store_u32(&g_jobs.count, i + 1, MARU_MO_RELEASE);
+        if (allowed_count > 1 && maru_thread_set_affinity(jt->thread, nth_cpu(allowed, i % allowed_count)) == 0) {
+            pinned++;
+        }
+    }
+
+    uint32_t count = maru_atomic_load_u32(&g_jobs.count, MARU_MO_RELAXED);
+    g_parallel.workers = count;
+    INFO("[job] %u threads (%u workers, %u pinned)", count, count - 1, pinned);
+    return 0;
+
+fail:
+    maru_free(maru_tagged_allocator(MEM_TAG_CORE), g_jobs.threads, sizeof(job_thread_t) * g_jobs.capacity, MARU_CACHE_LINE);
+    memset(&g_jobs, 0, sizeof(g_jobs));
+    return -1;
+}
+
+void maru_job_system_shutdown(void) {
+    if (!g_jobs.running) return;
+
+    /* finish what is queued; workers help until they see quit with nothing left */
+    job_item_t j;
+    while (find_job(t_self, &j)) run_job(t_self, &j);
+
+    uint32_t count = maru_atomic_load_u32(&g_jobs.count, MARU_MO_RELAXED);
+    maru_atomic_store_u32(&g_jobs.quit, 1, MARU_MO_SEQ_CST);
+    if (count > 1) maru_sem_post(&g_jobs.sem, count - 1);
+
+    for (uint32_t i = 1; i < count; ++i) {
+        maru_thread_join(g_jobs.threads[i].thread);
+    }
+    for (uint32_t i = 0; i < g_jobs.capacity; ++i) {
+        MARU_FREE(g_jobs.threads[i].slots);
+    }
+
+    maru_mpmc_destroy(&g_jobs.inject);
+    maru_free(maru_tagged_allocator(MEM_TAG_CORE), g_jobs.threads, sizeof(job_thread_t) * g_jobs.capacity, MARU_CACHE_LINE);
+
+    t_self = NULL;
+    g_parallel.workers = 1;
+    memset(&g_jobs, 0, sizeof(g_jobs));
+}
+
+int maru_job_system_running(void) {
+    return g_jobs.running;
+}
+
+uint32_t maru_job_thread_count(void) {
+    return g_jobs.running ? maru_atomic_load_u32(&g_jobs.count, MARU_MO_RELAXED) : 1;
+}
+
+int maru_job_thread_index(void) {
+    return t_self ? (int) t_self->index : -1;
+}
+
+/* Queues one job, or runs it here if there is no room */
+static void submit_item(const job_item_t *j) {
+    if (g_jobs.running) {
+        if (t_self ? deque_push(t_self, j) : maru_mpmc_push(&g_jobs.inject, j)) return;
+    }
+    maru_atomic_fetch_add_u64(&g_jobs.inline_runs, 1, MARU_MO_RELAXED);
+    run_job(t_self, j);
+}
+
+static void submit_range(maru_job_fn fn, void *user, uint32_t first, uint32_t n, maru_job_counter_t *counter) {
+    if (counter) maru_atomic_fetch_add_u32(&counter->pending, n, MARU_MO_RELAXED);
+
+    job_item_t j = {fn, user, counter, 0};
+    for (uint32_t i = 0; i < n; ++i) {
+        j.index = first + i;
+        submit_item(&j);
+    }
+    if (g_jobs.running) wake_workers(n);
+}
+
+void maru_job_submit(const maru_job_t *jobs, uint32_t n, maru_job_counter_t *counter) {
+    if (!jobs || n == 0) return;
+    if (counter) maru_atomic_fetch_add_u32(&counter->pending, n, MARU_MO_RELAXED);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        job_item_t j = {jobs[i].fn, jobs[i].user, counter, jobs[i].index};
+        submit_item(&j);
+    }
+    if (g_jobs.running) wake_workers(n);
+}
+
+int maru_job_done(const maru_job_counter_t *counter) {
+    return !counter || maru_atomic_load_u32(&counter->pending, MARU_MO_ACQUIRE) == 0;
+}
+
+void maru_job_wait(maru_job_counter_t *counter) {
+    uint32_t spins = 0;
+    while (!maru_job_done(counter)) {
+        job_item_t j;
+        if (g_jobs.running && find_job(t_self, &j)) {
+            run_job(t_self, &j);
+            spins = 0;
+            continue;
+        }
+        if (++spins < JOB_SPIN_ROUNDS) maru_cpu_pause();
+        else maru_thread_yield();
+    }
+}
+
+typedef struct pfor_ctx {
+    maru_job_range_fn fn;
+    void *user;
+    uint32_t count;
+    uint32_t grain;
+} pfor_ctx_t;
+
+static void pfor_chunk(void *user, uint32_t chunk) {
+    const pfor_ctx_t *c = (const pfor_ctx_t*) user;
+    uint32_t begin = chunk * c->grain;
+    uint32_t end = c->count - begin < c->grain ? c->count : begin + c->grain;
+    c->fn(c->user, begin, end);
+}
+
+void maru_job_parallel_for(uint32_t count, uint32_t grain, maru_job_range_fn fn, void *user) {
+    if (!fn || count == 0) return;
+
+    uint32_t threads = maru_job_thread_count();
+    if (grain == 0) grain = count / (threads * JOB_CHUNKS_PER_THREAD);
+    if (grain == 0) grain = 1;
+
+    /* half a deque, so the chunks never spill into inline runs */
+    uint32_t chunks = (uint32_t) (((uint64_t) count + grain - 1) / grain);
+    if (chunks > JOB_DEQUE_CAP / 2) {
+        grain = (uint32_t) (((uint64_t) count + JOB_DEQUE_CAP / 2 - 1) / (JOB_DEQUE_CAP / 2));
+        chunks = (uint32_t) (((uint64_t) count + grain - 1) / grain);
+    }
+    if (chunks == 1 || threads == 1) {
+        fn(user, 0, count);
+        return;
+    }
+
+    pfor_ctx_t ctx = {fn, user, count, grain};
+    maru_job_counter_t counter = MARU_JOB_COUNTER_INIT;
+
+    /* the caller does the first chunk itself rather than queueing it */
+    submit_range(pfor_chunk, &ctx, 1, chunks - 1, &counter);
+    pfor_chunk(&ctx, 0);
+    maru_job_wait(&counter);
+}
+
+static void parallel_run(void *user, uint32_t task_count, maru_parallel_task_fn fn, void *ctx) {
+    UNUSED(user);
+    if (task_count == 0) return;
+
+    maru_job_counter_t counter = MARU_JOB_COUNTER_INIT;
+    submit_range(fn, ctx, 1, task_count - 1, &counter);
+    fn(ctx, 0);
+    maru_job_wait(&counter);
+}
+
+const maru_parallel_t *maru_job_parallel(void) {
+    return &g_parallel;
+}
+
+void maru_job_stats(maru_job_stats_t *out) {
+    if (!out) return;
+
+    memset(out, 0, sizeof(*out));
+    out->threads = maru_job_thread_count();
+    out->inline_runs = maru_atomic_load_u64(&g_jobs.inline_runs, MARU_MO_RELAXED);
+    out->executed = maru_atomic_load_u64(&g_jobs.external_executed, MARU_MO_RELAXED);
+    uint32_t count = g_jobs.running ? maru_atomic_load_u32(&g_jobs.count, MARU_MO_RELAXED) : 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const job_thread_t *jt = &g_jobs.threads[i];
+        out->executed += maru_atomic_load_u64(&jt->executed, MARU_MO_RELAXED);
+        out->stolen += maru_atomic_load_u64(&jt->stolen, MARU_MO_RELAXED);
+        out->sleeps += maru_atomic_load_u64(&jt->sleeps, MARU_MO_RELAXED);
+    }
+}
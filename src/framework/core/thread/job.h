@@ -0,0 +1,83 @@
+#ifndef MARU_JOB_H
+#define MARU_JOB_H
+
+#include <stdint.h>
+
+#include "atomic.h"
+#include "parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Work-stealing job system. One worker per core (pinned and named
+ * "maru-job-N") plus the thread that called init, each with a Chase-Lev
+ * deque: the owner pushes and pops at the bottom, idle threads steal from
+ * the top. Other threads submit through a shared bounded queue.
+ *
+ * Jobs are fire-and-count: each submit can name a counter that drops to
+ * zero once all of its jobs have run. maru_job_wait runs pending jobs
+ * (anyone's) while it waits, so waiting inside a job cannot deadlock the
+ * pool. Idle workers spin briefly, then sleep until work is submitted.
+ *
+ * When the system is not running, jobs run inline on the submitting
+ * thread, so callers need no serial fallback of their own.
+ */
+typedef maru_parallel_task_fn maru_job_fn;   /* fn(user, index) */
+
+typedef struct maru_job {
+    maru_job_fn fn;
+    void *user;
+    uint32_t index;
+} maru_job_t;
+
+typedef struct maru_job_counter {
+    maru_atomic_u32_t pending;
+} maru_job_counter_t;
+
+#define MARU_JOB_COUNTER_INIT {{0}}
+
+typedef struct maru_job_stats {
+    uint32_t threads;       /* workers + the init thread */
+    uint64_t executed;      /* jobs run by pool threads (waiters included) */
+    uint64_t stolen;
+    uint64_t inline_runs;   /* queue full or system off: run by the submitter */
+    uint64_t sleeps;
+} maru_job_stats_t;
+
+/* workers < 0: one per core minus the caller; 0: no workers (waiters run everything). Returns 0 or -1 */
+int maru_job_system_init(int workers);
+/* Runs what is still queued, then stops the workers. Call from the init thread */
+void maru_job_system_shutdown(void);
+int maru_job_system_running(void);
+
+/* Threads that run jobs, at least 1 */
+uint32_t maru_job_thread_count(void);
+/* 0 for the init thread, 1..workers for workers, -1 for any other thread */
+int maru_job_thread_index(void);
+
+/* Queues n jobs; counter (may be NULL) is raised by n before any of them can run */
+void maru_job_submit(const maru_job_t *jobs, uint32_t n, maru_job_counter_t *counter);
+int maru_job_done(const maru_job_counter_t *counter);
+/* Runs jobs until counter reaches zero */
+void maru_job_wait(maru_job_counter_t *counter);
+
+/*
+ * Calls fn(user, begin, end) over [0, count) in chunks of `grain` items
+ * (0 = a few chunks per thread) and returns when all have run. The caller
+ * takes part.
+ */
+typedef void (*maru_job_range_fn)(void *user, uint32_t begin, uint32_t end);
+void maru_job_parallel_for(uint32_t count, uint32_t grain, maru_job_range_fn fn, void *user);
+
+/* Adapter for core algorithms taking a maru_parallel_t (e.g. maru_radix_sort_u32_mt) */
+const maru_parallel_t *maru_job_parallel(void);
+
+void maru_job_stats(maru_job_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_JOB_H */
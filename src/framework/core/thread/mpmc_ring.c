@@ -0,0 +1,101 @@
+#include "mpmc_ring.h"
+
+#include <string.h>
+
+#include "mem/mem_diag.h"
+
+/* cell: sequence number, then the element at offset 8 */
+#define CELL_DATA_OFFSET 8
+
+static uint32_t round_pow2(uint32_t v) {
+    uint32_t p = 2;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+static inline maru_atomic_u32_t *cell_seq(const maru_mpmc_ring_t *r, uint32_t pos) {
+    return (maru_atomic_u32_t*) (r->cells + (size_t) (pos & r->mask) * r->stride);
+}
+
+static inline uint8_t *cell_data(const maru_mpmc_ring_t *r, uint32_t pos) {
+    return r->cells + (size_t) (pos & r->mask) * r->stride + CELL_DATA_OFFSET;
+}
+
+int maru_mpmc_init(maru_mpmc_ring_t *r, uint32_t capacity, uint32_t elem_size) {
+    if (!r || capacity == 0 || capacity > 0x80000000u || elem_size == 0) return -1;
+
+    memset(r, 0, sizeof(*r));
+    capacity = round_pow2(capacity);
+
+    r->stride = ALIGN_UP((size_t) CELL_DATA_OFFSET + elem_size, (size_t) 8);
+    r->cells = (uint8_t*) MARU_MALLOC(r->stride * capacity);
+    if (!r->cells) return -1;
+
+    r->mask = capacity - 1;
+    r->elem_size = elem_size;
+
+    /* cell i is ready for the producer that claims position i */
+    for (uint32_t i = 0; i < capacity; ++i) {
+        maru_atomic_store_u32(cell_seq(r, i), i, MARU_MO_RELAXED);
+    }
+    maru_atomic_store_u32(&r->enqueue_pos, 0, MARU_MO_RELAXED);
+    maru_atomic_store_u32(&r->dequeue_pos, 0, MARU_MO_RELEASE);
+    return 0;
+}
+
+void maru_mpmc_destroy(maru_mpmc_ring_t *r) {
+    if (!r) return;
+    MARU_FREE(r->cells);
+    r->cells = NULL;
+}
+
+int maru_mpmc_push(maru_mpmc_ring_t *r, const void *elem) {
+    uint32_t pos = maru_atomic_load_u32(&r->enqueue_pos, MARU_MO_RELAXED);
+
+    for (;;) {
+        uint32_t seq = maru_atomic_load_u32(cell_seq(r, pos), MARU_MO_ACQUIRE);
+        int32_t diff = (int32_t) (seq - pos);
+
+        if (diff == 0) {
+            /* on failure pos is reloaded with the current enqueue index */
+            if (maru_atomic_cas_u32(&r->enqueue_pos, &pos, pos + 1, MARU_MO_RELAXED)) break;
+        } else if (diff < 0) {
+            return 0; /* the consumer one lap behind has not freed this cell */
+        } else {
+            pos = maru_atomic_load_u32(&r->enqueue_pos, MARU_MO_RELAXED);
+        }
+    }
+
+    memcpy(cell_data(r, pos), elem, r->elem_size);
+    maru_atomic_store_u32(cell_seq(r, pos), pos + 1, MARU_MO_RELEASE);
+    return 1;
+}
+
+int maru_mpmc_pop(maru_mpmc_ring_t *r, void *out) {
+    uint32_t pos = maru_atomic_load_u32(&r->dequeue_pos, MARU_MO_RELAXED);
+
+    for (;;) {
+        uint32_t seq = maru_atomic_load_u32(cell_seq(r, pos), MARU_MO_ACQUIRE);
+        int32_t diff = (int32_t) (seq - (pos + 1));
+
+        if (diff == 0) {
+            if (maru_atomic_cas_u32(&r->dequeue_pos, &pos, pos + 1, MARU_MO_RELAXED)) break;
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = maru_atomic_load_u32(&r->dequeue_pos, MARU_MO_RELAXED);
+        }
+    }
+
+    memcpy(out, cell_data(r, pos), r->elem_size);
+    /* hand the cell to the producer one lap ahead */
+    maru_atomic_store_u32(cell_seq(r, pos), pos + r->mask + 1, MARU_MO_RELEASE);
+    return 1;
+}
+
+uint32_t maru_mpmc_count_approx(const maru_mpmc_ring_t *r) {
+    uint32_t head = maru_atomic_load_u32(&r->dequeue_pos, MARU_MO_RELAXED);
+    uint32_t tail = maru_atomic_load_u32(&r->enqueue_pos, MARU_MO_RELAXED);
+    int32_t n = (int32_t) (tail - head);
+    return n > 0 ? (uint32_t) n : 0;
+}
@@ -0,0 +1,60 @@
+#ifndef MARU_MPMC_RING_H
+#define MARU_MPMC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bounded multi-producer / multi-consumer ring of fixed-size elements
+ * (Vyukov's sequence-per-cell queue).
+ *
+ * Any number of threads may push and pop concurrently. Producers claim a
+ * slot with one CAS on the enqueue index, copy the element, then publish the
+ * cell with a release store of its sequence number; consumers acquire that
+ * sequence before copying out, so element bytes are always fully visible.
+ * FIFO per producer; no global order across producers. Lock-free, but a
+ * producer stalled between claim and publish delays consumers of that slot.
+ * Elements are stored 8-byte aligned.
+ */
+typedef struct maru_mpmc_ring {
+    uint8_t *cells;
+    size_t stride;
+    uint32_t mask;
+    uint32_t elem_size;
+    uint8_t pad0_[MARU_CACHE_LINE];
+
+    maru_atomic_u32_t enqueue_pos;
+    uint8_t pad1_[MARU_CACHE_LINE];
+
+    maru_atomic_u32_t dequeue_pos;
+    uint8_t pad2_[MARU_CACHE_LINE];
+} maru_mpmc_ring_t;
+
+/* capacity is rounded up to a power of two (minimum 2). Returns 0 or -1. */
+int maru_mpmc_init(maru_mpmc_ring_t *r, uint32_t capacity, uint32_t elem_size);
+void maru_mpmc_destroy(maru_mpmc_ring_t *r);
+
+/* 1 if pushed, 0 if full */
+int maru_mpmc_push(maru_mpmc_ring_t *r, const void *elem);
+
+/* 1 if an element was copied to `out`, 0 if empty */
+int maru_mpmc_pop(maru_mpmc_ring_t *r, void *out);
+
+/* Snapshot; may be stale by the time it returns */
+uint32_t maru_mpmc_count_approx(const maru_mpmc_ring_t *r);
+
+MARU_INLINE uint32_t maru_mpmc_capacity(const maru_mpmc_ring_t *r) {
+    return r->mask + 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_MPMC_RING_H */
@@ -0,0 +1,71 @@
+#ifndef MARU_MPSC_STACK_H
+#define MARU_MPSC_STACK_H
+
+#include <stddef.h>
+
+#include "atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lock-free intrusive stack: many producers push, one consumer takes the
+ * whole list at once. Embed a maru_mpsc_node_t in your struct; the stack
+ * never allocates.
+ *
+ * Push is a release CAS and pop_all an acquire exchange, so everything a
+ * producer wrote to its node before pushing is visible to the consumer that
+ * takes it. Taking the entire list (rather than popping one node) is what
+ * keeps this free of ABA without tags. pop_all returns newest-first; use
+ * maru_mpsc_reverse for submission order.
+ */
+typedef struct maru_mpsc_node {
+    struct maru_mpsc_node *next;
+} maru_mpsc_node_t;
+
+typedef struct maru_mpsc_stack {
+    maru_atomic_ptr_t head;
+} maru_mpsc_stack_t;
+
+#define MARU_MPSC_STACK_INIT {{NULL}}
+
+/* Containing struct of an embedded node */
+#define MARU_MPSC_ENTRY(node, type, member) \
+    ((type*) ((char*) (node) - offsetof(type, member)))
+
+/* Returns 1 if the stack was empty before this push (e.g. to wake the consumer) */
+MARU_INLINE int maru_mpsc_push(maru_mpsc_stack_t *s, maru_mpsc_node_t *node) {
+    void *old = maru_atomic_load_ptr(&s->head, MARU_MO_RELAXED);
+    do {
+        node->next = (maru_mpsc_node_t*) old;
+    } while (!maru_atomic_cas_ptr(&s->head, &old, node, MARU_MO_RELEASE));
+    return old == NULL;
+}
+
+/* Consumer: detaches and returns every pushed node, newest first (NULL if empty) */
+MARU_INLINE maru_mpsc_node_t *maru_mpsc_pop_all(maru_mpsc_stack_t *s) {
+    if (!maru_atomic_load_ptr(&s->head, MARU_MO_RELAXED)) return NULL;
+    return (maru_mpsc_node_t*) maru_atomic_exchange_ptr(&s->head, NULL, MARU_MO_ACQUIRE);
+}
+
+MARU_INLINE int maru_mpsc_empty(const maru_mpsc_stack_t *s) {
+    return maru_atomic_load_ptr(&s->head, MARU_MO_RELAXED) == NULL;
+}
+
+MARU_INLINE maru_mpsc_node_t *maru_mpsc_reverse(maru_mpsc_node_t *list) {
+    maru_mpsc_node_t *out = NULL;
+    while (list) {
+        maru_mpsc_node_t *next = list->next;
+        list->next = out;
+        out = list;
+        list = next;
+    }
+    return out;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_MPSC_STACK_H */
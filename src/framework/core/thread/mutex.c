@@ -1,13 +1,19 @@
 #include "mutex.h"
 
+#include "futex.h"
 #include "mem/mem_diag.h"
 
 #if defined(_WIN32)
 #include <windows.h>
 struct mutex { CRITICAL_SECTION cs; };
+struct cond { CONDITION_VARIABLE cv; };
 #elif defined(__APPLE__) || defined(__linux__)
+#include <sys/types.h> /* clockid_t: core/time.h shadows <time.h> on the include path */
+#include <sys/time.h>
+#include <errno.h>
 #include <pthread.h>
 struct mutex { pthread_mutex_t m; };
+struct cond { pthread_cond_t c; };
 #else
 #error "Unsupported platform for maru_mutex"
 #endif
@@ -23,7 +29,7 @@ mutex_t *maru_mutex_create(void) {
     InitializeCriticalSection(&m->cs);
 #elif defined(__APPLE__) || defined(__linux__)
     /* ⺻() ؽ */
-    if (pthread_mutex_init(&m->m, NULL) != 0) { free(m); return NULL; }
+    if (pthread_mutex_init(&m->m, NULL) != 0) { MARU_FREE(m); return NULL; }
 #endif
     return m;
 }
@@ -68,3 +74,78 @@ int maru_mutex_trylock(mutex_t *m) {
     return pthread_mutex_trylock(&m->m) == 0 ? 0 : 1;
 #endif
 }
+
+cond_t *maru_cond_create(void) {
+    cond_t *c = (cond_t*)MARU_MALLOC(sizeof(cond_t));
+    if (!c) {
+        return NULL;
+    }
+
+#if defined(_WIN32)
+    InitializeConditionVariable(&c->cv);
+#elif defined(__APPLE__) || defined(__linux__)
+    if (pthread_cond_init(&c->c, NULL) != 0) { MARU_FREE(c); return NULL; }
+#endif
+    return c;
+}
+
+void maru_cond_destroy(cond_t *c) {
+    if (!c) return;
+
+#if defined(__APPLE__) || defined(__linux__)
+    pthread_cond_destroy(&c->c);
+#endif
+    MARU_FREE(c);
+}
+
+void maru_cond_wait(cond_t *c, mutex_t *m) {
+    if (!c || !m) return;
+
+#if defined(_WIN32)
+    SleepConditionVariableCS(&c->cv, &m->cs, INFINITE);
+#elif defined(__APPLE__) || defined(__linux__)
+    pthread_cond_wait(&c->c, &m->m);
+#endif
+}
+
+int maru_cond_wait_timeout(cond_t *c, mutex_t *m, uint32_t timeout_ms) {
+    if (!c || !m) return 1;
+
+#if defined(_WIN32)
+    if (SleepConditionVariableCS(&c->cv, &m->cs, timeout_ms == MARU_WAIT_INFINITE ? INFINITE : (DWORD)timeout_ms)) return 0;
+    return GetLastError() == ERROR_TIMEOUT ? 1 : 0;
+#elif defined(__APPLE__) || defined(__linux__)
+    if (timeout_ms == MARU_WAIT_INFINITE) {
+        pthread_cond_wait(&c->c, &m->m);
+        return 0;
+    }
+    /* absolute CLOCK_REALTIME deadline */
+    struct timeval now;
+    struct timespec until;
+    gettimeofday(&now, NULL);
+    uint64_t ns = (uint64_t)now.tv_usec * 1000u + (uint64_t)(timeout_ms % 1000) * 1000000u;
+    until.tv_sec = now.tv_sec + (time_t)(timeout_ms / 1000) + (time_t)(ns / 1000000000u);
+    until.tv_nsec = (long)(ns % 1000000000u);
+    return pthread_cond_timedwait(&c->c, &m->m, &until) == ETIMEDOUT ? 1 : 0;
+#endif
+}
+
+void maru_cond_signal(cond_t *c) {
+    if (!c) return;
+
+#if defined(_WIN32)
+    WakeConditionVariable(&c->cv);
+#elif defined(__APPLE__) || defined(__linux__)
+    pthread_cond_signal(&c->c);
+#endif
+}
+
+void maru_cond_broadcast(cond_t *c) {
+    if (!c) return;
+
+#if defined(_WIN32)
+    WakeAllConditionVariable(&c->cv);
+#elif defined(__APPLE__) || defined(__linux__)
+    pthread_cond_broadcast(&c->c);
+#endif
+}
@@ -1,6 +1,8 @@
 #ifndef MARU_MUTEX_H
 #define MARU_MUTEX_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,6 +17,22 @@ void maru_mutex_unlock(mutex_t *m);
 
 int maru_mutex_trylock(mutex_t *m);
 
+/*
+ * Condition variable used with a mutex_t. Wakes can be spurious: wait in a
+ * loop on the predicate, with the mutex held.
+ */
+typedef struct cond cond_t;
+
+cond_t *maru_cond_create(void);
+void maru_cond_destroy(cond_t *c);
+
+void maru_cond_wait(cond_t *c, mutex_t *m);
+/* timeout_ms may be MARU_WAIT_INFINITE (futex.h). Returns 0 when woken, 1 on timeout; m is held again either way */
+int maru_cond_wait_timeout(cond_t *c, mutex_t *m, uint32_t timeout_ms);
+
+void maru_cond_signal(cond_t *c);
+void maru_cond_broadcast(cond_t *c);
+
 #ifdef __cplusplus
 }
 #endif
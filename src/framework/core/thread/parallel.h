@@ -0,0 +1,28 @@
+#ifndef MARU_PARALLEL_H
+#define MARU_PARALLEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Minimal fork/join hook for core algorithms that can split work. `run` must
+ * call fn(ctx, i) once for every i in [0, task_count), on any threads, and
+ * return only after all calls have finished. Core algorithms never spawn
+ * threads themselves; the job system (job.h) provides one.
+ */
+typedef void (*maru_parallel_task_fn)(void *ctx, uint32_t task_index);
+
+typedef struct maru_parallel {
+    void (*run)(void *user, uint32_t task_count, maru_parallel_task_fn fn, void *ctx);
+    void *user;
+    uint32_t workers; /* how many tasks are worth creating; 0 or 1 = serial */
+} maru_parallel_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_PARALLEL_H */
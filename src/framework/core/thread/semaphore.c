@@ -0,0 +1,63 @@
+#include "semaphore.h"
+
+#include "time.h"
+
+/* Pause rounds before a waiter goes to the kernel */
+#define SEM_SPIN_ROUNDS 64
+
+static int sem_take(maru_sem_t *s) {
+    uint32_t c = maru_atomic_load_u32(&s->count, MARU_MO_RELAXED);
+    while (c > 0) {
+        if (maru_atomic_cas_u32(&s->count, &c, c - 1, MARU_MO_ACQUIRE)) return 1;
+    }
+    return 0;
+}
+
+void maru_sem_init(maru_sem_t *s, uint32_t initial) {
+    if (!s) return;
+    maru_atomic_store_u32(&s->count, initial, MARU_MO_RELAXED);
+    maru_atomic_store_u32(&s->waiters, 0, MARU_MO_RELEASE);
+}
+
+void maru_sem_post(maru_sem_t *s, uint32_t n) {
+    if (!s || n == 0) return;
+
+    /* pairs with the waiter's waiters++ then count check: one side sees the other */
+    maru_atomic_fetch_add_u32(&s->count, n, MARU_MO_SEQ_CST);
+    if (maru_atomic_load_u32(&s->waiters, MARU_MO_SEQ_CST) != 0) maru_futex_wake(&s->count, n);
+}
+
+int maru_sem_trywait(maru_sem_t *s) {
+    return (s && sem_take(s)) ? 0 : 1;
+}
+
+int maru_sem_wait_timeout(maru_sem_t *s, uint32_t timeout_ms) {
+    if (!s) return 1;
+
+    for (int i = 0; i < SEM_SPIN_ROUNDS; ++i) {
+        if (sem_take(s)) return 0;
+        maru_cpu_pause();
+    }
+    if (timeout_ms == 0) return 1;
+
+    uint64_t deadline = timeout_ms == MARU_WAIT_INFINITE ? 0 : time_now_ms() + timeout_ms;
+    for (;;) {
+        uint32_t wait_ms = MARU_WAIT_INFINITE;
+        if (timeout_ms != MARU_WAIT_INFINITE) {
+            uint64_t now = time_now_ms();
+            if (now >= deadline) return sem_take(s) ? 0 : 1;
+            wait_ms = (uint32_t) (deadline - now);
+        }
+
+        maru_atomic_fetch_add_u32(&s->waiters, 1, MARU_MO_SEQ_CST);
+        int taken = sem_take(s);
+        if (!taken) maru_futex_wait(&s->count, 0, wait_ms);
+        maru_atomic_fetch_add_u32(&s->waiters, (uint32_t) -1, MARU_MO_RELAXED);
+
+        if (taken || sem_take(s)) return 0;
+    }
+}
+
+void maru_sem_wait(maru_sem_t *s) {
+    maru_sem_wait_timeout(s, MARU_WAIT_INFINITE);
+}
@@ -0,0 +1,35 @@
+#ifndef MARU_SEMAPHORE_H
+#define MARU_SEMAPHORE_H
+
+#include <stdint.h>
+
+#include "futex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Counting semaphore on a futex word. Post only enters the kernel when a
+ * waiter is asleep; wait only when the count is zero.
+ */
+typedef struct maru_sem {
+    maru_atomic_u32_t count;
+    maru_atomic_u32_t waiters;
+} maru_sem_t;
+
+void maru_sem_init(maru_sem_t *s, uint32_t initial);
+
+void maru_sem_post(maru_sem_t *s, uint32_t n);
+
+void maru_sem_wait(maru_sem_t *s);
+/* Returns 0 when a unit was taken, 1 when the count was zero (like maru_mutex_trylock) */
+int maru_sem_trywait(maru_sem_t *s);
+/* Returns 0 when a unit was taken, 1 on timeout */
+int maru_sem_wait_timeout(maru_sem_t *s, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_SEMAPHORE_H */
@@ -0,0 +1,64 @@
+#include "spsc_ring.h"
+
+#include <string.h>
+
+#include "mem/mem_diag.h"
+
+static uint32_t round_pow2(uint32_t v) {
+    uint32_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+int maru_spsc_init(maru_spsc_ring_t *r, uint32_t capacity, uint32_t elem_size) {
+    if (!r || capacity == 0 || capacity > 0x80000000u || elem_size == 0) return -1;
+
+    memset(r, 0, sizeof(*r));
+    capacity = round_pow2(capacity);
+
+    r->buf = (uint8_t*) MARU_MALLOC((size_t) capacity * elem_size);
+    if (!r->buf) return -1;
+
+    r->mask = capacity - 1;
+    r->elem_size = elem_size;
+    return 0;
+}
+
+void maru_spsc_destroy(maru_spsc_ring_t *r) {
+    if (!r) return;
+    MARU_FREE(r->buf);
+    r->buf = NULL;
+}
+
+int maru_spsc_push(maru_spsc_ring_t *r, const void *elem) {
+    uint32_t tail = maru_atomic_load_u32(&r->tail, MARU_MO_RELAXED);
+
+    if (tail - r->cached_head > r->mask) {
+        /* acquire: the consumer has finished reading the slot we are about to reuse */
+        r->cached_head = maru_atomic_load_u32(&r->head, MARU_MO_ACQUIRE);
+        if (tail - r->cached_head > r->mask) return 0;
+    }
+
+    memcpy(r->buf + (size_t) (tail & r->mask) * r->elem_size, elem, r->elem_size);
+    maru_atomic_store_u32(&r->tail, tail + 1, MARU_MO_RELEASE);
+    return 1;
+}
+
+int maru_spsc_pop(maru_spsc_ring_t *r, void *out) {
+    uint32_t head = maru_atomic_load_u32(&r->head, MARU_MO_RELAXED);
+
+    if (head == r->cached_tail) {
+        r->cached_tail = maru_atomic_load_u32(&r->tail, MARU_MO_ACQUIRE);
+        if (head == r->cached_tail) return 0;
+    }
+
+    memcpy(out, r->buf + (size_t) (head & r->mask) * r->elem_size, r->elem_size);
+    maru_atomic_store_u32(&r->head, head + 1, MARU_MO_RELEASE);
+    return 1;
+}
+
+uint32_t maru_spsc_count(const maru_spsc_ring_t *r) {
+    uint32_t head = maru_atomic_load_u32(&r->head, MARU_MO_ACQUIRE);
+    uint32_t tail = maru_atomic_load_u32(&r->tail, MARU_MO_ACQUIRE);
+    return tail - head;
+}
@@ -0,0 +1,59 @@
+#ifndef MARU_SPSC_RING_H
+#define MARU_SPSC_RING_H
+
+#include <stdint.h>
+
+#include "atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bounded single-producer / single-consumer ring of fixed-size elements.
+ *
+ * Exactly one thread may push and exactly one (other) thread may pop; no
+ * locks and no CAS. The element copy happens before the index release, so a
+ * pop that sees the new tail also sees the element bytes (release/acquire on
+ * tail, and likewise on head for slot reuse). Each side caches the other's
+ * index and only re-reads it when the ring looks full/empty.
+ */
+typedef struct maru_spsc_ring {
+    uint8_t *buf;
+    uint32_t mask;
+    uint32_t elem_size;
+    uint8_t pad0_[MARU_CACHE_LINE];
+
+    /* consumer */
+    maru_atomic_u32_t head;
+    uint32_t cached_tail;
+    uint8_t pad1_[MARU_CACHE_LINE];
+
+    /* producer */
+    maru_atomic_u32_t tail;
+    uint32_t cached_head;
+    uint8_t pad2_[MARU_CACHE_LINE];
+} maru_spsc_ring_t;
+
+/* capacity is rounded up to a power of two. Returns 0 or -1. */
+int maru_spsc_init(maru_spsc_ring_t *r, uint32_t capacity, uint32_t elem_size);
+void maru_spsc_destroy(maru_spsc_ring_t *r);
+
+/* Producer only. 1 if pushed, 0 if full */
+int maru_spsc_push(maru_spsc_ring_t *r, const void *elem);
+
+/* Consumer only. 1 if an element was copied to `out`, 0 if empty */
+int maru_spsc_pop(maru_spsc_ring_t *r, void *out);
+
+/* Exact from either side for that side's view; a snapshot otherwise */
+uint32_t maru_spsc_count(const maru_spsc_ring_t *r);
+
+MARU_INLINE uint32_t maru_spsc_capacity(const maru_spsc_ring_t *r) {
+    return r->mask + 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_SPSC_RING_H */
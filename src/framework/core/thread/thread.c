@@ -0,0 +1,306 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* pthread_setaffinity_np, pthread_setname_np, usleep */
+#endif
+
+#include "thread.h"
+
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#include <windows.h>
+#include <process.h>
+#elif defined(__APPLE__) || defined(__linux__)
+#include <errno.h>
+#include <sys/types.h> /* clockid_t: core/time.h shadows <time.h> on the include path */
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#else
+#include <pthread/qos.h>
+#endif
+#else
+#error "Unsupported platform for maru_thread"
+#endif
+
+#include "mem/mem_diag.h"
+#include "mem/mem_scratch.h"
+#include "mem/mem_slab.h"
+#include "log.h"
+#include "macro.h"
+
+/* Kernel limit on Linux; longer names are cut */
+#define THREAD_NAME_MAX 16
+
+struct maru_thread {
+#if defined(_WIN32)
+    HANDLE h;
+#else
+    pthread_t h;
+#endif
+    maru_thread_fn fn;
+    void *user;
+    maru_thread_priority_t priority;
+    int result;
+    char name[THREAD_NAME_MAX];
+};
+
+#if defined(_WIN32)
+typedef HRESULT (WINAPI *set_description_fn)(HANDLE, PCWSTR);
+
+static void set_name_win32(HANDLE h, const char *name) {
+    /* Windows 10 1607+; looked up at run time so older systems still start */
+    static set_description_fn fn = NULL;
+    static int looked_up = 0;
+    if (!looked_up) {
+        HMODULE k32 = GetModuleHandleA("kernel32.dll");
+        fn = k32 ? (set_description_fn) (void*) GetProcAddress(k32, "SetThreadDescription") : NULL;
+        looked_up = 1;
+    }
+    if (!fn) return;
+
+    wchar_t wide[64];
+    if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide, 64) > 0) fn(h, wide);
+}
+
+#endif
+
+/* Name and priority are set by the thread itself: macOS and Linux (nice) only offer that */
+static void thread_setup(maru_thread_t *t) {
+    if (t->name[0]) maru_thread_set_name(t->name);
+    if (t->priority != MARU_THREAD_PRIORITY_NORMAL && maru_thread_set_priority(t->priority) != 0) {
+        WARN("[thread] '%s': priority %d not granted", t->name, (int) t->priority);
+    }
+}
+
+/* Hands this thread's slab cache back and frees its scratch blocks; both are thread-local */
+static void thread_teardown(void) {
+    slab_thread_flush();
+    scratch_thread_release();
+}
+
+#if defined(_WIN32)
+static unsigned __stdcall thread_entry(void *arg) {
+    maru_thread_t *t = (maru_thread_t*) arg;
+    thread_setup(t);
+    t->result = t->fn(t->user);
+    thread_teardown();
+    return 0;
+}
+#else
+static void *thread_entry(void *arg) {
+    maru_thread_t *t = (maru_thread_t*) arg;
+    thread_setup(t);
+    t->result = t->fn(t->user);
+    thread_teardown();
+    return NULL;
+}
+#endif
+
+maru_thread_t *maru_thread_create_ex(const maru_thread_desc_t *desc) {
+    if (!desc || !desc->fn) return NULL;
+
+    maru_thread_t *t = (maru_thread_t*) MARU_CALLOC_T(MEM_TAG_CORE, 1, sizeof(*t));
+    if (!t) return NULL;
+
+    t->fn = desc->fn;
+    t->user = desc->user;
+    t->priority = desc->priority;
+    if (desc->name) {
+        strncpy(t->name, desc->name, THREAD_NAME_MAX - 1);
+        t->name[THREAD_NAME_MAX - 1] = '\0';
+    }
+
+#if defined(_WIN32)
+    /* suspended, so the affinity holds from the first instruction */
+    t->h = (HANDLE) _beginthreadex(NULL, (unsigned) desc->stack_size, thread_entry, t, CREATE_SUSPENDED, NULL);
+    if (!t->h) {
+        ERROR("[thread] failed to create thread '%s'", t->name);
+        MARU_FREE(t);
+        return NULL;
+    }
+    if (desc->affinity && maru_thread_set_affinity(t, desc->affinity) != 0) {
+        WARN("[thread] '%s': affinity 0x%llx not applied", t->name, (unsigned long long) desc->affinity);
+    }
+    ResumeThread(t->h);
+#else
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (desc->stack_size) {
+        size_t page = (size_t) sysconf(_SC_PAGESIZE);
+        size_t size = (desc->stack_size + page - 1) & ~(page - 1);
+        if (pthread_attr_setstacksize(&attr, size) != 0) {
+            WARN("[thread] '%s': stack size %zu rejected, using the default", t->name, desc->stack_size);
+        }
+    }
+    int rc = pthread_create(&t->h, &attr, thread_entry, t);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        ERROR("[thread] failed to create thread '%s'", t->name);
+        MARU_FREE(t);
+        return NULL;
+    }
+    if (desc->affinity && maru_thread_set_affinity(t, desc->affinity) != 0) {
+        WARN("[thread] '%s': affinity 0x%llx not applied", t->name, (unsigned long long) desc->affinity);
+    }
+#endif
+    return t;
+}
+
+maru_thread_t *maru_thread_create(maru_thread_fn fn, void *user, const char *name) {
+    maru_thread_desc_t desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.fn = fn;
+    desc.user = user;
+    desc.name = name;
+    return maru_thread_create_ex(&desc);
+}
+
+int maru_thread_join(maru_thread_t *t) {
+    if (!t) return -1;
+
+#if defined(_WIN32)
+    WaitForSingleObject(t->h, INFINITE);
+    CloseHandle(t->h);
+#else
+    pthread_join(t->h, NULL);
+#endif
+    int result = t->result;
+    MARU_FREE(t);
+    return result;
+}
+
+void maru_thread_set_name(const char *name) {
+    if (!name) return;
+
+#if defined(_WIN32)
+    set_name_win32(GetCurrentThread(), name);
+#else
+    char buf[THREAD_NAME_MAX];
+    strncpy(buf, name, THREAD_NAME_MAX - 1);
+    buf[THREAD_NAME_MAX - 1] = '\0';
+#if defined(__APPLE__)
+    pthread_setname_np(buf);
+#else
+    pthread_setname_np(pthread_self(), buf);
+#endif
+#endif
+}
+
+int maru_thread_set_affinity(maru_thread_t *t, maru_cpu_mask_t mask) {
+#if defined(_WIN32)
+    DWORD_PTR m = (DWORD_PTR) mask;
+    if (!m) return -1;
+    HANDLE h = t ? t->h : GetCurrentThread();
+    return SetThreadAffinityMask(h, m) ? 0 : -1;
+#elif defined(__linux__)
+    if (!mask) return -1;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t cpu = 0; cpu < 64; ++cpu) {
+        if (mask & ((maru_cpu_mask_t) 1 << cpu)) CPU_SET(cpu, &set);
+    }
+#if defined(__ANDROID__)
+    /* bionic has no pthread_setaffinity_np; the kernel call takes a tid (0 = caller) */
+    pid_t tid = t ? pthread_gettid_np(t->h) : 0;
+    return sched_setaffinity(tid, sizeof(set), &set) == 0 ? 0 : -1;
+#else
+    return pthread_setaffinity_np(t ? t->h : pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+#endif
+#else
+    UNUSED(t);
+    UNUSED(mask);
+    return -1;
+#endif
+}
+
+int maru_thread_pin(maru_thread_t *t, uint32_t cpu) {
+    if (cpu >= 64) return -1;
+    return maru_thread_set_affinity(t, (maru_cpu_mask_t) 1 << cpu);
+}
+
+int maru_thread_set_priority(maru_thread_priority_t priority) {
+#if defined(_WIN32)
+    static const int levels[] = {
+        THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_BELOW_NORMAL,
+        THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_TIME_CRITICAL,
+    };
+    if ((unsigned) priority >= ARRAY_SIZE(levels)) return -1;
+    return SetThreadPriority(GetCurrentThread(), levels[priority]) ? 0 : -1;
+#elif defined(__APPLE__)
+    static const qos_class_t classes[] = {
+        QOS_CLASS_DEFAULT, QOS_CLASS_UTILITY,
+        QOS_CLASS_USER_INITIATED, QOS_CLASS_USER_INTERACTIVE,
+    };
+    if ((unsigned) priority >= ARRAY_SIZE(classes)) return -1;
+    return pthread_set_qos_class_self_np(classes[priority], 0) == 0 ? 0 : -1;
+#else
+    /*
+     * SCHED_OTHER threads only differ by nice value, which Linux keeps per
+     * thread. Going below 0 needs CAP_SYS_NICE or RLIMIT_NICE; refused, the
+     * thread is clamped to 0 and the call still reports failure.
+     */
+    static const int nice_values[] = {0, 10, -5, -10};
+    if ((unsigned) priority >= ARRAY_SIZE(nice_values)) return -1;
+    id_t tid = (id_t) syscall(SYS_gettid);
+    if (setpriority(PRIO_PROCESS, tid, nice_values[priority]) == 0) return 0;
+    if (nice_values[priority] < 0 && (errno == EPERM || errno == EACCES)) setpriority(PRIO_PROCESS, tid, 0);
+    return -1;
+#endif
+}
+
+void maru_thread_sleep_ms(uint32_t ms) {
+#if defined(_WIN32)
+    Sleep(ms);
+#else
+    if (ms >= 1000) sleep(ms / 1000);
+    usleep((useconds_t) (ms % 1000) * 1000u);
+#endif
+}
+
+uint32_t maru_cpu_count(void) {
+#if defined(_WIN32)
+    DWORD_PTR proc = 0, sys = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &proc, &sys) && proc) {
+        uint32_t n = 0;
+        for (; proc; proc &= proc - 1) n++;
+        return n;
+    }
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? (uint32_t) si.dwNumberOfProcessors : 1;
+#else
+#if defined(__linux__)
+    /* honours taskset / cgroup cpusets, unlike _SC_NPROCESSORS_ONLN */
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        int n = CPU_COUNT(&set);
+        if (n > 0) return (uint32_t) n;
+    }
+#endif
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (uint32_t) n : 1;
+#endif
+}
+
+maru_cpu_mask_t maru_cpu_process_mask(void) {
+#if defined(_WIN32)
+    DWORD_PTR proc = 0, sys = 0;
+    return GetProcessAffinityMask(GetCurrentProcess(), &proc, &sys) ? (maru_cpu_mask_t) proc : 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+
+    maru_cpu_mask_t mask = 0;
+    for (uint32_t cpu = 0; cpu < 64; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) mask |= (maru_cpu_mask_t) 1 << cpu;
+    }
+    return mask;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,82 @@
+#ifndef MARU_THREAD_H
+#define MARU_THREAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * OS threads. Names show up in debuggers and profilers (Linux truncates
+ * them to 15 characters). Affinity and priority are hints: they fail
+ * (return -1) where the OS has no usable API (affinity on macOS) or the
+ * process lacks the right (raising priority on Linux without
+ * CAP_SYS_NICE), and the thread runs on regardless.
+ */
+typedef struct maru_thread maru_thread_t;
+typedef int (*maru_thread_fn)(void *user);
+
+/* Bit i = logical CPU i; CPUs past 63 cannot be named */
+typedef uint64_t maru_cpu_mask_t;
+
+typedef enum maru_thread_priority {
+    MARU_THREAD_PRIORITY_NORMAL = 0,
+    MARU_THREAD_PRIORITY_LOW,       /* background work: streaming, compression */
+    MARU_THREAD_PRIORITY_HIGH,      /* latency-sensitive: render, loader hand-off */
+    MARU_THREAD_PRIORITY_CRITICAL,  /* audio mixing */
+} maru_thread_priority_t;
+
+typedef struct maru_thread_desc {
+    maru_thread_fn fn;
+    void *user;
+    const char *name;               /* may be NULL */
+    size_t stack_size;              /* 0 = platform default */
+    maru_cpu_mask_t affinity;       /* 0 = any CPU */
+    maru_thread_priority_t priority;
+} maru_thread_desc_t;
+
+/* Returns NULL on failure; affinity and priority failures are only logged */
+maru_thread_t *maru_thread_create_ex(const maru_thread_desc_t *desc);
+
+/* name may be NULL. Returns NULL on failure */
+maru_thread_t *maru_thread_create(maru_thread_fn fn, void *user, const char *name);
+
+/* Waits for the thread, frees it and returns what fn returned */
+int maru_thread_join(maru_thread_t *t);
+
+/* Names the calling thread */
+void maru_thread_set_name(const char *name);
+
+/* Restricts the thread (NULL = calling thread) to the CPUs in mask. Returns 0 or -1 */
+int maru_thread_set_affinity(maru_thread_t *t, maru_cpu_mask_t mask);
+
+/* Restricts the thread (NULL = calling thread) to one logical CPU. Returns 0 or -1 */
+int maru_thread_pin(maru_thread_t *t, uint32_t cpu);
+
+/*
+ * Sets the calling thread's scheduling priority. Returns 0 or -1. On Linux
+ * HIGH and CRITICAL are nice -5 and -10, which an unprivileged process
+ * (no CAP_SYS_NICE, RLIMIT_NICE at its default) is refused with EPERM; the
+ * thread then stays at nice 0 and -1 is returned.
+ */
+int maru_thread_set_priority(maru_thread_priority_t priority);
+
+/* Sleeps the calling thread for about ms milliseconds */
+void maru_thread_sleep_ms(uint32_t ms);
+
+/* Logical CPUs available to the process, at least 1 */
+uint32_t maru_cpu_count(void);
+
+/*
+ * CPUs the process may run on (taskset, cgroup cpusets), as a mask over
+ * CPUs 0..63. 0 where the OS does not say (macOS).
+ */
+maru_cpu_mask_t maru_cpu_process_mask(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_THREAD_H */
@@ -2,6 +2,7 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <stddef.h> /* NULL: <time.h> here resolves to core/time.h */
 #include <sys/time.h>
 #endif
 
@@ -17,3 +18,19 @@ uint64_t time_now_ms(void) {
     return (uint64_t)tv.tv_sec * 1000ULL + (uint64_t)tv.tv_usec / 1000ULL;
 #endif
 }
+
+uint64_t time_now_us(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    /* split to keep counter * 1e6 from overflowing */
+    uint64_t sec = (uint64_t)(counter.QuadPart / freq.QuadPart);
+    uint64_t rem = (uint64_t)(counter.QuadPart % freq.QuadPart);
+    return sec * 1000000ULL + rem * 1000000ULL / (uint64_t)freq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
+#endif
+}
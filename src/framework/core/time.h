@@ -4,5 +4,7 @@
 #include <stdint.h>
 
 uint64_t time_now_ms(void);
+/* Same clock in microseconds, for timing work shorter than a frame */
+uint64_t time_now_us(void);
 
 #endif /* MARU_TIME_H */
\ No newline at end of file
@@ -13,7 +13,8 @@ set(ENGINE_MATERIAL_SRC
 
 set(ENGINE_RENDERER_SRC
     "engine/renderer/renderer.c"
-    "engine/renderer/render_object.c")
+    "engine/renderer/render_object.c"
+    "engine/renderer/render_packet.c")
 
 set(ENGINE_RHI_SRC
     "engine/rhi/rhi.c")
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 
 #include "mem/mem_diag.h"
+#include "mem/mem_scratch.h"
 
 #define ASSET_ROOT_REL "../../content"
 #define ASSET_SUBDIR   "assets"
@@ -68,7 +69,7 @@ int asset_read_into(const char *relpath, void **out_buf, size_t cap, size_t *out
     return fs_read_into(abs, out_buf, cap, out_size, need_null_terminator);
 }
 
-char *asset_read_all(const char *relpath, size_t *out_size, int need_null_terminator) {
+static char *read_all(const char *relpath, size_t *out_size, int need_null_terminator, int scratch) {
     const char *abs = asset_resolve_path(relpath);
     if (!abs) {
         return NULL;
@@ -79,11 +80,19 @@ char *asset_read_all(const char *relpath, size_t *out_size, int need_null_termin
         return NULL;
     }
 
-    buf = MARU_MALLOC(*out_size + 1);
-    if (fs_read_into(abs, &buf, *out_size + 1, out_size, need_null_terminator) != MARU_OK || buf == 0) {
-        MARU_FREE(buf);
+    buf = scratch ? scratch_alloc(*out_size + 1, 0) : MARU_MALLOC_T(MEM_TAG_ASSET, *out_size + 1);
+    if (fs_read_into(abs, (void**) &buf, *out_size + 1, out_size, need_null_terminator) != MARU_OK || buf == 0) {
+        if (!scratch) MARU_FREE(buf);
         return NULL;
     }
 
     return buf;
 }
+
+char *asset_read_all(const char *relpath, size_t *out_size, int need_null_terminator) {
+    return read_all(relpath, out_size, need_null_terminator, 0);
+}
+
+char *asset_read_scratch(const char *relpath, size_t *out_size, int need_null_terminator) {
+    return read_all(relpath, out_size, need_null_terminator, 1);
+}
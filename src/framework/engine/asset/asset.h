@@ -9,6 +9,9 @@ int asset_read_into(const char *relpath, void **out_buf, size_t cap, size_t *out
 // NOTE NEED MARU_FREE() MANUALLY!!!!
 char *asset_read_all(const char *relpath, size_t *out_size, int need_null_terminator);
 
+/* Same, but the buffer lives in thread scratch: released by the caller's scratch_pop, not MARU_FREE */
+char *asset_read_scratch(const char *relpath, size_t *out_size, int need_null_terminator);
+
 const char *asset_resolve_path(const char *relpath);
 
 #endif /* MARU_ASSET_H */
@@ -3,6 +3,8 @@
 #include "asset/asset.h"
 #include "log.h"
 #include "mem/mem_diag.h"
+#include "mem/mem_scratch.h"
+#include "mem/mem_slab.h"
 #include "rhi/rhi.h"
 
 #include <string.h>
@@ -48,39 +50,48 @@ typedef struct obj_data_t {
     uint32_t idx_cap;
 } obj_data_t;
 
-static void obj_data_init(obj_data_t *obj) {
-    memset(obj, 0, sizeof(*obj));
-    obj->pos_cap = 1024;
-    obj->tex_cap = 1024;
-    obj->norm_cap = 1024;
-    obj->vert_cap = 2048;
-    obj->idx_cap = 4096;
-
-    obj->positions = MARU_MALLOC(obj->pos_cap * sizeof(vec3_t));
-    obj->texcoords = MARU_MALLOC(obj->tex_cap * sizeof(vec2_t));
-    obj->normals = MARU_MALLOC(obj->norm_cap * sizeof(vec3_t));
-    obj->vertices = MARU_MALLOC(obj->vert_cap * sizeof(vertex_t));
-    obj->indices = MARU_MALLOC(obj->idx_cap * sizeof(uint32_t));
+/* Sizes every array with one pass over the text; triangulated faces emit 3 vertices */
+static void obj_count(const char *data, obj_data_t *obj) {
+    const char *ptr = data;
+    while (*ptr) {
+        if (ptr[0] == 'v' && ptr[1] == ' ') {
+            obj->pos_cap++;
+        } else if (ptr[0] == 'v' && ptr[1] == 't' && ptr[2] == ' ') {
+            obj->tex_cap++;
+        } else if (ptr[0] == 'v' && ptr[1] == 'n' && ptr[2] == ' ') {
+            obj->norm_cap++;
+        } else if (ptr[0] == 'f' && ptr[1] == ' ') {
+            obj->vert_cap += 3;
+        }
+
+        while (*ptr && *ptr != '\n') ptr++;
+        if (*ptr == '\n') ptr++;
+    }
+    obj->idx_cap = obj->vert_cap;
 }
 
-static void obj_data_free(obj_data_t *obj) {
-    if (obj->positions)
-        MARU_FREE(obj->positions);
-    if (obj->texcoords)
-        MARU_FREE(obj->texcoords);
-    if (obj->normals)
-        MARU_FREE(obj->normals);
-    if (obj->vertices)
-        MARU_FREE(obj->vertices);
-    if (obj->indices)
-        MARU_FREE(obj->indices);
+/* Arrays live in the caller's scratch scope */
+static int obj_data_init(const char *data, obj_data_t *obj) {
     memset(obj, 0, sizeof(*obj));
+    obj_count(data, obj);
+
+    obj->positions = scratch_alloc(obj->pos_cap * sizeof(vec3_t), 0);
+    obj->texcoords = scratch_alloc(obj->tex_cap * sizeof(vec2_t), 0);
+    obj->normals = scratch_alloc(obj->norm_cap * sizeof(vec3_t), 0);
+    obj->vertices = scratch_alloc(obj->vert_cap * sizeof(vertex_t), 0);
+    obj->indices = scratch_alloc(obj->idx_cap * sizeof(uint32_t), 0);
+
+    if (!obj->positions || !obj->texcoords || !obj->normals || !obj->vertices || !obj->indices) {
+        ERROR("OBJ: out of scratch memory");
+        return -1;
+    }
+    return 0;
 }
 
 static int parse_obj(const char *data, obj_data_t *obj) {
     if (!data || !obj) return -1;
 
-    obj_data_init(obj);
+    if (obj_data_init(data, obj) != 0) return -1;
 
     char line[512];
     const char *ptr = data;
@@ -184,11 +195,14 @@ static int mesh_obj_check(const char *ext) {
 static void *mesh_obj_import(const char *path, const void *opts) {
     UNUSED(opts);
 
+    scratch_marker_t scratch = scratch_push();
+
     /* Read OBJ file */
     size_t data_size;
-    char *data = asset_read_all(path, &data_size, 1);
+    char *data = asset_read_scratch(path, &data_size, 1);
     if (!data) {
         ERROR("Failed to read OBJ file: %s", path);
+        scratch_pop(scratch);
         return NULL;
     }
 
@@ -196,10 +210,9 @@ static void *mesh_obj_import(const char *path, const void *opts) {
     obj_data_t obj;
     if (parse_obj(data, &obj) != 0) {
         ERROR("Failed to parse OBJ: %s", path);
-        MARU_FREE(data);
+        scratch_pop(scratch);
         return NULL;
     }
-    MARU_FREE(data);
 
     /* Create mesh descriptor */
     static const rhi_vertex_attr_t attrs[] = {
@@ -220,8 +233,8 @@ static void *mesh_obj_import(const char *path, const void *opts) {
     /* Create mesh */
     mesh_handle_t handle = mesh_create(&desc);
 
-    /* Free temporary data */
-    obj_data_free(&obj);
+    /* Free temporary data: file text and parse arrays in one go */
+    scratch_pop(scratch);
 
     if (handle == MESH_HANDLE_INVALID) {
         ERROR("Failed to create mesh from OBJ: %s", path);
@@ -229,7 +242,11 @@ static void *mesh_obj_import(const char *path, const void *opts) {
     }
 
     /* Return handle as pointer (need wrapper struct for proper handling) */
-    mesh_handle_t *h = MARU_MALLOC(sizeof(mesh_handle_t));
+    mesh_handle_t *h = MARU_SLAB_NEW(mesh_handle_t);
+    if (!h) {
+        mesh_destroy(handle);
+        return NULL;
+    }
     *h = handle;
 
     return (void*) h;
@@ -240,7 +257,7 @@ static void mesh_obj_free(void *asset) {
 
     mesh_handle_t *h = (mesh_handle_t*) asset;
     mesh_destroy(*h);
-    MARU_FREE(h);
+    MARU_SLAB_DELETE(h);
 }
 
 /* Public importer vtable */
@@ -4,8 +4,14 @@
 #include "engine_context.h"
 #include "log.h"
 #include "mem/mem_diag.h"
+#include "mem/mem_scratch.h"
 #include "rhi/rhi.h"
 
+/* Decode buffers come from the importing thread's scratch scope; frees are no-ops until its pop */
+#define STBI_MALLOC(sz)                      scratch_alloc((sz), 0)
+#define STBI_REALLOC_SIZED(p, oldsz, newsz)  scratch_realloc((p), (oldsz), (newsz), 0)
+#define STBI_FREE(p)                         ((void) (p))
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -40,11 +46,14 @@ static void *texture_import(const char *path, const void *opts_in) {
         flip_y = (caps.conventions.uv_yaxis == RHI_AXIS_UP) ? 1 : 0;
     }
 
+    scratch_marker_t scratch = scratch_push();
+
     /* Read file */
     size_t buf_len;
-    char *buf = asset_read_all(path, &buf_len, 1);
+    char *buf = asset_read_scratch(path, &buf_len, 1);
     if (!buf) {
         ERROR("Failed to read texture file: %s", path);
+        scratch_pop(scratch);
         return NULL;
     }
 
@@ -52,18 +61,19 @@ static void *texture_import(const char *path, const void *opts_in) {
     stbi_set_flip_vertically_on_load(flip_y ? 1 : 0);
     int w = 0, h = 0, ch = 0;
     unsigned char *pixels = stbi_load_from_memory((const unsigned char*) buf, (int) buf_len, &w, &h, &ch, 4);
-    MARU_FREE(buf);
 
     if (!pixels || w <= 0 || h <= 0) {
         ERROR("stbi decode failed for %s: %s", path, stbi_failure_reason());
-        if (pixels) stbi_image_free(pixels);
+        scratch_pop(scratch);
         return NULL;
     }
 
     /* Create texture from RGBA pixels */
     texture_opts_t tex_opts = {.gen_mips = opts.gen_mips};
     texture_t *tex = texture_create_from_data(w, h, pixels, &tex_opts);
-    stbi_image_free(pixels);
+
+    /* file bytes, decoder state and pixels */
+    scratch_pop(scratch);
 
     if (!tex) {
         ERROR("Texture import failed: %s", path);
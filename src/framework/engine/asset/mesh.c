@@ -2,8 +2,10 @@
 
 #include "engine_context.h"
 #include "rhi/rhi.h"
+#include "renderer/renderer.h"
 #include "log.h"
-#include "mem/mem_diag.h"
+#include "handle/typed_pool.h"
+#include "mem/mem_region.h"
 
 #include <string.h>
 
@@ -14,64 +16,51 @@ typedef struct mesh_s {
     struct rhi_buffer *ib;
     uint32_t vertex_count;
     uint32_t index_count;
+    mem_region_t *region;   /* lifetime the mesh was created under */
 } mesh_t;
 
-static struct {
-    mesh_t *meshes;
-    uint32_t *free_list;
-    uint32_t capacity;
-    uint32_t count;
-    uint32_t free_count;
-} g_mesh_pool;
+MARU_DEFINE_POOL_TAGGED(mesh, mesh_t, MEM_TAG_MESH);
+
+static mem_region_t *s_region = NULL;
 
 int mesh_system_init(size_t capacity) {
-    if (g_mesh_pool.meshes) {
+    if (mesh_pool_ready()) {
         ERROR("mesh system already initialized");
         return -1;
     }
 
-    g_mesh_pool.capacity = (uint32_t) capacity;
-    g_mesh_pool.meshes = (mesh_t*) MARU_CALLOC(capacity, sizeof(mesh_t));
-    g_mesh_pool.free_list = (uint32_t*) MARU_MALLOC(capacity * sizeof(uint32_t));
-
-    if (!g_mesh_pool.meshes || !g_mesh_pool.free_list) {
+    /* capacity is the page size; the pool grows a page at a time */
+    if (mesh_pool_init(capacity) != 0) {
         ERROR("mesh system allocation failed");
-        if (g_mesh_pool.meshes)
-            MARU_FREE(g_mesh_pool.meshes);
-        if (g_mesh_pool.free_list)
-            MARU_FREE(g_mesh_pool.free_list);
         return -1;
     }
 
-    for (uint32_t i = 0; i < capacity; ++i) {
-        g_mesh_pool.free_list[i] = capacity - 1 - i;
-    }
-    g_mesh_pool.free_count = capacity;
-    g_mesh_pool.count = 0;
-
-    INFO("mesh system initialized (capacity=%u)", capacity);
+    INFO("mesh system initialized (page capacity=%zu)", capacity);
     return 0;
 }
 
-void mesh_system_shutdown(void) {
-    if (!g_mesh_pool.meshes) return;
-
+static void mesh_release(const mesh_t *m) {
     const rhi_dispatch_t *rhi = g_ctx.active_rhi;
-    if (rhi) {
-        for (uint32_t i = 0; i < g_mesh_pool.capacity; ++i) {
-            mesh_t *m = &g_mesh_pool.meshes[i];
-            if (m->vb) {
-                rhi->destroy_buffer(g_ctx.active_device, m->vb);
-            }
-            if (m->ib) {
-                rhi->destroy_buffer(g_ctx.active_device, m->ib);
-            }
-        }
-    }
+    if (!rhi) return;
+
+    /* an in-flight packet may still draw from these */
+    renderer_flush(g_ctx.renderer);
+
+    if (m->ib) rhi->destroy_buffer(g_ctx.active_device, m->ib);
+    if (m->vb) rhi->destroy_buffer(g_ctx.active_device, m->vb);
+}
+
+static void mesh_release_cb(handle_t h, void *obj, void *user) {
+    UNUSED(h);
+    UNUSED(user);
+    mesh_release((const mesh_t*) obj);
+}
 
-    MARU_FREE(g_mesh_pool.meshes);
-    MARU_FREE(g_mesh_pool.free_list);
-    memset(&g_mesh_pool, 0, sizeof(g_mesh_pool));
+void mesh_system_shutdown(void) {
+    if (!mesh_pool_ready()) return;
+
+    mesh_pool_foreach(mesh_release_cb, NULL);
+    mesh_pool_shutdown();
 
     INFO("mesh system shutdown");
 }
@@ -82,30 +71,22 @@ mesh_handle_t mesh_create(const mesh_desc_t *desc) {
         return MESH_HANDLE_INVALID;
     }
 
-    if (g_mesh_pool.free_count == 0) {
-        ERROR("mesh_create: pool exhausted");
-        return MESH_HANDLE_INVALID;
-    }
-
     const rhi_dispatch_t *rhi = g_ctx.active_rhi;
     if (!rhi) {
         ERROR("mesh_create: no active RHI");
         return MESH_HANDLE_INVALID;
     }
 
-    uint32_t idx = g_mesh_pool.free_list[--g_mesh_pool.free_count];
-    mesh_t *m = &g_mesh_pool.meshes[idx];
-    memset(m, 0, sizeof(*m));
+    mesh_t m = {0};
 
     /* Create vertex buffer */
     rhi_buffer_desc_t vbd = {0};
     vbd.size = desc->vertex_size * desc->vertex_count;
     vbd.usage = RHI_BUF_VERTEX;
     vbd.stride = (uint32_t) desc->vertex_size;
-    m->vb = rhi->create_buffer(g_ctx.active_device, &vbd, desc->vertices);
-    if (!m->vb) {
+    m.vb = rhi->create_buffer(g_ctx.active_device, &vbd, desc->vertices);
+    if (!m.vb) {
         ERROR("mesh_create: failed to create vertex buffer");
-        g_mesh_pool.free_list[g_mesh_pool.free_count++] = idx;
         return MESH_HANDLE_INVALID;
     }
 
@@ -114,68 +95,70 @@ mesh_handle_t mesh_create(const mesh_desc_t *desc) {
         rhi_buffer_desc_t ibd = {0};
         ibd.size = sizeof(uint32_t) * desc->index_count;
         ibd.usage = RHI_BUF_INDEX;
-        m->ib = rhi->create_buffer(g_ctx.active_device, &ibd, desc->indices);
-        if (!m->ib) {
+        m.ib = rhi->create_buffer(g_ctx.active_device, &ibd, desc->indices);
+        if (!m.ib) {
             ERROR("mesh_create: failed to create index buffer");
-            rhi->destroy_buffer(g_ctx.active_device, m->vb);
-            g_mesh_pool.free_list[g_mesh_pool.free_count++] = idx;
+            rhi->destroy_buffer(g_ctx.active_device, m.vb);
             return MESH_HANDLE_INVALID;
         }
     }
 
-    m->vertex_count = desc->vertex_count;
-    m->index_count = desc->index_count;
-    g_mesh_pool.count++;
+    m.vertex_count = desc->vertex_count;
+    m.index_count = desc->index_count;
+    m.region = s_region;
+
+    handle_t h = mesh_pool_alloc(&m);
+    if (h == HANDLE_INVALID) {
+        ERROR("mesh_create: pool exhausted");
+        mesh_release(&m);
+        return MESH_HANDLE_INVALID;
+    }
 
-    return (mesh_handle_t) (idx + 1);
+    return (mesh_handle_t) h;
 }
 
 void mesh_destroy(mesh_handle_t h) {
     if (h == MESH_HANDLE_INVALID) return;
 
-    uint32_t idx = h - 1;
-    if (idx >= g_mesh_pool.capacity) {
+    mesh_t *m = mesh_pool_get((handle_t) h);
+    if (!m) {
         ERROR("mesh_destroy: invalid handle");
         return;
     }
 
-    mesh_t *m = &g_mesh_pool.meshes[idx];
-    const rhi_dispatch_t *rhi = g_ctx.active_rhi;
-
-    if (rhi) {
-        if (m->ib) rhi->destroy_buffer(g_ctx.active_device, m->ib);
-        if (m->vb) rhi->destroy_buffer(g_ctx.active_device, m->vb);
-    }
-
-    memset(m, 0, sizeof(*m));
-    g_mesh_pool.free_list[g_mesh_pool.free_count++] = idx;
-    g_mesh_pool.count--;
+    mesh_release(m);
+    mesh_pool_free((handle_t) h);
 }
 
 uint32_t mesh_get_vertex_count(mesh_handle_t h) {
-    if (h == MESH_HANDLE_INVALID) return 0;
-    uint32_t idx = h - 1;
-    if (idx >= g_mesh_pool.capacity) return 0;
-    return g_mesh_pool.meshes[idx].vertex_count;
+    const mesh_t *m = mesh_pool_get((handle_t) h);
+    return m ? m->vertex_count : 0;
 }
 
 uint32_t mesh_get_index_count(mesh_handle_t h) {
-    if (h == MESH_HANDLE_INVALID) return 0;
-    uint32_t idx = h - 1;
-    if (idx >= g_mesh_pool.capacity) return 0;
-    return g_mesh_pool.meshes[idx].index_count;
+    const mesh_t *m = mesh_pool_get((handle_t) h);
+    return m ? m->index_count : 0;
+}
+
+void mesh_prefetch(const mesh_handle_t *handles, size_t n) {
+    mesh_t *tmp[64];
+    while (n > 0) {
+        size_t k = n < ARRAY_SIZE(tmp) ? n : ARRAY_SIZE(tmp);
+        mesh_pool_get_many((const handle_t*) handles, k, tmp);
+        handles += k;
+        n -= k;
+    }
 }
 
 void mesh_bind(struct rhi_cmd *cmd, mesh_handle_t h) {
     if (!cmd || h == MESH_HANDLE_INVALID) return;
 
-    uint32_t idx = h - 1;
-    if (idx >= g_mesh_pool.capacity) {
+    const mesh_t *m = mesh_pool_get((handle_t) h);
+    if (UNLIKELY(!m)) {
         ERROR("mesh_bind: invalid handle");
         return;
     }
 
-    mesh_t *m = &g_mesh_pool.meshes[idx];
     const rhi_dispatch_t *rhi = g_ctx.active_rhi;
 
     if (rhi && m->vb) {
@@ -189,13 +172,12 @@ void mesh_bind(struct rhi_cmd *cmd, mesh_handle_t h) {
 void mesh_draw(struct rhi_cmd *cmd, mesh_handle_t h) {
     if (!cmd || h == MESH_HANDLE_INVALID) return;
 
-    uint32_t idx = h - 1;
-    if (idx >= g_mesh_pool.capacity) {
+    const mesh_t *m = mesh_pool_get((handle_t) h);
+    if (UNLIKELY(!m)) {
         ERROR("mesh_draw: invalid handle");
         return;
     }
 
-    mesh_t *m = &g_mesh_pool.meshes[idx];
     const rhi_dispatch_t *rhi = g_ctx.active_rhi;
 
     if (!rhi) return;
@@ -206,3 +188,35 @@ void mesh_draw(struct rhi_cmd *cmd, mesh_handle_t h) {
         rhi->cmd_draw(cmd, m->vertex_count, 0, 1);
     }
 }
+
+int mesh_get_draw_info(mesh_handle_t h, mesh_draw_info_t *out) {
+    if (!out) return -1;
+    memset(out, 0, sizeof(*out));
+
+    const mesh_t *m = mesh_pool_get((handle_t) h);
+    if (!m) return -1;
+
+    out->vb = m->vb;
+    out->ib = m->ib;
+    out->vertex_count = m->vertex_count;
+    out->index_count = m->index_count;
+    return 0;
+}
+
+void mesh_set_region(mem_region_t *r) {
+    s_region = r;
+}
+
+static void mesh_release_region_cb(handle_t h, void *obj, void *user) {
+    if (((const mesh_t*) obj)->region == (const mem_region_t*) user) {
+        mesh_destroy((mesh_handle_t) h);
+    }
+}
+
+void mesh_release_region(mem_region_t *r) {
+    if (!mesh_pool_ready() || !r) return;
+    if (s_region == r) s_region = NULL;
+
+    /* foreach walks backwards, so freeing the visited mesh is safe */
+    mesh_pool_foreach(mesh_release_region_cb, r);
+}
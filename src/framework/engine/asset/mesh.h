@@ -9,6 +9,7 @@ extern "C" {
 #endif
 
 struct rhi_vertex_attr;
+struct rhi_buffer;
 
 typedef uint32_t mesh_handle_t;
 #define MESH_HANDLE_INVALID ((mesh_handle_t)0)
@@ -43,6 +44,29 @@ struct rhi_cmd;
 void mesh_bind(struct rhi_cmd *cmd, mesh_handle_t h);
 void mesh_draw(struct rhi_cmd *cmd, mesh_handle_t h);
 
+/* What mesh_bind + mesh_draw use, resolved for recording a draw to replay elsewhere */
+typedef struct mesh_draw_info {
+    struct rhi_buffer *vb;
+    struct rhi_buffer *ib;
+    uint32_t vertex_count;
+    uint32_t index_count;
+} mesh_draw_info_t;
+
+/* Returns 0, or -1 for a stale handle */
+int mesh_get_draw_info(mesh_handle_t h, mesh_draw_info_t *out);
+
+/*
+ * Meshes created while a region is set belong to its lifetime;
+ * mesh_release_region destroys them all before the region is reset. The
+ * record itself is a pool slot, so no heap block is involved.
+ */
+struct mem_region;
+void mesh_set_region(struct mem_region *r);
+void mesh_release_region(struct mem_region *r);
+
+/* Warm the cache for meshes about to be drawn; invalid handles are skipped */
+void mesh_prefetch(const mesh_handle_t *handles, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
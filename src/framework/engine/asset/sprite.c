@@ -5,7 +5,7 @@
 #include "engine_context.h"
 #include "rhi/rhi.h"
 #include "log.h"
-#include "mem/mem_diag.h"
+#include "handle/typed_pool.h"
 
 #include <string.h>
 
@@ -18,56 +18,38 @@ typedef struct sprite_s {
     float height;
 } sprite_t;
 
-static struct {
-    sprite_t *sprites;
-    uint32_t *free_list;
-    uint32_t capacity;
-    uint32_t count;
-    uint32_t free_count;
-} g_sprite_pool;
+MARU_DEFINE_POOL_TAGGED(sprite, sprite_t, MEM_TAG_ASSET);
 
 int sprite_system_init(size_t capacity) {
-    if (g_sprite_pool.sprites) {
+    if (sprite_pool_ready()) {
         ERROR("sprite system already initialized");
         return -1;
     }
 
-    g_sprite_pool.capacity = (uint32_t) capacity;
-    g_sprite_pool.sprites = (sprite_t*) MARU_CALLOC(capacity, sizeof(sprite_t));
-    g_sprite_pool.free_list = (uint32_t*) MARU_MALLOC(capacity * sizeof(uint32_t));
-
-    if (!g_sprite_pool.sprites || !g_sprite_pool.free_list) {
+    /* capacity is the page size; the pool grows a page at a time */
+    if (sprite_pool_init(capacity) != 0) {
         ERROR("sprite system allocation failed");
-        if (g_sprite_pool.sprites)
-            MARU_FREE(g_sprite_pool.sprites);
-        if (g_sprite_pool.free_list)
-            MARU_FREE(g_sprite_pool.free_list);
         return -1;
     }
 
-    for (uint32_t i = 0; i < capacity; ++i) {
-        g_sprite_pool.free_list[i] = capacity - 1 - i;
-    }
-    g_sprite_pool.free_count = capacity;
-    g_sprite_pool.count = 0;
-
-    INFO("sprite system initialized (capacity=%u)", capacity);
+    INFO("sprite system initialized (page capacity=%zu)", capacity);
     return 0;
 }
 
-void sprite_system_shutdown(void) {
-    if (!g_sprite_pool.sprites) return;
-
-    for (uint32_t i = 0; i < g_sprite_pool.capacity; ++i) {
-        sprite_t *s = &g_sprite_pool.sprites[i];
-        if (s->mesh != MESH_HANDLE_INVALID) {
-            mesh_destroy(s->mesh);
-        }
+static void sprite_release_cb(handle_t h, void *obj, void *user) {
+    UNUSED(h);
+    UNUSED(user);
+    const sprite_t *s = (const sprite_t*) obj;
+    if (s->mesh != MESH_HANDLE_INVALID) {
+        mesh_destroy(s->mesh);
     }
+}
 
-    MARU_FREE(g_sprite_pool.sprites);
-    MARU_FREE(g_sprite_pool.free_list);
-    memset(&g_sprite_pool, 0, sizeof(g_sprite_pool));
+void sprite_system_shutdown(void) {
+    if (!sprite_pool_ready()) return;
+
+    sprite_pool_foreach(sprite_release_cb, NULL);
+    sprite_pool_shutdown();
 
     INFO("sprite system shutdown");
 }
@@ -78,11 +60,6 @@ sprite_handle_t sprite_create(const sprite_desc_t *desc) {
         return SPRITE_HANDLE_INVALID;
     }
 
-    if (g_sprite_pool.free_count == 0) {
-        ERROR("sprite_create: pool exhausted");
-        return SPRITE_HANDLE_INVALID;
-    }
-
     /* Create quad mesh: position(3) + texcoord(2) + normal(3) */
     float hw = desc->width * 0.5f;
     float hh = desc->height * 0.5f;
@@ -117,49 +94,47 @@ sprite_handle_t sprite_create(const sprite_desc_t *desc) {
         return SPRITE_HANDLE_INVALID;
     }
 
-    uint32_t idx = g_sprite_pool.free_list[--g_sprite_pool.free_count];
-    sprite_t *s = &g_sprite_pool.sprites[idx];
-    memset(s, 0, sizeof(*s));
+    sprite_t s = {0};
+    s.mesh = mesh;
+    s.texture = desc->texture;
+    s.width = desc->width;
+    s.height = desc->height;
 
-    s->mesh = mesh;
-    s->texture = desc->texture;
-    s->width = desc->width;
-    s->height = desc->height;
-    g_sprite_pool.count++;
+    handle_t h = sprite_pool_alloc(&s);
+    if (h == HANDLE_INVALID) {
+        ERROR("sprite_create: pool exhausted");
+        mesh_destroy(mesh);
+        return SPRITE_HANDLE_INVALID;
+    }
 
-    return (sprite_handle_t) (idx + 1);
+    return (sprite_handle_t) h;
 }
 
 void sprite_destroy(sprite_handle_t h) {
     if (h == SPRITE_HANDLE_INVALID) return;
 
-    uint32_t idx = h - 1;
-    if (idx >= g_sprite_pool.capacity) {
+    sprite_t *s = sprite_pool_get((handle_t) h);
+    if (!s) {
         ERROR("sprite_destroy: invalid handle");
         return;
     }
 
-    sprite_t *s = &g_sprite_pool.sprites[idx];
     if (s->mesh != MESH_HANDLE_INVALID) {
         mesh_destroy(s->mesh);
     }
 
-    memset(s, 0, sizeof(*s));
-    g_sprite_pool.free_list[g_sprite_pool.free_count++] = idx;
-    g_sprite_pool.count--;
+    sprite_pool_free((handle_t) h);
 }
 
 void sprite_draw(struct rhi_cmd *cmd, sprite_handle_t h, float x, float y) {
     if (h == SPRITE_HANDLE_INVALID) return;
 
-    uint32_t idx = h - 1;
-    if (idx >= g_sprite_pool.capacity) {
+    const sprite_t *s = sprite_pool_get((handle_t) h);
+    if (UNLIKELY(!s)) {
         ERROR("sprite_draw: invalid handle");
         return;
     }
 
-    sprite_t *s = &g_sprite_pool.sprites[idx];
-
     /* TODO: Apply transform (x, y) via constant buffer or push constants */
 
     /* Bind texture */
@@ -174,3 +149,14 @@ void sprite_draw(struct rhi_cmd *cmd, sprite_handle_t h, float x, float y) {
     mesh_bind(cmd, s->mesh);
     mesh_draw(cmd, s->mesh);
 }
+
+int sprite_get_draw_info(sprite_handle_t h, mesh_draw_info_t *mesh, rhi_texture_t **texture) {
+    if (!mesh || !texture) return -1;
+    *texture = NULL;
+
+    const sprite_t *s = sprite_pool_get((handle_t) h);
+    if (!s) return -1;
+
+    if (s->texture != TEX_HANDLE_INVALID) *texture = tex_acquire_rhi(s->texture);
+    return mesh_get_draw_info(s->mesh, mesh);
+}
@@ -30,6 +30,11 @@ void sprite_destroy(sprite_handle_t h);
 struct rhi_cmd;
 void sprite_draw(struct rhi_cmd *cmd, sprite_handle_t h, float x, float y);
 
+/* What sprite_draw binds: its quad, and its texture (NULL until ready). Returns 0 or -1 */
+struct mesh_draw_info;
+struct rhi_texture;
+int sprite_get_draw_info(sprite_handle_t h, struct mesh_draw_info *mesh, struct rhi_texture **texture);
+
 #ifdef __cplusplus
 }
 #endif
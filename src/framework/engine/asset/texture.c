@@ -3,12 +3,24 @@
 #include "engine_context.h"
 #include "log.h"
 #include "mem/mem_diag.h"
+#include "mem/mem_region.h"
+#include "mem/mem_slab.h"
+#include "renderer/renderer.h"
 #include "rhi/rhi.h"
 
 #include <string.h>
 
 extern engine_context_t g_ctx;
 
+static mem_region_t *s_region = NULL;
+
+/* texture_t records count as texture memory, not as core slab pages */
+static slab_pool_t s_pool = SLAB_POOL_INIT(sizeof(texture_t), MEM_TAG_TEXTURE_CPU);
+
+void texture_set_region(mem_region_t *r) {
+    s_region = r;
+}
+
 texture_t *texture_create_from_data(int width, int height, const unsigned char *rgba_pixels, const texture_opts_t *opts_in) {
     if (!rgba_pixels || width <= 0 || height <= 0) {
         ERROR("texture_create_from_data: invalid args");
@@ -32,7 +44,8 @@ texture_t *texture_create_from_data(int width, int height, const unsigned char *
         return NULL;
     }
 
-    texture_t *tex = (texture_t*) MARU_MALLOC(sizeof(texture_t));
+    texture_t *tex = s_region ? (texture_t*) region_alloc(s_region, sizeof(texture_t), 0)
+                              : (texture_t*) slab_pool_alloc(&s_pool);
     if (!tex) {
         g_ctx.active_rhi->destroy_texture(g_ctx.active_device, rhi_tex);
         return NULL;
@@ -41,6 +54,7 @@ texture_t *texture_create_from_data(int width, int height, const unsigned char *
     tex->height = height;
     tex->channels = 4;
     tex->internal = (void*) rhi_tex;
+    tex->region = s_region;
 
     DEBUG_LOG("texture_create_from_data: %dx%d", width, height);
     return tex;
@@ -52,13 +66,17 @@ void texture_destroy(texture_t *tex) {
     if (tex->internal) {
         rhi_texture_t *rhi_tex = (rhi_texture_t*) tex->internal;
         if (g_ctx.active_device && g_ctx.active_rhi && g_ctx.active_rhi->destroy_texture) {
+            /* an in-flight packet may still bind it */
+            renderer_flush(g_ctx.renderer);
             g_ctx.active_rhi->destroy_texture(g_ctx.active_device, rhi_tex);
         } else {
-            MARU_FREE(rhi_tex);
+            /* backend objects are sized and allocated by the backend; only it can release them */
+            WARN("texture_destroy: no active RHI, leaking backend texture %p", (void*) rhi_tex);
         }
         tex->internal = NULL;
     }
-    MARU_FREE(tex);
+    /* region records go back with region_reset */
+    if (!tex->region) slab_pool_free(&s_pool, tex);
 }
 
 void *texture_get_rhi_handle(texture_t *tex) {
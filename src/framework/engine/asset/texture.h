@@ -7,11 +7,14 @@ extern "C" {
 
 #include <stdint.h>
 
+struct mem_region;
+
 typedef struct texture_t {
     int width;
     int height;
     int channels;
     void *internal;
+    struct mem_region *region; /* record lives here rather than in the slab */
 } texture_t;
 
 typedef struct texture_opts_t {
@@ -22,6 +25,9 @@ texture_t *texture_create_from_data(int width, int height, const unsigned char *
 void texture_destroy(texture_t *tex);
 void *texture_get_rhi_handle(texture_t *tex);
 
+/* Records of textures created from now on come from r (NULL = slab) */
+void texture_set_region(struct mem_region *r);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,50 +2,63 @@
 
 #include "asset/importer.h"
 #include "handle/handle_pool.h"
+#include "container/hashmap.h"
+#include "strid.h"
 #include "mem/mem_diag.h"
+#include "mem/mem_region.h"
 #include "log.h"
+#include "macro.h"
 
 #include <string.h>
 
 typedef struct tex_rec_s {
     texture_t *tex;
-    char *src_rel;
+    const char *src_rel; /* interned, never freed here */
+    strid_t src_id;
     uint32_t flags;
+    mem_region_t *region;
 } tex_rec_t;
 
 static handle_pool_t *s_pool = NULL;
 
-static char *dup_cstr(const char *s) {
-    if (!s) return NULL;
-    size_t n = strlen(s) + 1;
-    char *p = (char*) MARU_MALLOC(n);
-    if (p) memcpy(p, s, n);
-    return p;
-}
+/* strid(relpath) -> handle */
+static map_u32_u32_t s_by_path;
 
+static mem_region_t *s_region = NULL;
 
 int texture_manager_init(size_t capacity) {
     if (s_pool) return 0;
     if (capacity == 0) capacity = 256;
 
-    s_pool = handle_pool_create(capacity, sizeof(tex_rec_t), (size_t) _Alignof(tex_rec_t));
+    s_pool = handle_pool_create_paged(capacity, 0, sizeof(tex_rec_t), (size_t) MARU_ALIGNOF(tex_rec_t));
     if (!s_pool) {
         MR_LOG(FATAL, "texture_manager: handle pool create failed (cap=%zu)", capacity);
         return -1;
     }
 
+    map_u32_u32_init(&s_by_path, maru_tagged_allocator(MEM_TAG_TEXTURE_CPU));
     return 0;
 }
 
+static void tex_release_cb(handle_t h, void *obj, void *user) {
+    UNUSED(h);
+    UNUSED(user);
+
+    tex_rec_t *rec = (tex_rec_t*) obj;
+    if (rec->tex) {
+        texture_destroy(rec->tex);
+        rec->tex = NULL;
+    }
+    rec->src_rel = NULL;
+}
+
 void texture_manager_shutdown(void) {
     if (!s_pool) return;
 
-    size_t cap = handle_pool_capacity(s_pool);
-    for (uint32_t idx = 0; idx < (uint32_t) cap; ++idx) {
-        tex_rec_t *rec = (tex_rec_t*) handle_pool_get(s_pool, make_handle(idx, ((uint8_t) 0xFF)));
-        if (!rec) continue;
-    }
+    /* Release textures the user never destroyed */
+    handle_pool_foreach(s_pool, tex_release_cb, NULL);
 
+    map_u32_u32_destroy(&s_by_path);
     handle_pool_destroy(s_pool);
     s_pool = NULL;
 }
@@ -62,21 +75,37 @@ texture_handle_t tex_create_from_file(const char *relpath) {
 
     tex_rec_t init = {0};
     init.tex = t;
-    init.src_rel = dup_cstr(relpath);
+    init.src_rel = strid_intern_str(relpath);
+    init.src_id = strid_hash(relpath);
     init.flags = TEX_STATE_READY;
+    init.region = t->region;
     handle_t h = handle_pool_alloc(s_pool, &init);
     if (h == HANDLE_INVALID) {
-        ERROR("texture_manager: pool full; cannot allocate handle for %s", relpath);
+        ERROR("texture_manager: cannot allocate handle for %s", relpath);
         texture_destroy(t);
-        if (init.src_rel) {
-            MARU_FREE(init.src_rel);
-        }
         return TEX_HANDLE_INVALID;
     }
 
+    /* Latest load of a path wins the lookup slot */
+    if (map_u32_u32_put(&s_by_path, init.src_id, h) != 0) {
+        WARN("texture_manager: path index insert failed: %s", relpath);
+    }
+
     return (texture_handle_t) h;
 }
 
+texture_handle_t tex_find(const char *relpath) {
+    if (!relpath) return TEX_HANDLE_INVALID;
+    return tex_find_id(strid_hash(relpath));
+}
+
+texture_handle_t tex_find_id(strid_t path_id) {
+    if (!s_pool) return TEX_HANDLE_INVALID;
+
+    texture_handle_t th = (texture_handle_t) map_u32_u32_get(&s_by_path, path_id, TEX_HANDLE_INVALID);
+    return handle_pool_get(s_pool, (handle_t) th) ? th : TEX_HANDLE_INVALID;
+}
+
 void tex_destroy(texture_handle_t th) {
     if (!s_pool || th == TEX_HANDLE_INVALID) return;
     tex_rec_t *rec = (tex_rec_t*) handle_pool_get(s_pool, (handle_t) th);
@@ -86,10 +115,10 @@ void tex_destroy(texture_handle_t th) {
         texture_destroy(rec->tex);
         rec->tex = NULL;
     }
-    if (rec->src_rel) {
-        MARU_FREE(rec->src_rel);
-        rec->src_rel = NULL;
+    if (map_u32_u32_get(&s_by_path, rec->src_id, TEX_HANDLE_INVALID) == th) {
+        map_u32_u32_remove(&s_by_path, rec->src_id);
     }
+    rec->src_rel = NULL;
     rec->flags = TEX_STATE_EMPTY;
 
     handle_pool_free(s_pool, (handle_t) th);
@@ -120,3 +149,23 @@ const char *tex_get_source_path(texture_handle_t th) {
     tex_rec_t *rec = (tex_rec_t*) handle_pool_get(s_pool, (handle_t) th);
     return rec ? rec->src_rel : NULL;
 }
+
+
+void tex_set_region(mem_region_t *r) {
+    s_region = r;
+    texture_set_region(r);
+}
+
+static void tex_release_region_cb(handle_t h, void *obj, void *user) {
+    if (((const tex_rec_t*) obj)->region == (const mem_region_t*) user) {
+        tex_destroy((texture_handle_t) h);
+    }
+}
+
+void tex_release_region(mem_region_t *r) {
+    if (!s_pool || !r) return;
+    if (s_region == r) tex_set_region(NULL);
+
+    /* foreach walks backwards, so freeing the visited record is safe */
+    handle_pool_foreach(s_pool, tex_release_region_cb, r);
+}
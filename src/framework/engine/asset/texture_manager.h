@@ -5,6 +5,7 @@
 #include "core.h"
 #include "rhi/rhi.h"
 #include "asset/texture.h"
+#include "strid.h"
 
 
 #ifdef __cplusplus
@@ -26,6 +27,10 @@ void texture_manager_shutdown(void);
 
 texture_handle_t tex_create_from_file(const char *relpath);
 
+/* Live texture most recently loaded from relpath, or TEX_HANDLE_INVALID */
+texture_handle_t tex_find(const char *relpath);
+texture_handle_t tex_find_id(strid_t path_id); /* path_id = strid_hash / MARU_SID of relpath */
+
 void tex_destroy(texture_handle_t h);
 
 rhi_texture_t *tex_acquire_rhi(texture_handle_t h);
@@ -33,6 +38,15 @@ rhi_texture_t *tex_acquire_rhi(texture_handle_t h);
 int tex_is_ready(texture_handle_t h);
 const char *tex_get_source_path(texture_handle_t h);
 
+/*
+ * Textures loaded while a region is set keep their CPU records in it.
+ * tex_release_region destroys all of them (backend textures included) so
+ * the caller can region_reset it.
+ */
+struct mem_region;
+void tex_set_region(struct mem_region *r);
+void tex_release_region(struct mem_region *r);
+
 
 #ifdef __cplusplus
 }
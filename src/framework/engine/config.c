@@ -40,6 +40,16 @@ int config_load(const char *engine_json, maru_config_t *out) {
     out->gfx_width = json_get_int(root, "graphics.width", 1280);
     out->gfx_height = json_get_int(root, "graphics.height", 720);
     out->gfx_vsync = json_get_int(root, "graphics.vsync", 1);
+    out->gfx_render_thread = json_get_int(root, "graphics.render_thread", 0);
+
+    out->job_workers = json_get_int(root, "jobs.workers", -1);
+
+    out->mem_backend = str_dup(json_get_string(root, "mem.backend", "system"));
+    out->mem_tlsf_region_mb = json_get_int(root, "mem.tlsf_region_mb", 64);
+
+    out->debug_alloc_churn = json_get_int(root, "debug.alloc_churn", 0);
+    out->debug_alloc_churn_csv = str_dup(json_get_string(root, "debug.alloc_churn_csv", NULL));
+    out->debug_zero_alloc_after = json_get_int(root, "debug.zero_alloc_after", 0);
 
     json_free(root);
     return MARU_OK;
@@ -59,4 +69,12 @@ void config_free(maru_config_t *cfg) {
         MARU_FREE(cfg->plugin_paths);
         cfg->plugin_paths = NULL;
     }
+    if (cfg->mem_backend) {
+        MARU_FREE((void*) cfg->mem_backend);
+        cfg->mem_backend = NULL;
+    }
+    if (cfg->debug_alloc_churn_csv) {
+        MARU_FREE((void*) cfg->debug_alloc_churn_csv);
+        cfg->debug_alloc_churn_csv = NULL;
+    }
 }
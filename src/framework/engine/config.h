@@ -11,6 +11,17 @@ typedef struct maru_config {
     int gfx_width;
     int gfx_height;
     int gfx_vsync;
+    int gfx_render_thread;              /* submit and present from a render thread, a frame behind (not on GL/GLES) */
+
+    int job_workers;                    /* job system threads besides the main one, -1 = one per core */
+
+    const char *mem_backend;            /* MARU_MALLOC heap: "system" or "tlsf" */
+    int mem_tlsf_region_mb;             /* tlsf: size of each region taken from the system */
+
+    /* Allocation churn profiling of maru_engine_tick (see mem_churn.h) */
+    int debug_alloc_churn;
+    const char *debug_alloc_churn_csv;  /* written at shutdown, or NULL */
+    int debug_zero_alloc_after;         /* frames; warn when a later tick allocates, 0 = off */
 } maru_config_t;
 
 int config_load(const char *engine_json, maru_config_t *out);
@@ -6,6 +6,7 @@
 #include "rhi/rhi.h"
 #include "renderer/renderer.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include "asset/asset.h"
@@ -22,8 +23,13 @@ extern const asset_importer_vtable_t g_texture_importer;
 extern const asset_importer_vtable_t g_mesh_obj_importer;
 
 #include "time.h"
+#include "strid.h"
 #include "mem/mem_diag.h"
+#include "mem/mem_churn.h"
 #include "mem/mem_frame.h"
+#include "mem/mem_region.h"
+#include "mem/tlsf.h"
+#include "thread/job.h"
 
 typedef struct boot_prof_s {
     uint64_t t0;
@@ -53,8 +59,23 @@ static int initialized = 0;
 renderer_t g_renderer;
 
 static rhi_swapchain_t *g_swapchain = NULL;
+
+/* Address space only; pages are committed as the level loads */
+#define LEVEL_REGION_RESERVE ((size_t) 256 * 1024 * 1024)
+
+static mem_region_t g_level_region;
+static int g_level_active = 0;
 static rhi_render_target_t *g_back_rt = NULL;
 
+/* Heap allocations made inside maru_engine_tick, from config "debug.*" */
+#define ALLOC_WARN_LIMIT 16
+
+static struct {
+    size_t zero_after;          /* frames; 0 = no check */
+    uint32_t violations;
+    char csv[260];
+} g_alloc_check;
+
 static const char *map_backend_to_regname(const char *backend) {
     if (!backend) return "gl";
     if (strcmp(backend, "dx") == 0 || strcmp(backend, "dx11") == 0) return "dx11";
@@ -78,6 +99,8 @@ int maru_engine_init(const char *config_path) {
 
     INFO("maru init");
 
+    strid_system_init();
+
     asset_init(NULL);
     boot_prof_step(&prof, "asset_init");
 
@@ -95,6 +118,16 @@ int maru_engine_init(const char *config_path) {
 
     boot_prof_step(&prof, "config_load");
 
+    /* still single-threaded: what was allocated so far stays with libc */
+    if (cfg.mem_backend && strcmp(cfg.mem_backend, "tlsf") == 0) {
+        size_t region = (size_t) (cfg.mem_tlsf_region_mb > 0 ? cfg.mem_tlsf_region_mb : 64) << 20;
+        if (mem_tlsf_backend_init(region) == 0) {
+            INFO("[mem] MARU_MALLOC backend: tlsf, %zu MB regions", region >> 20);
+        } else {
+            WARN("[mem] tlsf backend unavailable, using the system allocator");
+        }
+    }
+
     engine_context_init(&g_ctx);
     boot_prof_step(&prof, "engine_context_init");
 
@@ -142,7 +175,16 @@ int maru_engine_init(const char *config_path) {
     g_back_rt = g_ctx.active_rhi->get_backbuffer_rt(g_ctx.active_device);
     boot_prof_step(&prof, "swapchain+backbuffer");
 
-    frame_arena_init(8 * 1024 * 1024, 2);
+    /* without workers, jobs run on the submitting thread */
+    if (maru_job_system_init(cfg.job_workers) != 0) {
+        WARN("job system unavailable, running jobs inline");
+    }
+    boot_prof_step(&prof, "job_system_init");
+
+    /* address space only; pages commit as frames use them */
+    if (frame_arena_init_virtual(64 * 1024 * 1024, 2) != 0) {
+        frame_arena_init(8 * 1024 * 1024, 2);
+    }
 
     if (texture_manager_init(512) != 0) {
         FATAL("texture manager initialize failed");
@@ -168,8 +210,21 @@ int maru_engine_init(const char *config_path) {
     int cw = 0, ch = 0;
     platform_window_get_size(g_ctx.window, &cw, &ch);
     renderer_init(&g_renderer, g_ctx.active_rhi, g_ctx.active_device, cw, ch);
+    g_ctx.renderer = &g_renderer;
+    if (cfg.gfx_render_thread && renderer_start_thread(&g_renderer, g_swapchain) != 0) {
+        WARN("render thread unavailable, rendering on the main thread");
+    }
     boot_prof_step(&prof, "renderer_init");
 
+    g_alloc_check.zero_after = cfg.debug_zero_alloc_after > 0 ? (size_t) cfg.debug_zero_alloc_after : 0;
+    g_alloc_check.violations = 0;
+    g_alloc_check.csv[0] = '\0';
+    if (cfg.debug_alloc_churn_csv) {
+        snprintf(g_alloc_check.csv, sizeof(g_alloc_check.csv), "%s", cfg.debug_alloc_churn_csv);
+    }
+    /* the zero-alloc check needs the profiler to name offending sites */
+    mem_churn_enable(cfg.debug_alloc_churn || g_alloc_check.zero_after);
+
     config_free(&cfg);
     boot_prof_total(&prof);
 
@@ -179,9 +234,22 @@ int maru_engine_init(const char *config_path) {
 }
 
 static size_t frame_count = 0;
-bool maru_engine_tick(void) {
-    if (!initialized) return false;
+/* Warns when a steady-state tick touched the heap, naming the sites if profiling */
+static void tick_alloc_check(uint64_t allocs) {
+    if (!g_alloc_check.zero_after || frame_count <= g_alloc_check.zero_after || allocs == 0) return;
+
+    if (++g_alloc_check.violations > ALLOC_WARN_LIMIT) return;
+    WARN("[mem] frame %zu: maru_engine_tick made %llu heap allocations%s", frame_count,
+         (unsigned long long) allocs, g_alloc_check.violations == ALLOC_WARN_LIMIT ? " (further ones counted only)" : "");
+
+    mem_churn_site_t sites[8];
+    size_t n = mem_churn_last_frame(sites, 8);
+    for (size_t i = 0; i < n && i < 8; ++i) {
+        WARN("[mem]   %llu @ %s:%d", (unsigned long long) sites[i].last_count, sites[i].file, sites[i].line);
+    }
+}
 
+static bool tick_frame(void) {
     frame_arena_begin(frame_count++);
 
     if (platform_should_close(g_ctx.window)) return false;
@@ -190,7 +258,14 @@ bool maru_engine_tick(void) {
 
     int cur_w = 0, cur_h = 0;
     platform_window_get_size(g_ctx.window, &cur_w, &cur_h);
-    if (g_ctx.active_rhi && g_ctx.active_rhi->resize) {
+
+    /* the render thread owns the device while a packet is in flight */
+    int threaded = renderer_threaded(&g_renderer);
+    if (threaded && (cur_w != g_renderer.w || cur_h != g_renderer.h)) {
+        renderer_flush(&g_renderer);
+    }
+
+    if (g_ctx.active_rhi && g_ctx.active_rhi->resize && (!threaded || cur_w != g_renderer.w || cur_h != g_renderer.h)) {
         g_ctx.active_rhi->resize(g_ctx.active_device, cur_w, cur_h);
 
         if (g_ctx.active_rhi->get_backbuffer_rt) {
@@ -205,27 +280,95 @@ bool maru_engine_tick(void) {
 
     renderer_resize(&g_renderer, cur_w, cur_h);
     renderer_render(&g_renderer);
+    if (threaded) return true;      /* presented by the render thread */
 
     if (!g_swapchain) g_swapchain = rhi->get_swapchain(g_ctx.active_device);
     rhi->present(g_swapchain);
     return true;
 }
 
+bool maru_engine_tick(void) {
+    if (!initialized) return false;
+
+    uint64_t allocs = mem_alloc_total();
+    mem_churn_frame_begin();
+
+    bool running = tick_frame();
+
+    mem_churn_frame_end();
+    tick_alloc_check(mem_alloc_total() - allocs);
+    return running;
+}
+
+uint32_t maru_engine_tick_alloc_violations(void) {
+    return g_alloc_check.violations;
+}
+
+int maru_engine_level_begin(void) {
+    if (!initialized) return MARU_ERR_INVALID;
+    if (g_level_active) maru_engine_level_end();
+
+    if (!g_level_region.vm.base &&
+        region_init(&g_level_region, "level", LEVEL_REGION_RESERVE, MEM_TAG_ASSET) != 0) {
+        return MARU_ERR_OUT_OF_MEMORY;
+    }
+
+    material_set_region(&g_level_region);
+    mesh_set_region(&g_level_region);
+    tex_set_region(&g_level_region);
+    g_level_active = 1;
+    return MARU_OK;
+}
+
+void maru_engine_level_end(void) {
+    if (!g_level_active) return;
+    renderer_flush(&g_renderer);
+
+    /* GPU objects still go one by one; the CPU side is a single reset */
+    material_release_region(&g_level_region);
+    mesh_release_region(&g_level_region);
+    tex_release_region(&g_level_region);
+
+    region_stats_t rs;
+    region_stats(&g_level_region, &rs);
+    INFO("[mem] level unload: %zu allocations, %zu bytes released", rs.allocs, rs.used);
+
+    region_reset(&g_level_region);
+    g_level_active = 0;
+}
+
 void maru_engine_shutdown(void) {
     if (!initialized) return;
 
+    if (mem_churn_enabled()) {
+        mem_churn_dump(20);
+        if (g_alloc_check.csv[0]) mem_churn_write_csv(g_alloc_check.csv, (size_t) -1);
+        mem_churn_enable(0);
+    }
+    if (g_alloc_check.violations) {
+        WARN("[mem] %u steady-state ticks allocated from the heap", g_alloc_check.violations);
+    }
+
+    renderer_stop_thread(&g_renderer);
+    maru_engine_level_end();
+    maru_job_system_shutdown();
+
     material_system_shutdown();
     sprite_system_shutdown();
     mesh_system_shutdown();
     texture_manager_shutdown();
     frame_arena_shutdown();
+    region_destroy(&g_level_region);
 
+    g_ctx.renderer = NULL;
     renderer_shutdown(&g_renderer);
     engine_context_shutdown(&g_ctx);
 
     /* Shutdown asset importer system */
     asset_importer_shutdown();
 
+    strid_system_shutdown();
+
     INFO("maru shutdown");
 
     initialized = 0;
@@ -11,6 +11,21 @@ int maru_engine_init(const char *config_path);
 bool maru_engine_tick();
 void maru_engine_shutdown(void);
 
+/*
+ * Ticks past config "debug.zero_alloc_after" that allocated from the heap;
+ * a smoke run can fail on a non-zero result. Always 0 when the check is off.
+ */
+uint32_t maru_engine_tick_alloc_violations(void);
+
+/*
+ * Level lifetime. Materials, meshes and textures created between begin and
+ * end keep their CPU-side records in one region and are all destroyed by
+ * end, which then drops the region with a single reset. Beginning a new
+ * level ends the current one; shutdown ends it too.
+ */
+int maru_engine_level_begin(void);
+void maru_engine_level_end(void);
+
 /* Renderer access for user */
 extern renderer_t g_renderer;
 
@@ -35,6 +35,9 @@ typedef struct engine_context {
     rhi_device_t *active_device;
 
     struct platform_window *window;
+
+    /* Its in-flight packet is waited for before GPU objects are destroyed; may be NULL */
+    struct renderer *renderer;
 } engine_context_t;
 
 void engine_context_init(engine_context_t *ctx);
@@ -4,21 +4,20 @@
 #include "rhi/rhi.h"
 #include "asset/texture_manager.h"
 #include "asset/asset.h"
-#include "handle/handle_pool.h"
+#include "renderer/renderer.h"
+#include "handle/typed_pool.h"
+#include "container/hashmap.h"
+#include "strid.h"
 #include "mem/mem_diag.h"
+#include "mem/mem_region.h"
+#include "mem/mem_scratch.h"
 #include "log.h"
 #include <string.h>
 
 extern engine_context_t g_ctx;
 
 material_param_id material_param(const char *name) {
-    unsigned long h = 5381;
-    if (!name) return 0;
-    for (const unsigned char *p = (const unsigned char*) name; *p; ++p) {
-        h = ((h << 5) + h) + (unsigned long) (*p);
-    }
-
-    return (material_param_id) h;
+    return name ? (material_param_id) strid_hash(name) : 0;
 }
 
 enum {
@@ -48,24 +47,36 @@ typedef struct {
     struct rhi_shader *sh;
     struct rhi_pipeline *pl;
 
-    /* Dynamic parameters */
+    /* Dynamic parameters; an instance only keeps the ones that override its base */
     material_param_t *params;
     uint32_t param_count;
     uint32_t param_capacity;
+    map_u32_u32_t *param_index; /* id -> params[] index, built once param_count >= PARAM_INDEX_MIN */
 
-    /* Constant buffers (auto-managed) */
+    /* Constant buffers (auto-managed); an instance only fills the slots it overrides */
     struct rhi_buffer *cb_buffers[4]; /* b0~b3 */
     uint8_t *cb_data[4]; /* CPU-side data */
     size_t cb_sizes[4];
     uint8_t cb_dirty[4];
+    uint32_t cb_version[4]; /* base: bumped per change; instance: base version last packed */
+
+    mem_region_t *region;      /* CPU-side data lives here instead of the heap */
 
     /* Instance management */
-    uint8_t is_instance : 1;  /* If true, don't destroy shader/pipeline */
+    material_handle_t base;    /* Instances read shader, pipeline and params through this */
+    uint32_t instance_count;   /* Live instances of a base */
+    uint8_t is_instance : 1;   /* If true, don't destroy shader/pipeline */
 } material_t;
 
-static handle_pool_t *s_pool = NULL;
+MARU_DEFINE_POOL_TAGGED(material, material_t, MEM_TAG_MATERIAL);
 
 static struct rhi_sampler *s_default_sampler = NULL;
+static mem_region_t *s_region = NULL;
+
+/* Below this a linear scan over params beats hashing */
+#define PARAM_INDEX_MIN 32
+
+#define MAX_CB_SIZE (256 * 16) /* 256 vec4s */
 
 /* ===== ��ƿ ===== */
 static int ensure_default_sampler(void) {
@@ -84,12 +95,11 @@ static int ensure_default_sampler(void) {
 }
 
 int material_system_init(size_t capacity) {
-    if (s_pool) return 0;
+    if (material_pool_ready()) return 0;
     if (capacity == 0) capacity = 128;
 
-    s_pool = handle_pool_create(capacity, sizeof(material_t), (size_t) _Alignof(material_t));
-    if (!s_pool) {
-        MR_LOG(FATAL, "material: handle_pool_create failed");
+    if (material_pool_init(capacity) != 0) {
+        MR_LOG(FATAL, "material: pool create failed");
         return -1;
     }
 
@@ -99,33 +109,68 @@ int material_system_init(size_t capacity) {
     return 0;
 }
 
-void material_system_shutdown(void) {
-    if (!s_pool) return;
-    const rhi_dispatch_t *rhi = g_ctx.active_rhi;
+static void *mat_alloc(const material_t *m, size_t size) {
+    return m->region ? region_alloc(m->region, size, 0) : MARU_MALLOC_T(MEM_TAG_MATERIAL, size);
+}
 
-    size_t cap = handle_pool_capacity(s_pool);
-    for (uint32_t idx = 0; idx < (uint32_t) cap; ++idx) {
-        material_t *m = (material_t*) handle_pool_get(s_pool, make_handle(idx, (uint8_t) 0xFF));
-        if (!m) continue;
+static void *mat_realloc(const material_t *m, void *p, size_t old_size, size_t size) {
+    return m->region ? region_realloc(m->region, p, old_size, size, 0) : MARU_REALLOC_T(MEM_TAG_MATERIAL, p, size);
+}
+
+/* Region memory goes back all at once with region_reset */
+static void mat_free(const material_t *m, void *p) {
+    if (p && !m->region) MARU_FREE(p);
+}
 
-        /* Free dynamic parameters */
-        if (m->params) {
-            MARU_FREE(m->params);
-            m->params = NULL;
+static void param_index_free(material_t *m) {
+    if (!m->param_index) return;
+    map_u32_u32_destroy(m->param_index);
+    mat_free(m, m->param_index);
+    m->param_index = NULL;
+}
+
+static int param_index_build(material_t *m) {
+    m->param_index = (map_u32_u32_t*) mat_alloc(m, sizeof(map_u32_u32_t));
+    if (!m->param_index) return 0;
+
+    map_u32_u32_init(m->param_index, m->region ? region_allocator(m->region) : maru_tagged_allocator(MEM_TAG_MATERIAL));
+    maru_hashmap_reserve(&m->param_index->base, m->param_count * 2);
+    for (uint32_t i = 0; i < m->param_count; ++i) {
+        if (map_u32_u32_put(m->param_index, m->params[i].id, i) != 0) {
+            param_index_free(m);
+            return 0;
         }
+    }
+    return 1;
+}
 
-        /* Free constant buffers */
-        for (uint32_t i = 0; i < 4; ++i) {
-            if (m->cb_buffers[i]) {
-                rhi->destroy_buffer(g_ctx.active_device, m->cb_buffers[i]);
-                m->cb_buffers[i] = NULL;
-            }
-            if (m->cb_data[i]) {
-                MARU_FREE(m->cb_data[i]);
-                m->cb_data[i] = NULL;
-            }
+static void material_release_cb(handle_t h, void *obj, void *user) {
+    UNUSED(h);
+    UNUSED(user);
+
+    material_t *m = (material_t*) obj;
+    const rhi_dispatch_t *rhi = g_ctx.active_rhi;
+
+    /* Captured records in an in-flight packet point at these buffers and the pipeline */
+    renderer_flush(g_ctx.renderer);
+
+    /* Free dynamic parameters */
+    mat_free(m, m->params);
+    m->params = NULL;
+    param_index_free(m);
+
+    /* Free constant buffers */
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (m->cb_buffers[i]) {
+            rhi->destroy_buffer(g_ctx.active_device, m->cb_buffers[i]);
+            m->cb_buffers[i] = NULL;
         }
+        mat_free(m, m->cb_data[i]);
+        m->cb_data[i] = NULL;
+    }
 
+    /* Instances share the base's shader/pipeline */
+    if (!m->is_instance) {
         if (m->pl) {
             rhi->destroy_pipeline(g_ctx.active_device, m->pl);
             m->pl = NULL;
@@ -135,29 +180,36 @@ void material_system_shutdown(void) {
             m->sh = NULL;
         }
     }
+}
+
+void material_system_shutdown(void) {
+    if (!material_pool_ready()) return;
+
+    /* Only live materials are visited */
+    material_pool_foreach(material_release_cb, NULL);
 
     if (s_default_sampler) {
         g_ctx.active_rhi->destroy_sampler(g_ctx.active_device, s_default_sampler);
         s_default_sampler = NULL;
     }
 
-    handle_pool_destroy(s_pool);
-    s_pool = NULL;
+    material_pool_shutdown();
 }
 
 material_handle_t material_create(const material_desc_t *desc) {
-    if (!s_pool || !desc || !desc->shader_path || !desc->vs_entry || !desc->ps_entry) {
+    if (!material_pool_ready() || !desc || !desc->shader_path || !desc->vs_entry || !desc->ps_entry) {
         return MAT_HANDLE_INVALID;
     }
 
     const rhi_dispatch_t *rhi = g_ctx.active_rhi;
 
+    scratch_marker_t scratch = scratch_push();
+
     size_t sz = 0;
-    char *blob = asset_read_all(desc->shader_path, &sz, 1);
+    char *blob = asset_read_scratch(desc->shader_path, &sz, 1);
     if (!blob || sz == 0) {
         MR_LOG(ERROR, "material: shader read failed: %s", desc->shader_path ? desc->shader_path : "(null)");
-        if (blob)
-            MARU_FREE(blob);
+        scratch_pop(scratch);
         return MAT_HANDLE_INVALID;
     }
 
@@ -171,7 +223,7 @@ material_handle_t material_create(const material_desc_t *desc) {
     sd.blob_ps_size = sz;
 
     rhi_shader_t *sh = rhi->create_shader(g_ctx.active_device, &sd);
-    MARU_FREE(blob);
+    scratch_pop(scratch);
     if (!sh) {
         MR_LOG(ERROR, "material: create_shader failed (%s)", desc->shader_path);
         return MAT_HANDLE_INVALID;
@@ -227,13 +279,14 @@ material_handle_t material_create(const material_desc_t *desc) {
     init.params = NULL;
     init.param_count = 0;
     init.param_capacity = 0;
+    init.region = s_region;
     init.is_instance = 0;  /* Base material */
 
-    handle_t h = handle_pool_alloc(s_pool, &init);
+    handle_t h = material_pool_alloc(&init);
     if (h == HANDLE_INVALID) {
         rhi->destroy_pipeline(g_ctx.active_device, pl);
         rhi->destroy_shader(g_ctx.active_device, sh);
-        MR_LOG(ERROR, "material: pool full");
+        MR_LOG(ERROR, "material: handle alloc failed");
         return MAT_HANDLE_INVALID;
     }
 
@@ -241,116 +294,144 @@ material_handle_t material_create(const material_desc_t *desc) {
 }
 
 material_handle_t material_create_instance(material_handle_t base) {
-    if (!s_pool || base == MAT_HANDLE_INVALID) {
+    if (!material_pool_ready() || base == MAT_HANDLE_INVALID) {
         return MAT_HANDLE_INVALID;
     }
 
-    material_t *base_mat = (material_t*) handle_pool_get(s_pool, (handle_t) base);
+    material_t *base_mat = material_pool_get((handle_t) base);
     if (!base_mat) {
         MR_LOG(ERROR, "material_create_instance: invalid base material");
         return MAT_HANDLE_INVALID;
     }
 
-    /* Create instance - shares shader/pipeline, clones params */
+    /* Instances of an instance hang off the same base and start with its overrides */
+    const material_t *src = NULL;
+    if (base_mat->is_instance) {
+        src = base_mat;
+        base = base_mat->base;
+        base_mat = material_pool_get((handle_t) base);
+        if (!base_mat) {
+            MR_LOG(ERROR, "material_create_instance: base of instance is gone");
+            return MAT_HANDLE_INVALID;
+        }
+    }
+
+    /* Copy-on-write: shader, pipeline and params are read through the base until overridden */
     material_t instance;
     memset(&instance, 0, sizeof(instance));
-
-    /* Shared resources (pointer copy only) */
-    instance.sh = base_mat->sh;
-    instance.pl = base_mat->pl;
-
-    /* Per-instance data (deep copy of params array) */
-    instance.param_count = base_mat->param_count;
-    instance.param_capacity = base_mat->param_capacity;
+    instance.base = base;
+    instance.region = s_region;
     instance.is_instance = 1;  /* Mark as instance */
 
-    if (base_mat->param_count > 0 && base_mat->params) {
-        size_t params_size = base_mat->param_capacity * sizeof(material_param_t);
-        instance.params = (material_param_t*) MARU_MALLOC(params_size);
+    if (src && src->param_count > 0) {
+        instance.params = (material_param_t*) mat_alloc(&instance, src->param_count * sizeof(material_param_t));
         if (!instance.params) {
             MR_LOG(ERROR, "material_create_instance: failed to allocate params");
             return MAT_HANDLE_INVALID;
         }
-        memcpy(instance.params, base_mat->params, params_size);
+        memcpy(instance.params, src->params, src->param_count * sizeof(material_param_t));
+        instance.param_count = src->param_count;
+        instance.param_capacity = src->param_count;
 
-        /* Mark all constant buffer slots as dirty for first update */
-        for (uint32_t i = 0; i < base_mat->param_count; ++i) {
-            material_param_t *p = &instance.params[i];
-            if (p->type != MATERIAL_PARAM_TEXTURE) {
-                instance.cb_dirty[p->slot] = 1;
+        for (uint32_t i = 0; i < instance.param_count; ++i) {
+            if (instance.params[i].type != MATERIAL_PARAM_TEXTURE) {
+                instance.cb_dirty[instance.params[i].slot] = 1;
             }
         }
-    } else {
-        instance.params = NULL;
     }
 
     /* Allocate new handle */
-    handle_t h = handle_pool_alloc(s_pool, &instance);
+    handle_t h = material_pool_alloc(&instance);
     if (h == HANDLE_INVALID) {
-        if (instance.params) {
-            MARU_FREE(instance.params);
-        }
-        MR_LOG(ERROR, "material_create_instance: pool full");
+        mat_free(&instance, instance.params);
+        MR_LOG(ERROR, "material_create_instance: handle alloc failed");
         return MAT_HANDLE_INVALID;
     }
 
+    /* The alloc may have grown the pool */
+    base_mat = material_pool_get((handle_t) base);
+    if (base_mat) base_mat->instance_count++;
+
     return (material_handle_t) h;
 }
 
 void material_destroy(material_handle_t mh) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID) return;
+    if (mh == MAT_HANDLE_INVALID) return;
 
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
+    material_t *m = material_pool_get((handle_t) mh);
     if (!m) return;
 
-    const rhi_dispatch_t *rhi = g_ctx.active_rhi;
-
-    /* Free per-instance data */
-    if (m->params) {
-        MARU_FREE(m->params);
-        m->params = NULL;
+    if (m->is_instance) {
+        material_t *base = material_pool_get((handle_t) m->base);
+        if (base && base->instance_count > 0) base->instance_count--;
+    } else if (m->instance_count > 0) {
+        /* Their binds become no-ops; nothing dangles since they only hold the handle */
+        MR_LOG(WARN, "material: destroying base with %u live instances", m->instance_count);
     }
 
-    for (uint32_t i = 0; i < 4; ++i) {
-        if (m->cb_buffers[i]) {
-            rhi->destroy_buffer(g_ctx.active_device, m->cb_buffers[i]);
-            m->cb_buffers[i] = NULL;
-        }
-        if (m->cb_data[i]) {
-            MARU_FREE(m->cb_data[i]);
-            m->cb_data[i] = NULL;
-        }
+    material_release_cb((handle_t) mh, m, NULL);
+    material_pool_free((handle_t) mh);
+}
+
+void material_set_region(mem_region_t *r) {
+    s_region = r;
+}
+
+typedef struct {
+    const mem_region_t *region;
+    int instances;
+} release_pass_t;
+
+static void release_region_cb(handle_t h, void *obj, void *user) {
+    const material_t *m = (const material_t*) obj;
+    const release_pass_t *pass = (const release_pass_t*) user;
+
+    if (m->region == pass->region && m->is_instance == (pass->instances != 0)) {
+        material_destroy((material_handle_t) h);
     }
+}
 
-    /* Only destroy shared resources if this is NOT an instance */
-    if (!m->is_instance) {
-        if (m->pl) {
-            rhi->destroy_pipeline(g_ctx.active_device, m->pl);
-            m->pl = NULL;
-        }
-        if (m->sh) {
-            rhi->destroy_shader(g_ctx.active_device, m->sh);
-            m->sh = NULL;
-        }
+void material_release_region(mem_region_t *r) {
+    if (!material_pool_ready() || !r) return;
+    if (s_region == r) s_region = NULL;
+
+    /* Instances first so their bases see none left; foreach walks backwards, so freeing the visited one is safe */
+    release_pass_t pass = {r, 1};
+    material_pool_foreach(release_region_cb, &pass);
+    pass.instances = 0;
+    material_pool_foreach(release_region_cb, &pass);
+}
+
+static material_param_t *param_find(const material_t *m, material_param_id id) {
+    if (m->param_index) {
+        uint32_t i = map_u32_u32_get(m->param_index, id, UINT32_MAX);
+        return i != UINT32_MAX ? &m->params[i] : NULL;
     }
 
-    handle_pool_free(s_pool, (handle_t) mh);
+    for (uint32_t i = 0; i < m->param_count; ++i) {
+        if (m->params[i].id == id) return &m->params[i];
+    }
+    return NULL;
 }
 
 static material_param_t *material_find_or_create_param(material_t *m, material_param_id id, material_param_type_e type) {
-    for (uint32_t i = 0; i < m->param_count; ++i) {
-        if (m->params[i].id == id) {
-            if (m->params[i].type != type) {
-                MR_LOG(ERROR, "material: param type mismatch");
-                return NULL;
-            }
-            return &m->params[i];
+    if (m->param_count >= PARAM_INDEX_MIN && !m->param_index) {
+        param_index_build(m); /* on failure keep scanning linearly */
+    }
+
+    material_param_t *found = param_find(m, id);
+    if (found) {
+        if (found->type != type) {
+            MR_LOG(ERROR, "material: param type mismatch");
+            return NULL;
         }
+        return found;
     }
 
     if (m->param_count >= m->param_capacity) {
         uint32_t new_cap = m->param_capacity ? m->param_capacity * 2 : 8;
-        material_param_t *new_params = (material_param_t*) MARU_REALLOC(m->params, new_cap * sizeof(material_param_t));
+        material_param_t *new_params = (material_param_t*) mat_realloc(m, m->params, m->param_capacity * sizeof(material_param_t),
+                                                                       new_cap * sizeof(material_param_t));
         if (!new_params) {
             MR_LOG(ERROR, "material: param alloc failed");
             return NULL;
@@ -359,6 +440,10 @@ static material_param_t *material_find_or_create_param(material_t *m, material_p
         m->param_capacity = new_cap;
     }
 
+    if (m->param_index && map_u32_u32_put(m->param_index, id, m->param_count) != 0) {
+        param_index_free(m); /* rebuilt on the next lookup */
+    }
+
     material_param_t *p = &m->params[m->param_count++];
     memset(p, 0, sizeof(*p));
     p->id = id;
@@ -369,188 +454,294 @@ static material_param_t *material_find_or_create_param(material_t *m, material_p
     return p;
 }
 
-void material_set_float(material_handle_t mh, const char *name, float value) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID || !name) return;
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
+static void set_param(material_handle_t mh, material_param_id id, material_param_type_e type,
+                      const void *value, size_t size) {
+    if (mh == MAT_HANDLE_INVALID) return;
+    material_t *m = material_pool_get((handle_t) mh);
     if (!m) return;
 
-    material_param_id id = material_param(name);
-    material_param_t *p = material_find_or_create_param(m, id, MATERIAL_PARAM_FLOAT);
-    if (p) {
-        p->data.f = value;
-        p->dirty = 1;
-        m->cb_dirty[p->slot] = 1;
+    const material_param_t *bp = NULL;
+    if (m->is_instance && !param_find(m, id)) {
+        material_t *base = material_pool_get((handle_t) m->base);
+        bp = base ? param_find(base, id) : NULL;
+        if (bp && bp->type != type) {
+            MR_LOG(ERROR, "material: param type mismatch");
+            return;
+        }
+        /* Same as the base: nothing to override */
+        if (bp && memcmp(&bp->data, value, size) == 0) return;
     }
-}
 
-void material_set_vec2(material_handle_t mh, const char *name, const float *v) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID || !name || !v) return;
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
-    if (!m) return;
+    material_param_t *p = material_find_or_create_param(m, id, type);
+    if (!p) return;
 
-    material_param_id id = material_param(name);
-    material_param_t *p = material_find_or_create_param(m, id, MATERIAL_PARAM_VEC2);
-    if (p) {
-        memcpy(p->data.vec2, v, sizeof(float) * 2);
-        p->dirty = 1;
+    if (bp) {
+        p->slot = bp->slot;
+        p->stage = bp->stage;
+    }
+    memcpy(&p->data, value, size);
+    p->dirty = 1;
+    if (type != MATERIAL_PARAM_TEXTURE) {
         m->cb_dirty[p->slot] = 1;
+        if (!m->is_instance) m->cb_version[p->slot]++;
     }
 }
 
-void material_set_vec3(material_handle_t mh, const char *name, const float *v) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID || !name || !v) return;
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
-    if (!m) return;
+void material_set_float_id(material_handle_t mh, material_param_id id, float value) {
+    set_param(mh, id, MATERIAL_PARAM_FLOAT, &value, sizeof(float));
+}
 
-    material_param_id id = material_param(name);
-    material_param_t *p = material_find_or_create_param(m, id, MATERIAL_PARAM_VEC3);
-    if (p) {
-        memcpy(p->data.vec3, v, sizeof(float) * 3);
-        p->dirty = 1;
-        m->cb_dirty[p->slot] = 1;
-    }
+void material_set_vec2_id(material_handle_t mh, material_param_id id, const float *v) {
+    if (!v) return;
+    set_param(mh, id, MATERIAL_PARAM_VEC2, v, sizeof(float) * 2);
+}
+
+void material_set_vec3_id(material_handle_t mh, material_param_id id, const float *v) {
+    if (!v) return;
+    set_param(mh, id, MATERIAL_PARAM_VEC3, v, sizeof(float) * 3);
+}
+
+void material_set_vec4_id(material_handle_t mh, material_param_id id, const float *v) {
+    if (!v) return;
+    set_param(mh, id, MATERIAL_PARAM_VEC4, v, sizeof(float) * 4);
+}
+
+void material_set_mat4_id(material_handle_t mh, material_param_id id, const float *m16) {
+    if (!m16) return;
+    set_param(mh, id, MATERIAL_PARAM_MAT4, m16, sizeof(float) * 16);
+}
+
+void material_set_texture_id(material_handle_t mh, material_param_id id, texture_handle_t tex) {
+    set_param(mh, id, MATERIAL_PARAM_TEXTURE, &tex, sizeof(tex));
+}
+
+void material_set_float(material_handle_t mh, const char *name, float value) {
+    if (!name) return;
+    material_set_float_id(mh, material_param(name), value);
+}
+
+void material_set_vec2(material_handle_t mh, const char *name, const float *v) {
+    if (!name) return;
+    material_set_vec2_id(mh, material_param(name), v);
+}
+
+void material_set_vec3(material_handle_t mh, const char *name, const float *v) {
+    if (!name) return;
+    material_set_vec3_id(mh, material_param(name), v);
 }
 
 void material_set_vec4(material_handle_t mh, const char *name, const float *v) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID || !name || !v) return;
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
-    if (!m) return;
+    if (!name) return;
+    material_set_vec4_id(mh, material_param(name), v);
+}
 
-    material_param_id id = material_param(name);
-    material_param_t *p = material_find_or_create_param(m, id, MATERIAL_PARAM_VEC4);
-    if (p) {
-        memcpy(p->data.vec4, v, sizeof(float) * 4);
-        p->dirty = 1;
-        m->cb_dirty[p->slot] = 1;
+void material_set_mat4(material_handle_t mh, const char *name, const float *m16) {
+    if (!name) return;
+    material_set_mat4_id(mh, material_param(name), m16);
+}
+
+void material_set_texture(material_handle_t mh, const char *name, texture_handle_t tex) {
+    if (!name) return;
+    material_set_texture_id(mh, material_param(name), tex);
+}
+
+/* Appends p at 16-byte alignment. Returns 0, or -1 if it doesn't fit */
+static int cb_pack_param(uint8_t *dst, size_t *offset, const material_param_t *p) {
+    size_t size = 0;
+    const void *src = NULL;
+
+    switch (p->type) {
+    case MATERIAL_PARAM_FLOAT: size = 4;
+        src = &p->data.f;
+        break;
+    case MATERIAL_PARAM_VEC2: size = 8;
+        src = p->data.vec2;
+        break;
+    case MATERIAL_PARAM_VEC3: size = 12;
+        src = p->data.vec3;
+        break;
+    case MATERIAL_PARAM_VEC4: size = 16;
+        src = p->data.vec4;
+        break;
+    case MATERIAL_PARAM_MAT4: size = 64;
+        src = p->data.mat4;
+        break;
+    default: return 0;
     }
+
+    size_t at = (*offset + 15) & ~(size_t) 15;
+    if (at + size > MAX_CB_SIZE) {
+        MR_LOG(ERROR, "material: cb overflow");
+        return -1;
+    }
+
+    memcpy(dst + at, src, size);
+    *offset = at + size;
+    return 0;
 }
 
-void material_set_mat4(material_handle_t mh, const char *name, const float *m16) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID || !name || !m16) return;
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
-    if (!m) return;
+/*
+ * Packs one slot into dst and returns its size. An instance (base != NULL)
+ * keeps the base's layout with its overrides patched in; params only the
+ * instance has go last.
+ */
+static size_t cb_pack_to(uint8_t *dst, const material_t *m, const material_t *base, uint32_t slot) {
+    const material_t *layout = base ? base : m;
+    size_t offset = 0;
+
+    for (uint32_t i = 0; i < layout->param_count; ++i) {
+        const material_param_t *p = &layout->params[i];
+        if (p->slot != slot || p->type == MATERIAL_PARAM_TEXTURE) continue;
+
+        if (base) {
+            const material_param_t *q = param_find(m, p->id);
+            if (q) p = q;
+        }
+        if (cb_pack_param(dst, &offset, p) != 0) return offset;
+    }
 
-    material_param_id id = material_param(name);
-    material_param_t *p = material_find_or_create_param(m, id, MATERIAL_PARAM_MAT4);
-    if (p) {
-        memcpy(p->data.mat4, m16, sizeof(float) * 16);
-        p->dirty = 1;
-        m->cb_dirty[p->slot] = 1;
+    for (uint32_t i = 0; base && i < m->param_count; ++i) {
+        const material_param_t *p = &m->params[i];
+        if (p->slot != slot || p->type == MATERIAL_PARAM_TEXTURE || param_find(base, p->id)) continue;
+        if (cb_pack_param(dst, &offset, p) != 0) break;
     }
+    return offset;
 }
 
-void material_set_texture(material_handle_t mh, const char *name, texture_handle_t tex) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID || !name) return;
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
-    if (!m) return;
+static size_t cb_pack(const material_t *m, const material_t *base, uint32_t slot) {
+    return cb_pack_to(m->cb_data[slot], m, base, slot);
+}
 
-    material_param_id id = material_param(name);
-    material_param_t *p = material_find_or_create_param(m, id, MATERIAL_PARAM_TEXTURE);
-    if (p) {
-        p->data.tex = tex;
-        p->dirty = 1;
+/* The slot's RHI buffer, made on first use */
+static struct rhi_buffer *cb_buffer(material_t *m, uint32_t slot) {
+    if (!m->cb_buffers[slot]) {
+        const rhi_dispatch_t *rhi = g_ctx.active_rhi;
+
+        rhi_buffer_desc_t bd = {0};
+        bd.size = MAX_CB_SIZE;
+        bd.usage = RHI_BUF_CONST;
+        m->cb_buffers[slot] = rhi->create_buffer(g_ctx.active_device, &bd, NULL);
+        if (!m->cb_buffers[slot]) {
+            MR_LOG(ERROR, "material: cb create failed");
+            return NULL;
+        }
+        m->cb_sizes[slot] = MAX_CB_SIZE;
     }
+    return m->cb_buffers[slot];
 }
 
-static void material_update_cbuffers(material_t *m) {
+/* Returns 0 once the slot is uploaded; the CPU copy and RHI buffer are made on first use */
+static int cb_update_slot(material_t *m, const material_t *base, uint32_t slot) {
     const rhi_dispatch_t *rhi = g_ctx.active_rhi;
 
+    if (!m->cb_data[slot]) {
+        m->cb_data[slot] = (uint8_t*) mat_alloc(m, MAX_CB_SIZE);
+        if (!m->cb_data[slot]) {
+            MR_LOG(ERROR, "material: cb_data alloc failed");
+            return -1;
+        }
+        memset(m->cb_data[slot], 0, MAX_CB_SIZE);
+    }
+
+    size_t size = cb_pack(m, base, slot);
+    if (size == 0) return -1;
+    if (!cb_buffer(m, slot)) return -1;
+
+    rhi->update_buffer(g_ctx.active_device, m->cb_buffers[slot], m->cb_data[slot], size);
+    m->cb_dirty[slot] = 0;
+    return 0;
+}
+
+static void material_update_cbuffers(material_t *m) {
     for (uint32_t slot = 0; slot < 4; ++slot) {
-        if (!m->cb_dirty[slot]) continue;
+        if (m->cb_dirty[slot]) cb_update_slot(m, NULL, slot);
+    }
+}
 
-        size_t offset = 0;
-        const size_t max_cb_size = 256 * 16; /* 256 vec4s */
+/* Only slots the instance overrides get their own buffer, repacked when either side changes */
+static void instance_update_cbuffers(material_t *m, const material_t *base) {
+    uint8_t owned[4] = {0};
+    for (uint32_t i = 0; i < m->param_count; ++i) {
+        if (m->params[i].type != MATERIAL_PARAM_TEXTURE) owned[m->params[i].slot] = 1;
+    }
 
-        if (!m->cb_data[slot]) {
-            m->cb_data[slot] = (uint8_t*) MARU_MALLOC(max_cb_size);
-            if (!m->cb_data[slot]) {
-                MR_LOG(ERROR, "material: cb_data alloc failed");
-                continue;
-            }
-            memset(m->cb_data[slot], 0, max_cb_size);
-        }
+    for (uint32_t slot = 0; slot < 4; ++slot) {
+        if (!owned[slot]) continue;
+        if (!m->cb_dirty[slot] && m->cb_version[slot] == base->cb_version[slot]) continue;
 
-        for (uint32_t i = 0; i < m->param_count; ++i) {
-            material_param_t *p = &m->params[i];
-            if (p->slot != slot || p->type == MATERIAL_PARAM_TEXTURE) continue;
-
-            size_t size = 0;
-            void *src = NULL;
-
-            switch (p->type) {
-            case MATERIAL_PARAM_FLOAT: size = 4;
-                src = &p->data.f;
-                break;
-            case MATERIAL_PARAM_VEC2: size = 8;
-                src = p->data.vec2;
-                break;
-            case MATERIAL_PARAM_VEC3: size = 12;
-                src = p->data.vec3;
-                break;
-            case MATERIAL_PARAM_VEC4: size = 16;
-                src = p->data.vec4;
-                break;
-            case MATERIAL_PARAM_MAT4: size = 64;
-                src = p->data.mat4;
-                break;
-            default: continue;
-            }
+        if (cb_update_slot(m, base, slot) == 0) {
+            m->cb_version[slot] = base->cb_version[slot];
+        }
+    }
+}
 
-            /* 16-byte alignment */
-            offset = (offset + 15) & ~15;
-            if (offset + size > max_cb_size) {
-                MR_LOG(ERROR, "material: cb overflow");
-                break;
-            }
+void material_prefetch(const material_handle_t *handles, size_t n) {
+    material_t *tmp[64];
+    while (n > 0) {
+        size_t k = n < ARRAY_SIZE(tmp) ? n : ARRAY_SIZE(tmp);
+        material_pool_get_many((const handle_t*) handles, k, tmp);
 
-            memcpy(m->cb_data[slot] + offset, src, size);
-            offset += size;
+        /* material_bind walks the param array next */
+        for (size_t i = 0; i < k; ++i) {
+            if (tmp[i] && tmp[i]->params) MARU_PREFETCH(tmp[i]->params);
         }
 
-        if (offset > 0) {
-            if (!m->cb_buffers[slot]) {
-                rhi_buffer_desc_t bd = {0};
-                bd.size = max_cb_size;
-                bd.usage = RHI_BUF_CONST;
-                m->cb_buffers[slot] = rhi->create_buffer(g_ctx.active_device, &bd, NULL);
-                if (!m->cb_buffers[slot]) {
-                    MR_LOG(ERROR, "material: cb create failed");
-                    continue;
-                }
-                m->cb_sizes[slot] = max_cb_size;
-            }
+        handles += k;
+        n -= k;
+    }
+}
+
+static void bind_param(rhi_cmd_t *cmd, const material_param_t *p, struct rhi_buffer *const *cbs) {
+    const rhi_dispatch_t *rhi = g_ctx.active_rhi;
 
-            rhi->update_buffer(g_ctx.active_device, m->cb_buffers[slot], m->cb_data[slot], offset);
-            m->cb_dirty[slot] = 0;
+    if (p->type == MATERIAL_PARAM_TEXTURE) {
+        if (p->data.tex != TEX_HANDLE_INVALID) {
+            rhi_texture_t *rt = tex_acquire_rhi(p->data.tex);
+            if (rt) {
+                rhi->cmd_bind_texture(cmd, rt, p->slot, p->stage);
+            }
+        }
+    } else {
+        if (cbs[p->slot]) {
+            rhi->cmd_bind_const_buffer(cmd, p->slot, cbs[p->slot], p->stage);
         }
     }
 }
 
 void material_bind(rhi_cmd_t *cmd, material_handle_t mh) {
-    if (!s_pool || mh == MAT_HANDLE_INVALID || !cmd) return;
-    material_t *m = (material_t*) handle_pool_get(s_pool, (handle_t) mh);
+    if (mh == MAT_HANDLE_INVALID || !cmd) return;
+    material_t *m = material_pool_get((handle_t) mh);
     if (!m) return;
 
     const rhi_dispatch_t *rhi = g_ctx.active_rhi;
 
-    rhi->cmd_bind_pipeline(cmd, m->pl);
+    if (!m->is_instance) {
+        rhi->cmd_bind_pipeline(cmd, m->pl);
+        material_update_cbuffers(m);
 
-    material_update_cbuffers(m);
+        for (uint32_t i = 0; i < m->param_count; ++i) {
+            bind_param(cmd, &m->params[i], m->cb_buffers);
+        }
+    } else {
+        material_t *base = material_pool_get((handle_t) m->base);
+        if (!base) return;
 
-    for (uint32_t i = 0; i < m->param_count; ++i) {
-        material_param_t *p = &m->params[i];
-
-        if (p->type == MATERIAL_PARAM_TEXTURE) {
-            if (p->data.tex != TEX_HANDLE_INVALID) {
-                rhi_texture_t *rt = tex_acquire_rhi(p->data.tex);
-                if (rt) {
-                    rhi->cmd_bind_texture(cmd, rt, p->slot, p->stage);
-                }
-            }
-        } else {
-            if (m->cb_buffers[p->slot]) {
-                rhi->cmd_bind_const_buffer(cmd, p->slot, m->cb_buffers[p->slot], p->stage);
-            }
+        rhi->cmd_bind_pipeline(cmd, base->pl);
+        material_update_cbuffers(base);
+        instance_update_cbuffers(m, base);
+
+        struct rhi_buffer *cbs[4];
+        for (uint32_t slot = 0; slot < 4; ++slot) {
+            cbs[slot] = m->cb_buffers[slot] ? m->cb_buffers[slot] : base->cb_buffers[slot];
+        }
+
+        for (uint32_t i = 0; i < base->param_count; ++i) {
+            const material_param_t *p = &base->params[i];
+            const material_param_t *q = m->param_count ? param_find(m, p->id) : NULL;
+            bind_param(cmd, q ? q : p, cbs);
+        }
+        for (uint32_t i = 0; i < m->param_count; ++i) {
+            if (!param_find(base, m->params[i].id)) bind_param(cmd, &m->params[i], cbs);
         }
     }
 
@@ -558,3 +749,144 @@ void material_bind(rhi_cmd_t *cmd, material_handle_t mh) {
         rhi->cmd_bind_sampler(cmd, s_default_sampler, SLOT_SAMP_S0, RHI_STAGE_PS);
     }
 }
+
+/* ===== Capture for the render thread ===== */
+
+#define CAPTURE_ALIGN(x) (((x) + 15) & ~(size_t) 15)
+
+typedef struct capture_binding {
+    struct rhi_texture *tex;    /* NULL: the slot's constant buffer */
+    uint8_t slot;
+    uint8_t stage;
+} capture_binding_t;
+
+/* Followed by bindings[] and each slot's packed bytes */
+typedef struct capture_hdr {
+    uint32_t size;
+    uint32_t binding_count;
+    struct rhi_pipeline *pl;
+    struct rhi_sampler *sampler;
+    struct rhi_buffer *cb[4];
+    uint32_t cb_at[4];
+    uint16_t cb_size[4];        /* 0 = nothing to upload */
+} capture_hdr_t;
+
+/* Same effect as bind_param: textures resolved now, one entry per constant buffer slot and stage */
+static void capture_binding(capture_binding_t *b, uint32_t *count, const material_param_t *p) {
+    struct rhi_texture *tex = NULL;
+    if (p->type == MATERIAL_PARAM_TEXTURE) {
+        if (p->data.tex == TEX_HANDLE_INVALID) return;
+        tex = tex_acquire_rhi(p->data.tex);
+        if (!tex) return;
+    } else {
+        for (uint32_t i = 0; i < *count; ++i) {
+            if (!b[i].tex && b[i].slot == p->slot && b[i].stage == p->stage) return;
+        }
+    }
+
+    b[*count].tex = tex;
+    b[*count].slot = p->slot;
+    b[*count].stage = p->stage;
+    (*count)++;
+}
+
+size_t material_capture_bound(material_handle_t mh) {
+    const material_t *m = material_pool_get((handle_t) mh);
+    if (!m) return 0;
+
+    const material_t *base = m->is_instance ? material_pool_get((handle_t) m->base) : NULL;
+    size_t n = m->param_count + (base ? base->param_count : 0);
+
+    /* a packed param takes at most a mat4 plus alignment */
+    return CAPTURE_ALIGN(sizeof(capture_hdr_t)) + CAPTURE_ALIGN(n * sizeof(capture_binding_t)) + 4 * 16 + n * (64 + 16);
+}
+
+size_t material_capture(material_handle_t mh, void *dst, size_t cap) {
+    material_t *m = material_pool_get((handle_t) mh);
+    if (!m || !dst) return 0;
+
+    material_t *base = m->is_instance ? material_pool_get((handle_t) m->base) : NULL;
+    if (m->is_instance && !base) return 0;
+    if (cap < material_capture_bound(mh)) return 0;
+
+    const material_t *layout = base ? base : m;
+    uint32_t n = layout->param_count + (base ? m->param_count : 0);
+
+    uint8_t *bytes = (uint8_t*) dst;
+    capture_hdr_t *hdr = (capture_hdr_t*) dst;
+    capture_binding_t *bindings = (capture_binding_t*) (bytes + CAPTURE_ALIGN(sizeof(capture_hdr_t)));
+    size_t at = CAPTURE_ALIGN((size_t) ((uint8_t*) (bindings + n) - bytes));
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->pl = layout->pl;
+    hdr->sampler = ensure_default_sampler() ? s_default_sampler : NULL;
+
+    /* bindings in material_bind order */
+    uint32_t nb = 0;
+    for (uint32_t i = 0; i < layout->param_count; ++i) {
+        const material_param_t *p = &layout->params[i];
+        const material_param_t *q = (base && m->param_count) ? param_find(m, p->id) : NULL;
+        capture_binding(bindings, &nb, q ? q : p);
+    }
+    for (uint32_t i = 0; base && i < m->param_count; ++i) {
+        if (!param_find(base, m->params[i].id)) capture_binding(bindings, &nb, &m->params[i]);
+    }
+
+    /* constants: slots an instance overrides use its own buffer, the rest the base's */
+    uint8_t used[4] = {0}, owned[4] = {0};
+    for (uint32_t i = 0; i < layout->param_count; ++i) {
+        if (layout->params[i].type != MATERIAL_PARAM_TEXTURE) used[layout->params[i].slot] = 1;
+    }
+    for (uint32_t i = 0; base && i < m->param_count; ++i) {
+        if (m->params[i].type != MATERIAL_PARAM_TEXTURE) used[m->params[i].slot] = owned[m->params[i].slot] = 1;
+    }
+
+    for (uint32_t slot = 0; slot < 4; ++slot) {
+        if (!used[slot]) continue;
+
+        int own = !base || owned[slot];
+        struct rhi_buffer *buf = cb_buffer(own ? m : base, slot);
+        if (!buf) continue;
+
+        size_t size = own ? cb_pack_to(bytes + at, m, base, slot) : cb_pack_to(bytes + at, base, NULL, slot);
+        if (size == 0) continue;
+
+        hdr->cb[slot] = buf;
+        hdr->cb_at[slot] = (uint32_t) at;
+        hdr->cb_size[slot] = (uint16_t) size;
+        at = CAPTURE_ALIGN(at + size);
+    }
+
+    hdr->binding_count = nb;
+    hdr->size = (uint32_t) at;
+    return at;
+}
+
+void material_bind_captured(rhi_cmd_t *cmd, const void *rec) {
+    if (!cmd || !rec) return;
+
+    const rhi_dispatch_t *rhi = g_ctx.active_rhi;
+    const uint8_t *bytes = (const uint8_t*) rec;
+    const capture_hdr_t *hdr = (const capture_hdr_t*) rec;
+    const capture_binding_t *bindings = (const capture_binding_t*) (bytes + CAPTURE_ALIGN(sizeof(capture_hdr_t)));
+
+    rhi->cmd_bind_pipeline(cmd, hdr->pl);
+
+    for (uint32_t slot = 0; slot < 4; ++slot) {
+        if (!hdr->cb_size[slot]) continue;
+        rhi->update_buffer(g_ctx.active_device, hdr->cb[slot], bytes + hdr->cb_at[slot], hdr->cb_size[slot]);
+    }
+
+    for (uint32_t i = 0; i < hdr->binding_count; ++i) {
+        const capture_binding_t *b = &bindings[i];
+        if (b->tex) {
+            rhi->cmd_bind_texture(cmd, b->tex, b->slot, b->stage);
+        } else if (hdr->cb[b->slot]) {
+            rhi->cmd_bind_const_buffer(cmd, b->slot, hdr->cb[b->slot], b->stage);
+        }
+    }
+
+    if (hdr->sampler) {
+        rhi->cmd_bind_sampler(cmd, hdr->sampler, SLOT_SAMP_S0, RHI_STAGE_PS);
+    }
+}
@@ -2,6 +2,7 @@
 #define ENGINE_MATERIAL_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +25,7 @@ typedef enum {
     MATERIAL_PARAM_TEXTURE
 } material_param_type_e;
 
+/* strid_hash(name); MARU_SID("name") gives the same ID at compile time */
 material_param_id material_param(const char *name);
 
 int material_system_init(size_t capacity);
@@ -39,6 +41,16 @@ material_handle_t material_create(const material_desc_t *desc);
 material_handle_t material_create_instance(material_handle_t base);
 void material_destroy(material_handle_t h);
 
+/*
+ * Materials created while a region is set keep their params and cbuffer
+ * copies in it and never free them one by one; NULL goes back to the heap.
+ * material_release_region destroys every material of the region (GPU
+ * buffers included) so the caller can region_reset it.
+ */
+struct mem_region;
+void material_set_region(struct mem_region *r);
+void material_release_region(struct mem_region *r);
+
 void material_set_float(material_handle_t h, const char *name, float value);
 void material_set_vec2(material_handle_t h, const char *name, const float *v);
 void material_set_vec3(material_handle_t h, const char *name, const float *v);
@@ -46,10 +58,33 @@ void material_set_vec4(material_handle_t h, const char *name, const float *v);
 void material_set_mat4(material_handle_t h, const char *name, const float *m);
 void material_set_texture(material_handle_t h, const char *name, texture_handle_t tex);
 
+/* Same as above keyed by a precomputed ID, for hot paths */
+void material_set_float_id(material_handle_t h, material_param_id id, float value);
+void material_set_vec2_id(material_handle_t h, material_param_id id, const float *v);
+void material_set_vec3_id(material_handle_t h, material_param_id id, const float *v);
+void material_set_vec4_id(material_handle_t h, material_param_id id, const float *v);
+void material_set_mat4_id(material_handle_t h, material_param_id id, const float *m);
+void material_set_texture_id(material_handle_t h, material_param_id id, texture_handle_t tex);
+
 /* Internal - used by renderer */
 struct rhi_cmd;
 void material_bind(struct rhi_cmd *cmd, material_handle_t h);
 
+/* Warm the cache for materials about to be bound; invalid handles are skipped */
+void material_prefetch(const material_handle_t *handles, size_t n);
+
+/*
+ * Render-thread support. material_capture writes what material_bind would
+ * upload and bind (pipeline, packed constants, resolved textures) into one
+ * self-contained record of at most material_capture_bound(h) bytes, and
+ * returns its size (0 on failure). material_bind_captured replays it
+ * without reading the material, which may meanwhile change. Records are
+ * 16-byte aligned in size; place them at 16-byte offsets.
+ */
+size_t material_capture_bound(material_handle_t h);
+size_t material_capture(material_handle_t h, void *dst, size_t cap);
+void material_bind_captured(struct rhi_cmd *cmd, const void *rec);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,37 +1,36 @@
 #include "render_object.h"
-#include "handle/handle_pool.h"
+#include "handle/typed_pool.h"
 #include "material/material.h"
 #include "log.h"
 #include <string.h>
 
-static handle_pool_t *g_render_object_pool = NULL;
+MARU_DEFINE_POOL_TAGGED(render_object, render_object_t, MEM_TAG_RENDERER);
 
 int render_object_system_init(size_t capacity) {
-    if (g_render_object_pool) {
+    if (render_object_pool_ready()) {
         WARN("render_object_system already initialized");
         return 0;
     }
 
-    g_render_object_pool = handle_pool_create(capacity, sizeof(render_object_t), (size_t) _Alignof(render_object_t));
-    if (!g_render_object_pool) {
+    /* capacity is the page size; the pool grows a page at a time instead of failing */
+    if (render_object_pool_init(capacity) != 0) {
         ERROR("failed to create render_object handle pool");
         return -1;
     }
 
-    INFO("render_object_system initialized (capacity: %zu)", capacity);
+    INFO("render_object_system initialized (page capacity: %zu)", capacity);
     return 0;
 }
 
 void render_object_system_shutdown(void) {
-    if (g_render_object_pool) {
-        handle_pool_destroy(g_render_object_pool);
-        g_render_object_pool = NULL;
+    if (render_object_pool_ready()) {
+        render_object_pool_shutdown();
         INFO("render_object_system shutdown");
     }
 }
 
 render_object_handle_t render_object_create(void) {
-    if (!g_render_object_pool) {
+    if (!render_object_pool_ready()) {
         ERROR("render_object_system not initialized");
         return RENDER_OBJECT_HANDLE_INVALID;
     }
@@ -41,7 +40,7 @@ render_object_handle_t render_object_create(void) {
     init.layer = 0;
     init.cast_shadow = 0;
 
-    render_object_handle_t handle = handle_pool_alloc(g_render_object_pool, &init);
+    render_object_handle_t handle = render_object_pool_alloc(&init);
     if (handle == HANDLE_INVALID) {
         ERROR("failed to allocate render_object");
         return RENDER_OBJECT_HANDLE_INVALID;
@@ -51,22 +50,21 @@ render_object_handle_t render_object_create(void) {
 }
 
 void render_object_destroy(render_object_handle_t handle) {
-    if (!g_render_object_pool) return;
     if (handle == RENDER_OBJECT_HANDLE_INVALID) return;
 
     /* Cleanup material instance */
-    render_object_t *obj = handle_pool_get(g_render_object_pool, handle);
+    render_object_t *obj = render_object_pool_get(handle);
     if (obj && obj->material != MAT_HANDLE_INVALID) {
         material_destroy(obj->material);
         obj->material = MAT_HANDLE_INVALID;
     }
 
-    handle_pool_free(g_render_object_pool, handle);
+    render_object_pool_free(handle);
 }
 
 void render_object_set_mesh(render_object_handle_t handle, mesh_handle_t mesh) {
     if (handle == RENDER_OBJECT_HANDLE_INVALID) return;
-    render_object_t *obj = handle_pool_get(g_render_object_pool, handle);
+    render_object_t *obj = render_object_pool_get(handle);
     if (obj) {
         obj->mesh = mesh;
     }
@@ -74,7 +72,7 @@ void render_object_set_mesh(render_object_handle_t handle, mesh_handle_t mesh) {
 
 void render_object_set_material(render_object_handle_t handle, material_handle_t base_material) {
     if (handle == RENDER_OBJECT_HANDLE_INVALID || base_material == MAT_HANDLE_INVALID) return;
-    render_object_t *obj = handle_pool_get(g_render_object_pool, handle);
+    render_object_t *obj = render_object_pool_get(handle);
     if (!obj) return;
 
     /* Destroy existing instance if any */
@@ -91,7 +89,7 @@ void render_object_set_material(render_object_handle_t handle, material_handle_t
 
 void render_object_set_transform(render_object_handle_t handle, transform_t *transform) {
     if (handle == RENDER_OBJECT_HANDLE_INVALID) return;
-    render_object_t *obj = handle_pool_get(g_render_object_pool, handle);
+    render_object_t *obj = render_object_pool_get(handle);
     if (obj) {
         obj->transform = transform;
     }
@@ -99,7 +97,7 @@ void render_object_set_transform(render_object_handle_t handle, transform_t *tra
 
 void render_object_set_visible(render_object_handle_t handle, uint8_t visible) {
     if (handle == RENDER_OBJECT_HANDLE_INVALID) return;
-    render_object_t *obj = handle_pool_get(g_render_object_pool, handle);
+    render_object_t *obj = render_object_pool_get(handle);
     if (obj) {
         obj->visible = visible ? 1 : 0;
     }
@@ -107,18 +105,37 @@ void render_object_set_visible(render_object_handle_t handle, uint8_t visible) {
 
 void render_object_set_layer(render_object_handle_t handle, uint32_t layer) {
     if (handle == RENDER_OBJECT_HANDLE_INVALID) return;
-    render_object_t *obj = handle_pool_get(g_render_object_pool, handle);
+    render_object_t *obj = render_object_pool_get(handle);
     if (obj) {
         obj->layer = layer;
     }
 }
 
+typedef struct {
+    render_object_foreach_fn fn;
+    void *user;
+} foreach_ctx_t;
+
+static void foreach_thunk(handle_t h, void *obj, void *user) {
+    foreach_ctx_t *ctx = (foreach_ctx_t*) user;
+    ctx->fn((render_object_handle_t) h, (render_object_t*) obj, ctx->user);
+}
+
+void render_object_foreach(render_object_foreach_fn fn, void *user) {
+    if (!fn) return;
+
+    foreach_ctx_t ctx = {fn, user};
+    render_object_pool_foreach(foreach_thunk, &ctx);
+}
+
 render_object_t *render_object_get(render_object_handle_t handle) {
-    if (!g_render_object_pool) return NULL;
-    return (render_object_t *)handle_pool_get(g_render_object_pool, handle);
+    return render_object_pool_get(handle);
 }
 
 const render_object_t *render_object_get_const(render_object_handle_t handle) {
-    if (!g_render_object_pool) return NULL;
-    return (const render_object_t *)handle_pool_get_const(g_render_object_pool, handle);
+    return render_object_pool_get(handle);
+}
+
+size_t render_object_get_many(const render_object_handle_t *handles, size_t n, render_object_t **out) {
+    return render_object_pool_get_many((const handle_t*) handles, n, out);
 }
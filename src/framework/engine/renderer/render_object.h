@@ -2,6 +2,7 @@
 #define MARU_RENDER_OBJECT_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "math/transform.h"
 
 #ifdef __cplusplus
@@ -40,10 +41,17 @@ void render_object_set_transform(render_object_handle_t handle, transform_t *tra
 void render_object_set_visible(render_object_handle_t handle, uint8_t visible);
 void render_object_set_layer(render_object_handle_t handle, uint32_t layer);
 
+/* Iteration over live render objects */
+typedef void (*render_object_foreach_fn)(render_object_handle_t handle, render_object_t *obj, void *user);
+void render_object_foreach(render_object_foreach_fn fn, void *user);
+
 /* Getters */
 render_object_t *render_object_get(render_object_handle_t handle);
 const render_object_t *render_object_get_const(render_object_handle_t handle);
 
+/* Batch lookup: out[i] is NULL for stale handles. Returns how many resolved. */
+size_t render_object_get_many(const render_object_handle_t *handles, size_t n, render_object_t **out);
+
 #ifdef __cplusplus
 }
 #endif
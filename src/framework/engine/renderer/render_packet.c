@@ -0,0 +1,111 @@
+#include "render_packet.h"
+
+#include <string.h>
+
+#include "material/material.h"
+#include "mem/mem_diag.h"
+#include "log.h"
+
+#define PACKET_MIN_ITEMS 64
+
+/* Grows *arr to hold `need` elements of `size` bytes, doubling; 0 or -1 */
+static int grow(void **arr, uint32_t *capacity, uint32_t need, size_t size) {
+    if (need <= *capacity) return 0;
+
+    uint32_t cap = *capacity ? *capacity : PACKET_MIN_ITEMS;
+    while (cap < need) cap *= 2;
+
+    void *p = MARU_REALLOC_T(MEM_TAG_RENDERER, *arr, (size_t) cap * size);
+    if (!p) {
+        ERROR("render_packet: out of memory (%u entries)", need);
+        return -1;
+    }
+    *arr = p;
+    *capacity = cap;
+    return 0;
+}
+
+void render_packet_init(render_packet_t *p) {
+    if (!p) return;
+    memset(p, 0, sizeof(*p));
+}
+
+void render_packet_free(render_packet_t *p) {
+    if (!p) return;
+    MARU_FREE(p->views);
+    MARU_FREE(p->items);
+    MARU_FREE(p->transforms);
+    MARU_FREE(p->materials);
+    memset(p, 0, sizeof(*p));
+}
+
+void render_packet_reset(render_packet_t *p, uint64_t frame) {
+    if (!p) return;
+    p->frame = frame;
+    p->view_count = 0;
+    p->item_count = 0;
+    p->transform_count = 0;
+    p->materials_size = 0;
+}
+
+uint32_t render_packet_add_view(render_packet_t *p, const float *view, const float *projection, int camera_set) {
+    if (grow((void**) &p->views, &p->view_capacity, p->view_count + 1, sizeof(render_view_t)) != 0) {
+        return RENDER_PACKET_NONE;
+    }
+
+    render_view_t *v = &p->views[p->view_count];
+    memcpy(v->view, view, sizeof(v->view));
+    memcpy(v->projection, projection, sizeof(v->projection));
+    v->camera_set = camera_set ? 1u : 0u;
+    return p->view_count++;
+}
+
+uint32_t render_packet_add_transform(render_packet_t *p, const float *m16) {
+    if (grow((void**) &p->transforms, &p->transform_capacity, p->transform_count + 1, 16 * sizeof(float)) != 0) {
+        return RENDER_PACKET_NONE;
+    }
+
+    memcpy(p->transforms + (size_t) p->transform_count * 16, m16, 16 * sizeof(float));
+    return p->transform_count++;
+}
+
+uint32_t render_packet_add_material(render_packet_t *p, material_handle_t mat) {
+    size_t bound = material_capture_bound(mat);
+    if (bound == 0) return RENDER_PACKET_NONE;
+
+    size_t need = p->materials_size + bound;
+    if (need > UINT32_MAX) return RENDER_PACKET_NONE;
+    if (need > p->materials_capacity) {
+        size_t cap = p->materials_capacity ? p->materials_capacity : 4096;
+        while (cap < need) cap *= 2;
+
+        uint8_t *m = (uint8_t*) MARU_REALLOC_T(MEM_TAG_RENDERER, p->materials, cap);
+        if (!m) {
+            ERROR("render_packet: out of memory (%zu material bytes)", need);
+            return RENDER_PACKET_NONE;
+        }
+        p->materials = m;
+        p->materials_capacity = cap;
+    }
+
+    size_t size = material_capture(mat, p->materials + p->materials_size, p->materials_capacity - p->materials_size);
+    if (size == 0) return RENDER_PACKET_NONE;
+
+    /* records are multiples of 16, so the next one stays aligned */
+    uint32_t at = (uint32_t) p->materials_size;
+    p->materials_size += size;
+    return at;
+}
+
+render_draw_item_t *render_packet_add_item(render_packet_t *p) {
+    if (grow((void**) &p->items, &p->item_capacity, p->item_count + 1, sizeof(render_draw_item_t)) != 0) {
+        return NULL;
+    }
+
+    render_draw_item_t *it = &p->items[p->item_count++];
+    memset(it, 0, sizeof(*it));
+    it->view = RENDER_PACKET_NONE;
+    it->material = RENDER_PACKET_NONE;
+    it->transform = RENDER_PACKET_NONE;
+    return it;
+}
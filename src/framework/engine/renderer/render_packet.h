@@ -0,0 +1,78 @@
+#ifndef MARU_RENDER_PACKET_H
+#define MARU_RENDER_PACKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct rhi_buffer;
+struct rhi_texture;
+
+typedef uint32_t material_handle_t;
+
+#define RENDER_PACKET_NONE 0xffffffffu
+
+/*
+ * One frame's worth of rendering, recorded on the simulation thread and
+ * replayed on the render thread. Everything the replay needs is copied or
+ * resolved to RHI objects at record time, so the packet does not change
+ * and nothing in it points back into the asset or material pools.
+ *
+ * Matrices are column-major float[16]; copy them to aligned locals before
+ * doing SIMD math on them.
+ */
+typedef struct render_view {
+    float view[16];
+    float projection[16];
+    uint32_t camera_set;
+} render_view_t;
+
+typedef struct render_draw_item {
+    uint32_t view;                  /* views[] */
+    uint32_t material;              /* offset of a material_capture record in materials, or NONE: keep what is bound */
+    uint32_t transform;             /* transforms[]: MVP goes to the per-draw constants, or NONE */
+    struct rhi_texture *texture;    /* bound to t0 (PS) before drawing, or NULL */
+    struct rhi_buffer *vb;
+    struct rhi_buffer *ib;
+    uint32_t vertex_count;
+    uint32_t index_count;
+} render_draw_item_t;
+
+typedef struct render_packet {
+    uint64_t frame;
+
+    render_view_t *views;
+    uint32_t view_count, view_capacity;
+
+    render_draw_item_t *items;
+    uint32_t item_count, item_capacity;
+
+    float *transforms;              /* 16 floats each */
+    uint32_t transform_count, transform_capacity;
+
+    uint8_t *materials;             /* captured material records */
+    size_t materials_size, materials_capacity;
+} render_packet_t;
+
+void render_packet_init(render_packet_t *p);
+void render_packet_free(render_packet_t *p);
+
+/* Empties the packet for another frame; capacity is kept */
+void render_packet_reset(render_packet_t *p, uint64_t frame);
+
+/* Each returns the new entry's index (offset for materials), or RENDER_PACKET_NONE when out of memory */
+uint32_t render_packet_add_view(render_packet_t *p, const float *view, const float *projection, int camera_set);
+uint32_t render_packet_add_transform(render_packet_t *p, const float *m16);
+uint32_t render_packet_add_material(render_packet_t *p, material_handle_t mat);
+
+/* NULL when out of memory; the item is zeroed with view, material and transform set to NONE */
+render_draw_item_t *render_packet_add_item(render_packet_t *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MARU_RENDER_PACKET_H */
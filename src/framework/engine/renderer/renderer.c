@@ -9,9 +9,32 @@
 #include "asset/sprite.h"
 #include "asset/asset.h"
 #include "mem/mem_diag.h"
+#include "mem/mem_scratch.h"
 #include "render_object.h"
+#include "render_packet.h"
 #include "math/math.h"
 #include "math/proj.h"
+#include "time.h"
+#include "thread/atomic.h"
+#include "thread/event.h"
+#include "thread/semaphore.h"
+#include "thread/thread.h"
+
+struct render_thread {
+    renderer_t *R;
+    maru_thread_t *handle;
+    rhi_swapchain_t *swapchain;
+
+    render_packet_t packets[2];
+    uint32_t next;                  /* packet the caller records into */
+    render_packet_t *pending;       /* handed over by posting ready */
+    int in_flight;                  /* caller side: done not yet consumed */
+
+    maru_sem_t ready;
+    maru_event_t done;
+    maru_atomic_u32_t quit;
+    maru_atomic_u32_t busy_us;      /* submit + present time of the last packet */
+};
 
 static void destroy_offscreen(renderer_t *R) {
     if (!R || !R->rhi) return;
@@ -82,9 +105,12 @@ static void destroy_post(renderer_t *R) {
 static void create_post(renderer_t *R) {
     const rhi_dispatch_t *r = R->rhi;
 
+    scratch_marker_t scratch = scratch_push();
+
     size_t buf_len;
-    char *buf = asset_read_all("shader\\single_fullscreen.hlsl", &buf_len, TRUE);
+    char *buf = asset_read_scratch("shader\\single_fullscreen.hlsl", &buf_len, TRUE);
     if (buf == NULL) {
+        scratch_pop(scratch);
         FATAL("unable to load shader");
         return;
     }
@@ -97,6 +123,7 @@ static void create_post(renderer_t *R) {
     sd.blob_ps = buf;
     sd.blob_ps_size = buf_len;
     R->post_sh = r->create_shader(R->dev, &sd);
+    scratch_pop(scratch);
 
     rhi_pipeline_desc_t pd = {0};
     pd.shader = R->post_sh;
@@ -117,8 +144,15 @@ static void create_post(renderer_t *R) {
     samp_desc.anisotropy = 1;
     samp_desc.mip_bias = 0.0f;
     R->post_sampler = r->create_sampler(R->dev, &samp_desc);
+}
 
-    MARU_FREE(buf);
+/* One mat4 rewritten before every object draw */
+static void create_draw_cb(renderer_t *R) {
+    rhi_buffer_desc_t bd = {0};
+    bd.size = sizeof(mat4);
+    bd.usage = RHI_BUF_CONST;
+    R->draw_cb = R->rhi->create_buffer(R->dev, &bd, NULL);
+    if (!R->draw_cb) ERROR("renderer: per-draw constant buffer create failed");
 }
 
 int renderer_init(renderer_t *R, const rhi_dispatch_t *rhi, rhi_device_t *dev, int w, int h) {
@@ -131,6 +165,7 @@ int renderer_init(renderer_t *R, const rhi_dispatch_t *rhi, rhi_device_t *dev, i
     R->h = h;
     create_offscreen(R, w, h);
     create_post(R);
+    create_draw_cb(R);
     return 0;
 }
 
@@ -152,57 +187,349 @@ void renderer_set_scene(renderer_t *R, render_scene_fn fn, void *user) {
     R->scene_user = user;
 }
 
-void renderer_render(renderer_t *R) {
-    if (!R || !R->rhi) return;
+static const float s_scene_clear[4] = {0.1f, 0.1f, 0.1f, 1.0f};
+
+/* Pass 2: Post to backbuffer */
+static void post_pass(renderer_t *R, rhi_cmd_t *cmd) {
     const rhi_dispatch_t *r = R->rhi;
 
+    rhi_render_target_t *back = r->get_backbuffer_rt ? r->get_backbuffer_rt(R->dev) : NULL;
+    r->cmd_begin_render(cmd, back, NULL);
+    r->cmd_bind_pipeline(cmd, R->post_pl);
+
+    r->cmd_bind_texture(cmd, R->off_color, 0, RHI_STAGE_PS);
+    r->cmd_bind_sampler(cmd, R->post_sampler, 0, RHI_STAGE_PS);
+
+    r->cmd_draw(cmd, 3, 0, 1);
+    r->cmd_end_render(cmd);
+}
+
+static void update_stats(renderer_t *R, uint64_t now, uint64_t wait_us, uint64_t render_us, int threaded,
+                         const render_packet_t *p) {
+    renderer_frame_stats_t *s = &R->stats;
+
+    uint64_t frame_us = R->last_handoff_us ? now - R->last_handoff_us : 0;
+    uint64_t sim_us = frame_us > wait_us ? frame_us - wait_us : 0;
+    R->last_handoff_us = now;
+
+    s->frame++;
+    s->frame_ms = (float) frame_us / 1000.0f;
+    s->sim_ms = (float) sim_us / 1000.0f;
+    s->render_ms = (float) render_us / 1000.0f;
+    s->wait_ms = (float) wait_us / 1000.0f;
+    s->views = p ? p->view_count : 0;
+    s->draw_items = p ? p->item_count : 0;
+
+    /* the last packet rendered during this frame's sim; whatever the frame did not pay for ran concurrently */
+    float overlap = 0.0f;
+    uint64_t shorter = sim_us < render_us ? sim_us : render_us;
+    if (threaded && frame_us && shorter && sim_us + render_us > frame_us) {
+        overlap = (float) (sim_us + render_us - frame_us) / (float) shorter;
+        if (overlap > 1.0f) overlap = 1.0f;
+    }
+    s->overlap = overlap;
+    s->overlap_avg = s->frame > 1 ? s->overlap_avg * 0.95f + overlap * 0.05f : overlap;
+}
+
+/* MVP into the per-draw constants; call after the material is bound */
+static void bind_draw_constants(renderer_t *R, rhi_cmd_t *cmd, const mat4 MVP) {
+    if (!R->draw_cb) return;
+    R->rhi->update_buffer(R->dev, R->draw_cb, MVP, sizeof(mat4));
+    R->rhi->cmd_bind_const_buffer(cmd, RENDERER_SLOT_PER_DRAW, R->draw_cb, RHI_STAGE_VS);
+}
+
+static void render_immediate(renderer_t *R) {
+    const rhi_dispatch_t *r = R->rhi;
+    uint64_t t0 = time_now_us();
+
     R->current_cmd = r->begin_cmd(R->dev);
 
     /* Pass 1: Offscreen scene */
-    const float clear1[4] = {0.1f, 0.1f, 0.1f, 1.0f};
-    r->cmd_begin_render(R->current_cmd, R->off_rt, clear1);
+    r->cmd_begin_render(R->current_cmd, R->off_rt, s_scene_clear);
     if (R->scene_cb) {
         R->scene_cb(R, R->scene_user);
     }
     r->cmd_end_render(R->current_cmd);
 
-    /* Pass 2: Post to backbuffer */
-    rhi_render_target_t *back = r->get_backbuffer_rt ? r->get_backbuffer_rt(R->dev) : NULL;
-    r->cmd_begin_render(R->current_cmd, back, NULL);
-    r->cmd_bind_pipeline(R->current_cmd, R->post_pl);
-
-    rhi_binding_t b0[2] = {0};
-    r->cmd_bind_texture(R->current_cmd, R->off_color, 0, RHI_STAGE_PS);
-    r->cmd_bind_sampler(R->current_cmd, R->post_sampler, 0, RHI_STAGE_PS);
-
-    r->cmd_draw(R->current_cmd, 3, 0, 1);
-    r->cmd_end_render(R->current_cmd);
+    post_pass(R, R->current_cmd);
 
     r->end_cmd(R->current_cmd);
     R->current_cmd = NULL;
+
+    uint64_t now = time_now_us();
+    update_stats(R, now, 0, now - t0, 0, NULL);
+}
+
+/* Render thread: replays what draw_* recorded, in order */
+static void replay_packet(renderer_t *R, rhi_cmd_t *cmd, const render_packet_t *p, const rhi_capabilities_t *caps) {
+    const rhi_dispatch_t *r = R->rhi;
+    uint32_t bound = RENDER_PACKET_NONE;
+
+    for (uint32_t i = 0; i < p->item_count; ++i) {
+        const render_draw_item_t *it = &p->items[i];
+
+        if (it->material != RENDER_PACKET_NONE && it->material != bound) {
+            material_bind_captured(cmd, p->materials + it->material);
+            bound = it->material;
+        }
+
+        if (it->transform != RENDER_PACKET_NONE && it->view != RENDER_PACKET_NONE) {
+            const render_view_t *v = &p->views[it->view];
+            mat4 P, V, W, PV, MVP;
+            memcpy(P, v->projection, sizeof(mat4));
+            memcpy(V, v->view, sizeof(mat4));
+            memcpy(W, p->transforms + (size_t) it->transform * 16, sizeof(mat4));
+
+            mat4_mul(P, V, PV);
+            mat4_mul(PV, W, MVP);
+            mat4_to_backend_order(caps, MVP, MVP);
+            bind_draw_constants(R, cmd, MVP);
+        }
+
+        if (it->texture) r->cmd_bind_texture(cmd, it->texture, 0, RHI_STAGE_PS);
+        if (!it->vb) continue;
+
+        r->cmd_set_vertex_buffer(cmd, 0, it->vb);
+        if (it->ib) r->cmd_set_index_buffer(cmd, it->ib);
+
+        if (it->ib && it->index_count > 0) {
+            r->cmd_draw_indexed(cmd, it->index_count, 0, 0, 1);
+        } else if (it->vertex_count > 0) {
+            r->cmd_draw(cmd, it->vertex_count, 0, 1);
+        }
+    }
+}
+
+static void submit_packet(renderer_t *R, const render_packet_t *p) {
+    const rhi_dispatch_t *r = R->rhi;
+
+    rhi_capabilities_t caps;
+    r->get_capabilities(R->dev, &caps);
+
+    rhi_cmd_t *cmd = r->begin_cmd(R->dev);
+
+    r->cmd_begin_render(cmd, R->off_rt, s_scene_clear);
+    replay_packet(R, cmd, p, &caps);
+    r->cmd_end_render(cmd);
+
+    post_pass(R, cmd);
+    r->end_cmd(cmd);
+}
+
+static int render_thread_main(void *user) {
+    struct render_thread *t = (struct render_thread*) user;
+
+    for (;;) {
+        maru_sem_wait(&t->ready);
+        if (maru_atomic_load_u32(&t->quit, MARU_MO_ACQUIRE)) break;
+
+        uint64_t t0 = time_now_us();
+        submit_packet(t->R, t->pending);
+        if (t->swapchain) t->R->rhi->present(t->swapchain);
+        maru_atomic_store_u32(&t->busy_us, (uint32_t) (time_now_us() - t0), MARU_MO_RELAXED);
+
+        maru_event_set(&t->done);
+    }
+    return 0;
+}
+
+static void render_threaded(renderer_t *R) {
+    struct render_thread *t = R->thread;
+    render_packet_t *p = &t->packets[t->next];
+
+    /*
+     * One packet in flight at most: the picture trails by a frame, never
+     * more. Waiting before recording keeps the render thread idle while the
+     * scene callback runs, so capturing materials may create their buffers
+     * and the sampler; the overlap is with the simulation between renders.
+     */
+    uint64_t wait0 = time_now_us();
+    renderer_flush(R);
+    uint64_t wait_us = time_now_us() - wait0;
+
+    render_packet_reset(p, R->stats.frame + 1);
+    R->record.packet = p;
+    R->record.view = render_packet_add_view(p, (const float*) R->view_matrix, (const float*) R->projection_matrix,
+                                            R->camera_set);
+    R->record.material = RENDER_PACKET_NONE;
+    if (R->scene_cb) {
+        R->scene_cb(R, R->scene_user);
+    }
+    R->record.packet = NULL;
+
+    update_stats(R, time_now_us(), wait_us, maru_atomic_load_u32(&t->busy_us, MARU_MO_RELAXED), 1, p);
+
+    t->pending = p;
+    t->in_flight = 1;
+    t->next ^= 1u;
+    maru_sem_post(&t->ready, 1);
+}
+
+void renderer_render(renderer_t *R) {
+    if (!R || !R->rhi) return;
+
+    if (R->thread) {
+        render_threaded(R);
+    } else {
+        render_immediate(R);
+    }
+}
+
+int renderer_start_thread(renderer_t *R, rhi_swapchain_t *swapchain) {
+    if (!R || !R->rhi) return -1;
+    if (R->thread) return 0;
+
+    /* GL-style backends bind their context to the thread that made it */
+    rhi_capabilities_t caps;
+    memset(&caps, 0, sizeof(caps));
+    if (R->rhi->get_capabilities) R->rhi->get_capabilities(R->dev, &caps);
+    if (!caps.threaded_submit) {
+        INFO("renderer: backend cannot submit from another thread");
+        return -1;
+    }
+
+    struct render_thread *t = (struct render_thread*) MARU_CALLOC_T(MEM_TAG_RENDERER, 1, sizeof(*t));
+    if (!t) return -1;
+
+    t->R = R;
+    t->swapchain = swapchain;
+    render_packet_init(&t->packets[0]);
+    render_packet_init(&t->packets[1]);
+    maru_sem_init(&t->ready, 0);
+    maru_event_init(&t->done, 1, 0);
+
+    maru_thread_desc_t desc = {0};
+    desc.fn = render_thread_main;
+    desc.user = t;
+    desc.name = "maru-render";
+    desc.priority = MARU_THREAD_PRIORITY_HIGH;
+    t->handle = maru_thread_create_ex(&desc);
+    if (!t->handle) {
+        ERROR("renderer: unable to start render thread");
+        MARU_FREE(t);
+        return -1;
+    }
+
+    R->thread = t;
+    INFO("renderer: render thread started");
+    return 0;
+}
+
+void renderer_stop_thread(renderer_t *R) {
+    if (!R || !R->thread) return;
+    struct render_thread *t = R->thread;
+
+    renderer_flush(R);
+    maru_atomic_store_u32(&t->quit, 1, MARU_MO_RELEASE);
+    maru_sem_post(&t->ready, 1);
+    maru_thread_join(t->handle);
+
+    render_packet_free(&t->packets[0]);
+    render_packet_free(&t->packets[1]);
+    MARU_FREE(t);
+    R->thread = NULL;
+}
+
+int renderer_threaded(const renderer_t *R) {
+    return R && R->thread;
+}
+
+void renderer_flush(renderer_t *R) {
+    if (!R || !R->thread || !R->thread->in_flight) return;
+
+    maru_event_wait(&R->thread->done);
+    R->thread->in_flight = 0;
+}
+
+void renderer_frame_stats(const renderer_t *R, renderer_frame_stats_t *out) {
+    if (!out) return;
+    if (!R) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = R->stats;
 }
 
 void renderer_shutdown(renderer_t *R) {
     if (!R) return;
+    renderer_stop_thread(R);
     destroy_offscreen(R);
     destroy_post(R);
+    if (R->rhi && R->draw_cb) R->rhi->destroy_buffer(R->dev, R->draw_cb);
     memset(R, 0, sizeof(*R));
 }
 
 /* Rendering API */
+/*
+ * Recording: the packet copies transforms and material parameters, but
+ * keeps raw RHI pointers for buffers, textures and pipelines. Destroying
+ * a mesh, material or texture waits for the packet in flight
+ * (renderer_flush through g_ctx.renderer), so those stay valid.
+ */
+static void record_draw(renderer_t *R, const mesh_draw_info_t *mi, rhi_texture_t *texture, uint32_t transform) {
+    render_draw_item_t *it = render_packet_add_item(R->record.packet);
+    if (!it) return;
+
+    it->view = R->record.view;
+    it->material = R->record.material;
+    it->transform = transform;
+    it->texture = texture;
+    it->vb = mi->vb;
+    it->ib = mi->ib;
+    it->vertex_count = mi->vertex_count;
+    it->index_count = mi->index_count;
+}
+
+static void record_object(renderer_t *R, const render_object_t *ro) {
+    render_packet_t *p = R->record.packet;
+
+    mesh_draw_info_t mi;
+    if (mesh_get_draw_info(ro->mesh, &mi) != 0) return;
+
+    /* MVP is computed on the render thread, into the per-draw constants */
+    uint32_t xf = RENDER_PACKET_NONE;
+    if (R->camera_set && ro->transform) {
+        const mat4 *M = transform_get_world_matrix(ro->transform);
+        xf = render_packet_add_transform(p, (const float*) *M);
+    }
+
+    if (ro->material != MAT_HANDLE_INVALID) {
+        R->record.material = render_packet_add_material(p, ro->material);
+    }
+    record_draw(R, &mi, NULL, xf);
+}
+
 void renderer_bind_material(renderer_t *R, material_handle_t mat) {
-    if (!R || !R->current_cmd || mat == MAT_HANDLE_INVALID) return;
+    if (!R || mat == MAT_HANDLE_INVALID) return;
+    if (R->record.packet) {
+        R->record.material = render_packet_add_material(R->record.packet, mat);
+        return;
+    }
+    if (!R->current_cmd) return;
     material_bind(R->current_cmd, mat);
 }
 
 void renderer_draw_mesh(renderer_t *R, mesh_handle_t mesh) {
-    if (!R || !R->current_cmd || mesh == MESH_HANDLE_INVALID) return;
+    if (!R || mesh == MESH_HANDLE_INVALID) return;
+    if (R->record.packet) {
+        mesh_draw_info_t mi;
+        if (mesh_get_draw_info(mesh, &mi) == 0) record_draw(R, &mi, NULL, RENDER_PACKET_NONE);
+        return;
+    }
+    if (!R->current_cmd) return;
     mesh_bind(R->current_cmd, mesh);
     mesh_draw(R->current_cmd, mesh);
 }
 
 void renderer_draw_sprite(renderer_t *R, sprite_handle_t sprite, float x, float y) {
-    if (!R || !R->current_cmd || sprite == SPRITE_HANDLE_INVALID) return;
+    if (!R || sprite == SPRITE_HANDLE_INVALID) return;
+    if (R->record.packet) {
+        mesh_draw_info_t mi;
+        rhi_texture_t *tex;
+        if (sprite_get_draw_info(sprite, &mi, &tex) == 0) record_draw(R, &mi, tex, RENDER_PACKET_NONE);
+        return;
+    }
+    if (!R->current_cmd) return;
     sprite_draw(R->current_cmd, sprite, x, y);
 }
 
@@ -212,18 +539,24 @@ void renderer_set_camera(renderer_t *R, const float *view, const float *projecti
     memcpy(R->view_matrix, view, sizeof(mat4));
     memcpy(R->projection_matrix, projection, sizeof(mat4));
     R->camera_set = 1;
-}
-
-void renderer_draw_object(renderer_t *R, render_object_handle_t obj) {
-    if (!R || !R->current_cmd || obj == RENDER_OBJECT_HANDLE_INVALID) return;
 
-    const render_object_t *ro = render_object_get_const(obj);
-    if (!ro) return;
+    if (R->record.packet) {
+        R->record.view = render_packet_add_view(R->record.packet, view, projection, 1);
+    }
+}
 
+static void draw_resolved(renderer_t *R, const render_object_t *ro, const rhi_capabilities_t *caps) {
     /* Skip invisible objects */
     if (!ro->visible) return;
 
-    /* Auto-calculate MVP if camera is set and transform exists */
+    if (R->record.packet) {
+        record_object(R, ro);
+        return;
+    }
+
+    /* Bind material, then the MVP if camera is set and transform exists */
+    renderer_bind_material(R, ro->material);
+
     if (R->camera_set && ro->transform) {
         const mat4 *M = transform_get_world_matrix(ro->transform);
 
@@ -232,15 +565,58 @@ void renderer_draw_object(renderer_t *R, render_object_handle_t obj) {
         mat4_mul(PV, *M, MVP);
 
         /* Backend order conversion */
-        rhi_capabilities_t caps;
-        R->rhi->get_capabilities(R->dev, &caps);
-        mat4_to_backend_order(&caps, MVP, MVP);
-
-        /* Set MVP to material instance */
-        material_set_mat4(ro->material, "uMVP", (const float*)MVP);
+        mat4_to_backend_order(caps, MVP, MVP);
+        bind_draw_constants(R, R->current_cmd, MVP);
     }
 
-    /* Bind material and draw mesh */
-    renderer_bind_material(R, ro->material);
     renderer_draw_mesh(R, ro->mesh);
 }
+
+void renderer_draw_object(renderer_t *R, render_object_handle_t obj) {
+    if (!R || (!R->current_cmd && !R->record.packet) || obj == RENDER_OBJECT_HANDLE_INVALID) return;
+
+    const render_object_t *ro = render_object_get_const(obj);
+    if (!ro) return;
+
+    rhi_capabilities_t caps;
+    R->rhi->get_capabilities(R->dev, &caps);
+    draw_resolved(R, ro, &caps);
+}
+
+#define DRAW_BATCH 64
+
+void renderer_draw_objects(renderer_t *R, const render_object_handle_t *objs, size_t count) {
+    if (!R || (!R->current_cmd && !R->record.packet) || !objs) return;
+
+    rhi_capabilities_t caps;
+    R->rhi->get_capabilities(R->dev, &caps);
+
+    render_object_t *ro[DRAW_BATCH];
+    material_handle_t mats[DRAW_BATCH];
+    mesh_handle_t meshes[DRAW_BATCH];
+
+    while (count > 0) {
+        size_t n = count < DRAW_BATCH ? count : DRAW_BATCH;
+
+        /* Resolve the whole batch first so the dependent lookups overlap */
+        render_object_get_many(objs, n, ro);
+
+        size_t k = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!ro[i] || !ro[i]->visible) continue;
+            mats[k] = ro[i]->material;
+            meshes[k] = ro[i]->mesh;
+            ++k;
+        }
+
+        material_prefetch(mats, k);
+        mesh_prefetch(meshes, k);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (ro[i]) draw_resolved(R, ro[i], &caps);
+        }
+
+        objs += n;
+        count -= n;
+    }
+}
@@ -2,6 +2,7 @@
 #define MARU_RENDERER_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "math/math.h"
 
@@ -17,7 +18,11 @@ struct rhi_render_target;
 struct rhi_shader;
 struct rhi_pipeline;
 struct rhi_sampler;
+struct rhi_buffer;
 struct rhi_cmd;
+struct rhi_swapchain;
+struct render_packet;
+struct render_thread;
 
 typedef uint32_t material_handle_t;
 typedef uint32_t mesh_handle_t;
@@ -26,6 +31,35 @@ typedef uint32_t render_object_handle_t;
 
 typedef struct renderer renderer_t;
 
+/*
+ * Constant buffer slot of the per-draw constants. Object draws with a
+ * transform get their MVP there instead of in the material, declared as
+ *
+ *     cbuffer PerDraw : register(b1) { row_major float4x4 uMVP; };
+ *
+ * so material instances that override nothing keep sharing their base's
+ * constant buffers.
+ */
+#define RENDERER_SLOT_PER_DRAW 1
+
+/*
+ * Per-frame timing, in milliseconds. frame is the handoff-to-handoff time
+ * on the simulation thread; wait is how much of it went to waiting for the
+ * render thread. overlap is the share of the shorter of sim and render
+ * that ran concurrently with the other (0 without a render thread).
+ */
+typedef struct renderer_frame_stats {
+    uint64_t frame;
+    float frame_ms;
+    float sim_ms;
+    float render_ms;
+    float wait_ms;
+    float overlap;
+    float overlap_avg;
+    uint32_t views;
+    uint32_t draw_items;
+} renderer_frame_stats_t;
+
 /* Scene callback - receives renderer instead of cmd */
 typedef void (*render_scene_fn)(renderer_t *R, void *user);
 
@@ -52,10 +86,26 @@ struct renderer {
     render_scene_fn scene_cb;
     void *scene_user;
 
+    /* Per-draw constants (RENDERER_SLOT_PER_DRAW) */
+    struct rhi_buffer *draw_cb;
+
     /* Camera matrices */
     mat4_t view_matrix;
     mat4_t projection_matrix;
     uint8_t camera_set : 1;
+
+    /* Render thread; NULL renders and presents on the caller */
+    struct render_thread *thread;
+
+    /* Packet being recorded (valid only during render, threaded) */
+    struct {
+        struct render_packet *packet;
+        uint32_t view;
+        uint32_t material;
+    } record;
+
+    renderer_frame_stats_t stats;
+    uint64_t last_handoff_us;
 };
 
 int renderer_init(renderer_t *R, const struct rhi_dispatch *rhi, struct rhi_device *dev, int w, int h);
@@ -64,11 +114,41 @@ void renderer_set_scene(renderer_t *R, render_scene_fn fn, void *user);
 void renderer_render(renderer_t *R); /* no present */
 void renderer_shutdown(renderer_t *R);
 
+/*
+ * Render thread. Once started, renderer_render runs the scene callback
+ * into a render packet and hands it to the thread, which submits it and
+ * presents the swapchain while the caller simulates the next frame. At
+ * most one packet is in flight, so the picture lags simulation by one
+ * frame at most. renderer_start_thread fails (-1) unless the backend
+ * reports rhi_capabilities_t.threaded_submit; GL and GLES do not.
+ *
+ * The RHI is not thread-safe: while a packet is in flight (from the
+ * return of renderer_render until the next one, or renderer_flush) the
+ * caller must not create or update GPU resources. Call renderer_flush
+ * first (before resizing or loading assets); it returns once the render
+ * thread is idle. renderer_render itself waits for the previous packet
+ * before running the scene callback, so the callback may create
+ * resources (materials make their constant buffers on first capture).
+ *
+ * Packets copy material parameters and transforms, which may change
+ * freely, but point at RHI objects directly. Destroying a mesh, material
+ * or texture waits for the packet in flight (through g_ctx.renderer), so
+ * unloading needs no flush of its own.
+ */
+int renderer_start_thread(renderer_t *R, struct rhi_swapchain *swapchain);
+void renderer_stop_thread(renderer_t *R);
+int renderer_threaded(const renderer_t *R);
+void renderer_flush(renderer_t *R);
+
+void renderer_frame_stats(const renderer_t *R, renderer_frame_stats_t *out);
+
 /* Camera */
 void renderer_set_camera(renderer_t *R, const float *view, const float *projection);
 
 /* High-level rendering API */
 void renderer_draw_object(renderer_t *R, render_object_handle_t obj);
+/* Same as calling renderer_draw_object for each handle, with lookups batched */
+void renderer_draw_objects(renderer_t *R, const render_object_handle_t *objs, size_t count);
 void renderer_draw_sprite(renderer_t *R, sprite_handle_t sprite, float x, float y);
 
 /* Low-level API (internal, prefer render_object for 3D) */
@@ -27,6 +27,8 @@ typedef struct rhi_capabilities {
     float min_depth;
     float max_depth;
     rhi_conventions_t conventions;
+    /* Commands may be submitted and presented from a thread other than the device's creator (not GL/GLES) */
+    bool threaded_submit;
 } rhi_capabilities_t;
 
 typedef struct rhi_device rhi_device_t;
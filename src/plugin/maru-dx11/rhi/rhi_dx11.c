@@ -1,6 +1,7 @@
 #include "rhi_dx11.h"
 
 #include "../../../framework/core/mem/mem_diag.h"
+#include "../../../framework/core/mem/mem_slab.h"
 #include <stdlib.h>
 
 #include "export.h"
@@ -173,7 +174,7 @@ static int dx11_create_backbuffer_rtv(dx11_state_t *st) {
 static void dx11_refresh_backbuffer_rt(dx11_state_t *st) {
     if (!st || !st->rtv) return;
     if (!st->back_rt) {
-        st->back_rt = (rhi_render_target_t*) MARU_CALLOC(1, sizeof(rhi_render_target_t));
+        st->back_rt = MARU_SLAB_NEW(rhi_render_target_t);
         dx11_rt_t *rt = &st->back_rt->rt;
         memset(rt, 0, sizeof(*rt));
         rt->st = st;
@@ -191,7 +192,7 @@ static void dx11_refresh_backbuffer_rt(dx11_state_t *st) {
 static void dx11_drop_backbuffer_rt(dx11_state_t *st) {
     if (!st) return;
     if (st->back_rt) {
-        MARU_FREE(st->back_rt);
+        MARU_SLAB_DELETE(st->back_rt);
         st->back_rt = NULL;
     }
 }
@@ -358,7 +359,7 @@ static UINT mip_count_from_wh(UINT w, UINT h) {
 static rhi_device_t *dx11_create_device(const rhi_device_desc_t *desc) {
     if (!desc || !desc->native_window) return NULL;
 
-    dx11_state_t *st = (dx11_state_t*) MARU_CALLOC(1, sizeof(dx11_state_t));
+    dx11_state_t *st = (dx11_state_t*) MARU_CALLOC_T(MEM_TAG_RENDERER, 1, sizeof(dx11_state_t));
     if (!st) return NULL;
 
     st->hwnd = (HWND) desc->native_window;
@@ -405,7 +406,7 @@ static rhi_device_t *dx11_create_device(const rhi_device_desc_t *desc) {
 
     dx11_refresh_backbuffer_rt(st);
 
-    rhi_device_t *dev = (rhi_device_t*) MARU_CALLOC(1, sizeof(rhi_device_t));
+    rhi_device_t *dev = (rhi_device_t*) MARU_CALLOC_T(MEM_TAG_RENDERER, 1, sizeof(rhi_device_t));
     if (!dev) {
         dx11_release_all(st);
         MARU_FREE(st);
@@ -428,7 +429,7 @@ static void dx11_destroy_device(rhi_device_t *d) {
 
 static rhi_swapchain_t *dx11_get_swapchain(rhi_device_t *desc) {
     if (!desc || !desc->st) return NULL;
-    rhi_swapchain_t *s = (rhi_swapchain_t*) MARU_CALLOC(1, sizeof(rhi_swapchain_t));
+    rhi_swapchain_t *s = (rhi_swapchain_t*) MARU_CALLOC_T(MEM_TAG_RENDERER, 1, sizeof(rhi_swapchain_t));
     if (!s) return NULL;
     s->st = desc->st;
     return s;
@@ -505,7 +506,7 @@ static rhi_buffer_t *dx11_create_buffer(rhi_device_t *d, const rhi_buffer_desc_t
     HRESULT hr = ID3D11Device_CreateBuffer(d->st->dev, &bd, initial ? &srd : NULL, &buf);
     if (FAILED(hr)) return NULL;
 
-    rhi_buffer_t *b = (rhi_buffer_t*) MARU_CALLOC(1, sizeof(rhi_buffer_t));
+    rhi_buffer_t *b = MARU_SLAB_NEW(rhi_buffer_t);
     b->vb.buf = buf;
     b->vb.size = desc->size;
     b->vb.stride = desc->stride;
@@ -538,7 +539,7 @@ static void dx11_destroy_buffer(rhi_device_t *d, rhi_buffer_t *b) {
     if (b->vb.buf) {
         ID3D11Buffer_Release(b->vb.buf);
     }
-    MARU_FREE(b);
+    MARU_SLAB_DELETE(b);
 }
 
 static rhi_texture_t *dx11_create_texture(rhi_device_t *d, const rhi_texture_desc_t *desc, const void *initial) {
@@ -573,7 +574,7 @@ static rhi_texture_t *dx11_create_texture(rhi_device_t *d, const rhi_texture_des
     }
 
 
-    rhi_texture_t *tex = (rhi_texture_t*) MARU_CALLOC(1, sizeof(rhi_texture_t));
+    rhi_texture_t *tex = MARU_SLAB_NEW(rhi_texture_t);
     if (!tex) return NULL;
 
     D3D11_TEXTURE2D_DESC td = {0};
@@ -601,14 +602,14 @@ static rhi_texture_t *dx11_create_texture(rhi_device_t *d, const rhi_texture_des
         const size_t bpp = bytes_per_pixel_dxgi(base_fmt);
         if (bpp == 0) {
             MR_LOG(ERROR, "Unsupported initial-data format for DXGI format %d", (int)base_fmt);
-            MARU_FREE(tex);
+            MARU_SLAB_DELETE(tex);
             return NULL;
         }
 
         UINT mip_count = td.MipLevels;
-        subs = (D3D11_SUBRESOURCE_DATA*) MARU_MALLOC(sizeof(D3D11_SUBRESOURCE_DATA) * mip_count);
+        subs = (D3D11_SUBRESOURCE_DATA*) MARU_MALLOC_T(MEM_TAG_RENDERER, sizeof(D3D11_SUBRESOURCE_DATA) * mip_count);
         if (!subs) {
-            MARU_FREE(tex);
+            MARU_SLAB_DELETE(tex);
             return NULL;
         }
 
@@ -638,7 +639,7 @@ static rhi_texture_t *dx11_create_texture(rhi_device_t *d, const rhi_texture_des
     }
 
     if (FAILED(hr)) {
-        MARU_FREE(tex);
+        MARU_SLAB_DELETE(tex);
         return NULL;
     }
 
@@ -719,7 +720,7 @@ fail:
         ID3D11Texture2D_Release(tex->t.tex);
     }
 
-    MARU_FREE(tex);
+    MARU_SLAB_DELETE(tex);
     return NULL;
 }
 
@@ -744,7 +745,7 @@ static void dx11_destroy_texture(rhi_device_t *d, rhi_texture_t *t) {
         ID3D11Texture2D_Release(t->t.tex);
     }
 
-    MARU_FREE(t);
+    MARU_SLAB_DELETE(t);
 }
 
 static rhi_sampler_t *dx11_create_sampler(rhi_device_t *d, const rhi_sampler_desc_t *desc) {
@@ -770,7 +771,7 @@ static rhi_sampler_t *dx11_create_sampler(rhi_device_t *d, const rhi_sampler_des
     HRESULT hr = ID3D11Device_CreateSamplerState(d->st->dev, &sd, &state);
     if (FAILED(hr)) return NULL;
 
-    rhi_sampler_t *s = (rhi_sampler_t*) MARU_CALLOC(1, sizeof(rhi_sampler_t));
+    rhi_sampler_t *s = MARU_SLAB_NEW(rhi_sampler_t);
     s->state = state;
     return s;
 }
@@ -780,7 +781,7 @@ static void dx11_destroy_sampler(rhi_device_t *d, rhi_sampler_t *s) {
     if (!s) return;
     if (s->state)
         ID3D11SamplerState_Release(s->state);
-    MARU_FREE(s);
+    MARU_SLAB_DELETE(s);
 }
 
 static rhi_shader_t *dx11_create_shader(rhi_device_t *d, const rhi_shader_desc_t *sd) {
@@ -828,7 +829,7 @@ static rhi_shader_t *dx11_create_shader(rhi_device_t *d, const rhi_shader_desc_t
         return NULL;
     }
 
-    rhi_shader_t *sh = (rhi_shader_t*) MARU_CALLOC(1, sizeof(rhi_shader_t));
+    rhi_shader_t *sh = MARU_SLAB_NEW(rhi_shader_t);
     sh->sh.vs = vs;
     sh->sh.ps = ps;
     sh->sh.vs_blob = vsb;
@@ -852,7 +853,7 @@ static void dx11_destroy_shader(rhi_device_t *d, rhi_shader_t *s) {
     if (s->sh.vs_blob) {
         ID3D10Blob_Release(s->sh.vs_blob);
     }
-    MARU_FREE(s);
+    MARU_SLAB_DELETE(s);
 }
 
 static void dx11_destroy_pipeline(rhi_device_t *d, rhi_pipeline_t *p);
@@ -860,7 +861,7 @@ static void dx11_destroy_pipeline(rhi_device_t *d, rhi_pipeline_t *p);
 static rhi_pipeline_t *dx11_create_pipeline(rhi_device_t *d, const rhi_pipeline_desc_t *pd) {
     if (!d || !pd || !pd->shader) return NULL;
 
-    rhi_pipeline_t *p = (rhi_pipeline_t*) MARU_CALLOC(1, sizeof(rhi_pipeline_t));
+    rhi_pipeline_t *p = MARU_SLAB_NEW(rhi_pipeline_t);
     p->p.sh = pd->shader;
 
     D3D11_INPUT_ELEMENT_DESC il[32];
@@ -887,7 +888,7 @@ static rhi_pipeline_t *dx11_create_pipeline(rhi_device_t *d, const rhi_pipeline_
             (SIZE_T)ID3D10Blob_GetBufferSize(p->p.sh->sh.vs_blob), &p->p.il);
 
         if (FAILED(hr)) {
-            MARU_FREE(p);
+            MARU_SLAB_DELETE(p);
             return NULL;
         }
 
@@ -958,14 +959,14 @@ static void dx11_destroy_pipeline(rhi_device_t *d, rhi_pipeline_t *p) {
         ID3D11RasterizerState_Release(p->p.rs);
     }
 
-    MARU_FREE(p);
+    MARU_SLAB_DELETE(p);
 }
 
 static rhi_render_target_t *dx11_create_render_target(rhi_device_t *d, const rhi_render_target_desc_t *desc) {
     if (!d || !d->st || !desc) return NULL;
     dx11_state_t *st = d->st;
 
-    rhi_render_target_t *rt = (rhi_render_target_t*) MARU_CALLOC(1, sizeof(rhi_render_target_t));
+    rhi_render_target_t *rt = MARU_SLAB_NEW(rhi_render_target_t);
     dx11_rt_t *dxrt = &rt->rt;
     dxrt->st = st;
     dxrt->is_backbuffer = 0;
@@ -975,7 +976,7 @@ static rhi_render_target_t *dx11_create_render_target(rhi_device_t *d, const rhi
     for (int i = 0; i < desc->color_count; ++i) {
         rhi_texture_t *t = desc->color[i].texture;
         if (!t || !t->t.rtv) {
-            MARU_FREE(rt);
+            MARU_SLAB_DELETE(rt);
             return NULL;
         }
         dxrt->rtvs[i] = t->t.rtv;
@@ -1014,7 +1015,7 @@ static void dx11_destroy_render_target(rhi_device_t *d, rhi_render_target_t *rt)
         }
     }
 
-    MARU_FREE(rt);
+    MARU_SLAB_DELETE(rt);
 }
 
 static rhi_render_target_t *dx11_get_backbuffer_rt(rhi_device_t *d) {
@@ -1030,7 +1031,7 @@ static rhi_texture_t *dx11_render_target_get_color_tex(rhi_render_target_t *rt,
 }
 
 static rhi_cmd_t *dx11_begin_cmd(rhi_device_t *d) {
-    rhi_cmd_t *c = (rhi_cmd_t*) MARU_CALLOC(1, sizeof(rhi_cmd_t));
+    rhi_cmd_t *c = MARU_SLAB_NEW(rhi_cmd_t);
     if (!c) return NULL;
     c->st = d->st;
     c->current_rt = NULL;
@@ -1038,7 +1039,7 @@ static rhi_cmd_t *dx11_begin_cmd(rhi_device_t *d) {
 }
 
 static void dx11_end_cmd(rhi_cmd_t *c) {
-    MARU_FREE(c);
+    MARU_SLAB_DELETE(c);
 }
 
 static void dx11_get_rt_size(dx11_rt_t *rt, int *out_w, int *out_h) {
@@ -1238,7 +1239,7 @@ static void dx11_cmd_draw_indexed(rhi_cmd_t *c, uint32_t idx_count, uint32_t fir
 
 static rhi_fence_t *dx11_fence_create(rhi_device_t *d) {
     UNUSED(d);
-    return (rhi_fence_t*) MARU_CALLOC(1, sizeof(rhi_fence_t));
+    return MARU_SLAB_NEW(rhi_fence_t);
 }
 
 static void dx11_fence_wait(rhi_fence_t *f) {
@@ -1246,7 +1247,7 @@ static void dx11_fence_wait(rhi_fence_t *f) {
 }
 
 static void dx11_fence_destroy(rhi_fence_t *f) {
-    MARU_FREE(f);
+    MARU_SLAB_DELETE(f);
 }
 
 static void dx11_get_capabilities(rhi_device_t *dev, rhi_capabilities_t *out) {
@@ -1256,6 +1257,8 @@ static void dx11_get_capabilities(rhi_device_t *dev, rhi_capabilities_t *out) {
     out->conventions.uv_yaxis = RHI_AXIS_DOWN;
     out->conventions.ndc_yaxis = RHI_AXIS_UP;
     out->conventions.matrix_order = RHI_MATRIX_COLUMN_MAJOR;
+    /* the immediate context is only ever used by one thread at a time */
+    out->threaded_submit = true;
 }
 
 PLUGIN_API const rhi_dispatch_t *maru_rhi_entry(void) {
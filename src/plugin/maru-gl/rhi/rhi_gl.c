@@ -1,6 +1,7 @@
 #include "rhi_gl.h"
 
 #include "../../../framework/core/mem/mem_diag.h"
+#include "../../../framework/core/mem/mem_slab.h"
 #include <stdlib.h>
 
 struct rhi_device {
@@ -107,7 +108,7 @@ static rhi_device_t *gl_create_device(const rhi_device_desc_t *d) {
     INFO("creating openGL device");
 
     UNUSED(d);
-    return (rhi_device_t*) MARU_CALLOC(1, sizeof(rhi_device_t));
+    return (rhi_device_t*) MARU_CALLOC_T(MEM_TAG_RENDERER, 1, sizeof(rhi_device_t));
 }
 
 static void gl_update_buffer(rhi_device_t *d, rhi_buffer_t *b, const void *data, size_t bytes) {
@@ -123,7 +124,7 @@ static void gl_destroy_device(rhi_device_t *d) {
 
 static rhi_swapchain_t *gl_get_swapchain(rhi_device_t *d) {
     UNUSED(d);
-    return (rhi_swapchain_t*) MARU_CALLOC(1, sizeof(rhi_swapchain_t));
+    return (rhi_swapchain_t*) MARU_CALLOC_T(MEM_TAG_RENDERER, 1, sizeof(rhi_swapchain_t));
 }
 
 static void gl_present(rhi_swapchain_t *s) {
@@ -139,19 +140,19 @@ static void gl_resize(rhi_device_t *d, int w, int h) {
 static rhi_buffer_t *gl_create_buffer(rhi_device_t *d, const rhi_buffer_desc_t *desc, const void *initial) {
     UNUSED(d);
     UNUSED(initial);
-    return (rhi_buffer_t*) MARU_CALLOC(1, sizeof(rhi_buffer_t));
+    return MARU_SLAB_NEW(rhi_buffer_t);
 }
 
 static void gl_destroy_buffer(rhi_device_t *d, rhi_buffer_t *b) {
     UNUSED(d);
-    MARU_FREE(b);
+    MARU_SLAB_DELETE(b);
 }
 
 static rhi_texture_t *gl_create_texture(rhi_device_t *d, const rhi_texture_desc_t *desc, const void *initial) {
     UNUSED(d);
     UNUSED(initial);
 
-    rhi_texture_t *t = (rhi_texture_t*) MARU_CALLOC(1, sizeof(*t));
+    rhi_texture_t *t = MARU_SLAB_NEW(rhi_texture_t);
     glGenTextures(1, &t->id);
     t->target = GL_TEXTURE_2D;
     t->w = desc->width;
@@ -188,13 +189,13 @@ static void gl_destroy_texture(rhi_device_t *d, rhi_texture_t *t) {
         glDeleteTextures(1, &t->id);
     }
 
-    MARU_FREE(t);
+    MARU_SLAB_DELETE(t);
 }
 
 static rhi_sampler_t *gl_create_sampler(rhi_device_t *d, const rhi_sampler_desc_t *desc) {
     UNUSED(d);
     UNUSED(desc);
-    rhi_sampler_t *s = (rhi_sampler_t*) MARU_CALLOC(1, sizeof(rhi_sampler_t));
+    rhi_sampler_t *s = MARU_SLAB_NEW(rhi_sampler_t);
     if (!s) return NULL;
     s->_dummy = 1;
     return s;
@@ -203,23 +204,23 @@ static rhi_sampler_t *gl_create_sampler(rhi_device_t *d, const rhi_sampler_desc_
 static void gl_destroy_sampler(rhi_device_t *d, rhi_sampler_t *s) {
     UNUSED(d);
     if (!s) return;
-    MARU_FREE(s);
+    MARU_SLAB_DELETE(s);
 }
 
 static rhi_shader_t *gl_create_shader(rhi_device_t *d, const rhi_shader_desc_t *sd) {
     UNUSED(d);
     UNUSED(sd);
-    return (rhi_shader_t*) MARU_CALLOC(1, sizeof(rhi_shader_t));
+    return MARU_SLAB_NEW(rhi_shader_t);
 }
 
 static void gl_destroy_shader(rhi_device_t *d, rhi_shader_t *s) {
     UNUSED(d);
-    MARU_FREE(s);
+    MARU_SLAB_DELETE(s);
 }
 
 static rhi_pipeline_t *gl_create_pipeline(rhi_device_t *d, const rhi_pipeline_desc_t *pd) {
     UNUSED(d);
-    rhi_pipeline_t *p = (rhi_pipeline_t*) MARU_CALLOC(1, sizeof(rhi_pipeline_t));
+    rhi_pipeline_t *p = MARU_SLAB_NEW(rhi_pipeline_t);
     p->sh = pd->shader;
     p->blend = pd->blend;
     p->depthst = pd->depthst;
@@ -229,12 +230,12 @@ static rhi_pipeline_t *gl_create_pipeline(rhi_device_t *d, const rhi_pipeline_de
 
 static void gl_destroy_pipeline(rhi_device_t *d, rhi_pipeline_t *p) {
     UNUSED(d);
-    MARU_FREE(p);
+    MARU_SLAB_DELETE(p);
 }
 
 static rhi_render_target_t *gl_create_render_target(rhi_device_t *d, const rhi_render_target_desc_t *desc) {
     UNUSED(d);
-    rhi_render_target_t *rt = (rhi_render_target_t*) MARU_CALLOC(1, sizeof(*rt));
+    rhi_render_target_t *rt = MARU_SLAB_NEW(rhi_render_target_t);
     glGenFramebuffers(1, &rt->fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, rt->fbo);
 
@@ -264,7 +265,7 @@ static rhi_render_target_t *gl_create_render_target(rhi_device_t *d, const rhi_r
     if (status != GL_FRAMEBUFFER_COMPLETE) {
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glDeleteFramebuffers(1, &rt->fbo);
-        MARU_FREE(rt);
+        MARU_SLAB_DELETE(rt);
         return NULL;
     }
 
@@ -280,14 +281,14 @@ static void gl_destroy_render_target(rhi_device_t *d, rhi_render_target_t *rt) {
         glDeleteFramebuffers(1, &rt->fbo);
     }
 
-    MARU_FREE(rt);
+    MARU_SLAB_DELETE(rt);
 }
 
 static rhi_render_target_t *gl_get_backbuffer_rt(rhi_device_t *d) {
     UNUSED(d);
     static rhi_render_target_t *s = NULL;
     if (!s) {
-        s = (rhi_render_target_t*) MARU_CALLOC(1, sizeof(*s));
+        s = MARU_SLAB_NEW(rhi_render_target_t);
         s->is_backbuffer = 1;
     }
     return s;
@@ -301,13 +302,13 @@ static rhi_texture_t *gl_render_target_get_color_tex(rhi_render_target_t *rt, in
 
 static rhi_cmd_t *gl_begin_cmd(rhi_device_t *d) {
     UNUSED(d);
-    rhi_cmd_t *c = (rhi_cmd_t*) MARU_CALLOC(1, sizeof(rhi_cmd_t));
+    rhi_cmd_t *c = MARU_SLAB_NEW(rhi_cmd_t);
     if (c) c->current_rt = NULL;
     return c;
 }
 
 static void gl_end_cmd(rhi_cmd_t *c) {
-    MARU_FREE(c);
+    MARU_SLAB_DELETE(c);
 }
 
 static void gl_cmd_begin_render(rhi_cmd_t *c, rhi_render_target_t *rt, const float clear_rgba[4]) {
@@ -428,7 +429,7 @@ static void gl_cmd_draw_indexed(rhi_cmd_t *c, uint32_t idx_count, uint32_t first
 
 static rhi_fence_t *gl_fence_create(rhi_device_t *d) {
     UNUSED(d);
-    return (rhi_fence_t*) MARU_CALLOC(1, sizeof(rhi_fence_t));
+    return MARU_SLAB_NEW(rhi_fence_t);
 }
 
 static void gl_fence_wait(rhi_fence_t *f) {
@@ -436,7 +437,7 @@ static void gl_fence_wait(rhi_fence_t *f) {
 }
 
 static void gl_fence_destroy(rhi_fence_t *f) {
-    MARU_FREE(f);
+    MARU_SLAB_DELETE(f);
 }
 
 PLUGIN_API const rhi_dispatch_t *maru_rhi_entry(void) {
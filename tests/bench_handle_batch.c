@@ -0,0 +1,110 @@
+/*
+ * Scalar handle_pool_get against handle_pool_get_many over shuffled handles:
+ * a plain read of each object, and a dependent second lookup through a
+ * handle stored in the object (the render object -> material shape).
+ */
+#include "test.h"
+
+#include "handle/handle_pool.h"
+
+#define BATCH 64
+
+typedef struct {
+    handle_t next;
+    uint32_t value;
+    uint8_t pad[56];
+} obj_t;
+
+static void shuffle(handle_t *hs, size_t n) {
+    uint32_t x = 12345;
+    for (size_t i = n - 1; i > 0; --i) {
+        x = x * 1664525u + 1013904223u;
+        size_t j = x % (i + 1);
+        handle_t t = hs[i];
+        hs[i] = hs[j];
+        hs[j] = t;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t n = (size_t) 256 * 1024 * bench_scale(argc, argv);
+    const int rounds = 5;
+
+    handle_pool_t *hp = handle_pool_create_paged(4096, 0, sizeof(obj_t), 16);
+    handle_t *hs = (handle_t*) malloc(n * sizeof(handle_t));
+    TEST_CHECK(hp && hs);
+    TEST_CHECK(handle_pool_alloc_n(hp, n, hs) == n);
+
+    for (size_t i = 0; i < n; ++i) {
+        obj_t *o = (obj_t*) handle_pool_get(hp, hs[i]);
+        o->value = (uint32_t) i;
+    }
+    shuffle(hs, n);
+    for (size_t i = 0; i < n; ++i) {
+        obj_t *o = (obj_t*) handle_pool_get(hp, hs[i]);
+        o->next = hs[(i + 1) % n];
+    }
+    shuffle(hs, n);
+
+    uint64_t best[4] = {UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX};
+    uint64_t sums[4] = {0};
+    void *out[BATCH];
+    void *dep[BATCH];
+    handle_t next[BATCH];
+
+    for (int r = 0; r < rounds; ++r) {
+        uint64_t t0 = time_now_us(), sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += ((obj_t*) handle_pool_get(hp, hs[i]))->value;
+        }
+        uint64_t t1 = time_now_us();
+        sums[0] = sum;
+        if (t1 - t0 < best[0]) best[0] = t1 - t0;
+
+        sum = 0;
+        t0 = time_now_us();
+        for (size_t i = 0; i < n; i += BATCH) {
+            size_t k = n - i < BATCH ? n - i : BATCH;
+            handle_pool_get_many(hp, hs + i, k, out);
+            for (size_t j = 0; j < k; ++j) sum += ((obj_t*) out[j])->value;
+        }
+        t1 = time_now_us();
+        sums[1] = sum;
+        if (t1 - t0 < best[1]) best[1] = t1 - t0;
+
+        sum = 0;
+        t0 = time_now_us();
+        for (size_t i = 0; i < n; ++i) {
+            const obj_t *o = (const obj_t*) handle_pool_get(hp, hs[i]);
+            sum += ((const obj_t*) handle_pool_get(hp, o->next))->value;
+        }
+        t1 = time_now_us();
+        sums[2] = sum;
+        if (t1 - t0 < best[2]) best[2] = t1 - t0;
+
+        sum = 0;
+        t0 = time_now_us();
+        for (size_t i = 0; i < n; i += BATCH) {
+            size_t k = n - i < BATCH ? n - i : BATCH;
+            handle_pool_get_many(hp, hs + i, k, out);
+            for (size_t j = 0; j < k; ++j) next[j] = ((obj_t*) out[j])->next;
+            handle_pool_get_many(hp, next, k, dep);
+            for (size_t j = 0; j < k; ++j) sum += ((obj_t*) dep[j])->value;
+        }
+        t1 = time_now_us();
+        sums[3] = sum;
+        if (t1 - t0 < best[3]) best[3] = t1 - t0;
+    }
+
+    TEST_CHECK(sums[0] == sums[1]);
+    TEST_CHECK(sums[2] == sums[3]);
+
+    bench_report("get, scalar", best[0], n);
+    bench_report("get_many, batch 64", best[1], n);
+    bench_report("dependent get, scalar", best[2], n);
+    bench_report("dependent get_many, batch 64", best[3], n);
+
+    handle_pool_destroy(hp);
+    free(hs);
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * Swiss-table map against a linear scan of a key array, the lookup this
+ * map replaces for small registries, across table sizes. Also checks
+ * put/remove/find/next against a reference array under random churn.
+ */
+#include "test.h"
+
+#include <string.h>
+
+#include "container/hashmap.h"
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(void) {
+    s_rng = s_rng * 1664525u + 1013904223u;
+    return s_rng >> 8;
+}
+
+static void check_churn(void) {
+    enum { K = 4096 };
+    static uint32_t ref[K];
+    static int has[K];
+
+    map_u32_u32_t m;
+    map_u32_u32_init(&m, NULL);
+    for (int it = 0; it < 500000; ++it) {
+        uint32_t k = rnd() % K;
+        switch (rnd() % 3) {
+            case 0: {
+                uint32_t v = rnd();
+                TEST_CHECK(map_u32_u32_put(&m, k, v) == 0);
+                ref[k] = v;
+                has[k] = 1;
+                break;
+            }
+            case 1:
+                TEST_CHECK(map_u32_u32_remove(&m, k) == has[k]);
+                has[k] = 0;
+                break;
+            default: {
+                uint32_t *v = map_u32_u32_find(&m, k);
+                TEST_CHECK((v != NULL) == has[k]);
+                if (v) TEST_CHECK(*v == ref[k]);
+                break;
+            }
+        }
+    }
+
+    size_t alive = 0, seen = 0;
+    for (int i = 0; i < K; ++i) alive += (size_t) has[i];
+    TEST_CHECK(alive == map_u32_u32_count(&m));
+
+    size_t it = 0;
+    uint32_t k, v;
+    while (map_u32_u32_next(&m, &it, &k, &v)) {
+        TEST_CHECK(has[k] && ref[k] == v);
+        ++seen;
+    }
+    TEST_CHECK(seen == alive);
+    map_u32_u32_destroy(&m);
+
+    map_str_u32_t sm;
+    map_str_u32_init(&sm, NULL);
+    static char names[1000][16];
+    for (int i = 0; i < 1000; ++i) {
+        snprintf(names[i], sizeof(names[i]), "tex/%d.png", i);
+        map_str_u32_put(&sm, names[i], (uint32_t) i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        char q[16];
+        snprintf(q, sizeof(q), "tex/%d.png", i);
+        TEST_CHECK(map_str_u32_get(&sm, q, ~0u) == (uint32_t) i);
+    }
+    TEST_CHECK(map_str_u32_find(&sm, "missing") == NULL);
+    map_str_u32_destroy(&sm);
+}
+
+int main(int argc, char **argv) {
+    check_churn();
+
+    const uint32_t queries = 1000000u * (uint32_t) bench_scale(argc, argv);
+    static const int sizes[] = {8, 16, 32, 64, 256, 1024, 4096};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int n = sizes[s];
+        uint32_t *keys = (uint32_t*) malloc((size_t) n * sizeof(uint32_t));
+        TEST_CHECK(keys);
+
+        map_u32_u32_t m;
+        map_u32_u32_init(&m, NULL);
+        for (int i = 0; i < n; ++i) {
+            keys[i] = (uint32_t) i * 2654435761u + 1u;  /* distinct, scattered */
+            map_u32_u32_put(&m, keys[i], (uint32_t) i);
+        }
+
+        uint64_t linear_sum = 0, map_sum = 0;
+        uint64_t t0 = time_now_us();
+        for (uint32_t q = 0; q < queries; ++q) {
+            uint32_t key = keys[(q * 7919u) % (uint32_t) n];
+            for (int i = 0; i < n; ++i) {
+                if (keys[i] == key) {
+                    linear_sum += (uint64_t) i;
+                    break;
+                }
+            }
+        }
+        uint64_t t1 = time_now_us();
+        for (uint32_t q = 0; q < queries; ++q) {
+            map_sum += *map_u32_u32_find(&m, keys[(q * 7919u) % (uint32_t) n]);
+        }
+        uint64_t t2 = time_now_us();
+        TEST_CHECK(linear_sum == map_sum);
+
+        char name[40];
+        snprintf(name, sizeof(name), "linear scan, n=%d", n);
+        bench_report(name, t1 - t0, queries);
+        snprintf(name, sizeof(name), "hashmap find, n=%d", n);
+        bench_report(name, t2 - t1, queries);
+
+        map_u32_u32_destroy(&m);
+        free(keys);
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Job system scaling from 0 workers (the caller alone) up to one per core.
+ * Each worker count runs three loads:
+ *
+ *   parallel_for  a compute-bound loop over 1M items, default grain
+ *   tiny jobs     64K empty jobs submitted one at a time from the caller,
+ *                 so deque pushes, steals and wake-ups dominate
+ *   transforms    a scene-graph update over 4K transforms: compose each
+ *                 local matrix from position, rotation and scale, then
+ *                 multiply by the parent's world matrix. Roots go first,
+ *                 then their children, one parallel_for per level
+ *
+ * Speedup is against the 0-worker run of the same load. The top count is
+ * one worker per core after the caller's; a second argument overrides it.
+ */
+#include "test.h"
+
+#include <string.h>
+
+#include "thread/job.h"
+#include "thread/thread.h"
+
+#define ITEMS (1u << 20)
+#define TINY_JOBS (1u << 16)
+
+/* 2 levels: roots, then children whose parents are all roots */
+#define TRANSFORM_ROOTS 256u
+#define TRANSFORMS 4096u
+#define TRANSFORM_FRAMES 16
+
+static float s_data[ITEMS];
+
+/* Column-major like the engine's mat4; plain floats so the bench needs no cglm */
+typedef struct bench_transform {
+    float position[3];
+    float rotation[4];          /* x, y, z, w */
+    float scale[3];
+    uint32_t parent;            /* UINT32_MAX = root */
+    float local[16];
+    float world[16];
+} bench_transform_t;
+
+static bench_transform_t s_transforms[TRANSFORMS];
+
+static void work(void *user, uint32_t begin, uint32_t end) {
+    (void) user;
+    for (uint32_t i = begin; i < end; ++i) {
+        float x = s_data[i];
+        for (int k = 0; k < 32; ++k) x = x * 0.999f + 0.5f;
+        s_data[i] = x;
+    }
+}
+
+static void nothing(void *user, uint32_t index) {
+    (void) user;
+    (void) index;
+}
+
+static void compose_trs(bench_transform_t *t) {
+    const float x = t->rotation[0], y = t->rotation[1], z = t->rotation[2], w = t->rotation[3];
+    const float *s = t->scale;
+    float *m = t->local;
+
+    m[0] = (1.0f - 2.0f * (y * y + z * z)) * s[0];
+    m[1] = (2.0f * (x * y + z * w)) * s[0];
+    m[2] = (2.0f * (x * z - y * w)) * s[0];
+    m[3] = 0.0f;
+    m[4] = (2.0f * (x * y - z * w)) * s[1];
+    m[5] = (1.0f - 2.0f * (x * x + z * z)) * s[1];
+    m[6] = (2.0f * (y * z + x * w)) * s[1];
+    m[7] = 0.0f;
+    m[8] = (2.0f * (x * z + y * w)) * s[2];
+    m[9] = (2.0f * (y * z - x * w)) * s[2];
+    m[10] = (1.0f - 2.0f * (x * x + y * y)) * s[2];
+    m[11] = 0.0f;
+    m[12] = t->position[0];
+    m[13] = t->position[1];
+    m[14] = t->position[2];
+    m[15] = 1.0f;
+}
+
+static void mat4_mul_cm(const float *a, const float *b, float *out) {
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            out[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] + a[8 + r] * b[c * 4 + 2] +
+                             a[12 + r] * b[c * 4 + 3];
+        }
+    }
+}
+
+static void update_transforms(void *user, uint32_t begin, uint32_t end) {
+    const uint32_t first = (uint32_t) (uintptr_t) user;
+    for (uint32_t i = first + begin; i < first + end; ++i) {
+        bench_transform_t *t = &s_transforms[i];
+        t->position[0] += 0.001f;
+        compose_trs(t);
+        if (t->parent == UINT32_MAX) memcpy(t->world, t->local, sizeof(t->world));
+        else mat4_mul_cm(s_transforms[t->parent].world, t->local, t->world);
+    }
+}
+
+static void init_transforms(void) {
+    for (uint32_t i = 0; i < TRANSFORMS; ++i) {
+        bench_transform_t *t = &s_transforms[i];
+        memset(t, 0, sizeof(*t));
+        t->position[0] = (float) (i % 64);
+        t->position[2] = (float) (i / 64);
+        /* a quarter turn about y, normalised */
+        t->rotation[1] = 0.70710678f;
+        t->rotation[3] = 0.70710678f;
+        t->scale[0] = t->scale[1] = t->scale[2] = 1.0f + (float) (i % 3) * 0.5f;
+        t->parent = i < TRANSFORM_ROOTS ? UINT32_MAX : i % TRANSFORM_ROOTS;
+    }
+}
+
+static uint64_t run_transforms(int rounds) {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < rounds; ++r) {
+        uint64_t t0 = time_now_us();
+        for (int f = 0; f < TRANSFORM_FRAMES; ++f) {
+            /* a level starts once the one above it is done */
+            maru_job_parallel_for(TRANSFORM_ROOTS, 0, update_transforms, (void*) (uintptr_t) 0);
+            maru_job_parallel_for(TRANSFORMS - TRANSFORM_ROOTS, 0, update_transforms,
+                                  (void*) (uintptr_t) TRANSFORM_ROOTS);
+        }
+        uint64_t t = time_now_us() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+static uint64_t run_for(int rounds) {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < rounds; ++r) {
+        uint64_t t0 = time_now_us();
+        maru_job_parallel_for(ITEMS, 0, work, NULL);
+        uint64_t t = time_now_us() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+static uint64_t run_tiny(int rounds) {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < rounds; ++r) {
+        maru_job_counter_t counter = MARU_JOB_COUNTER_INIT;
+        uint64_t t0 = time_now_us();
+        for (uint32_t i = 0; i < TINY_JOBS; ++i) {
+            maru_job_t j = {nothing, NULL, i};
+            maru_job_submit(&j, 1, &counter);
+        }
+        maru_job_wait(&counter);
+        uint64_t t = time_now_us() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    const int rounds = 5 * bench_scale(argc, argv);
+    const uint32_t cpus = maru_cpu_count();
+    const uint32_t top = argc > 2 ? (uint32_t) atoi(argv[2]) : cpus - 1;
+    uint64_t base_for = 0, base_tiny = 0, base_xf = 0;
+    init_transforms();
+
+    for (uint32_t w = 0; w <= top; ++w) {
+        TEST_CHECK(maru_job_system_init((int) w) == 0);
+        TEST_CHECK(maru_job_thread_count() == w + 1);
+
+        uint64_t t_for = run_for(rounds);
+        uint64_t t_tiny = run_tiny(rounds);
+        uint64_t t_xf = run_transforms(rounds);
+        if (w == 0) {
+            base_for = t_for;
+            base_tiny = t_tiny;
+            base_xf = t_xf;
+        }
+
+        maru_job_stats_t st;
+        maru_job_stats(&st);
+        maru_job_system_shutdown();
+
+        char label[64];
+        snprintf(label, sizeof(label), "%u workers parallel_for", w);
+        bench_report(label, t_for, ITEMS);
+        printf("%-32s %10.2fx\n", "  speedup", t_for ? (double) base_for / (double) t_for : 0.0);
+        snprintf(label, sizeof(label), "%u workers tiny jobs", w);
+        bench_report(label, t_tiny, TINY_JOBS);
+        printf("%-32s %10.2fx %llu stolen, %llu sleeps, %llu inline\n", "  speedup",
+               t_tiny ? (double) base_tiny / (double) t_tiny : 0.0, (unsigned long long) st.stolen,
+               (unsigned long long) st.sleeps, (unsigned long long) st.inline_runs);
+        snprintf(label, sizeof(label), "%u workers transforms", w);
+        bench_report(label, t_xf, (uint64_t) TRANSFORMS * TRANSFORM_FRAMES);
+        printf("%-32s %10.2fx\n", "  speedup", t_xf ? (double) base_xf / (double) t_xf : 0.0);
+    }
+    return s_data[0] == -1.0f || s_transforms[TRANSFORMS - 1].world[15] != 1.0f;
+}
@@ -0,0 +1,133 @@
+/*
+ * Iteration and shuffled lookup over a 100K-object handle pool, with its
+ * payload on normal pages and on transparent huge pages. Each object size
+ * runs three pools:
+ *
+ *   paged         handle_pool_create_paged, payload from MARU_MALLOC
+ *   virtual 4K    handle_pool_create_virtual with THP disabled for the
+ *                 process while it faults in (Linux PR_SET_THP_DISABLE)
+ *   virtual THP   handle_pool_create_virtual as the engine makes it
+ *
+ * AnonHugePages growth per pool shows whether huge pages were granted; it
+ * stays 0 where THP is off or unsupported, and the two virtual rows then
+ * measure the same thing.
+ */
+#include "test.h"
+
+#include <string.h>
+
+#include "macro.h"
+#include "handle/handle_pool.h"
+#include "mem/vm_arena.h"
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
+
+#define OBJECTS 100000
+#define PASSES 8
+
+typedef struct {
+    float pos[4];
+    float vel[4];
+} obj_head_t;
+
+static float s_sink;
+
+static void step(handle_t h, void *obj, void *user) {
+    (void) h;
+    (void) user;
+    obj_head_t *o = (obj_head_t*) obj;
+    o->pos[0] += o->vel[0];
+    s_sink += o->pos[0];
+}
+
+static size_t anon_huge_kb(void) {
+    size_t kb = 0;
+#if defined(__linux__)
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "AnonHugePages:", 14) == 0) kb = strtoul(line + 14, NULL, 10);
+    }
+    fclose(f);
+#endif
+    return kb;
+}
+
+static void set_thp(int on) {
+#if defined(__linux__)
+    prctl(PR_SET_THP_DISABLE, on ? 0 : 1, 0, 0, 0);
+#else
+    (void) on;
+#endif
+}
+
+static void shuffle(handle_t *hs, size_t n) {
+    uint32_t x = 12345;
+    for (size_t i = n - 1; i > 0; --i) {
+        x = x * 1664525u + 1013904223u;
+        size_t j = x % (i + 1);
+        handle_t t = hs[i];
+        hs[i] = hs[j];
+        hs[j] = t;
+    }
+}
+
+static void run(const char *name, handle_pool_t *hp, size_t obj_size, size_t n, int rounds, int thp) {
+    static handle_t hs[OBJECTS];
+    TEST_CHECK(hp);
+
+    size_t kb0 = anon_huge_kb();
+    set_thp(thp);
+    TEST_CHECK(handle_pool_alloc_n(hp, n, hs) == n);
+    for (size_t i = 0; i < n; ++i) {
+        obj_head_t *o = (obj_head_t*) handle_pool_get(hp, hs[i]);
+        memset(o, 0, obj_size);
+        o->vel[0] = 1.0f;
+        o->vel[1] = 0.5f;
+    }
+    set_thp(1);
+    size_t huge_kb = anon_huge_kb() - kb0;
+    shuffle(hs, n);
+
+    uint64_t best_iter = UINT64_MAX, best_lookup = UINT64_MAX;
+    for (int r = 0; r < rounds; ++r) {
+        uint64_t t0 = time_now_us();
+        for (int p = 0; p < PASSES; ++p) handle_pool_foreach(hp, step, NULL);
+        uint64_t t1 = time_now_us();
+        for (int p = 0; p < PASSES; ++p) {
+            for (size_t i = 0; i < n; ++i) {
+                obj_head_t *o = (obj_head_t*) handle_pool_get(hp, hs[i]);
+                o->pos[1] += o->vel[1];
+            }
+        }
+        uint64_t t2 = time_now_us();
+        if (t1 - t0 < best_iter) best_iter = t1 - t0;
+        if (t2 - t1 < best_lookup) best_lookup = t2 - t1;
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%zuB %s foreach", obj_size, name);
+    bench_report(label, best_iter, (uint64_t) n * PASSES);
+    snprintf(label, sizeof(label), "%zuB %s lookup", obj_size, name);
+    bench_report(label, best_lookup, (uint64_t) n * PASSES);
+    printf("%-32s %10zu KB\n", "  AnonHugePages", huge_kb);
+
+    handle_pool_destroy(hp);
+}
+
+int main(int argc, char **argv) {
+    const int rounds = 5 * bench_scale(argc, argv);
+    const size_t sizes[] = {64, 256};
+
+    printf("huge page size: %zu KB\n", vm_huge_page_size() / 1024);
+    for (size_t s = 0; s < ARRAY_SIZE(sizes); ++s) {
+        size_t sz = sizes[s];
+        run("paged", handle_pool_create_paged(4096, 0, sz, 16), sz, OBJECTS, rounds, 1);
+        run("virtual 4K", handle_pool_create_virtual(OBJECTS, sz, 16, MEM_TAG_CORE), sz, OBJECTS, rounds, 0);
+        run("virtual THP", handle_pool_create_virtual(OBJECTS, sz, 16, MEM_TAG_CORE), sz, OBJECTS, rounds, 1);
+    }
+    return s_sink == -1.0f;
+}
@@ -0,0 +1,107 @@
+/*
+ * TLSF against the system allocator on a game-like mix: mostly small
+ * blocks, some medium, a few large, freed in random order with a bounded
+ * live set. Runs the raw heap, the system heap, and MARU_MALLOC through
+ * the TLSF backend installed after an earlier libc allocation (the engine's
+ * mem.backend = "tlsf" path), checking heap consistency and that the
+ * earlier block is still freed by libc.
+ */
+#include "test.h"
+
+#include <string.h>
+
+#include "mem/mem_diag.h"
+#include "mem/tlsf.h"
+
+#define LIVE 4096
+
+static uint32_t s_rng = 7;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static size_t pick_size(void) {
+    uint32_t r = rnd() % 100;
+    if (r < 80) return 16 + rnd() % 240;           /* components, strings */
+    if (r < 98) return 256 + rnd() % (16 * 1024);  /* buffers, small assets */
+    return 64 * 1024 + rnd() % (512 * 1024);       /* decode scratch */
+}
+
+typedef struct {
+    void *(*alloc)(void *user, size_t size);
+    void (*free)(void *user, void *ptr);
+    void *user;
+} heap_t;
+
+static void *sys_alloc(void *u, size_t n) { (void) u; return malloc(n); }
+static void sys_free(void *u, void *p) { (void) u; free(p); }
+static void *tlsf_alloc_(void *u, size_t n) { return tlsf_malloc((tlsf_t*) u, n); }
+static void tlsf_free_(void *u, void *p) { tlsf_free((tlsf_t*) u, p); }
+static void *maru_alloc_(void *u, size_t n) { (void) u; return MARU_MALLOC(n); }
+static void maru_free_(void *u, void *p) { (void) u; MARU_FREE(p); }
+
+/* Same sequence for every heap: the generator is reseeded per run */
+static uint64_t run(const heap_t *h, uint32_t ops) {
+    static void *live[LIVE];
+    memset(live, 0, sizeof(live));
+    s_rng = 7;
+
+    uint64_t t0 = time_now_us();
+    for (uint32_t i = 0; i < ops; ++i) {
+        uint32_t slot = rnd() % LIVE;
+        if (live[slot]) h->free(h->user, live[slot]);
+
+        size_t n = pick_size();
+        live[slot] = h->alloc(h->user, n);
+        TEST_CHECK(live[slot]);
+        *(volatile uint8_t*) live[slot] = (uint8_t) n;
+    }
+    for (uint32_t i = 0; i < LIVE; ++i) {
+        if (live[i]) h->free(h->user, live[i]);
+    }
+    return time_now_us() - t0;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t ops = 1000000u * (uint32_t) bench_scale(argc, argv);
+
+    /* allocated through libc before the backend exists */
+    char *early = (char*) MARU_MALLOC(64);
+    TEST_CHECK(early);
+
+    heap_t sys = {sys_alloc, sys_free, NULL};
+    bench_report("system malloc/free", run(&sys, ops), ops);
+
+    size_t region = (size_t) 64 << 20;
+    void *mem = malloc(region);
+    tlsf_t *t = tlsf_create(mem, region);
+    TEST_CHECK(t);
+    heap_t raw = {tlsf_alloc_, tlsf_free_, t};
+    bench_report("tlsf malloc/free", run(&raw, ops), ops);
+    TEST_CHECK(tlsf_check(t) == 0);
+
+    tlsf_stats_t st;
+    tlsf_get_stats(t, &st);
+    TEST_CHECK(st.used_blocks == 0 && st.free_blocks == 1);
+    free(mem);
+
+    /* MARU_MALLOC adds tracking on top of either heap; compare like with like */
+    heap_t maru = {maru_alloc_, maru_free_, NULL};
+    bench_report("MARU_MALLOC on system", run(&maru, ops), ops);
+
+    TEST_CHECK(mem_tlsf_backend_init(region) == 0);
+    bench_report("MARU_MALLOC on tlsf backend", run(&maru, ops), ops);
+
+    mem_tlsf_backend_stats(&st);
+    TEST_CHECK(st.used_blocks == 0);
+    printf("tlsf backend: %zu KB in regions, largest free %zu KB\n", st.pool_bytes >> 10, st.largest_free >> 10);
+
+    early = (char*) MARU_REALLOC(early, 128);   /* resized by libc, not the heap */
+    TEST_CHECK(early);
+    MARU_FREE(early);
+    return 0;
+}
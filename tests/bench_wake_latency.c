@@ -0,0 +1,129 @@
+/*
+ * Wake latency of the waiting primitives: two threads ping-pong through a
+ * pair of them, each side sleeping until the other wakes it, so every
+ * round trip is two wakes of a blocked thread. Reported per wake.
+ *
+ *   event      two auto-reset maru_event_t
+ *   semaphore  two maru_sem_t
+ *   condvar    one mutex_t, two cond_t and a turn flag
+ */
+#include "test.h"
+
+#include "thread/event.h"
+#include "thread/mutex.h"
+#include "thread/semaphore.h"
+#include "thread/thread.h"
+
+#define ROUND_TRIPS 20000
+
+typedef struct ping {
+    int trips;
+
+    maru_event_t ev[2];
+    maru_sem_t sem[2];
+
+    mutex_t *lock;
+    cond_t *cv[2];
+    int turn;               /* side that may run, under lock */
+} ping_t;
+
+/* ===== event ===== */
+
+static int event_pong(void *user) {
+    ping_t *p = (ping_t*) user;
+    for (int i = 0; i < p->trips; ++i) {
+        maru_event_wait(&p->ev[1]);
+        maru_event_set(&p->ev[0]);
+    }
+    return 0;
+}
+
+static void event_ping(ping_t *p) {
+    for (int i = 0; i < p->trips; ++i) {
+        maru_event_set(&p->ev[1]);
+        maru_event_wait(&p->ev[0]);
+    }
+}
+
+/* ===== semaphore ===== */
+
+static int sem_pong(void *user) {
+    ping_t *p = (ping_t*) user;
+    for (int i = 0; i < p->trips; ++i) {
+        maru_sem_wait(&p->sem[1]);
+        maru_sem_post(&p->sem[0], 1);
+    }
+    return 0;
+}
+
+static void sem_ping(ping_t *p) {
+    for (int i = 0; i < p->trips; ++i) {
+        maru_sem_post(&p->sem[1], 1);
+        maru_sem_wait(&p->sem[0]);
+    }
+}
+
+/* ===== condvar ===== */
+
+static void cond_pass(ping_t *p, int self) {
+    maru_mutex_lock(p->lock);
+    while (p->turn != self) maru_cond_wait(p->cv[self], p->lock);
+    p->turn = !self;
+    maru_cond_signal(p->cv[!self]);
+    maru_mutex_unlock(p->lock);
+}
+
+static int cond_pong(void *user) {
+    ping_t *p = (ping_t*) user;
+    for (int i = 0; i < p->trips; ++i) cond_pass(p, 1);
+    return 0;
+}
+
+static void cond_ping(ping_t *p) {
+    for (int i = 0; i < p->trips; ++i) cond_pass(p, 0);
+    /* the last pass handed the turn over; wait for it to come back */
+    maru_mutex_lock(p->lock);
+    while (p->turn != 0) maru_cond_wait(p->cv[0], p->lock);
+    maru_mutex_unlock(p->lock);
+}
+
+static void run(const char *name, ping_t *p, maru_thread_fn pong, void (*ping)(ping_t*), int rounds) {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < rounds; ++r) {
+        maru_event_init(&p->ev[0], 1, 0);
+        maru_event_init(&p->ev[1], 1, 0);
+        maru_sem_init(&p->sem[0], 0);
+        maru_sem_init(&p->sem[1], 0);
+        p->turn = 0;
+
+        maru_thread_t *t = maru_thread_create(pong, p, "maru-pong");
+        TEST_CHECK(t);
+        uint64_t t0 = time_now_us();
+        ping(p);
+        uint64_t us = time_now_us() - t0;
+        TEST_CHECK(maru_thread_join(t) == 0);
+        if (us < best) best = us;
+    }
+    bench_report(name, best, (uint64_t) p->trips * 2);
+}
+
+int main(int argc, char **argv) {
+    const int rounds = 3 * bench_scale(argc, argv);
+
+    static ping_t p;
+    p.trips = ROUND_TRIPS;
+    p.lock = maru_mutex_create();
+    p.cv[0] = maru_cond_create();
+    p.cv[1] = maru_cond_create();
+    TEST_CHECK(p.lock && p.cv[0] && p.cv[1]);
+
+    printf("%u CPUs, one-way wake\n", maru_cpu_count());
+    run("event", &p, event_pong, event_ping, rounds);
+    run("semaphore", &p, sem_pong, sem_ping, rounds);
+    run("condvar", &p, cond_pong, cond_ping, rounds);
+
+    maru_cond_destroy(p.cv[1]);
+    maru_cond_destroy(p.cv[0]);
+    maru_mutex_destroy(p.lock);
+    return 0;
+}
@@ -0,0 +1,327 @@
+#include "fake_rhi.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine_context.h"
+#include "asset/asset.h"
+#include "asset/texture_manager.h"
+#include "mem/mem_scratch.h"
+#include "thread/atomic.h"
+#include "thread/thread.h"
+
+engine_context_t g_ctx;
+
+/* Every dummy object; usage tells buffers apart */
+typedef struct fake_obj {
+    uint32_t usage;
+} fake_obj_t;
+
+static fake_rhi_stats_t s_stats;
+static fake_obj_t s_device;
+static fake_obj_t s_cmd;
+static fake_obj_t s_backbuffer;
+
+/* A command list is open, and whether this thread opened it */
+static maru_atomic_u32_t s_open;
+static maru_atomic_u32_t s_conflicts;
+static MARU_THREAD_LOCAL int t_open;
+static uint32_t s_hold_ms;
+static bool s_threaded_submit = true;
+
+/* Resource calls from one thread while another records or submits */
+static void check_owner(void) {
+    if (!t_open && maru_atomic_load_u32(&s_open, MARU_MO_ACQUIRE)) {
+        maru_atomic_fetch_add_u32(&s_conflicts, 1, MARU_MO_RELAXED);
+    }
+}
+
+static void *fake_new(uint32_t usage) {
+    fake_obj_t *o = (fake_obj_t*) calloc(1, sizeof(*o));
+    if (o) o->usage = usage;
+    return o;
+}
+
+static rhi_swapchain_t *fake_get_swapchain(rhi_device_t *d) {
+    (void) d;
+    return NULL;
+}
+
+static void fake_present(rhi_swapchain_t *s) {
+    (void) s;
+}
+
+static void fake_resize(rhi_device_t *d, int w, int h) {
+    (void) d;
+    (void) w;
+    (void) h;
+}
+
+static rhi_buffer_t *fake_create_buffer(rhi_device_t *d, const rhi_buffer_desc_t *desc, const void *initial) {
+    (void) d;
+    check_owner();
+    (void) initial;
+    s_stats.buffers++;
+    if (desc->usage & RHI_BUF_CONST) {
+        s_stats.const_buffers++;
+        s_stats.const_created++;
+    }
+    return (rhi_buffer_t*) fake_new(desc->usage);
+}
+
+static void fake_destroy_buffer(rhi_device_t *d, rhi_buffer_t *b) {
+    (void) d;
+    check_owner();
+    if (!b) return;
+    s_stats.buffers--;
+    if (((fake_obj_t*) b)->usage & RHI_BUF_CONST) s_stats.const_buffers--;
+    free(b);
+}
+
+static void fake_update_buffer(rhi_device_t *d, rhi_buffer_t *b, const void *data, size_t bytes) {
+    (void) d;
+    check_owner();
+    (void) b;
+    (void) data;
+    (void) bytes;
+    s_stats.updates++;
+}
+
+static rhi_texture_t *fake_create_texture(rhi_device_t *d, const rhi_texture_desc_t *desc, const void *initial) {
+    (void) d;
+    check_owner();
+    (void) initial;
+    s_stats.textures++;
+    return (rhi_texture_t*) fake_new(desc->usage);
+}
+
+static void fake_destroy_texture(rhi_device_t *d, rhi_texture_t *t) {
+    (void) d;
+    check_owner();
+    if (!t) return;
+    s_stats.textures--;
+    free(t);
+}
+
+static rhi_sampler_t *fake_create_sampler(rhi_device_t *d, const rhi_sampler_desc_t *desc) {
+    (void) d;
+    check_owner();
+    (void) desc;
+    s_stats.samplers++;
+    return (rhi_sampler_t*) fake_new(0);
+}
+
+static void fake_destroy_sampler(rhi_device_t *d, rhi_sampler_t *s) {
+    (void) d;
+    check_owner();
+    if (!s) return;
+    s_stats.samplers--;
+    free(s);
+}
+
+static rhi_shader_t *fake_create_shader(rhi_device_t *d, const rhi_shader_desc_t *desc) {
+    (void) d;
+    check_owner();
+    (void) desc;
+    return (rhi_shader_t*) fake_new(0);
+}
+
+static void fake_destroy_shader(rhi_device_t *d, rhi_shader_t *s) {
+    (void) d;
+    check_owner();
+    free(s);
+}
+
+static rhi_pipeline_t *fake_create_pipeline(rhi_device_t *d, const rhi_pipeline_desc_t *desc) {
+    (void) d;
+    check_owner();
+    (void) desc;
+    return (rhi_pipeline_t*) fake_new(0);
+}
+
+static void fake_destroy_pipeline(rhi_device_t *d, rhi_pipeline_t *p) {
+    (void) d;
+    check_owner();
+    free(p);
+}
+
+static rhi_render_target_t *fake_create_render_target(rhi_device_t *d, const rhi_render_target_desc_t *desc) {
+    (void) d;
+    (void) desc;
+    return (rhi_render_target_t*) fake_new(0);
+}
+
+static void fake_destroy_render_target(rhi_device_t *d, rhi_render_target_t *rt) {
+    (void) d;
+    free(rt);
+}
+
+static rhi_render_target_t *fake_get_backbuffer_rt(rhi_device_t *d) {
+    (void) d;
+    return (rhi_render_target_t*) &s_backbuffer;
+}
+
+static rhi_cmd_t *fake_begin_cmd(rhi_device_t *d) {
+    (void) d;
+    t_open = 1;
+    maru_atomic_store_u32(&s_open, 1, MARU_MO_RELEASE);
+    return (rhi_cmd_t*) &s_cmd;
+}
+
+static void fake_end_cmd(rhi_cmd_t *c) {
+    (void) c;
+    if (s_hold_ms) maru_thread_sleep_ms(s_hold_ms);
+    maru_atomic_store_u32(&s_open, 0, MARU_MO_RELEASE);
+    t_open = 0;
+}
+
+static void fake_cmd_begin_render(rhi_cmd_t *c, rhi_render_target_t *rt, const float clear_rgba[4]) {
+    (void) c;
+    (void) rt;
+    (void) clear_rgba;
+}
+
+static void fake_cmd_end_render(rhi_cmd_t *c) {
+    (void) c;
+}
+
+static void fake_cmd_bind_pipeline(rhi_cmd_t *c, rhi_pipeline_t *p) {
+    (void) c;
+    (void) p;
+}
+
+static void fake_cmd_bind_const_buffer(rhi_cmd_t *c, int slot, rhi_buffer_t *b, uint32_t stages) {
+    (void) c;
+    (void) slot;
+    (void) b;
+    (void) stages;
+}
+
+static void fake_cmd_bind_texture(rhi_cmd_t *c, rhi_texture_t *t, int slot, uint32_t stages) {
+    (void) c;
+    (void) t;
+    (void) slot;
+    (void) stages;
+}
+
+static void fake_cmd_bind_sampler(rhi_cmd_t *c, rhi_sampler_t *s, int slot, uint32_t stages) {
+    (void) c;
+    (void) s;
+    (void) slot;
+    (void) stages;
+}
+
+static void fake_cmd_set_vertex_buffer(rhi_cmd_t *c, int slot, rhi_buffer_t *b) {
+    (void) c;
+    (void) slot;
+    (void) b;
+}
+
+static void fake_cmd_set_index_buffer(rhi_cmd_t *c, rhi_buffer_t *b) {
+    (void) c;
+    (void) b;
+}
+
+static void fake_cmd_draw(rhi_cmd_t *c, uint32_t vtx_count, uint32_t first, uint32_t inst_count) {
+    (void) c;
+    (void) vtx_count;
+    (void) first;
+    (void) inst_count;
+    s_stats.draws++;
+}
+
+static void fake_cmd_draw_indexed(rhi_cmd_t *c, uint32_t idx_count, uint32_t first, uint32_t base_vtx,
+                                  uint32_t inst_count) {
+    (void) c;
+    (void) idx_count;
+    (void) first;
+    (void) base_vtx;
+    (void) inst_count;
+    s_stats.draws++;
+}
+
+static void fake_get_capabilities(rhi_device_t *d, rhi_capabilities_t *out) {
+    (void) d;
+    memset(out, 0, sizeof(*out));
+    out->max_depth = 1.0f;
+    out->conventions.matrix_order = RHI_MATRIX_COLUMN_MAJOR;
+    out->threaded_submit = s_threaded_submit;
+}
+
+static rhi_dispatch_t s_dispatch;
+
+const rhi_dispatch_t *fake_rhi_install(void) {
+    rhi_dispatch_t *r = &s_dispatch;
+    memset(r, 0, sizeof(*r));
+
+    r->get_swapchain = fake_get_swapchain;
+    r->present = fake_present;
+    r->resize = fake_resize;
+    r->create_buffer = fake_create_buffer;
+    r->destroy_buffer = fake_destroy_buffer;
+    r->update_buffer = fake_update_buffer;
+    r->create_texture = fake_create_texture;
+    r->destroy_texture = fake_destroy_texture;
+    r->create_sampler = fake_create_sampler;
+    r->destroy_sampler = fake_destroy_sampler;
+    r->create_shader = fake_create_shader;
+    r->destroy_shader = fake_destroy_shader;
+    r->create_pipeline = fake_create_pipeline;
+    r->destroy_pipeline = fake_destroy_pipeline;
+    r->create_render_target = fake_create_render_target;
+    r->destroy_render_target = fake_destroy_render_target;
+    r->get_backbuffer_rt = fake_get_backbuffer_rt;
+    r->begin_cmd = fake_begin_cmd;
+    r->end_cmd = fake_end_cmd;
+    r->cmd_begin_render = fake_cmd_begin_render;
+    r->cmd_end_render = fake_cmd_end_render;
+    r->cmd_bind_pipeline = fake_cmd_bind_pipeline;
+    r->cmd_bind_const_buffer = fake_cmd_bind_const_buffer;
+    r->cmd_bind_texture = fake_cmd_bind_texture;
+    r->cmd_bind_sampler = fake_cmd_bind_sampler;
+    r->cmd_set_vertex_buffer = fake_cmd_set_vertex_buffer;
+    r->cmd_set_index_buffer = fake_cmd_set_index_buffer;
+    r->cmd_draw = fake_cmd_draw;
+    r->cmd_draw_indexed = fake_cmd_draw_indexed;
+    r->get_capabilities = fake_get_capabilities;
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    maru_atomic_store_u32(&s_conflicts, 0, MARU_MO_RELAXED);
+    g_ctx.active_rhi = r;
+    g_ctx.active_device = fake_rhi_device();
+    return r;
+}
+
+rhi_device_t *fake_rhi_device(void) {
+    return (rhi_device_t*) &s_device;
+}
+
+void fake_rhi_hold_cmd(uint32_t ms) {
+    s_hold_ms = ms;
+}
+
+void fake_rhi_set_threaded_submit(bool on) {
+    s_threaded_submit = on;
+}
+
+void fake_rhi_stats(fake_rhi_stats_t *out) {
+    *out = s_stats;
+    out->conflicts = maru_atomic_load_u32(&s_conflicts, MARU_MO_RELAXED);
+}
+
+static const char s_shader_text[] = "// placeholder\n";
+
+char *asset_read_scratch(const char *relpath, size_t *out_size, int need_null_terminator) {
+    (void) relpath;
+    (void) need_null_terminator;
+
+    char *buf = scratch_strdup(s_shader_text);
+    if (buf && out_size) *out_size = sizeof(s_shader_text) - 1;
+    return buf;
+}
+
+/* Stable per handle, never dereferenced by the fake */
+rhi_texture_t *tex_acquire_rhi(texture_handle_t h) {
+    static fake_obj_t textures[64];
+    return h != TEX_HANDLE_INVALID ? (rhi_texture_t*) &textures[h % 64] : NULL;
+}
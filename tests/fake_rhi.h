@@ -0,0 +1,44 @@
+#ifndef MARU_TEST_FAKE_RHI_H
+#define MARU_TEST_FAKE_RHI_H
+
+#include <stdint.h>
+
+#include "rhi/rhi.h"
+
+/*
+ * An RHI backend that draws nothing and counts what the engine asks of it,
+ * for tests that run the renderer and material system headless. Objects
+ * are dummies from plain malloc, so they stay out of MARU_MALLOC totals.
+ * Creating, updating or destroying a resource while another thread has a
+ * command list open counts as a conflict: the real backends are not
+ * thread-safe.
+ *
+ * Linking it also provides the two asset entry points the renderer and
+ * materials need without touching the disk: asset_read_scratch hands out
+ * placeholder shader text, tex_acquire_rhi a dummy texture per handle.
+ */
+typedef struct fake_rhi_stats {
+    uint32_t buffers;           /* live buffers of any kind */
+    uint32_t const_buffers;     /* live RHI_BUF_CONST buffers */
+    uint32_t const_created;     /* RHI_BUF_CONST buffers ever created */
+    uint32_t samplers;
+    uint32_t textures;
+    uint32_t updates;           /* update_buffer calls */
+    uint32_t draws;
+    uint32_t conflicts;         /* resource calls while another thread had a command list open */
+} fake_rhi_stats_t;
+
+/* Installs the backend as g_ctx's active RHI and device, clearing the counters */
+const rhi_dispatch_t *fake_rhi_install(void);
+rhi_device_t *fake_rhi_device(void);
+
+/* end_cmd keeps the list open this much longer, so overlapping calls get caught */
+void fake_rhi_hold_cmd(uint32_t ms);
+
+/* What get_capabilities reports as threaded_submit (default true) */
+void fake_rhi_set_threaded_submit(bool on);
+
+/* Read while the render thread is idle (after renderer_flush) */
+void fake_rhi_stats(fake_rhi_stats_t *out);
+
+#endif /* MARU_TEST_FAKE_RHI_H */
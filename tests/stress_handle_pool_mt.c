@@ -0,0 +1,213 @@
+/*
+ * handle_pool_mt under contention: every thread allocates, resolves and
+ * frees batches against one pool sized so the free list keeps running dry,
+ * while a reader resolves a fixed set of long-lived handles. Checks that no
+ * handle is handed out twice, that stale handles stop resolving, and that
+ * the pool ends empty.
+ *
+ * The same mix then runs against a handle_pool_t behind one mutex, the
+ * way a shared pool would be guarded without handle_pool_mt; throughput
+ * of both is printed side by side per thread count.
+ */
+#include "test.h"
+
+#include "macro.h"
+#include "handle/handle_pool.h"
+#include "handle/handle_pool_mt.h"
+#include "thread/atomic.h"
+#include "thread/mutex.h"
+#include "thread/thread.h"
+
+#define BATCH 64
+#define PINNED 32
+
+typedef struct {
+    uint64_t owner;
+    uint64_t seq;
+} item_t;
+
+/* The pool under test: handle_pool_mt, or handle_pool_t under s_lock */
+typedef struct {
+    const char *name;
+    int (*create)(size_t capacity);
+    void (*destroy)(void);
+    handle_t (*alloc)(const item_t *v);
+    item_t *(*get)(handle_t h);
+    int (*free)(handle_t h);            /* 1 = freed, 0 = stale */
+    size_t (*alive)(void);
+} pool_ops_t;
+
+static handle_pool_mt_t *s_mt;
+static handle_pool_t *s_st;
+static mutex_t *s_lock;
+
+static int mt_create(size_t capacity) {
+    s_mt = handle_pool_mt_create(capacity, sizeof(item_t), 8);
+    return s_mt != NULL;
+}
+
+static void mt_destroy(void) {
+    handle_pool_mt_destroy(s_mt);
+}
+
+static handle_t mt_alloc(const item_t *v) {
+    return handle_pool_mt_alloc(s_mt, v);
+}
+
+static item_t *mt_get(handle_t h) {
+    return (item_t*) handle_pool_mt_get(s_mt, h);
+}
+
+static int mt_free(handle_t h) {
+    return handle_pool_mt_free(s_mt, h);
+}
+
+static size_t mt_alive(void) {
+    return handle_pool_mt_alive_count(s_mt);
+}
+
+static int locked_create(size_t capacity) {
+    s_st = handle_pool_create(capacity, sizeof(item_t), 8);
+    s_lock = maru_mutex_create();
+    return s_st && s_lock;
+}
+
+static void locked_destroy(void) {
+    handle_pool_destroy(s_st);
+    maru_mutex_destroy(s_lock);
+}
+
+static handle_t locked_alloc(const item_t *v) {
+    maru_mutex_lock(s_lock);
+    handle_t h = handle_pool_alloc(s_st, v);
+    maru_mutex_unlock(s_lock);
+    return h;
+}
+
+/* The object is only read under the lock, then copied out like a get would be used */
+static item_t *locked_get(handle_t h) {
+    static MARU_THREAD_LOCAL item_t copy;
+    maru_mutex_lock(s_lock);
+    item_t *p = (item_t*) handle_pool_get(s_st, h);
+    if (p) copy = *p;
+    maru_mutex_unlock(s_lock);
+    return p ? &copy : NULL;
+}
+
+static int locked_free(handle_t h) {
+    maru_mutex_lock(s_lock);
+    int live = handle_pool_get(s_st, h) != NULL;
+    if (live) handle_pool_free(s_st, h);
+    maru_mutex_unlock(s_lock);
+    return live;
+}
+
+static size_t locked_alive(void) {
+    return handle_pool_alive_count(s_st);
+}
+
+static const pool_ops_t s_pools[] = {
+    {"handle_pool_mt", mt_create, mt_destroy, mt_alloc, mt_get, mt_free, mt_alive},
+    {"mutex+handle_pool", locked_create, locked_destroy, locked_alloc, locked_get, locked_free, locked_alive},
+};
+
+static const pool_ops_t *s_ops;
+static handle_t s_pinned[PINNED];
+static maru_atomic_u32_t s_stop;
+static int s_iters;
+
+static int churn_main(void *user) {
+    uint64_t id = (uint64_t) (uintptr_t) user;
+    handle_t hs[BATCH];
+
+    for (int it = 0; it < s_iters; ++it) {
+        int n = 0;
+        for (int k = 0; k < BATCH; ++k) {
+            item_t v = {id, (uint64_t) it * BATCH + k};
+            handle_t h = s_ops->alloc(&v);
+            if (h) hs[n++] = h;
+        }
+
+        for (int k = 0; k < n; ++k) {
+            item_t *p = s_ops->get(hs[k]);
+            TEST_CHECK(p && p->owner == id);
+            TEST_CHECK(s_ops->free(hs[k]) == 1);
+            TEST_CHECK(s_ops->free(hs[k]) == 0);
+        }
+    }
+    return 0;
+}
+
+static int reader_main(void *user) {
+    (void) user;
+    uint64_t reads = 0;
+    while (!maru_atomic_load_u32(&s_stop, MARU_MO_ACQUIRE)) {
+        for (int i = 0; i < PINNED; ++i) {
+            item_t *p = s_ops->get(s_pinned[i]);
+            TEST_CHECK(p && p->owner == UINT64_MAX && p->seq == (uint64_t) i);
+            ++reads;
+        }
+    }
+    return (int) (reads > 0);
+}
+
+/* Returns the microseconds the churn threads took */
+static uint64_t run(const pool_ops_t *ops, uint32_t threads) {
+    s_ops = ops;
+
+    /* fewer slots than threads * BATCH: allocation failure paths get exercised too */
+    TEST_CHECK(ops->create(threads * BATCH / 2 + PINNED));
+
+    for (int i = 0; i < PINNED; ++i) {
+        item_t v = {UINT64_MAX, (uint64_t) i};
+        s_pinned[i] = ops->alloc(&v);
+        TEST_CHECK(s_pinned[i]);
+    }
+
+    maru_atomic_store_u32(&s_stop, 0, MARU_MO_RELEASE);
+    maru_thread_t *reader = maru_thread_create(reader_main, NULL, "reader");
+    TEST_CHECK(reader);
+
+    maru_thread_t *t[64];
+    uint64_t t0 = time_now_us();
+    for (uint32_t i = 0; i < threads; ++i) {
+        t[i] = maru_thread_create(churn_main, (void*) (uintptr_t) i, "churn");
+        TEST_CHECK(t[i]);
+    }
+    for (uint32_t i = 0; i < threads; ++i) {
+        TEST_CHECK(maru_thread_join(t[i]) == 0);
+    }
+    uint64_t us = time_now_us() - t0;
+
+    maru_atomic_store_u32(&s_stop, 1, MARU_MO_RELEASE);
+    maru_thread_join(reader);
+
+    TEST_CHECK(ops->alive() == PINNED);
+    for (int i = 0; i < PINNED; ++i) {
+        TEST_CHECK(ops->free(s_pinned[i]) == 1);
+    }
+    TEST_CHECK(ops->alive() == 0);
+    ops->destroy();
+    return us;
+}
+
+int main(int argc, char **argv) {
+    s_iters = 2000 * bench_scale(argc, argv);
+
+    uint32_t max = maru_cpu_count() * 2;
+    if (max < 4) max = 4;
+    if (max > 64) max = 64;
+
+    for (uint32_t n = 1; n <= max; n *= 2) {
+        const uint64_t ops = (uint64_t) n * s_iters * BATCH;
+        uint64_t us[ARRAY_SIZE(s_pools)];
+        for (size_t p = 0; p < ARRAY_SIZE(s_pools); ++p) us[p] = run(&s_pools[p], n);
+
+        printf("alloc+get+free x%-2u threads", n);
+        for (size_t p = 0; p < ARRAY_SIZE(s_pools); ++p) {
+            printf("  %s %8.2f ns/op", s_pools[p].name, (double) us[p] * 1000.0 / (double) ops);
+        }
+        printf("  (%.2fx)\n", us[0] ? (double) us[1] / (double) us[0] : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * Producer/consumer stress for the lock-free primitives in core/thread:
+ * SPSC ring, MPMC ring, MPSC stack and spinlock. Payloads are plain
+ * (non-atomic) data whose only ordering is what the primitive provides, so
+ * a missing release/acquire shows up as a torn payload here and as a race
+ * under ThreadSanitizer (configure with -DMARU_TEST_TSAN=ON).
+ */
+#include "test.h"
+
+#include "thread/atomic.h"
+#include "thread/mpmc_ring.h"
+#include "thread/mpsc_stack.h"
+#include "thread/spsc_ring.h"
+#include "thread/thread.h"
+
+#define PRODUCERS 4
+#define CONSUMERS 3
+
+typedef struct {
+    uint64_t seq;
+    uint64_t check;
+} payload_t;
+
+static uint32_t s_count;
+
+static maru_spsc_ring_t s_spsc;
+
+static int spsc_producer(void *user) {
+    (void) user;
+    for (uint64_t i = 0; i < s_count;) {
+        payload_t p = {i, ~i};
+        if (maru_spsc_push(&s_spsc, &p)) ++i;
+        else maru_thread_yield();
+    }
+    return 0;
+}
+
+static void test_spsc(void) {
+    TEST_CHECK(maru_spsc_init(&s_spsc, 100, sizeof(payload_t)) == 0);
+    TEST_CHECK(maru_spsc_capacity(&s_spsc) == 128);
+
+    maru_thread_t *t = maru_thread_create(spsc_producer, NULL, "spsc");
+    TEST_CHECK(t);
+
+    payload_t p;
+    for (uint64_t i = 0; i < s_count;) {
+        if (maru_spsc_pop(&s_spsc, &p)) {
+            TEST_CHECK(p.seq == i && p.check == ~i);
+            ++i;
+        } else {
+            maru_thread_yield();
+        }
+    }
+    maru_thread_join(t);
+    TEST_CHECK(!maru_spsc_pop(&s_spsc, &p));
+    maru_spsc_destroy(&s_spsc);
+}
+
+static maru_mpmc_ring_t s_mpmc;
+static maru_atomic_u32_t s_popped;
+static maru_atomic_u32_t s_got[PRODUCERS];
+
+static int mpmc_producer(void *user) {
+    uint64_t id = (uint64_t) (uintptr_t) user;
+    for (uint64_t i = 0; i < s_count;) {
+        payload_t p = {id << 32 | i, ~(id << 32 | i)};
+        if (maru_mpmc_push(&s_mpmc, &p)) ++i;
+        else maru_thread_yield();
+    }
+    return 0;
+}
+
+static int mpmc_consumer(void *user) {
+    (void) user;
+    uint64_t last[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; ++i) last[i] = UINT64_MAX;
+
+    payload_t p;
+    while (maru_atomic_load_u32(&s_popped, MARU_MO_RELAXED) < PRODUCERS * s_count) {
+        if (!maru_mpmc_pop(&s_mpmc, &p)) {
+            maru_thread_yield();
+            continue;
+        }
+        TEST_CHECK(p.check == ~p.seq);
+
+        /* each producer's items reach any one consumer in push order */
+        uint32_t id = (uint32_t) (p.seq >> 32);
+        uint64_t seq = p.seq & 0xffffffffu;
+        TEST_CHECK(id < PRODUCERS && (last[id] == UINT64_MAX || seq > last[id]));
+        last[id] = seq;
+
+        maru_atomic_fetch_add_u32(&s_got[id], 1, MARU_MO_RELAXED);
+        maru_atomic_fetch_add_u32(&s_popped, 1, MARU_MO_RELAXED);
+    }
+    return 0;
+}
+
+static void test_mpmc(void) {
+    TEST_CHECK(maru_mpmc_init(&s_mpmc, 64, sizeof(payload_t)) == 0);
+
+    maru_thread_t *t[PRODUCERS + CONSUMERS];
+    for (int i = 0; i < PRODUCERS; ++i) t[i] = maru_thread_create(mpmc_producer, (void*) (uintptr_t) i, "mpmc-p");
+    for (int i = 0; i < CONSUMERS; ++i) t[PRODUCERS + i] = maru_thread_create(mpmc_consumer, NULL, "mpmc-c");
+    for (int i = 0; i < PRODUCERS + CONSUMERS; ++i) {
+        TEST_CHECK(t[i]);
+        maru_thread_join(t[i]);
+    }
+
+    for (int i = 0; i < PRODUCERS; ++i) {
+        TEST_CHECK(maru_atomic_load_u32(&s_got[i], MARU_MO_RELAXED) == s_count);
+    }
+    payload_t p;
+    TEST_CHECK(!maru_mpmc_pop(&s_mpmc, &p));
+    maru_mpmc_destroy(&s_mpmc);
+}
+
+typedef struct {
+    maru_mpsc_node_t node;
+    uint32_t producer;
+    uint32_t seq;
+} stack_item_t;
+
+static maru_mpsc_stack_t s_stack = MARU_MPSC_STACK_INIT;
+
+static int stack_producer(void *user) {
+    uint32_t id = (uint32_t) (uintptr_t) user;
+    for (uint32_t i = 0; i < s_count / 8; ++i) {
+        stack_item_t *it = (stack_item_t*) malloc(sizeof(*it));
+        TEST_CHECK(it);
+        it->producer = id;
+        it->seq = i;
+        maru_mpsc_push(&s_stack, &it->node);
+    }
+    return 0;
+}
+
+static void test_mpsc(void) {
+    maru_thread_t *t[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; ++i) {
+        t[i] = maru_thread_create(stack_producer, (void*) (uintptr_t) i, "mpsc");
+        TEST_CHECK(t[i]);
+    }
+
+    uint32_t total = 0;
+    int64_t last[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; ++i) last[i] = -1;
+
+    while (total < PRODUCERS * (s_count / 8)) {
+        maru_mpsc_node_t *n = maru_mpsc_reverse(maru_mpsc_pop_all(&s_stack));
+        if (!n) maru_thread_yield();
+        while (n) {
+            maru_mpsc_node_t *next = n->next;
+            stack_item_t *it = MARU_MPSC_ENTRY(n, stack_item_t, node);
+            TEST_CHECK(it->producer < PRODUCERS && (int64_t) it->seq > last[it->producer]);
+            last[it->producer] = it->seq;
+            free(it);
+            ++total;
+            n = next;
+        }
+    }
+    for (int i = 0; i < PRODUCERS; ++i) maru_thread_join(t[i]);
+    TEST_CHECK(maru_mpsc_empty(&s_stack));
+}
+
+static maru_spinlock_t s_lock = MARU_SPINLOCK_INIT;
+static uint64_t s_shared;   /* plain: only the lock orders it */
+
+static int lock_worker(void *user) {
+    (void) user;
+    for (uint32_t i = 0; i < s_count; ++i) {
+        maru_spinlock_lock(&s_lock);
+        ++s_shared;
+        maru_spinlock_unlock(&s_lock);
+    }
+    return 0;
+}
+
+static void test_spinlock(void) {
+    maru_thread_t *t[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; ++i) {
+        t[i] = maru_thread_create(lock_worker, NULL, "spin");
+        TEST_CHECK(t[i]);
+    }
+    for (int i = 0; i < PRODUCERS; ++i) maru_thread_join(t[i]);
+    TEST_CHECK(s_shared == (uint64_t) PRODUCERS * s_count);
+}
+
+int main(int argc, char **argv) {
+    s_count = 100000u * (uint32_t) bench_scale(argc, argv);
+
+    uint64_t t0 = time_now_us();
+    test_spsc();
+    bench_report("spsc, 1:1", time_now_us() - t0, s_count);
+
+    t0 = time_now_us();
+    test_mpmc();
+    bench_report("mpmc, 4:3", time_now_us() - t0, (uint64_t) PRODUCERS * s_count);
+
+    t0 = time_now_us();
+    test_mpsc();
+    bench_report("mpsc stack, 4:1", time_now_us() - t0, (uint64_t) PRODUCERS * (s_count / 8));
+
+    t0 = time_now_us();
+    test_spinlock();
+    bench_report("spinlock, 4 threads", time_now_us() - t0, (uint64_t) PRODUCERS * s_count);
+    return 0;
+}
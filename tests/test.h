@@ -0,0 +1,33 @@
+#ifndef MARU_TEST_H
+#define MARU_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "time.h"
+
+/*
+ * Minimal harness for tests/. A failed check prints where and exits 1,
+ * which ctest reports. Benchmarks print one line per case; their first
+ * argument, when given, scales the work (ctest runs them unscaled).
+ */
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+static inline int bench_scale(int argc, char **argv) {
+    int s = argc > 1 ? atoi(argv[1]) : 1;
+    return s > 0 ? s : 1;
+}
+
+static inline void bench_report(const char *name, uint64_t us, uint64_t ops) {
+    printf("%-32s %10.3f ms %10.2f ns/op\n", name, (double) us / 1000.0,
+           ops ? (double) us * 1000.0 / (double) ops : 0.0);
+}
+
+#endif /* MARU_TEST_H */
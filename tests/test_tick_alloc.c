@@ -0,0 +1,169 @@
+/*
+ * Steady-state frames must not touch the heap. Runs the renderer on the
+ * fake RHI over a scene of render objects sharing one material, once on
+ * the caller and once with the render thread, and checks that after a few
+ * warm-up frames no frame makes a MARU_MALLOC allocation. A failing frame
+ * names its sites through the churn profiler, as the engine's
+ * debug.zero_alloc_after check does. The render thread is refused when
+ * the backend does not report threaded_submit.
+ *
+ * Also checks that the profiler reports the sites of the last frame even
+ * when busier sites from earlier frames outnumber them.
+ */
+#include "test.h"
+
+#include <string.h>
+
+#include "fake_rhi.h"
+#include "engine_context.h"
+#include "asset/mesh.h"
+#include "material/material.h"
+#include "mem/mem_churn.h"
+#include "mem/mem_diag.h"
+#include "renderer/render_object.h"
+#include "renderer/renderer.h"
+
+extern engine_context_t g_ctx;
+
+#define OBJECTS 64
+#define WARMUP 4
+#define FRAMES 200
+
+static transform_t s_transforms[OBJECTS];
+static render_object_handle_t s_objects[OBJECTS];
+
+static void scene(renderer_t *R, void *user) {
+    (void) user;
+
+    mat4 I;
+    memset(I, 0, sizeof(I));
+    I[0][0] = I[1][1] = I[2][2] = I[3][3] = 1.0f;
+    renderer_set_camera(R, (const float*) I, (const float*) I);
+
+    renderer_draw_objects(R, s_objects + 1, OBJECTS - 1);
+    renderer_draw_object(R, s_objects[0]);
+}
+
+static void check_frames(renderer_t *R, const char *mode) {
+    for (int f = 0; f < WARMUP; ++f) renderer_render(R);
+    renderer_flush(R);
+
+    for (int f = 0; f < FRAMES; ++f) {
+        uint64_t before = mem_alloc_total();
+        mem_churn_frame_begin();
+        renderer_render(R);
+        if (f == FRAMES - 1) renderer_flush(R);     /* the last packet's replay counts too */
+        mem_churn_frame_end();
+
+        uint64_t allocs = mem_alloc_total() - before;
+        if (allocs) {
+            mem_churn_site_t sites[8];
+            size_t n = mem_churn_last_frame(sites, 8);
+            fprintf(stderr, "%s frame %d: %llu allocations\n", mode, f, (unsigned long long) allocs);
+            for (size_t i = 0; i < n && i < 8; ++i) {
+                fprintf(stderr, "  %llu @ %s:%d\n", (unsigned long long) sites[i].last_count, sites[i].file,
+                        sites[i].line);
+            }
+        }
+        TEST_CHECK(allocs == 0);
+    }
+
+    fake_rhi_stats_t st;
+    fake_rhi_stats(&st);
+    TEST_CHECK(st.conflicts == 0);
+    printf("%-10s %d frames, %u draws, 0 allocations\n", mode, FRAMES, st.draws);
+}
+
+static void busy_sites(void) {
+    for (int i = 0; i < 16; ++i) {
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+        MARU_FREE(MARU_MALLOC(16));
+    }
+}
+
+static void check_last_frame_sites(void) {
+#ifdef MARU_ENABLE_MEM_DIAG
+    mem_churn_enable(1);
+
+    mem_churn_frame_begin();
+    busy_sites();
+    mem_churn_frame_end();
+
+    mem_churn_frame_begin();
+    int line = __LINE__; MARU_FREE(MARU_MALLOC(32));
+    mem_churn_frame_end();
+
+    mem_churn_site_t sites[8];
+    TEST_CHECK(mem_churn_stats(sites, 8) == 10);
+    TEST_CHECK(mem_churn_last_frame(sites, 8) == 1);
+    TEST_CHECK(sites[0].line == line && sites[0].last_count == 1);
+
+    mem_churn_enable(0);
+#endif
+}
+
+int main(void) {
+    check_last_frame_sites();
+
+    fake_rhi_install();
+    TEST_CHECK(material_system_init(64) == 0);
+    TEST_CHECK(mesh_system_init(16) == 0);
+    TEST_CHECK(render_object_system_init(OBJECTS) == 0);
+
+    static const float verts[3 * 8] = {0};
+    static const uint32_t indices[3] = {0, 1, 2};
+    mesh_desc_t md = {0};
+    md.vertices = verts;
+    md.vertex_size = 8 * sizeof(float);
+    md.vertex_count = 3;
+    md.indices = indices;
+    md.index_count = 3;
+    mesh_handle_t mesh = mesh_create(&md);
+    TEST_CHECK(mesh != MESH_HANDLE_INVALID);
+
+    material_desc_t desc = {"shader/default.hlsl", "VSMain", "PSMain"};
+    material_handle_t base = material_create(&desc);
+    TEST_CHECK(base != MAT_HANDLE_INVALID);
+    material_set_texture(base, "gAlbedo", 1);
+
+    for (int i = 0; i < OBJECTS; ++i) {
+        transform_init(&s_transforms[i]);
+        s_objects[i] = render_object_create();
+        TEST_CHECK(s_objects[i] != RENDER_OBJECT_HANDLE_INVALID);
+        render_object_set_mesh(s_objects[i], mesh);
+        render_object_set_material(s_objects[i], base);
+        render_object_set_transform(s_objects[i], &s_transforms[i]);
+    }
+
+    static renderer_t R;
+    TEST_CHECK(renderer_init(&R, g_ctx.active_rhi, g_ctx.active_device, 64, 64) == 0);
+    renderer_set_scene(&R, scene, NULL);
+
+    mem_churn_enable(1);
+    check_frames(&R, "immediate");
+
+    /* a backend that cannot submit from another thread keeps rendering on the caller */
+    fake_rhi_set_threaded_submit(false);
+    TEST_CHECK(renderer_start_thread(&R, NULL) != 0 && !renderer_threaded(&R));
+    fake_rhi_set_threaded_submit(true);
+
+    TEST_CHECK(renderer_start_thread(&R, NULL) == 0);
+    check_frames(&R, "threaded");
+    mem_churn_enable(0);
+
+    renderer_shutdown(&R);
+    for (int i = 0; i < OBJECTS; ++i) render_object_destroy(s_objects[i]);
+    material_destroy(base);
+    mesh_destroy(mesh);
+    render_object_system_shutdown();
+    mesh_system_shutdown();
+    material_system_shutdown();
+    return 0;
+}